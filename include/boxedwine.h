@@ -10,6 +10,7 @@
 #include <memory>
 #include <queue>
 #include <functional>
+#include <atomic>
 #include <set>
 #include <list>
 #include <filesystem>
@@ -25,6 +26,8 @@
 #include "ktimer.h"
 #include "../source/util/synchronization.h"
 #include "../source/util/karray.h"
+#include "../source/util/kringbuffer.h"
+#include "../source/util/kspscringbuffer.h"
 #include "../source/util/stringutil.h"
 #include "../source/util/vectorutils.h"
 #include "../source/util/fileutils.h"
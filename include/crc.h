@@ -20,6 +20,8 @@
 #define __CRC_H__
 
 unsigned int crc32b(unsigned char *message, int len);
+// continues a crc32b hash over more data, start with h=0
+unsigned int crc32bUpdate(unsigned int h, const unsigned char *message, int len);
 unsigned int crc32File(const std::string& filePath);
 
 #endif
\ No newline at end of file
@@ -19,6 +19,36 @@
 #ifndef __KEPOLL_H__
 #define __KEPOLL_H__
 
+class KEPoll;
+
+// One fd registered with an epoll.  Objects that can report their own readiness changes keep a list
+// of these (see KObject::signalEPoll) and push them onto the epoll's ready list, so epoll_wait only
+// has to look at the entries that changed.
+class KEPollEntry {
+public:
+    KEPollEntry(KEPoll* epoll, const std::shared_ptr<KObject>& object, U32 fd) : epoll(epoll), object(object), fd(fd), events(0), data(0), lastEvents(0), disabled(false), polled(false), objectNode(this), readyNode(this) {}
+
+    KEPoll* epoll;
+    std::weak_ptr<KObject> object;
+    U32 fd;
+    U32 events;
+    U64 data;
+    U32 lastEvents; // what the last wait saw, a polled EPOLLET entry is only reported when this changes
+    bool disabled; // EPOLLONESHOT already fired, nothing will be reported until EPOLL_CTL_MOD
+    bool polled; // the object can't signal readiness changes, so it will be checked on every wait
+    KListNode<KEPollEntry*> objectNode;
+    KListNode<KEPollEntry*> readyNode; // in KEPoll::readyList or KEPoll::polledList
+};
+
+// an object that KEPoll::wait holds the locks of while it checks the entries that watch it
+class KEPollWaitObject {
+public:
+    KEPollWaitObject(const std::shared_ptr<KObject>& object, U32 events) : object(object), events(events) {}
+
+    std::shared_ptr<KObject> object;
+    U32 events;
+};
+
 class KEPoll : public KObject {
 public:
     KEPoll();
@@ -47,14 +77,18 @@ public:
 
     U32 ctl(U32 op, FD fd, U32 address);
     U32 wait(U32 events, U32 maxevents, U32 timeout);
+
+    void signalReady(KEPollEntry* entry);
 private:
-    class Data {
-    public:
-        U32 fd;
-        U64 data;
-        U32 events;
-    };
-    std::unordered_map<U32, Data*> data;
+    void removeEntry(KEPollEntry* entry);
+    U32 getReadyEvents(KEPollEntry* entry, const std::shared_ptr<KObject>& object);
+    U32 reportEntry(KEPollEntry* entry, const std::shared_ptr<KObject>& object, U32 events, U32 index);
+    void getWaitObjects(KList<KEPollEntry*>& list, std::vector<KEPollWaitObject>& objects);
+
+    std::unordered_map<U32, KEPollEntry*> entries;
+    KList<KEPollEntry*> readyList;
+    KList<KEPollEntry*> polledList;
+    BOXEDWINE_CONDITION lockCond;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -5,12 +5,15 @@ class KNativeAudio {
 public:
 	static std::shared_ptr<KNativeAudio> createNativeAudio();
 	static void shutdown();
+	// OSS mixer levels (SOUND_MIXER_VOLUME and SOUND_MIXER_PCM), left | right << 8, 0-100, applied to every voice when mixing
+	static U32 getVolume(U32 mixerChannel);
+	static void setVolume(U32 mixerChannel, U32 volume);
 
 	virtual ~KNativeAudio() {}
 	virtual void openAudio(U32 format, U32 freq, U32 channels)=0;
 	virtual bool isOpen()=0;
 	virtual void closeAudio() = 0;
-	virtual void writeAudio(U8* data, U32 len) = 0;
+	virtual U32 writeAudio(U8* data, U32 len) = 0; // returns how many bytes fit in the buffer
 	virtual U32 getFragmentSize() = 0;
 	virtual U32 getBufferSize() = 0;
 	virtual U32 getBufferCapacity() = 0;
@@ -25,6 +25,8 @@ public:
     virtual void waitForEvents(BOXEDWINE_CONDITION& parentCondition, U32 events);
     virtual U32  writeNative(U8* buffer, U32 len);
     virtual U32  readNative(U8* buffer, U32 len);
+    virtual U32  writevNative(KIoVec& io);
+    virtual U32  readvNative(KIoVec& io);
     virtual U32  stat(U32 address, bool is64);
     virtual U32  map(U32 address, U32 len, S32 prot, S32 flags, U64 off);
     virtual bool canMap();
@@ -25,6 +25,46 @@
 #define KTYPE_EPOLL 3
 #define KTYPE_SIGNAL 4
 
+class KEPollEntry;
+
+#define K_IOV_MAX 1024
+// largest amount of guest memory that will be staged through a bounce buffer per host call
+#define K_IO_BOUNCE_SIZE (64*1024)
+
+class KIoSpan {
+public:
+    U8* buffer;
+    U32 len;
+    U32 address;
+    bool bounced;
+};
+
+// A guest buffer or iovec array resolved into host memory so that it can be
+// handed to a single host readv/writev/sendmsg.  Pages that can't be
+// addressed directly are staged through a bounce buffer.
+class KIoVec {
+public:
+    // toHost is true when data flows from guest memory to the object (write)
+    KIoVec(bool toHost) : totalLen(0), toHost(toHost) {}
+
+    void add(U32 address, U32 len);
+    U32 addIov(U32 iov, S32 iovcnt); // returns 0 or -K_EINVAL
+
+    // resolves each window of spans in turn and hands it to io, stops on a short transfer
+    U32 transfer(std::function<U32(KIoVec& io)> io);
+
+    std::vector<KIoSpan> spans; // the current window
+    U32 totalLen;
+
+private:
+    U32 resolve(U32 pos);
+    bool commit(U32 len);
+
+    std::vector<KIoSpan> ranges;
+    std::vector<U8> bounce;
+    bool toHost;
+};
+
 class KObject : public std::enable_shared_from_this<KObject> {
 protected:
     KObject(U32 type);
@@ -48,14 +88,27 @@ public:
     virtual U32  write(U32 buffer, U32 len);
     virtual U32  writeNative(U8* buffer, U32 len)=0;
     virtual U32  writev(U32 iov, S32 iovcnt);
+    virtual U32  writevNative(KIoVec& io); // default calls writeNative for each span
     virtual U32  read(U32 buffer, U32 len);
     virtual U32  readNative(U8* buffer, U32 len)=0;
+    virtual U32  readv(U32 iov, S32 iovcnt);
+    virtual U32  readvNative(KIoVec& io); // default calls readNative for each span
     virtual U32  stat(U32 address, bool is64)=0;
     virtual U32  map(U32 address, U32 len, S32 prot, S32 flags, U64 off)=0;
     virtual bool canMap()=0;
 
+    // epoll instances that are watching this object
+    void addEPollEntry(KEPollEntry* entry);
+    void removeEPollEntry(KEPollEntry* entry);
+    // should be called when the read/write readiness of this object might have changed
+    void signalEPoll();
+
     U32 type;
     U32 pid;
+
+private:
+    BOXEDWINE_MUTEX epollMutex;
+    KList<KEPollEntry*> epollEntries;
 };
 
 #endif
\ No newline at end of file
@@ -120,6 +120,7 @@ public:
 
     std::string getModuleName(U32 eip);
     U32 getModuleEip(U32 eip);    
+    BoxedPtr<MappedFile> getMappedFile(U32 eip);
     KFileDescriptor* allocFileDescriptor(const std::shared_ptr<KObject>& kobject, U32 accessFlags, U32 descriptorFlags, S32 handle, U32 afterHandle);
     KFileDescriptor* getFileDescriptor(FD handle);
     void clearFdHandle(FD handle);
@@ -205,6 +206,7 @@ public:
     U32 utimesat(FD dirfd, const std::string& path, U32 times, U32 flags);
     U32 write(FD fildes, U32 bufferAddress, U32 bufferLen);
     U32 writev(FD handle, U32 iov, S32 iovcnt);
+    U32 readv(FD handle, U32 iov, S32 iovcnt);
     U32 memfd_create(const std::string& name, U32 flags);
 
     user_desc* getLDT(U32 index);
@@ -240,6 +242,7 @@ public:
     U32 phnum;
     U32 phentsize;
     U32 entry;
+    U32 vdsoAddress;
     U32 eventQueueFD;     
     BOXEDWINE_CONDITION exitOrExecCond;
 
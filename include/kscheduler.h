@@ -26,6 +26,8 @@ void terminateCurrentThread(KThread* thread);
 
 void addTimer(KTimer* timer);
 void removeTimer(KTimer* timer);
+// how long until the next timer is due, capped at maxMillies
+U32 getMilliesUntilNextTimer(U32 maxMillies);
 
 bool runSlice();
 void runThreadSlice(KThread* thread);
@@ -36,4 +38,15 @@ void waitForProcessToFinish(const std::shared_ptr<KProcess>& process, KThread* t
 #endif
 U32 getMIPS();
 
+#ifdef BOXEDWINE_CPU_WORKERS
+// called by doMainLoop, count is -workers
+void startCpuWorkers(U32 count);
+void stopCpuWorkers();
+// gives up the kernel lock until the main thread has a thread to run or maxMillies have passed
+void waitForMainThreadWork(U32 maxMillies);
+// returns true if the caller has to stop running the thread so that the main thread can run it
+bool moveToMainThread(KThread* thread);
+bool isThreadRunningOnOtherCpuWorker(KThread* thread);
+#endif
+
 #endif
\ No newline at end of file
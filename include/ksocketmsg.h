@@ -9,11 +9,4 @@ public:
     U32 accessFlags;
 };
 
-
-class KSocketMsg : public BoxedPtrBase {
-public:
-    std::vector<KSocketMsgObject> objects;
-    std::vector<U8> data;
-};
-
 #endif
\ No newline at end of file
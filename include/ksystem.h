@@ -75,9 +75,14 @@ public:
 #endif
 #ifdef BOXEDWINE_MULTI_THREADED
     static U32 cpuAffinityCountForApp;
+    static bool glThread; // OpenGL calls are queued for a render thread, see GlCommandQueue
+#endif
+#ifdef BOXEDWINE_CPU_WORKERS
+    static U32 cpuWorkers; // host threads that run guest threads alongside the main thread, see kscheduler.cpp
 #endif
     static U32 pollRate;
     static bool showWindowImmediately;
+    static std::string decodedBlockCacheDir; // empty if decoded blocks aren't saved between runs
 
     static void init();
 	static void destroy();
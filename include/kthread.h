@@ -39,6 +39,7 @@ public:
 
 class KProcess;
 class Memory;
+class KCpuWorker;
 
 class KThreadGlContext {
 public:
@@ -49,6 +50,22 @@ public:
     bool sharing;
 };
 
+class KThread;
+
+// a thread can only wait on one futex at a time, so each thread owns the node it uses to wait
+class KFutexWaiter {
+public:
+    KFutexWaiter(KThread* thread) : thread(thread), address(0), guestAddress(0), expireTimeInMillies(0), bitset(0), wake(false), node(this), cond("futex") {}
+    KThread* thread;
+    U8* address; // host address, used as the key so that shared memory across processes will work
+    U32 guestAddress; // address passed to the syscall, used to detect a re-entered wait
+    U32 expireTimeInMillies;
+    U32 bitset;
+    bool wake;
+    KListNode<KFutexWaiter*> node;
+    BOXEDWINE_CONDITION cond;
+};
+
 class KThread {
 public:
     KThread(U32 id, const std::shared_ptr<KProcess>& process);
@@ -71,7 +88,7 @@ public:
     void setTLS(struct user_desc* desc);
 
     // syscalls
-    U32 futex(U32 addr, U32 op, U32 value, U32 pTime) ;
+    U32 futex(U32 addr, U32 op, U32 value, U32 pTime, U32 addr2, U32 value3);
     U32 modify_ldt(U32 func, U32 ptr, U32 count);
     U32 signalstack(U32 ss, U32 oss);
     U32 sigprocmask(U32 how, U32 set, U32 oset, U32 sigsetSize);
@@ -136,13 +153,17 @@ public:
     KListNode<KThread*> waitThreadNode;
         
     BoxedWineConditionTimer condTimer;
+#ifdef BOXEDWINE_CPU_WORKERS
+    KCpuWorker* cpuWorker; // set while a cpu worker is running it
+#endif
 #endif
 
     U32 condStartWaitTime;
 private:
     void clearFutexes();
+    U32 futexWait(U32 addr, U8* ramAddress, U32 value, U32 expireTime, U32 bitset);
 
-#ifdef BOXEDWINE_BINARY_TRANSLATOR
+#if defined(BOXEDWINE_BINARY_TRANSLATOR) || defined(BOXEDWINE_CPU_WORKERS)
     THREAD_LOCAL
 #endif
     static KThread* runningThread;
@@ -152,7 +173,7 @@ private:
     struct user_desc tls[TLS_ENTRIES];
     BOXEDWINE_MUTEX tlsMutex;
 
-    static BOXEDWINE_MUTEX futexesMutex;
+    KFutexWaiter futexWaiter;
 };
 
 class ChangeThread {
@@ -32,4 +32,40 @@ public:
 	bool active;
 };
 
+#define K_TIMER_WHEEL_BITS 6
+#define K_TIMER_WHEEL_SLOTS (1 << K_TIMER_WHEEL_BITS)
+#define K_TIMER_WHEEL_LEVELS 4
+
+// Hierarchical timing wheel with 1ms ticks.  Level 0 has a slot for each of
+// the next 64ms, each level above covers 64 times the range of the one below
+// it.  When the lower level wraps around, the next slot of the level above is
+// spread back down, so a timer moves at most K_TIMER_WHEEL_LEVELS times before
+// it fires.  Anything further out than the top level covers (about 4.6 hours)
+// waits in the last top level slot and is placed again when that cascades.
+//
+// add and remove are O(1), run skips over empty slots instead of looking at
+// every timer.
+class KTimerWheel {
+public:
+    KTimerWheel();
+
+    void add(KTimer* timer);
+    void remove(KTimer* timer);
+    // fires every timer with millies<=now
+    void run(U32 now);
+    // returns false if there are no timers
+    bool getNextDeadline(U32* millies);
+    bool isEmpty() {return this->count==0;}
+
+private:
+    void place(KTimer* timer);
+    void cascade(U32 level);
+    void fire(U32 slot);
+
+    KList<KTimer*> slots[K_TIMER_WHEEL_LEVELS][K_TIMER_WHEEL_SLOTS];
+    U64 occupied[K_TIMER_WHEEL_LEVELS]; // bit set if the slot might have timers, cleared when the slot is found empty
+    U32 current; // the next tick to be run, everything before it has fired
+    U32 count;
+};
+
 #endif
\ No newline at end of file
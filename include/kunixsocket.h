@@ -28,6 +28,7 @@ public:
     virtual U32  writev(U32 iov, S32 iovcnt);
     virtual U32  read(U32 buffer, U32 len);
     virtual U32  readNative(U8* buffer, U32 len);
+    virtual U32  readv(U32 iov, S32 iovcnt);
     virtual U32  stat(U32 address, bool is64);
     virtual U32  map(U32 address, U32 len, S32 prot, S32 flags, U64 off);
     virtual bool canMap();
@@ -57,10 +58,27 @@ private:
 
     BOXEDWINE_CONDITION lockCond;
 
-    std::deque<S8> recvBuffer;
-    std::queue<std::shared_ptr<KSocketMsg> > msgs;
+    // a run of the receive stream that was sent as one message, a datagram or a sendmsg with SCM_RIGHTS
+    class KUnixSocketRecord {
+    public:
+        U32 pos; // recvBuffer position of the first byte
+        U32 len;
+        U32 objectCount;
+    };
 
-    U32 internal_write(const std::shared_ptr<KUnixSocketObject>& con, BOXEDWINE_CONDITION& cond, U32 buffer, U32 len);
+    KRingBuffer recvBuffer;
+    // records and objects are consumed from the front and only cleared once empty so that
+    // their storage gets re-used instead of allocating for each message
+    std::vector<KUnixSocketRecord> records;
+    U32 nextRecord;
+    std::vector<KSocketMsgObject> objects;
+    U32 nextObject;
+
+    U32 internal_write(const std::shared_ptr<KUnixSocketObject>& con, KIoVec& io);
+    U32 internal_read(KIoVec& io, U32 control, U32 controlLen, U32* controlWritten);
+    U32 getReceiveLimit(KUnixSocketRecord** record);
+    U32 finishReceive(KUnixSocketRecord* record, U32 len, U32 control, U32 controlLen);
+    U32 writeDgram(U32 buffer, U32 len);
 };
 
 #endif
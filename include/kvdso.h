@@ -0,0 +1,21 @@
+#ifndef __KVDSO_H__
+#define __KVDSO_H__
+
+// The vDSO, the aux vector points glibc at it with AT_SYSINFO_EHDR.  It
+// exports __vdso_clock_gettime, __vdso_clock_gettime64, __vdso_gettimeofday and __vdso_time.
+//
+// The page before the image is a time page that the host keeps up to date.  The guest code
+// reads the time from it and adds how much rdtsc moved since the host wrote it, so the common
+// calls don't need a syscall.  Until the host knows the rdtsc rate, the rate in the time page is
+// 0 and the vDSO just makes the syscall.  Only the x64 binary translator maps it, for the other
+// cpu cores map returns 0 and nothing is added to the aux vector.
+class KVdso {
+public:
+    // maps the time page and the image into the current process, returns the address of the image
+    static U32 map(KThread* thread);
+
+    // refreshes the time page of the thread's process
+    static void update(KThread* thread);
+};
+
+#endif
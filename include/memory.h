@@ -20,20 +20,27 @@
 #define __MEMORY_H__
 
 class KFile;
+class DecodedBlockCache;
 
 class MappedFileCache : public BoxedPtrBase {
 public:
-    MappedFileCache(const std::string& name) : name(name) {}
+    MappedFileCache(const std::string& name) : name(name), decodedBlocks(NULL) {}
     virtual ~MappedFileCache();
     const std::string name;
     std::shared_ptr<KFile> file;
     U8** data;
+    DecodedBlockCache* decodedBlocks; // only created for files mapped with exec
+
 };
 
 #define K_PAGE_SIZE 4096
 #define K_PAGE_MASK 0xFFF
 #define K_PAGE_SHIFT 12
 #define K_NUMBER_OF_PAGES 0x100000
+#define K_MMU_LEAF_SHIFT 10
+#define K_MMU_LEAF_SIZE (1 << K_MMU_LEAF_SHIFT)
+#define K_MMU_LEAF_MASK (K_MMU_LEAF_SIZE-1)
+#define K_MMU_DIR_SIZE (K_NUMBER_OF_PAGES >> K_MMU_LEAF_SHIFT)
 #define K_ROUND_UP_TO_PAGE(x) ((x + 0xFFF) & 0xFFFFF000)
 #define K_MAX_X86_OP_LEN 15
 
@@ -67,7 +74,8 @@ U32 writeNativeString2(U32 address, const char* str, U32 len);
 void writeNativeStringW(U32 address, const char* str);
 U32 getNativeStringLen(U32 address);
 
-void memcopyFromNative(U32 address, const void* p, U32 len);
+// returns false if the host can't write to the range, the soft mmu faults the guest instead
+bool memcopyFromNative(U32 address, const void* p, U32 len);
 void memcopyToNative(U32 address, void* p, U32 len);
 
 class KProcess;
@@ -76,6 +84,7 @@ class Page;
 class CPU;
 class DecodedOp;
 class DecodedBlock;
+class NativeMemoryFile;
 class BtCodeChunk;
 
 typedef void (OPCALL *OpCallback)(CPU* cpu, DecodedOp* op);
@@ -116,18 +125,38 @@ public:
 
 #ifdef BOXEDWINE_DEFAULT_MMU
 private:
-    Page* mmu[K_NUMBER_OF_PAGES];        
-    U8* mmuReadPtr[K_NUMBER_OF_PAGES];
-    U8* mmuWritePtr[K_NUMBER_OF_PAGES];
+    // The page table is a directory of leaves, each leaf covers 4MB of the address space.  Leaves
+    // are only allocated once something is mapped in them, until then the directory entry points
+    // to the shared invalidLeaf.
+    Page** mmu[K_MMU_DIR_SIZE];
+    // flat so that reads and writes are a single lookup, these come from calloc so the host only
+    // backs the parts of them that cover mapped pages
+    U8** mmuReadPtr;
+    U8** mmuWritePtr;
+
+    static Page* invalidLeaf[K_MMU_LEAF_SIZE];
 
 public:
     void setPage(U32 index, Page* page);
-    inline Page* getPage(U32 index) {return this->mmu[index];}
-
-    static Page** currentMMU;
+    inline Page* getPage(U32 index) {return this->mmu[index >> K_MMU_LEAF_SHIFT][index & K_MMU_LEAF_MASK];}
+
+#ifdef BOXEDWINE_CPU_WORKERS
+    // each cpu worker is running its own guest thread
+    THREAD_LOCAL static Memory* currentMemory;
+    THREAD_LOCAL static U8** currentMMUReadPtr;
+    THREAD_LOCAL static U8** currentMMUWritePtr;
+
+    // the guest threads that share this memory, and its code cache, take turns on the cpu worker
+    // whose queue they are scheduled on, see kscheduler.cpp
+    KNativeMutex runMutex;
+    U32 cpuWorker;
+    bool mainThreadOnly; // one of its threads has called into SDL or OpenGL
+#else
+    static Memory* currentMemory;
     static U8** currentMMUReadPtr;
     static U8** currentMMUWritePtr;
 #endif
+#endif
 
 #ifdef BOXEDWINE_DYNAMIC
     std::vector<void*> dynamicExecutableMemory;
@@ -143,6 +172,14 @@ public:
 
     // this will contain id in each page unless that page was mapped to native host memory
     U64 memOffsets[K_NUMBER_OF_PAGES];
+#ifndef BOXEDWINE_MSVC
+    // the host memory files and guest files that committed pages are mapped from, so that
+    // cloneNativeMemory can map them into the child instead of copying.  nativeFiles[0] is unused.
+    std::vector<std::shared_ptr<NativeMemoryFile>> nativeFiles;
+    std::vector<U32> nativeFilePageCount;
+    U16 nativeFileIndex[K_NUMBER_OF_PAGES];
+    U32 nativeMemoryFile; // index of the memory file new anonymous pages are allocated in, 0 if there isn't one yet
+#endif
 #define MAX_DYNAMIC_CODE_PAGE_COUNT 0xFF
     U8 dynamicCodePageUpdateCount[K_NUMBER_OF_PAGES];
 
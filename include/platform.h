@@ -34,6 +34,11 @@
 #define BOXEDWINE_DEFAULT_MMU 1
 #endif
 
+// the single threaded build can spread guest threads over a pool of host threads, see -workers
+#if !defined(BOXEDWINE_MULTI_THREADED) && defined(BOXEDWINE_DEFAULT_MMU) && !defined(BOXEDWINE_DYNAMIC) && !defined(__EMSCRIPTEN__)
+#define BOXEDWINE_CPU_WORKERS 1
+#endif
+
 #ifdef BOXEDWINE_HAS_SETJMP
 #include <setjmp.h>
 #endif
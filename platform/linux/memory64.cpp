@@ -20,48 +20,462 @@
 #include <sys/mman.h>
 #include <string.h>
 #include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "../../source/emulation/hardmmu/hard_memory.h"
 
 U32 nativeMemoryPagesAllocated;
 
 #ifdef BOXEDWINE_64BIT_MMU
-void allocNativeMemory(Memory* memory, U32 page, U32 pageCount, U32 flags) {
-    U32 proto = 0;
-    
-    if ((flags & PAGE_READ) || (flags & PAGE_EXEC)) {
-        proto|=PROT_READ;
+#include <fcntl.h>
+#include <sys/resource.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+// Committed pages are always mapped from a host file.  Anonymous pages live in a memory file at
+// the same offset as their address and are mapped MAP_SHARED while only this Memory uses them.  On
+// fork both sides map those pages MAP_PRIVATE, so the host does the copy on write and nothing is
+// copied up front.  Anything allocated after that goes into a new memory file.
+//
+// So each fork leaves the parent with an old memory file that it still maps pages from.  To keep that
+// from growing without bound, an old file that is down to a few pages has them moved into the current
+// file on the next fork, and once a process has too many old files, or too many memory files are open
+// overall, a fork copies the private pages into the child instead.
+
+// old memory files with at most this many pages left are merged into the current one on the next fork
+#define RETIRED_MEMORY_FILE_MOVE_PAGES 64
+// past this many old memory files a fork copies the private pages
+#define MAX_RETIRED_MEMORY_FILES 32
+
+static std::atomic<U32> memoryFileCount; // each one is a host file descriptor
+
+NativeMemoryFile::~NativeMemoryFile() {
+    if (!this->file) {
+        close(this->handle);
+        memoryFileCount--;
+    }
+}
+
+// leaves most of the file descriptors for guest files and sockets
+static U32 getMemoryFileLimit() {
+    static U32 limit;
+
+    if (!limit) {
+        struct rlimit r;
+        if (getrlimit(RLIMIT_NOFILE, &r)==0 && r.rlim_cur!=RLIM_INFINITY) {
+            limit = (U32)(r.rlim_cur/4);
+        } else {
+            limit = 1024;
+        }
+        if (limit<16) {
+            limit = 16;
+        }
+    }
+    return limit;
+}
+
+static std::shared_ptr<NativeMemoryFile> createMemoryFile() {
+    S32 handle;
+
+#ifdef __linux__
+    handle = (S32)syscall(SYS_memfd_create, "boxedwine", 1); // MFD_CLOEXEC
+#else
+    static U32 nextName;
+    char name[64];
+
+    snprintf(name, sizeof(name), "/boxedwine-%d-%d", (int)getpid(), nextName++);
+    handle = shm_open(name, O_RDWR|O_CREAT|O_EXCL, 0600);
+    if (handle>=0) {
+        shm_unlink(name);
+    }
+#endif
+    if (handle<0 || ftruncate(handle, 0x100000000l)) {
+        kpanic("createMemoryFile failed: %s", strerror(errno));
+    }
+    memoryFileCount++;
+    return std::make_shared<NativeMemoryFile>(handle, nullptr, 0);
+}
+
+// gives the pages back to the host, after this they read as zero.  Returns false if the host can't.
+static bool zeroMemoryFile(const std::shared_ptr<NativeMemoryFile>& file, U32 page, U32 pageCount) {
+#ifdef __linux__
+    return fallocate(file->handle, FALLOC_FL_PUNCH_HOLE|FALLOC_FL_KEEP_SIZE, (U64)page << K_PAGE_SHIFT, (U64)pageCount << K_PAGE_SHIFT)==0;
+#else
+    return false;
+#endif
+}
+
+// returns 0 if nativeFileIndex can't hold another one
+static U32 addNativeFile(Memory* memory, const std::shared_ptr<NativeMemoryFile>& file) {
+    for (U32 i=1;i<memory->nativeFiles.size();i++) {
+        if (!memory->nativeFiles[i]) {
+            memory->nativeFiles[i] = file;
+            return i;
+        }
+    }
+    if (memory->nativeFiles.size()>0xFFFF) {
+        return 0;
+    }
+    memory->nativeFiles.push_back(file);
+    memory->nativeFilePageCount.push_back(0);
+    return (U32)memory->nativeFiles.size()-1;
+}
+
+static void releaseNativeFile(Memory* memory, U32 index) {
+    memory->nativeFiles[index] = nullptr;
+    if (index==memory->nativeMemoryFile) {
+        memory->nativeMemoryFile = 0;
+    }
+}
+
+static void setNativeFile(Memory* memory, U32 page, U32 index) {
+    U32 old = memory->nativeFileIndex[page];
+
+    if (old==index) {
+        return;
+    }
+    // the current memory file is kept even when it is empty, the next allocation will probably need it
+    if (old && --memory->nativeFilePageCount[old]==0 && old!=memory->nativeMemoryFile) {
+        releaseNativeFile(memory, old);
+    }
+    if (index) {
+        memory->nativeFilePageCount[index]++;
+    }
+    memory->nativeFileIndex[page] = (U16)index;
+}
+
+// after this new anonymous pages will go into a new memory file
+static void retireMemoryFile(Memory* memory) {
+    U32 index = memory->nativeMemoryFile;
+
+    if (index) {
+        memory->nativeMemoryFile = 0;
+        if (!memory->nativeFilePageCount[index]) {
+            releaseNativeFile(memory, index);
+        }
+    }
+}
+
+// Forgets the files behind the committed pages in the range.  If unmap is true an inaccessible
+// anonymous mapping is put over them, so that the host file is no longer referenced and nothing
+// written to these pages from now on can end up in it.
+static void releaseNativePages(Memory* memory, U32 page, U32 pageCount, bool unmap) {
+    U32 i = 0;
+
+    while (i<pageCount) {
+        U32 index = memory->nativeFileIndex[page+i];
+        if (!index) {
+            i++;
+            continue;
+        }
+        U32 start = i;
+        while (i<pageCount && memory->nativeFileIndex[page+i]==index) {
+            i++;
+        }
+        const std::shared_ptr<NativeMemoryFile>& file = memory->nativeFiles[index];
+        // if no other process maps this memory file then nothing else can see these pages
+        if (!file->file && file.use_count()==1) {
+            zeroMemoryFile(file, page+start, i-start);
+        }
+        if (unmap) {
+            void* p = (char*)memory->id + ((page+start) << K_PAGE_SHIFT);
+            if (mmap(p, (i-start) << K_PAGE_SHIFT, PROT_NONE, MAP_ANONYMOUS|MAP_FIXED|MAP_PRIVATE, -1, 0)!=p) {
+                kpanic("releaseNativePages mmap failed: %s", strerror(errno));
+            }
+        }
+        for (U32 j=start;j<i;j++) {
+            memory->nativeFlags[page+j] &= ~(NATIVE_FLAG_FILE_MAPPED|NATIVE_FLAG_HOST_SHARED|NATIVE_FLAG_HOST_READONLY);
+            setNativeFile(memory, page+j, 0);
+        }
     }
-    if (flags & PAGE_WRITE) {
-        proto|=PROT_WRITE;
+}
+
+static U32 getMemoryFile(Memory* memory) {
+    if (!memory->nativeMemoryFile) {
+        memory->nativeMemoryFile = addNativeFile(memory, createMemoryFile());
+        if (!memory->nativeMemoryFile) {
+            kpanic("getMemoryFile: too many host mappings");
+        }
     }
+    return memory->nativeMemoryFile;
+}
+
+void allocNativeMemory(Memory* memory, U32 page, U32 pageCount, U32 flags) {
+    releaseNativePages(memory, page, pageCount, false);
+    U32 index = getMemoryFile(memory);
+    const std::shared_ptr<NativeMemoryFile>& file = memory->nativeFiles[index];
+    // whatever an earlier page at this address left in the memory file has to go first
+    bool zeroed = zeroMemoryFile(file, page, pageCount);
     void* p = (char*)memory->id + (page << K_PAGE_SHIFT);
-    if (mprotect(p, pageCount << K_PAGE_SHIFT, PAGE_READ|PROT_WRITE)<0) {
-        kpanic("allocNativeMemory mprotect failed: %s", strerror(errno));
+
+    if (mmap(p, pageCount << K_PAGE_SHIFT, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_FIXED, file->handle, (U64)page << K_PAGE_SHIFT)!=p) {
+        kpanic("allocNativeMemory mmap failed: %s", strerror(errno));
     }
     memory->allocated += pageCount<< K_PAGE_SHIFT;
     for (int i=0;i<(int)pageCount;i++) {
         memory->flags[page+i] = flags |= PAGE_ALLOCATED;
-        memory->nativeFlags[page+i] |= NATIVE_FLAG_COMMITTED;
+        memory->nativeFlags[page+i] |= NATIVE_FLAG_COMMITTED | NATIVE_FLAG_HOST_SHARED;
+        setNativeFile(memory, page+i, index);
+    }
+    if (!zeroed) {
+        memset(p, 0, pageCount << K_PAGE_SHIFT);
     }
-    memset(getNativeAddress(memory, page << K_PAGE_SHIFT), 0, pageCount << K_PAGE_SHIFT);
     nativeMemoryPagesAllocated+=pageCount;
 }
 
-void freeNativeMemory(Memory* memory, U32 page, U32 pageCount) {
-    for (int i=0;i<(int)pageCount;i++) {
-        if (memory->nativeFlags[page+i] & NATIVE_FLAG_CODEPAGE_READONLY) {
-            memory->nativeFlags[page+i] &= ~ NATIVE_FLAG_CODEPAGE_READONLY;
+bool mapNativeFile(Memory* memory, U32 page, U32 pageCount, U32 flags, const std::shared_ptr<KFile>& file, U64 offset) {
+    static const U32 hostPageSize = (U32)sysconf(_SC_PAGESIZE);
+    struct stat buf;
+    S32 handle = file->openFile->getNativeHandle();
+
+    if (handle<0 || hostPageSize!=K_PAGE_SIZE || (offset & K_PAGE_MASK) || fstat(handle, &buf) || !S_ISREG(buf.st_mode) || (U64)buf.st_size<=offset) {
+        return false;
+    }
+    // touching a host page past the end of the file would raise SIGBUS, so only pages that have file data behind them are mapped
+    U64 filePageCount = ((U64)buf.st_size-offset+K_PAGE_SIZE-1) >> K_PAGE_SHIFT;
+    U32 mappedPageCount = (filePageCount<pageCount?(U32)filePageCount:pageCount);
+    void* p = (char*)memory->id + (page << K_PAGE_SHIFT);
+    // with no room for another file the caller reads the file into anonymous memory instead
+    U32 index = addNativeFile(memory, std::make_shared<NativeMemoryFile>(handle, file, (S64)offset-((S64)page << K_PAGE_SHIFT)));
+
+    if (!index) {
+        return false;
+    }
+    // Only writable on the host if the guest can write to it, so that the guest can't change a read only
+    // shared mapping and a read only file can be mapped shared.  widenNativeFilePage adds PROT_WRITE later.
+    if (mmap(p, mappedPageCount << K_PAGE_SHIFT, PROT_READ|((flags & PAGE_WRITE)?PROT_WRITE:0), ((flags & PAGE_SHARED)?MAP_SHARED:MAP_PRIVATE)|MAP_FIXED, handle, offset)!=p) {
+        // for example a shared writable mapping of a file that was opened read only, the old pages are still in place
+        releaseNativeFile(memory, index);
+        return false;
+    }
+    releaseNativePages(memory, page, mappedPageCount, false);
+    memory->allocated += mappedPageCount << K_PAGE_SHIFT;
+    for (U32 i=0;i<mappedPageCount;i++) {
+        memory->flags[page+i] = flags | PAGE_ALLOCATED;
+        memory->nativeFlags[page+i] |= NATIVE_FLAG_COMMITTED | NATIVE_FLAG_FILE_MAPPED;
+        if (flags & PAGE_SHARED) {
+            memory->nativeFlags[page+i] |= NATIVE_FLAG_HOST_SHARED;
         }
-        if (memory->nativeFlags[page+i] & NATIVE_FLAG_COMMITTED) {
-            memory->nativeFlags[page+i] &= ~ NATIVE_FLAG_COMMITTED;
-            mprotect((char*)memory->id + ((page+i) << K_PAGE_SHIFT), 1 << K_PAGE_SHIFT, PROT_NONE);
+        if (!(flags & PAGE_WRITE)) {
+            memory->nativeFlags[page+i] |= NATIVE_FLAG_HOST_READONLY;
         }
+        setNativeFile(memory, page+i, index);
+    }
+    nativeMemoryPagesAllocated+=mappedPageCount;
+    if (mappedPageCount<pageCount) {
+        allocNativeMemory(memory, page+mappedPageCount, pageCount-mappedPageCount, flags);
+    }
+    return true;
+}
+
+bool widenNativeFilePage(Memory* memory, U32 page, bool emulator) {
+    U8 nativeFlags = memory->nativeFlags[page];
+    void* p = (char*)memory->id + (page << K_PAGE_SHIFT);
+
+    if (!(nativeFlags & NATIVE_FLAG_HOST_READONLY)) {
+        return false;
+    }
+    // the emulator may write to a private read only page, that only changes this process's copy, but a
+    // shared one is the file itself and only the guest can make it writable
+    if (!(memory->flags[page] & PAGE_WRITE) && (!emulator || (nativeFlags & NATIVE_FLAG_HOST_SHARED))) {
+        return false;
+    }
+    // a shared mapping of a file that was opened read only can't be written to at all
+    if (mprotect(p, K_PAGE_SIZE, PROT_READ|PROT_WRITE)) {
+        return false;
+    }
+    // clearCodePageReadOnly will make it writable once the code on it is dealt with
+    if ((nativeFlags & NATIVE_FLAG_CODEPAGE_READONLY) && mprotect(p, K_PAGE_SIZE, PROT_READ)) {
+        kpanic("widenNativeFilePage mprotect failed: %s", strerror(errno));
+    }
+    memory->nativeFlags[page] &= ~NATIVE_FLAG_HOST_READONLY;
+    return true;
+}
+
+void freeNativeMemory(Memory* memory, U32 page, U32 pageCount) {
+    releaseNativePages(memory, page, pageCount, true);
+    for (int i=0;i<(int)pageCount;i++) {
+        memory->nativeFlags[page+i] &= ~(NATIVE_FLAG_CODEPAGE_READONLY | NATIVE_FLAG_COMMITTED);
         memory->flags[page+i] = 0;
     }
     nativeMemoryPagesAllocated-=pageCount;
 }
 
+// marks the pages in the range that were written to since they were mapped MAP_PRIVATE, those no longer match the file behind them
+static void getDirtyPages(Memory* memory, U32 page, U32 pageCount, std::vector<U64>& dirty) {
+    dirty.resize(pageCount);
+#ifdef __linux__
+    static S32 pagemap = open("/proc/self/pagemap", O_RDONLY|O_CLOEXEC);
+    U64 hostPage = ((U64)memory->id >> K_PAGE_SHIFT) + page;
+
+    if (pagemap>=0 && pread(pagemap, dirty.data(), pageCount*sizeof(U64), hostPage*sizeof(U64))==(ssize_t)(pageCount*sizeof(U64))) {
+        for (U32 i=0;i<pageCount;i++) {
+            U64 entry = dirty[i];
+            bool present = (entry >> 63) & 1;
+            bool swapped = (entry >> 62) & 1;
+            bool filePage = (entry >> 61) & 1;
+            // a page that was never touched or is still the file's page is clean
+            dirty[i] = swapped || (present && !filePage);
+        }
+        return;
+    }
+#endif
+    for (U32 i=0;i<pageCount;i++) {
+        dirty[i] = 1;
+    }
+}
+
+static void mapNativePages(Memory* memory, U32 page, U32 pageCount, U32 index, bool shared, bool readOnly) {
+    const std::shared_ptr<NativeMemoryFile>& file = memory->nativeFiles[index];
+    void* p = (char*)memory->id + (page << K_PAGE_SHIFT);
+
+    if (mmap(p, pageCount << K_PAGE_SHIFT, PROT_READ|(readOnly?0:PROT_WRITE), (shared?MAP_SHARED:MAP_PRIVATE)|MAP_FIXED, file->handle, file->offset+((S64)page << K_PAGE_SHIFT))!=p) {
+        kpanic("mapNativePages mmap failed: %s", strerror(errno));
+    }
+}
+
+// Writes the pages as they are now into the current memory file and maps them from there, so that
+// the old memory file they came from can be closed once nothing maps it anymore.
+static void moveToMemoryFile(Memory* memory, U32 page, U32 pageCount) {
+    U32 index = getMemoryFile(memory);
+    const std::shared_ptr<NativeMemoryFile>& file = memory->nativeFiles[index];
+    void* p = (char*)memory->id + (page << K_PAGE_SHIFT);
+    U32 len = pageCount << K_PAGE_SHIFT;
+
+    if (pwrite(file->handle, p, len, (U64)page << K_PAGE_SHIFT)!=(ssize_t)len) {
+        kpanic("moveToMemoryFile pwrite failed: %s", strerror(errno));
+    }
+    mapNativePages(memory, page, pageCount, index, true, (memory->nativeFlags[page] & NATIVE_FLAG_CODEPAGE_READONLY)!=0);
+    for (U32 i=0;i<pageCount;i++) {
+        memory->nativeFlags[page+i] |= NATIVE_FLAG_HOST_SHARED;
+        setNativeFile(memory, page+i, index);
+    }
+}
+
+static bool isSmallRetiredMemoryFile(Memory* memory, U32 index) {
+    return index!=memory->nativeMemoryFile && !memory->nativeFiles[index]->file && memory->nativeFilePageCount[index]<=RETIRED_MEMORY_FILE_MOVE_PAGES;
+}
+
+// Whether a fork can share the private pages in memory's current memory file copy on write, which
+// means memory has to retire that file.  If not they are copied into the child.
+static bool canRetireMemoryFile(Memory* memory) {
+    U32 retired = 0;
+
+    for (U32 i=1;i<memory->nativeFiles.size();i++) {
+        if (i!=memory->nativeMemoryFile && memory->nativeFiles[i] && !memory->nativeFiles[i]->file) {
+            retired++;
+        }
+    }
+    return retired<MAX_RETIRED_MEMORY_FILES && memoryFileCount<getMemoryFileLimit();
+}
+
+// maps pages that from has mapped from the same file, with the same flags, into memory
+static void cloneNativePages(Memory* memory, Memory* from, U32 page, U32 pageCount, std::vector<U32>& indexes, std::vector<U64>& dirty, bool retire) {
+    U32 fromIndex = from->nativeFileIndex[page];
+    U8 fromNativeFlags = from->nativeFlags[page];
+    bool hostShared = (fromNativeFlags & NATIVE_FLAG_HOST_SHARED)!=0;
+    bool shared = hostShared && (from->flags[page] & PAGE_SHARED);
+    U32 index = 0;
+
+    // moveToMemoryFile can add the current memory file after indexes was sized
+    if (fromIndex>=indexes.size()) {
+        indexes.resize(from->nativeFiles.size(), 0);
+    }
+    if (!hostShared || shared || retire) {
+        if (!indexes[fromIndex]) {
+            indexes[fromIndex] = addNativeFile(memory, from->nativeFiles[fromIndex]);
+        }
+        index = indexes[fromIndex];
+    }
+    if (!index) {
+        // from keeps writing to its memory file, or memory has no room for another file.  In the
+        // second case a MAP_SHARED page stops being shared, that takes 0xFFFF mapped files though.
+        dirty.assign(pageCount, 1);
+    } else if (hostShared && !shared) {
+        // private pages in from's memory file, from has to stop writing to the file too
+        mapNativePages(from, page, pageCount, fromIndex, false, (fromNativeFlags & NATIVE_FLAG_CODEPAGE_READONLY)!=0);
+        for (U32 i=0;i<pageCount;i++) {
+            from->nativeFlags[page+i] &= ~NATIVE_FLAG_HOST_SHARED;
+        }
+        dirty.assign(pageCount, 0);
+    } else if (!shared) {
+        getDirtyPages(from, page, pageCount, dirty);
+    } else {
+        dirty.assign(pageCount, 0);
+    }
+
+    U32 i = 0;
+    while (i<pageCount) {
+        U32 start = i;
+        U64 isDirty = dirty[i];
+        while (i<pageCount && dirty[i]==isDirty) {
+            i++;
+        }
+        if (isDirty) {
+            // only from has these, they have to be copied
+            allocNativeMemory(memory, page+start, i-start, from->flags[page+start]);
+            memcpy(getNativeAddress(memory, (page+start) << K_PAGE_SHIFT), getNativeAddress(from, (page+start) << K_PAGE_SHIFT), (i-start) << K_PAGE_SHIFT);
+            for (U32 j=page+start;j<page+i;j++) {
+                memory->flags[j] = from->flags[j];
+            }
+            continue;
+        }
+        mapNativePages(memory, page+start, i-start, index, shared, (fromNativeFlags & NATIVE_FLAG_HOST_READONLY)!=0);
+        memory->allocated += (i-start) << K_PAGE_SHIFT;
+        for (U32 j=page+start;j<page+i;j++) {
+            memory->flags[j] = from->flags[j];
+            memory->nativeFlags[j] = (memory->nativeFlags[j] & ~(NATIVE_FLAG_FILE_MAPPED|NATIVE_FLAG_HOST_SHARED|NATIVE_FLAG_HOST_READONLY)) | NATIVE_FLAG_COMMITTED | (fromNativeFlags & (NATIVE_FLAG_FILE_MAPPED|NATIVE_FLAG_HOST_READONLY)) | (shared?NATIVE_FLAG_HOST_SHARED:0);
+            setNativeFile(memory, j, index);
+        }
+        nativeMemoryPagesAllocated+=i-start;
+    }
+    if (index && !memory->nativeFilePageCount[index]) {
+        // every page was copied
+        releaseNativeFile(memory, index);
+        indexes[fromIndex] = 0;
+    }
+}
+
+void cloneNativeMemory(Memory* memory, Memory* from) {
+    std::vector<U32> indexes(from->nativeFiles.size(), 0); // from's index -> memory's index
+    std::vector<U64> dirty;
+    bool retire = canRetireMemoryFile(from);
+    const U8 mask = NATIVE_FLAG_FILE_MAPPED|NATIVE_FLAG_HOST_SHARED|NATIVE_FLAG_HOST_READONLY|NATIVE_FLAG_CODEPAGE_READONLY;
+    U32 i = 0;
+
+    memcpy(memory->flags, from->flags, sizeof(memory->flags));
+    while (i<K_NUMBER_OF_PAGES) {
+        U64 next;
+        // most of the address space is empty, skip it 4 pages at a time
+        memcpy(&next, &from->nativeFileIndex[i], sizeof(next));
+        if (!next) {
+            i+=4;
+            continue;
+        }
+        U32 index = from->nativeFileIndex[i];
+        if (!index || !from->isPageAllocated(i)) {
+            i++;
+            continue;
+        }
+        U32 start = i;
+        U8 nativeFlags = from->nativeFlags[i] & mask;
+        U32 shared = from->flags[i] & PAGE_SHARED;
+        while (i<K_NUMBER_OF_PAGES && from->isPageAllocated(i) && from->nativeFileIndex[i]==index && (from->nativeFlags[i] & mask)==nativeFlags && (from->flags[i] & PAGE_SHARED)==shared) {
+            i++;
+        }
+        if (retire && !(nativeFlags & (NATIVE_FLAG_FILE_MAPPED|NATIVE_FLAG_HOST_SHARED)) && isSmallRetiredMemoryFile(from, index)) {
+            moveToMemoryFile(from, start, i-start);
+        }
+        cloneNativePages(memory, from, start, i-start, indexes, dirty, retire);
+    }
+    // the pages memory copied are in its own memory file, nothing else maps that one
+    if (retire) {
+        retireMemoryFile(from);
+    }
+}
+
 static U64 nextMemoryId = 2;
 #include <unistd.h>
 #include <sys/mman.h>
@@ -180,6 +594,10 @@ static void* reserveNext32GBMemory() {
 
 void reserveNativeMemory(Memory* memory) {
     memory->id = (U64)reserveNext4GBMemory();
+    memory->nativeFiles.resize(1);
+    memory->nativeFilePageCount.resize(1);
+    memset(memory->nativeFileIndex, 0, sizeof(memory->nativeFileIndex));
+    memory->nativeMemoryFile = 0;
     for (int i = 0; i < K_NUMBER_OF_PAGES; i++) {
         memory->memOffsets[i] = memory->id;
     }
@@ -200,6 +618,9 @@ void releaseNativeMemory(Memory* memory) {
     memset(memory->nativeFlags, 0, sizeof(memory->nativeFlags));
     memory->allocated = 0;
     munmap((char*)memory->id, 0x100000000l);
+    memory->nativeFiles.clear();
+    memory->nativeFilePageCount.clear();
+    memory->nativeMemoryFile = 0;
 #ifdef BOXEDWINE_BINARY_TRANSLATOR
     if (memory->eipToHostInstructionAddressSpaceMapping) {
         munmap((char*)memory->eipToHostInstructionAddressSpaceMapping, 0x800000000l);
@@ -224,7 +645,8 @@ bool clearCodePageReadOnly(Memory* memory, U32 page) {
     bool result = false;
     
     if (memory->nativeFlags[page] & NATIVE_FLAG_CODEPAGE_READONLY) {
-        if (mprotect((char*)memory->id + (page << K_PAGE_SHIFT), 1 << K_PAGE_SHIFT, PROT_READ|PROT_WRITE)==-1) {
+        // a file page the guest can't write to stays read only
+        if (!(memory->nativeFlags[page] & NATIVE_FLAG_HOST_READONLY) && mprotect((char*)memory->id + (page << K_PAGE_SHIFT), 1 << K_PAGE_SHIFT, PROT_READ|PROT_WRITE)==-1) {
             kpanic("clearCodePageReadOnly mprotect failed: %s", strerror(errno));
         }
         memory->nativeFlags[page] &= ~NATIVE_FLAG_CODEPAGE_READONLY;
@@ -288,6 +710,9 @@ static void handler(int sig, siginfo_t* info, void* context)
 #else
         bool readAccess = (((ucontext_t*)context)->uc_mcontext.gregs[REG_ERR] & 1) == 0;
 #endif
+        if (!readAccess && widenNativeFilePage(thread->process->memory, address>>K_PAGE_SHIFT, false)) {
+            return;
+        }
         if (info->si_code==SEGV_MAPERR) {
             thread->seg_mapper(address, readAccess, !readAccess, true);
         } else {
@@ -3,11 +3,58 @@
 #include <SDL.h>
 #include "../../source/kernel/devs/oss.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BOXEDWINE_MIX_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define BOXEDWINE_MIX_NEON
+#endif
+
 // Perhaps in the future, this class and devdsp.cpp will go away and instead I will replace the oss interface Wine uses in wineoss.drv with a custom one, like what I did with winex11.drv
 #define DSP_BUFFER_SIZE (1024*256)
+// how many fragments the ring between the emulator and the sdl audio thread holds
+#define DSP_BUFFER_FRAGMENTS 8
+
+// every voice is converted to this format and then they are all summed together
+#define MIX_FREQ 44100
+#define MIX_CHANNELS 2
+#ifdef __EMSCRIPTEN__
+#define MIX_SAMPLES 8192 //Must be pow of 2
+#else
+#define MIX_SAMPLES 4096
+#endif
 
 static bool sdlAudioOpen;
-static U8 sdlSilence;
+static SDL_AudioSpec sdlMix;
+static std::vector<U8> sdlMixBuffer;
+
+// OSS mixer levels, left in the low byte and right in the next, 0 to 100
+static std::atomic<U32> mixerVolume(100 | (100 << 8));
+static std::atomic<U32> mixerPcm(100 | (100 << 8));
+
+void audioCallback(void* userdata, U8* stream, S32 len);
+
+static bool openSdlAudio() {
+	if (sdlAudioOpen) {
+		return true;
+	}
+	memset(&sdlMix, 0, sizeof(sdlMix));
+	sdlMix.format = AUDIO_S16SYS;
+	sdlMix.freq = MIX_FREQ;
+	sdlMix.channels = MIX_CHANNELS;
+	sdlMix.samples = MIX_SAMPLES;
+	sdlMix.callback = audioCallback;
+	// without an obtained spec SDL will convert to the real device format for us, so the mixer only deals with S16 stereo
+	if (SDL_OpenAudio(&sdlMix, NULL) < 0) {
+		printf("Failed to open audio: %s\n", SDL_GetError());
+		return false;
+	}
+	sdlMixBuffer.resize(sdlMix.size);
+	sdlAudioOpen = true;
+	SDL_PauseAudio(0);
+	return true;
+}
 
 void closeSdlAudio() {
 	if (sdlAudioOpen) {
@@ -19,28 +66,18 @@ void closeSdlAudio() {
 
 class KNativeAudioSdl : public KNativeAudio, public std::enable_shared_from_this<KNativeAudioSdl> {
 public:
-	KNativeAudioSdl() : bufferCond("KNativeAudioSdl::bufferCond") {
+	KNativeAudioSdl() {
 		memset(&this->want, 0, sizeof(this->want));
-		memset(&this->got, 0, sizeof(this->got));
+		memset(&this->cvt, 0, sizeof(this->cvt));
 		this->cvtBufLen = 0;
 		this->cvtBuf = NULL;
 		this->cvtBufPos = 0;
+		this->cvtChunk = 0;
 		this->want.format = AUDIO_U8;
 		this->want.channels = 1;
 		this->want.freq = 11025;
-#ifdef __EMSCRIPTEN__
-		this->want.samples = 8192; //Must be pow of 2
-#else
-		this->want.samples = 5512;
-#endif
-		this->got.channels = 1;
-		this->got.freq = 11025;
-#ifdef __EMSCRIPTEN__
-		this->got.samples = 8192; //Must be pow of 2
-#else
-		this->got.samples = 5512;
-#endif
 		this->sameFormat = false;
+		this->dspFragSize = MIX_SAMPLES * 11025 / MIX_FREQ;
 		this->open = false;
 		this->closeWhenDone = false;
 	}
@@ -54,13 +91,14 @@ public:
 	virtual void openAudio(U32 format, U32 freq, U32 channels);
 	virtual bool isOpen() { return this->open; }
 	virtual void closeAudio();
-	virtual void writeAudio(U8* data, U32 len);
-	virtual U32 getFragmentSize() {return this->got.samples;}
-	virtual U32 getBufferSize() {return (U32)this->audioBuffer.size();}
-	virtual U32 getBufferCapacity() { return DSP_BUFFER_SIZE;}
+	virtual U32 writeAudio(U8* data, U32 len);
+	virtual U32 getFragmentSize() {return this->dspFragSize;}
+	virtual U32 getBufferSize() {return this->audioBuffer.size();}
+	virtual U32 getBufferCapacity() {return this->audioBuffer.capacity() ? this->audioBuffer.capacity() : DSP_BUFFER_SIZE;}
 
 	void onClose();
-	void closeAudioFromAudioThread();
+	bool isDrained() {return this->audioBuffer.isEmpty() && (this->cvtBufPos == 0 || this->cvtBufPos >= this->cvt.len_cvt);}
+	U32 fill(U8* stream, U32 len);
 
 	U32 bytesPerSampleWant() {
 		if (this->want.format == AUDIO_S16LSB || this->want.format == AUDIO_S16MSB || this->want.format == AUDIO_U16LSB || this->want.format == AUDIO_U16MSB)
@@ -77,7 +115,7 @@ public:
 		case AFMT_A_LAW:
 		case AFMT_IMA_ADPCM:
 		case AFMT_U8:
-			return AUDIO_U8;		
+			return AUDIO_U8;
 		case AFMT_S16_LE:
 			return AUDIO_S16LSB;
 		case AFMT_S16_BE:
@@ -96,129 +134,160 @@ public:
 		}
 	}
 	SDL_AudioSpec want;
-	SDL_AudioSpec got;
 	SDL_AudioCVT cvt;
 	int cvtBufLen;
 	int cvtBufPos;
 	unsigned char* cvtBuf;
+	U32 cvtChunk; // how many bytes in the want format are converted per callback
 	bool sameFormat;
 	U32 dspFragSize;
 	bool open;
-	std::deque<U8> audioBuffer;
-	BOXEDWINE_CONDITION bufferCond;
+	KSpscRingBuffer audioBuffer; // written by the emulator, read by the sdl audio thread
 	bool closeWhenDone;
 };
 
-// not really a voice, currently they are not mixed
+// only touched by the emulator while holding SDL_LockAudio, the audio callback already holds it
 std::list<std::shared_ptr<KNativeAudioSdl>> voices;
 
-void audioCallback(void* userdata, U8* stream, S32 len) {	
-	if (!voices.size()) {
-		memset(stream, sdlSilence, len);
-		return;
-	}
-	std::shared_ptr<KNativeAudioSdl> data = voices.front();
-	if (data->closeWhenDone && data->audioBuffer.size()==0 && (data->cvtBufPos == 0 || data->cvtBufPos >= data->cvt.len_cvt)) {
-		data->closeAudioFromAudioThread();
-		memset(stream, sdlSilence, len);
-		return;
-	}
+// converts up to len bytes of this voice into the mix format, returns how many bytes were written
+U32 KNativeAudioSdl::fill(U8* stream, U32 len) {
+	U32 result = 0;
+	S32 available = (S32)this->audioBuffer.size();
 
-	S32 available = (S32)data->audioBuffer.size();
-
-	if (!data->sameFormat) {
-		if (data->cvtBufPos < data->cvt.len_cvt) {
-			S32 todo = data->cvt.len_cvt - data->cvtBufPos;
+	if (!this->sameFormat) {
+		if (this->cvtBufPos < this->cvt.len_cvt) {
+			U32 todo = this->cvt.len_cvt - this->cvtBufPos;
 			if (todo > len)
 				todo = len;
-			memcpy(stream, data->cvt.buf + data->cvtBufPos, todo);
-			data->cvtBufPos += todo;
-			stream += todo;
-			len -= todo;
+			memcpy(stream, this->cvt.buf + this->cvtBufPos, todo);
+			this->cvtBufPos += todo;
+			result += todo;
 		}
-		if (len) {
-			data->cvt.len = available;
-			if (data->cvtBufLen && data->cvtBufLen < data->cvt.len * data->cvt.len_mult) {
-				data->cvtBufLen = 0;
-				SDL_free(data->cvtBuf);
-				data->cvtBuf = NULL;
-			}
-			if (!data->cvtBufLen) {
-				data->cvtBufLen = data->cvt.len * data->cvt.len_mult;
-				data->cvtBuf = (Uint8*)SDL_malloc(data->cvt.len * data->cvt.len_mult);
-			}
-			data->cvt.buf = data->cvtBuf;
-
-			std::copy(data->audioBuffer.begin(), data->audioBuffer.begin() + available, data->cvt.buf);
-			data->audioBuffer.erase(data->audioBuffer.begin(), data->audioBuffer.begin() + available);
-
-			SDL_ConvertAudio(&data->cvt);
-			S32 todo = data->cvt.len_cvt;
-			if (todo > len)
-				todo = len;
-			memcpy(stream, data->cvt.buf, todo);
-			stream += todo;
-			len -= todo;
-			data->cvtBufPos = todo;
+		if (available > (S32)this->cvtChunk)
+			available = this->cvtChunk;
+		// SDL_ConvertAudio only works on whole frames
+		available -= available % (this->bytesPerSampleWant() * this->want.channels);
+		if (result < len && available) {
+			this->cvt.buf = this->cvtBuf;
+			this->cvt.len = this->audioBuffer.read(this->cvt.buf, available);
+			SDL_ConvertAudio(&this->cvt);
+			U32 todo = this->cvt.len_cvt;
+			if (todo > len - result)
+				todo = len - result;
+			memcpy(stream + result, this->cvt.buf, todo);
+			result += todo;
+			this->cvtBufPos = todo;
 		}
 	} else {
-		if (available > len)
+		if (available > (S32)len)
 			available = len;
 		if (available) {
-			std::copy(data->audioBuffer.begin(), data->audioBuffer.begin() + available, stream);
-			data->audioBuffer.erase(data->audioBuffer.begin(), data->audioBuffer.begin() + available);
-			len -= available;
-			stream += available;
+			result = this->audioBuffer.read(stream, available);
 		}
 	}
-	if (len) {
-		memset(stream, data->got.silence, len);
+	return result;
+}
+
+static S16 getMixVolume(U32 shift) {
+	U32 level = ((mixerVolume.load(std::memory_order_relaxed) >> shift) & 0xFF) * ((mixerPcm.load(std::memory_order_relaxed) >> shift) & 0xFF);
+	if (level >= 100 * 100)
+		return 0x7FFF;
+	return (S16)(level * 0x7FFF / (100 * 100));
+}
+
+// dst += src * volume, volume is Q15 and alternates left/right, the sum saturates
+static void mixS16(S16* dst, const S16* src, U32 count, S16 left, S16 right) {
+	U32 i = 0;
+#if defined(BOXEDWINE_MIX_SSE2)
+	__m128i volume = _mm_setr_epi16(left, right, left, right, left, right, left, right);
+	for (; i + 8 <= count; i += 8) {
+		__m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+		s = _mm_mulhi_epi16(s, volume);
+		s = _mm_adds_epi16(s, s);
+		__m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+		_mm_storeu_si128((__m128i*)(dst + i), _mm_adds_epi16(d, s));
 	}
+#elif defined(BOXEDWINE_MIX_NEON)
+	const S16 lr[8] = {left, right, left, right, left, right, left, right};
+	int16x8_t volume = vld1q_s16(lr);
+	for (; i + 8 <= count; i += 8) {
+		int16x8_t s = vqdmulhq_s16(vld1q_s16(src + i), volume);
+		vst1q_s16(dst + i, vqaddq_s16(vld1q_s16(dst + i), s));
+	}
+#endif
+	for (; i < count; i++) {
+		S32 s = dst[i] + (((S32)src[i] * ((i & 1) ? right : left)) >> 15);
+		if (s > 32767)
+			s = 32767;
+		else if (s < -32768)
+			s = -32768;
+		dst[i] = (S16)s;
+	}
+}
 
-	BOXEDWINE_CONDITION_LOCK(data->bufferCond);
-	BOXEDWINE_CONDITION_SIGNAL_ALL(data->bufferCond);
-	BOXEDWINE_CONDITION_UNLOCK(data->bufferCond);
+void audioCallback(void* userdata, U8* stream, S32 len) {
+	memset(stream, 0, len);
+	if (sdlMixBuffer.size() < (U32)len) {
+		return;
+	}
+	S16 left = getMixVolume(0);
+	S16 right = getMixVolume(8);
+	auto it = voices.begin();
+	while (it != voices.end()) {
+		std::shared_ptr<KNativeAudioSdl> data = *it;
+		if (data->closeWhenDone && data->isDrained()) {
+			data->open = false;
+			it = voices.erase(it);
+			continue;
+		}
+		U32 done = data->fill(sdlMixBuffer.data(), len);
+		mixS16((S16*)stream, (const S16*)sdlMixBuffer.data(), done / 2, left, right);
+		it++;
+	}
 }
 
 void KNativeAudioSdl::openAudio(U32 format, U32 freq, U32 channels) {
-	//want.samples = 4096;    
-	this->want.callback = audioCallback;
 	this->want.format = getSdlFormat(format);
 	this->want.freq = freq;
 	this->want.channels = channels;
 
-	if (!KSystem::soundEnabled) {
+	U32 frameSize = bytesPerSampleWant() * this->want.channels;
+	// one fragment is about one mix callback worth of input
+	this->dspFragSize = (U32)((U64)MIX_SAMPLES * freq / MIX_FREQ) * frameSize;
+	if (!this->dspFragSize) {
+		this->dspFragSize = frameSize;
+	}
+	if (!KSystem::soundEnabled || !openSdlAudio()) {
 		this->sameFormat = true;
-	} else {
-		// If the previous audio is still playing, it will get cut off.  If I find a game that needs this, then perhaps I should think of a mixer.
-		closeSdlAudio();
-		if (SDL_OpenAudio(&this->want, &this->got) < 0) {
-			printf("Failed to open audio: %s\n", SDL_GetError());
-		}
-		sdlSilence = this->got.silence;
-		sdlAudioOpen = true;
-		if (this->want.freq != this->got.freq || this->want.channels != this->got.channels || this->want.format != this->got.format) {
-			this->sameFormat = false;
-			SDL_BuildAudioCVT(&this->cvt, this->want.format, this->want.channels, this->want.freq, this->got.format, this->got.channels, this->got.freq);
-		} else {
-			this->sameFormat = true;
+	} else if (this->want.freq != sdlMix.freq || this->want.channels != sdlMix.channels || this->want.format != sdlMix.format) {
+		this->sameFormat = false;
+		SDL_BuildAudioCVT(&this->cvt, this->want.format, this->want.channels, this->want.freq, sdlMix.format, sdlMix.channels, sdlMix.freq);
+		// enough input to fill one callback, the conversion buffer is sized once here instead of in the callback
+		this->cvtChunk = (U32)((double)sdlMix.size / (this->cvt.len_ratio > 0 ? this->cvt.len_ratio : 1.0)) + frameSize;
+		if (this->cvtBufLen < (int)this->cvtChunk * this->cvt.len_mult) {
+			if (this->cvtBuf) {
+				SDL_free(this->cvtBuf);
+			}
+			this->cvtBufLen = this->cvtChunk * this->cvt.len_mult;
+			this->cvtBuf = (Uint8*)SDL_malloc(this->cvtBufLen);
 		}
+		this->cvt.len_cvt = 0;
+		this->cvtBufPos = 0;
+	} else {
+		this->sameFormat = true;
 	}
+	// the audio thread isn't reading from this voice yet, so it is safe to resize
+	this->audioBuffer.allocate(this->dspFragSize * DSP_BUFFER_FRAGMENTS);
+	this->closeWhenDone = false;
 	this->open = true;
-	voices.push_back(shared_from_this());
 	if (KSystem::soundEnabled) {
-		SDL_PauseAudio(0);
-	}
-	if (this->got.size) {
-		this->dspFragSize = this->got.size;
+		SDL_LockAudio();
 	}
-	printf("openAudio: freq=%d(got %d) format=%x(got %x) channels=%d(got %d)\n", this->want.freq, this->got.freq, this->want.format, this->got.format, this->want.channels, this->got.channels);
-}
-
-void KNativeAudioSdl::closeAudioFromAudioThread() {
-	if (this->open) {
-		this->onClose();
+	voices.push_back(shared_from_this());
+	if (KSystem::soundEnabled) {
+		SDL_UnlockAudio();
 	}
+	printf("openAudio: freq=%d format=%x channels=%d voices=%d\n", this->want.freq, this->want.format, this->want.channels, (int)voices.size());
 }
 
 void KNativeAudioSdl::closeAudio() {
@@ -227,19 +296,17 @@ void KNativeAudioSdl::closeAudio() {
 		if (KSystem::soundEnabled) {
 			SDL_LockAudio();
 		}
-		if (audioBuffer.size() || (this->cvtBufPos != 0 && this->cvtBufPos < this->cvt.len_cvt)) {
+		if (sdlAudioOpen && !this->isDrained()) {
+			// let the audio thread finish playing it, it will remove the voice
 			closeWhenDone = true;
 			needClose = false;
 		}
+		if (needClose) {
+			this->onClose();
+		}
 		if (KSystem::soundEnabled) {
 			SDL_UnlockAudio();
 		}
-		if (needClose) {
-			if (KSystem::soundEnabled) {
-				closeSdlAudio();
-			}
-			this->onClose();
-		}				
 	}
 }
 
@@ -257,12 +324,12 @@ void KNativeAudioSdl::onClose() {
 	this->open = false;
 }
 
-void KNativeAudioSdl::writeAudio(U8* data, U32 len) {
-	SDL_LockAudio();
-	BOXEDWINE_CONDITION_LOCK(this->bufferCond);
-	audioBuffer.insert(this->audioBuffer.end(), data, data + len);
-	BOXEDWINE_CONDITION_UNLOCK(this->bufferCond);
-	SDL_UnlockAudio();
+U32 KNativeAudioSdl::writeAudio(U8* data, U32 len) {
+	if (!sdlAudioOpen) {
+		// nothing will ever drain the buffer
+		return len;
+	}
+	return this->audioBuffer.write(data, len);
 }
 
 std::shared_ptr<KNativeAudio> KNativeAudio::createNativeAudio() {
@@ -270,6 +337,26 @@ std::shared_ptr<KNativeAudio> KNativeAudio::createNativeAudio() {
 }
 
 void KNativeAudio::shutdown() {
-	SDL_PauseAudio(1);
-	SDL_CloseAudio();
+	closeSdlAudio();
+}
+
+U32 KNativeAudio::getVolume(U32 mixerChannel) {
+	if (mixerChannel == SOUND_MIXER_VOLUME)
+		return mixerVolume.load();
+	if (mixerChannel == SOUND_MIXER_PCM)
+		return mixerPcm.load();
+	return 0;
+}
+
+void KNativeAudio::setVolume(U32 mixerChannel, U32 volume) {
+	U32 left = volume & 0xFF;
+	U32 right = (volume >> 8) & 0xFF;
+	if (left > 100)
+		left = 100;
+	if (right > 100)
+		right = 100;
+	if (mixerChannel == SOUND_MIXER_VOLUME)
+		mixerVolume.store(left | (right << 8));
+	else if (mixerChannel == SOUND_MIXER_PCM)
+		mixerPcm.store(left | (right << 8));
 }
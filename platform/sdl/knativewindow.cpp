@@ -30,6 +30,7 @@
 #include "../../source/emulation/hardmmu/hard_memory.h"
 #include "../../source/util/threadutils.h"
 #include "../../source/sdl/startupArgs.h"
+#include "../../source/opengl/sdl/glCommandQueue.h"
 
 #if !defined(BOXEDWINE_DISABLE_UI) && !defined(__TEST)
 #include "../../source/ui/mainui.h"
@@ -211,6 +212,7 @@ public:
 
 private:
     void contextCreated();
+    void deleteContext(SDL_GLContext context);
 
     int xToScreen(int x);
     int xFromScreen(int x);
@@ -345,9 +347,21 @@ void KNativeWindowSdl::destroyScreen(KThread* thread) {
     if (!thread) {
         // :TODO: should probably store all context in this file instead of in the threads
         if (currentContext) {
-            SDL_GL_DeleteContext(currentContext);
+#ifdef BOXEDWINE_GL_THREAD
+            if (GlCommandQueue::isEnabled()) {
+                SDL_GLContext context = currentContext;
+                GlCommandQueue::runOnRenderThread([context]() {
+                    SDL_GL_DeleteContext(context);
+                    GlCommandQueue::contextDeleted(context);
+                });
+            } else
+#endif
+            deleteContext(currentContext);
             contextCount=0;
         }
+#ifdef BOXEDWINE_GL_THREAD
+        GlCommandQueue::shutdown();
+#endif
     } else {
         if (contextCount) {
             contextCount++; // prevent it from calling displayChanged
@@ -416,12 +430,43 @@ void KNativeWindowSdl::preDrawWindow() {
 
 #if defined(BOXEDWINE_OPENGL_SDL) || defined(BOXEDWINE_OPENGL_ES)
 void loadExtensions();
+#ifndef BOXEDWINE_64BIT_MMU
+bool hasVertexStream(void* context);
+void vertexStreamContextDeleted(void* context);
+#endif
 #endif
 
+void KNativeWindowSdl::deleteContext(SDL_GLContext context) {
+#if (defined(BOXEDWINE_OPENGL_SDL) || defined(BOXEDWINE_OPENGL_ES)) && !defined(BOXEDWINE_64BIT_MMU)
+    // the client array stream has to be deleted while its context is current
+    if (hasVertexStream(context)) {
+        SDL_GLContext current = SDL_GL_GetCurrentContext();
+
+        if (current!=context) {
+            SDL_GL_MakeCurrent(window, context);
+        }
+        vertexStreamContextDeleted(context);
+        if (current!=context) {
+            SDL_GL_MakeCurrent(window, current);
+        }
+    }
+#endif
+    SDL_GL_DeleteContext(context);
+}
+
 void KNativeWindowSdl::glDeleteContext(KThread* thread, U32 contextId) {
     KThreadGlContext* threadContext = thread->getGlContextById(contextId);
     if (threadContext && threadContext->context) {
-        SDL_GL_DeleteContext(threadContext->context);
+#ifdef BOXEDWINE_GL_THREAD
+        if (GlCommandQueue::isEnabled()) {
+            void* context = threadContext->context;
+            GlCommandQueue::runOnRenderThread([context]() {
+                SDL_GL_DeleteContext((SDL_GLContext)context);
+                GlCommandQueue::contextDeleted(context);
+            });
+        } else
+#endif
+        deleteContext(threadContext->context);
         thread->removeGlContextById(contextId);
         contextCount--;
         if (contextCount==0) {
@@ -433,6 +478,11 @@ void KNativeWindowSdl::glDeleteContext(KThread* thread, U32 contextId) {
 }
 
 void KNativeWindowSdl::glUpdateContextForThread(KThread* thread) {
+#ifdef BOXEDWINE_GL_THREAD
+    if (GlCommandQueue::isEnabled()) {
+        return; // the render thread switches contexts
+    }
+#endif
     if (thread->currentContext && thread->currentContext!=currentContext) {
         SDL_GL_MakeCurrent(window, thread->currentContext);
         currentContext = thread->currentContext;        
@@ -442,6 +492,16 @@ void KNativeWindowSdl::glUpdateContextForThread(KThread* thread) {
 U32 KNativeWindowSdl::glMakeCurrent(KThread* thread, U32 arg) {
     KThreadGlContext* threadContext = thread->getGlContextById(arg);
     if (threadContext && threadContext->context) {
+#ifdef BOXEDWINE_GL_THREAD
+        if (GlCommandQueue::isEnabled()) {
+            // the render thread makes the context current before it runs the calls queued for it
+            threadContext->hasBeenMakeCurrent = true;
+            thread->currentContext = threadContext->context;
+            currentContext = threadContext->context;
+            GlCommandQueue::runOnRenderThread(loadExtensions, window, threadContext->context);
+            return 1;
+        }
+#endif
         if (SDL_GL_MakeCurrent(window, threadContext->context)==0) {
             threadContext->hasBeenMakeCurrent = true;
             thread->currentContext = threadContext->context;
@@ -454,6 +514,9 @@ U32 KNativeWindowSdl::glMakeCurrent(KThread* thread, U32 arg) {
             klog("sdlMakeCurrent failed: %s\n", SDL_GetError());
         }
     } else if (arg == 0) {
+#ifdef BOXEDWINE_GL_THREAD
+        if (!GlCommandQueue::isEnabled())
+#endif
         SDL_GL_MakeCurrent(window, 0);
         thread->currentContext = 0;
         currentContext = NULL;
@@ -488,7 +551,24 @@ U32 KNativeWindowSdl::glShareLists(KThread* thread, U32 srcContext, U32 destCont
             klog("could not share display lists because dest has already shared lists before\n");
             return 0;
         }
-        SDL_GL_DeleteContext(dst->context);
+#ifdef BOXEDWINE_GL_THREAD
+        if (GlCommandQueue::isEnabled()) {
+            void* oldContext = dst->context;
+            GlCommandQueue::runOnRenderThread([this, dst, oldContext]() {
+                SDL_GL_DeleteContext((SDL_GLContext)oldContext);
+                GlCommandQueue::contextDeleted(oldContext);
+                SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+                dst->context = SDL_GL_CreateContext(window);
+                SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 0);
+                if (dst->context) {
+                    GlCommandQueue::contextCreated(window, dst->context);
+                }
+            }, window, src->context);
+            dst->sharing = true;
+            return 1;
+        }
+#endif
+        deleteContext((SDL_GLContext)dst->context);
         SDL_GLContext currentContext = (SDL_GLContext)thread->currentContext;
         bool changedContext = false;
 
@@ -601,15 +681,44 @@ U32 KNativeWindowSdl::glCreateContext(KThread* thread, std::shared_ptr<Wnd> w, i
         result = sdlCreateOpenglWindow_main_thread(thread, wnd, major, minor, profile, flags);
     }
     if (result) {
-        SDL_GLContext context;
-        // Mac requires this on the main thread, but Windows make current will fail if its not on the same thread as create context
+        SDL_GLContext context = NULL;
+        bool renderThreadContext = false;
+#ifdef BOXEDWINE_GL_THREAD
+        if (GlCommandQueue::isEnabled()) {
+            // the render thread owns all the contexts, it also sets the swap interval since that needs the new context current
+            renderThreadContext = true;
+#ifdef __MACH__
+            // Mac requires this on the main thread, after that the render thread takes the context over like any other thread that makes it current
+            DISPATCH_MAIN_THREAD_BLOCK_BEGIN_WITH_ARG(&context COMMA this)
+            context = SDL_GL_CreateContext(window);
+            DISPATCH_MAIN_THREAD_BLOCK_END
+            if (context) {
+                GlCommandQueue::runOnRenderThread([this, context]() {
+                    contextCreated();
+                    GlCommandQueue::contextCreated(window, context);
+                }, window, context);
+            }
+#else
+            GlCommandQueue::runOnRenderThread([this, &context]() {
+                context = SDL_GL_CreateContext(window);
+                if (context) {
+                    contextCreated();
+                    GlCommandQueue::contextCreated(window, context);
+                }
+            });
+#endif
+        }
+#endif
+        if (!renderThreadContext) {
+            // Mac requires this on the main thread, but Windows make current will fail if its not on the same thread as create context
 #ifdef BOXEDWINE_MSVC
-        context = SDL_GL_CreateContext(window);
+            context = SDL_GL_CreateContext(window);
 #else
-        DISPATCH_MAIN_THREAD_BLOCK_BEGIN_WITH_ARG(&context COMMA this)
-        context = SDL_GL_CreateContext(window);
-        DISPATCH_MAIN_THREAD_BLOCK_END
+            DISPATCH_MAIN_THREAD_BLOCK_BEGIN_WITH_ARG(&context COMMA this)
+            context = SDL_GL_CreateContext(window);
+            DISPATCH_MAIN_THREAD_BLOCK_END
 #endif
+        }
         if (!context) {
             fprintf(stderr, "Couldn't create context: %s\n", SDL_GetError());
             DISPATCH_MAIN_THREAD_BLOCK_BEGIN_RETURN
@@ -617,7 +726,9 @@ U32 KNativeWindowSdl::glCreateContext(KThread* thread, std::shared_ptr<Wnd> w, i
             return 0;
             DISPATCH_MAIN_THREAD_BLOCK_END
         }
-        contextCreated();
+        if (!renderThreadContext) {
+            contextCreated();
+        }
         result = nextGlId;
         thread->addGlContext(nextGlId++, context);
         contextCount++;
@@ -753,12 +864,68 @@ void KNativeWindowSdl::displayChanged(KThread* thread) {
 
 void KNativeWindowSdl::glSwapBuffers(KThread* thread) {
     preOpenGLCall(XSwapBuffer);
+#ifdef BOXEDWINE_GL_THREAD
+    if (GlCommandQueue::isEnabled() && !GlCommandQueue::isRenderThread()) {
+        GlCommandQueue::swapBuffers(thread, window);
+        return;
+    }
+#endif
     SDL_GL_SwapWindow(window);
 }
 
-#if defined(BOXEDWINE_RECORDER) || ! defined(BOXEDWINE_64BIT_MMU)
+#ifndef BOXEDWINE_64BIT_MMU
 static S8 sdlBuffer[1024*1024*4];
+
+// returns a host pointer for [address, address+len) if every page of it is backed by adjacent host memory
+static U8* getContiguousReadAddress(U32 address, U32 len) {
+    U32 todo = K_PAGE_SIZE-(address & K_PAGE_MASK);
+    if (todo>len)
+        todo = len;
+    U8* result = getPhysicalReadAddress(address, todo);
+    U8* next = result;
+
+    while (next) {
+        len-=todo;
+        if (!len) {
+            return result;
+        }
+        address+=todo;
+        next+=todo;
+        todo = (len<K_PAGE_SIZE?len:K_PAGE_SIZE);
+        if (getPhysicalReadAddress(address, todo)!=next) {
+            return NULL;
+        }
+    }
+    return NULL;
+}
+#endif
+
+// r is in texture coordinates, the texture holds the rows in the same bottom up order as the dib
+static void updateTextureRect(Memory* memory, SDL_Texture* texture, U32 bits, U32 pitch, U32 bytesPerPixel, const SDL_Rect& r) {
+    U32 address = bits+r.y*pitch+r.x*bytesPerPixel;
+#ifdef BOXEDWINE_64BIT_MMU
+    SDL_UpdateTexture(texture, &r, getNativeAddress(memory, address), pitch);
+#else
+    U32 rowLen = r.w*bytesPerPixel;
+    U8* ram = getContiguousReadAddress(address, (r.h-1)*pitch+rowLen);
+
+    if (ram) {
+        SDL_UpdateTexture(texture, &r, ram, pitch);
+        return;
+    }
+    // the rect spans host pages that aren't next to each other, copy it out in bands that fit in sdlBuffer
+    S32 rowsPerBand = (S32)(sizeof(sdlBuffer)/rowLen);
+    SDL_Rect band = r;
+    for (S32 y=0;y<r.h;y+=band.h) {
+        band.y = r.y+y;
+        band.h = (r.h-y<rowsPerBand?r.h-y:rowsPerBand);
+        for (S32 i=0;i<band.h;i++) {
+            memcopyToNative(address+(y+i)*pitch, sdlBuffer+i*rowLen, rowLen);
+        }
+        SDL_UpdateTexture(texture, &band, sdlBuffer, rowLen);
+    }
 #endif
+}
 
 void KNativeWindowSdl::bltWnd(KThread* thread, U32 hwnd, U32 bits, S32 xOrg, S32 yOrg, U32 width, U32 height, U32 rect) {
     if (!firstWindowCreated) {
@@ -771,7 +938,8 @@ void KNativeWindowSdl::bltWnd(KThread* thread, U32 hwnd, U32 bits, S32 xOrg, S32
     std::shared_ptr<WndSdl> wnd = getWndSdl(hwnd);
     wRECT r;
     int bpp = screenBpp()==8?32:screenBpp();
-    int pitch = (width*((bpp+7)/8)+3) & ~3;
+    int bytesPerPixel = (bpp+7)/8;
+    int pitch = (width*bytesPerPixel+3) & ~3;
 
     if (!renderer) {
         // final reality will draw its main start window while an OpenGL context is still going
@@ -790,6 +958,7 @@ void KNativeWindowSdl::bltWnd(KThread* thread, U32 hwnd, U32 bits, S32 xOrg, S32
     if (wnd)
     {
         SDL_Texture *sdlTexture = NULL;
+        bool newTexture = false;
         
         if (wnd->sdlTexture) {
             sdlTexture = (SDL_Texture*)wnd->sdlTexture;
@@ -812,18 +981,11 @@ void KNativeWindowSdl::bltWnd(KThread* thread, U32 hwnd, U32 bits, S32 xOrg, S32
             }
             wnd->sdlTextureHeight = height;
             wnd->sdlTextureWidth = width;
+            newTexture = true;
         }
         if (!thread->memory->isValidReadAddress(bits, height*pitch)) {
             return;
         }
-#ifndef BOXEDWINE_64BIT_MMU        
-        for (U32 y = 0; y < height; y++) {
-            memcopyToNative(bits+(height-y-1)*pitch, sdlBuffer+y*pitch, pitch);
-        } 
-#endif
-        if (screenBpp()!=32) {
-            // SDL_ConvertPixels(width, height, )
-        }
 #ifdef BOXEDWINE_RECORDER
         if (Recorder::instance || Player::instance) {
             U32 toCopy = pitch*height;
@@ -834,20 +996,36 @@ void KNativeWindowSdl::bltWnd(KThread* thread, U32 hwnd, U32 bits, S32 xOrg, S32
                 wnd->bits = new U8[toCopy];
                 wnd->bitsSize = toCopy;
             }
-#ifdef BOXEDWINE_64BIT_MMU
             for (U32 y = 0; y < height; y++) {
-                memcopyToNative(bits+(height-y-1)*pitch, sdlBuffer+y*pitch, pitch);
+                memcopyToNative(bits+(height-y-1)*pitch, wnd->bits+y*pitch, pitch);
             } 
-#endif
-            memcpy(wnd->bits, sdlBuffer, toCopy);
         }
 #endif        
-        if (KSystem::videoEnabled && renderer) {
-#ifdef BOXEDWINE_64BIT_MMU
-            SDL_UpdateTexture(sdlTexture, NULL, getNativeAddress(KThread::currentThread()->process->memory, bits), pitch);
-#else
-            SDL_UpdateTexture(sdlTexture, NULL, sdlBuffer, pitch);
-#endif
+        if (KSystem::videoEnabled && renderer && sdlTexture) {
+            // only upload the dirty rect, unless the texture is new and has nothing in it yet
+            S32 left = 0;
+            S32 top = 0;
+            S32 right = (S32)width;
+            S32 bottom = (S32)height;
+            if (rect && !newTexture) {
+                if (r.left>left)
+                    left = r.left;
+                if (r.top>top)
+                    top = r.top;
+                if (r.right<right)
+                    right = r.right;
+                if (r.bottom<bottom)
+                    bottom = r.bottom;
+            }
+            if (left<right && top<bottom) {
+                SDL_Rect dirty;
+                dirty.x = left;
+                dirty.y = (S32)height-bottom;
+                dirty.w = right-left;
+                dirty.h = bottom-top;
+                // 15/16 bpp textures are created as RGB555/RGB565 so the bits never need to be converted
+                updateTextureRect(thread->memory, sdlTexture, bits, pitch, bytesPerPixel, dirty);
+            }
         }
     }
 }
@@ -943,11 +1121,7 @@ void KNativeWindowSdl::drawAllWindows(KThread* thread, U32 hWnd, int count) {
                     dstrect.y = wnd->windowRect.top*(int)scaleY/100 + scaleYOffset;
                     dstrect.w = wnd->sdlTextureWidth*(int)scaleX/100;
                     dstrect.h = wnd->sdlTextureHeight*(int)scaleY/100;
-#ifdef BOXEDWINE_64BIT_MMU
                     SDL_RenderCopyEx(renderer, wnd->sdlTexture, NULL, &dstrect, 0, NULL, SDL_FLIP_VERTICAL);
-#else
-                    SDL_RenderCopy(renderer, wnd->sdlTexture, NULL, &dstrect);
-#endif
                 }
             }
             if (scaleXOffset) {                
@@ -152,6 +152,24 @@ void freeNativeMemory(Memory* memory, U32 page, U32 pageCount) {
     }  
 }
 
+void cloneNativeMemory(Memory* memory, Memory* from) {
+    for (U32 i=0;i<K_NUMBER_OF_PAGES;i++) {
+        if (from->isPageAllocated(i)) {
+            if ((from->flags[i] & PAGE_SHARED) && (from->flags[i] & PAGE_WRITE)) {
+                static U32 shown = 0;
+                if (!shown) {
+                    klog("forking a process with shared memory is not fully supported with BOXEDWINE_64BIT_MMU");
+                    shown=1;
+                }
+            }
+            allocNativeMemory(memory, i, 1, from->flags[i]);
+            memcpy(getNativeAddress(memory, i << K_PAGE_SHIFT), getNativeAddress(from, i << K_PAGE_SHIFT), K_PAGE_SIZE);
+        } else {
+            memory->flags[i] = from->flags[i];
+        }
+    }
+}
+
 #ifdef BOXEDWINE_BINARY_TRANSLATOR
 void allocExecutable64kBlock(Memory* memory, U32 page) {
     if (!VirtualAlloc((void*)((page << K_PAGE_SHIFT) | memory->executableMemoryId), 64*1024, MEM_COMMIT, PAGE_EXECUTE_READWRITE)) {
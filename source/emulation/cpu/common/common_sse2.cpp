@@ -1305,6 +1305,10 @@ void common_shufpdXmmE128(CPU* cpu, U32 reg, U32 address, U8 imm) {
 }
 
 void common_pause(CPU* cpu) {
+#ifndef BOXEDWINE_MULTI_THREADED
+    // every guest thread shares this host thread, so a spin wait can't end until whoever holds the lock gets to run
+    cpu->yield = true;
+#endif
 }
 
 void common_pavgbXmmXmm(CPU* cpu, U32 r1, U32 r2) {
@@ -3,6 +3,7 @@
 #include "ksignal.h"
 #include "bufferaccess.h"
 #include "kstat.h"
+#include "lazyFlagsCondition.h"
 
 
 #ifdef BOXEDWINE_BINARY_TRANSLATOR
@@ -99,6 +100,7 @@ void CPU::reset() {
     this->stackMask = 0xFFFFFFFF;
     this->nextBlock = NULL;
     this->delayedFreeBlock = NULL;
+    this->traceBlocksLeft = 0;
 }
 
 void CPU::call(U32 big, U32 selector, U32 offset, U32 oldEip) {
@@ -192,6 +194,7 @@ void CPU::jmp(U32 big, U32 selector, U32 offset, U32 oldEip) {
 }
 
 void CPU::prepareFpuException(int code, int error) {
+    BOXEDWINE_KERNEL_CRITICAL_SECTION;
     const std::shared_ptr<KProcess>& process = this->thread->process;
 
     // blocking signals, signalfd can't handle these
@@ -210,6 +213,7 @@ void CPU::prepareFpuException(int code, int error) {
 }
 
 void CPU::prepareException(int code, int error) {
+    BOXEDWINE_KERNEL_CRITICAL_SECTION;
     const std::shared_ptr<KProcess>& process = this->thread->process;
 
      // blocking signals, signalfd can't handle these
@@ -1200,67 +1204,67 @@ U32 common_getCF(CPU* cpu) {
 }
 
 U32 common_condition_o(CPU* cpu) {
-    return cpu->getOF();
+    return lazyFlagsCondition(cpu, CONDITION_O);
 }
 
 U32 common_condition_no(CPU* cpu) {
-    return !cpu->getOF();
+    return lazyFlagsCondition(cpu, CONDITION_NO);
 }
 
 U32 common_condition_b(CPU* cpu) {
-    return cpu->getCF();
+    return lazyFlagsCondition(cpu, CONDITION_B);
 }
 
 U32 common_condition_nb(CPU* cpu) {
-    return !cpu->getCF();
+    return lazyFlagsCondition(cpu, CONDITION_NB);
 }
 
 U32 common_condition_z(CPU* cpu) {
-    return cpu->getZF();
+    return lazyFlagsCondition(cpu, CONDITION_Z);
 }
 
 U32 common_condition_nz(CPU* cpu) {
-    return !cpu->getZF();
+    return lazyFlagsCondition(cpu, CONDITION_NZ);
 }
 
 U32 common_condition_be(CPU* cpu) {
-    return cpu->getZF() || cpu->getCF();
+    return lazyFlagsCondition(cpu, CONDITION_BE);
 }
 
 U32 common_condition_nbe(CPU* cpu) {
-    return !cpu->getZF() && !cpu->getCF();
+    return lazyFlagsCondition(cpu, CONDITION_NBE);
 }
 
 U32 common_condition_s(CPU* cpu) {
-    return cpu->getSF();
+    return lazyFlagsCondition(cpu, CONDITION_S);
 }
 
 U32 common_condition_ns(CPU* cpu) {
-    return !cpu->getSF();
+    return lazyFlagsCondition(cpu, CONDITION_NS);
 }
 
 U32 common_condition_p(CPU* cpu) {
-    return cpu->getPF();
+    return lazyFlagsCondition(cpu, CONDITION_P);
 }
 
 U32 common_condition_np(CPU* cpu) {
-    return !cpu->getPF();
+    return lazyFlagsCondition(cpu, CONDITION_NP);
 }
 
 U32 common_condition_l(CPU* cpu) {
-    return cpu->getSF()!=cpu->getOF();
+    return lazyFlagsCondition(cpu, CONDITION_L);
 }
 
 U32 common_condition_nl(CPU* cpu) {
-    return cpu->getSF()==cpu->getOF();
+    return lazyFlagsCondition(cpu, CONDITION_NL);
 }
 
 U32 common_condition_le(CPU* cpu) {
-    return cpu->getZF() || cpu->getSF()!=cpu->getOF();
+    return lazyFlagsCondition(cpu, CONDITION_LE);
 }
 
 U32 common_condition_nle(CPU* cpu) {
-    return !cpu->getZF() && cpu->getSF()==cpu->getOF();
+    return lazyFlagsCondition(cpu, CONDITION_NLE);
 }
 
 U32 common_pop32(CPU* cpu) {
@@ -256,6 +256,7 @@ public:
 
     DecodedBlock* nextBlock;
     DecodedBlock* delayedFreeBlock;
+    U32 traceBlocksLeft; // normal core, how many more hot blocks can be chained before returning to the scheduler
 
     jmp_buf runBlockJump;
 
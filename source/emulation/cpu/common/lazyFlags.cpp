@@ -23,7 +23,7 @@ U8 parity_lookup[256] = {
 
 class LazyFlagsNone : public LazyFlags {
 public:
-    LazyFlagsNone(U32 width) : LazyFlags(width) {}
+    LazyFlagsNone(U32 width) : LazyFlags(width, LAZY_FLAGS_TYPE_NONE) {}
     U32 getCF(CPU* cpu) const {return cpu->flags & CF;}
     U32 getSF(CPU* cpu) const {return cpu->flags & SF;}
     U32 getZF(CPU* cpu) const {return cpu->flags & ZF;}
@@ -37,32 +37,34 @@ const LazyFlags* FLAGS_NONE = &flagsNone;
 
 class LazyFlagsDefault : public LazyFlags {
 public:
-    LazyFlagsDefault(U32 width) : LazyFlags(width) {}
+    LazyFlagsDefault(U32 width, U32 type) : LazyFlags(width, type) {}
     U32 getPF(CPU* cpu) const {return parity_lookup[cpu->result.u8];}
 };
 
 class LazyFlagsDefault8 : public LazyFlagsDefault {
 public:
-    LazyFlagsDefault8() : LazyFlagsDefault(8) {}
+    LazyFlagsDefault8(U32 type=LAZY_FLAGS_TYPE_OTHER) : LazyFlagsDefault(8, type) {}
     U32 getSF(CPU* cpu) const {return cpu->result.u8 & 0x80;}
     U32 getZF(CPU* cpu) const {return cpu->result.u8==0;}
 };
 
 class LazyFlagsDefault16 : public LazyFlagsDefault {
 public:
-    LazyFlagsDefault16() : LazyFlagsDefault(16) {}
+    LazyFlagsDefault16(U32 type=LAZY_FLAGS_TYPE_OTHER) : LazyFlagsDefault(16, type) {}
     U32 getSF(CPU* cpu) const {return cpu->result.u16 & 0x8000;}
     U32 getZF(CPU* cpu) const {return cpu->result.u16==0;}
 };
 
 class LazyFlagsDefault32 : public LazyFlagsDefault {
 public:
-    LazyFlagsDefault32() : LazyFlagsDefault(32) {}
+    LazyFlagsDefault32(U32 type=LAZY_FLAGS_TYPE_OTHER) : LazyFlagsDefault(32, type) {}
     U32 getSF(CPU* cpu) const {return cpu->result.u32 & 0x80000000;}
     U32 getZF(CPU* cpu) const {return cpu->result.u32==0;}
 };
 
 class LazyFlagsAdd8 : public LazyFlagsDefault8 {
+public:
+    LazyFlagsAdd8() : LazyFlagsDefault8(LAZY_FLAGS_TYPE_ADD8) {}
     U32 getCF(CPU* cpu) const {return cpu->result.u8<cpu->dst.u8;}
     U32 getOF(CPU* cpu) const {return ((cpu->dst.u8 ^ cpu->src.u8 ^ 0x80) & (cpu->result.u8 ^ cpu->src.u8)) & 0x80;}
     U32 getAF(CPU* cpu) const {return ((cpu->dst.u8 ^ cpu->src.u8) ^ cpu->result.u8) & 0x10;}
@@ -72,6 +74,8 @@ static LazyFlagsAdd8 flagsAdd8;
 const LazyFlags* FLAGS_ADD8 = &flagsAdd8;
 
 class LazyFlagsAdd16 : public LazyFlagsDefault16 {
+public:
+    LazyFlagsAdd16() : LazyFlagsDefault16(LAZY_FLAGS_TYPE_ADD16) {}
     U32 getCF(CPU* cpu) const {return cpu->result.u16<cpu->dst.u16;}
     U32 getOF(CPU* cpu) const {return ((cpu->dst.u16 ^ cpu->src.u16 ^ 0x8000) & (cpu->result.u16 ^ cpu->src.u16)) & 0x8000;}
     U32 getAF(CPU* cpu) const {return ((cpu->dst.u16 ^ cpu->src.u16) ^ cpu->result.u16) & 0x10;}
@@ -81,6 +85,8 @@ static LazyFlagsAdd16 flagsAdd16;
 const LazyFlags* FLAGS_ADD16 = &flagsAdd16;
 
 class LazyFlagsAdd32 : public LazyFlagsDefault32 {
+public:
+    LazyFlagsAdd32() : LazyFlagsDefault32(LAZY_FLAGS_TYPE_ADD32) {}
     U32 getCF(CPU* cpu) const {return cpu->result.u32<cpu->dst.u32;}
     U32 getOF(CPU* cpu) const {return ((cpu->dst.u32 ^ cpu->src.u32 ^ 0x80000000) & (cpu->result.u32 ^ cpu->src.u32)) & 0x80000000;}
     U32 getAF(CPU* cpu) const {return ((cpu->dst.u32 ^ cpu->src.u32) ^ cpu->result.u32) & 0x10;}
@@ -92,18 +98,24 @@ const LazyFlags* FLAGS_ADD32 = &flagsAdd32;
 U32 get_0(CPU* cpu) {return 0;}
 
 class LazyFlagsZero8 : public LazyFlagsDefault8 {
+public:
+    LazyFlagsZero8() : LazyFlagsDefault8(LAZY_FLAGS_TYPE_LOGIC8) {}
     U32 getCF(CPU* cpu) const {return 0;}
     U32 getOF(CPU* cpu) const {return 0;}
     U32 getAF(CPU* cpu) const {return 0;}
 };
 
 class LazyFlagsZero16 : public LazyFlagsDefault16 {
+public:
+    LazyFlagsZero16() : LazyFlagsDefault16(LAZY_FLAGS_TYPE_LOGIC16) {}
     U32 getCF(CPU* cpu) const {return 0;}
     U32 getOF(CPU* cpu) const {return 0;}
     U32 getAF(CPU* cpu) const {return 0;}
 };
 
 class LazyFlagsZero32 : public LazyFlagsDefault32 {
+public:
+    LazyFlagsZero32() : LazyFlagsDefault32(LAZY_FLAGS_TYPE_LOGIC32) {}
     U32 getCF(CPU* cpu) const {return 0;}
     U32 getOF(CPU* cpu) const {return 0;}
     U32 getAF(CPU* cpu) const {return 0;}
@@ -182,6 +194,8 @@ static LazyFlagsSbb32 flagsSbb32;
 const LazyFlags* FLAGS_SBB32 = &flagsSbb32;
 
 class LazyFlagsSub8 : public LazyFlagsDefault8 {
+public:
+    LazyFlagsSub8() : LazyFlagsDefault8(LAZY_FLAGS_TYPE_SUB8) {}
     U32 getCF(CPU* cpu) const {return cpu->dst.u8<cpu->src.u8;}
     U32 getOF(CPU* cpu) const {return ((cpu->dst.u8 ^ cpu->src.u8) & (cpu->dst.u8 ^ cpu->result.u8)) & 0x80;}
     U32 getAF(CPU* cpu) const {return ((cpu->dst.u8 ^ cpu->src.u8) ^ cpu->result.u8) & 0x10;}
@@ -192,6 +206,8 @@ const LazyFlags* FLAGS_SUB8 = &flagsSub8;
 const LazyFlags* FLAGS_CMP8 = &flagsSub8;
 
 class LazyFlagsSub16 : public LazyFlagsDefault16 {
+public:
+    LazyFlagsSub16() : LazyFlagsDefault16(LAZY_FLAGS_TYPE_SUB16) {}
     U32 getCF(CPU* cpu) const {return cpu->dst.u16<cpu->src.u16;}
     U32 getOF(CPU* cpu) const {return ((cpu->dst.u16 ^ cpu->src.u16) & (cpu->dst.u16 ^ cpu->result.u16)) & 0x8000;}
     U32 getAF(CPU* cpu) const {return ((cpu->dst.u16 ^ cpu->src.u16) ^ cpu->result.u16) & 0x10;}
@@ -202,6 +218,8 @@ const LazyFlags* FLAGS_SUB16 = &flagsSub16;
 const LazyFlags* FLAGS_CMP16 = &flagsSub16;
 
 class LazyFlagsSub32 : public LazyFlagsDefault32 {
+public:
+    LazyFlagsSub32() : LazyFlagsDefault32(LAZY_FLAGS_TYPE_SUB32) {}
     U32 getCF(CPU* cpu) const {return cpu->dst.u32<cpu->src.u32;}
     U32 getOF(CPU* cpu) const {return ((cpu->dst.u32 ^ cpu->src.u32) & (cpu->dst.u32 ^ cpu->result.u32)) & 0x80000000;}
     U32 getAF(CPU* cpu) const {return ((cpu->dst.u32 ^ cpu->src.u32) ^ cpu->result.u32) & 0x10;}
@@ -212,6 +230,8 @@ const LazyFlags* FLAGS_SUB32 = &flagsSub32;
 const LazyFlags* FLAGS_CMP32 = &flagsSub32;
 
 class LazyFlagsInc8 : public LazyFlagsDefault8 {
+public:
+    LazyFlagsInc8() : LazyFlagsDefault8(LAZY_FLAGS_TYPE_INC8) {}
     U32 getCF(CPU* cpu) const {return cpu->oldCF;}
     U32 getOF(CPU* cpu) const {return cpu->result.u8 == 0x80;}
     U32 getAF(CPU* cpu) const {return (cpu->result.u8 & 0x0f) == 0;}
@@ -221,6 +241,8 @@ static LazyFlagsInc8 flagsInc8;
 const LazyFlags* FLAGS_INC8 = &flagsInc8;
 
 class LazyFlagsInc16 : public LazyFlagsDefault16 {
+public:
+    LazyFlagsInc16() : LazyFlagsDefault16(LAZY_FLAGS_TYPE_INC16) {}
     U32 getCF(CPU* cpu) const {return cpu->oldCF;}
     U32 getOF(CPU* cpu) const {return cpu->result.u16 == 0x8000;}
     U32 getAF(CPU* cpu) const {return (cpu->result.u16 & 0x0f) == 0;}
@@ -230,6 +252,8 @@ static LazyFlagsInc16 flagsInc16;
 const LazyFlags* FLAGS_INC16 = &flagsInc16;
 
 class LazyFlagsInc32 : public LazyFlagsDefault32 {
+public:
+    LazyFlagsInc32() : LazyFlagsDefault32(LAZY_FLAGS_TYPE_INC32) {}
     U32 getCF(CPU* cpu) const {return cpu->oldCF;}
     U32 getOF(CPU* cpu) const {return cpu->result.u32 == 0x80000000;}
     U32 getAF(CPU* cpu) const {return (cpu->result.u32 & 0x0f) == 0;}
@@ -239,6 +263,8 @@ static LazyFlagsInc32 flagsInc32;
 const LazyFlags* FLAGS_INC32 = &flagsInc32;
 
 class LazyFlagsDec8 : public LazyFlagsDefault8 {
+public:
+    LazyFlagsDec8() : LazyFlagsDefault8(LAZY_FLAGS_TYPE_DEC8) {}
     U32 getCF(CPU* cpu) const {return cpu->oldCF;}
     U32 getOF(CPU* cpu) const {return cpu->result.u8 == 0x7f;}
     U32 getAF(CPU* cpu) const {return (cpu->result.u8 & 0x0f) == 0x0f;}
@@ -248,6 +274,8 @@ static LazyFlagsDec8 flagsDec8;
 const LazyFlags* FLAGS_DEC8 = &flagsDec8;
 
 class LazyFlagsDec16 : public LazyFlagsDefault16 {
+public:
+    LazyFlagsDec16() : LazyFlagsDefault16(LAZY_FLAGS_TYPE_DEC16) {}
     U32 getCF(CPU* cpu) const {return cpu->oldCF;}
     U32 getOF(CPU* cpu) const {return cpu->result.u16 == 0x7fff;}
     U32 getAF(CPU* cpu) const {return (cpu->result.u16 & 0x0f) == 0x0f;}
@@ -257,6 +285,8 @@ static LazyFlagsDec16 flagsDec16;
 const LazyFlags* FLAGS_DEC16 = &flagsDec16;
 
 class LazyFlagsDec32 : public LazyFlagsDefault32 {
+public:
+    LazyFlagsDec32() : LazyFlagsDefault32(LAZY_FLAGS_TYPE_DEC32) {}
     U32 getCF(CPU* cpu) const {return cpu->oldCF;}
     U32 getOF(CPU* cpu) const {return cpu->result.u32 == 0x7fffffff;}
     U32 getAF(CPU* cpu) const {return (cpu->result.u32 & 0x0f) == 0x0f;}
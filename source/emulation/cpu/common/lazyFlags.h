@@ -3,9 +3,31 @@
 
 class CPU;
 
+// Which calculation a LazyFlags does, so the common ones can be evaluated inline with a switch (see
+// lazyFlagsCondition.h) instead of through the virtual getters.  Everything else is LAZY_FLAGS_TYPE_OTHER.
+enum LazyFlagsType {
+    LAZY_FLAGS_TYPE_OTHER,
+    LAZY_FLAGS_TYPE_NONE,
+    LAZY_FLAGS_TYPE_ADD8,
+    LAZY_FLAGS_TYPE_ADD16,
+    LAZY_FLAGS_TYPE_ADD32,
+    LAZY_FLAGS_TYPE_SUB8, // also cmp
+    LAZY_FLAGS_TYPE_SUB16,
+    LAZY_FLAGS_TYPE_SUB32,
+    LAZY_FLAGS_TYPE_LOGIC8, // or, and, xor and test
+    LAZY_FLAGS_TYPE_LOGIC16,
+    LAZY_FLAGS_TYPE_LOGIC32,
+    LAZY_FLAGS_TYPE_INC8,
+    LAZY_FLAGS_TYPE_INC16,
+    LAZY_FLAGS_TYPE_INC32,
+    LAZY_FLAGS_TYPE_DEC8,
+    LAZY_FLAGS_TYPE_DEC16,
+    LAZY_FLAGS_TYPE_DEC32
+};
+
 class LazyFlags {
 public:
-    LazyFlags(U32 width) : width(width) {}
+    LazyFlags(U32 width, U32 type=LAZY_FLAGS_TYPE_OTHER) : width(width), type(type) {}
     virtual U32 getCF(CPU* cpu) const=0; // will always return 0 or 1, optimizations count on this
     virtual U32 getSF(CPU* cpu) const=0;
     virtual U32 getZF(CPU* cpu) const=0;
@@ -13,6 +35,7 @@ public:
     virtual U32 getAF(CPU* cpu) const=0;
     virtual U32 getPF(CPU* cpu) const=0;
     U32 width;
+    U32 type;
 };
 
 extern const LazyFlags* FLAGS_NONE;
@@ -0,0 +1,157 @@
+#ifndef __LAZY_FLAGS_CONDITION_H__
+#define __LAZY_FLAGS_CONDITION_H__
+
+// x86 condition codes, in the order jcc, setcc and cmovcc encode them
+enum LazyFlagsCondition {
+    CONDITION_O,
+    CONDITION_NO,
+    CONDITION_B,
+    CONDITION_NB,
+    CONDITION_Z,
+    CONDITION_NZ,
+    CONDITION_BE,
+    CONDITION_NBE,
+    CONDITION_S,
+    CONDITION_NS,
+    CONDITION_P,
+    CONDITION_NP,
+    CONDITION_L,
+    CONDITION_NL,
+    CONDITION_LE,
+    CONDITION_NLE
+};
+
+enum LazyFlagsOp {
+    LAZY_FLAGS_OP_ADD,
+    LAZY_FLAGS_OP_SUB,
+    LAZY_FLAGS_OP_LOGIC,
+    LAZY_FLAGS_OP_INC,
+    LAZY_FLAGS_OP_DEC
+};
+
+extern U8 parity_lookup[256];
+
+// op and T are constants, so after inlining only the compares the condition needs are left, for
+// example JZ after a 32-bit sub is just result.u32==0
+template <typename T, U32 op>
+inline U32 lazyFlagsCondition(CPU* cpu, U32 condition) {
+    const T sign = (T)1 << (sizeof(T)*8-1);
+    T dst = (T)cpu->dst.u32;
+    T src = (T)cpu->src.u32;
+    T result = (T)cpu->result.u32;
+    U32 cf;
+    U32 of;
+
+    if (op == LAZY_FLAGS_OP_ADD) {
+        cf = result<dst;
+        of = (((dst ^ src ^ sign) & (result ^ src)) & sign) != 0;
+    } else if (op == LAZY_FLAGS_OP_SUB) {
+        cf = dst<src;
+        of = (((dst ^ src) & (dst ^ result)) & sign) != 0;
+    } else if (op == LAZY_FLAGS_OP_LOGIC) {
+        cf = 0;
+        of = 0;
+    } else if (op == LAZY_FLAGS_OP_INC) {
+        cf = cpu->oldCF;
+        of = result == sign;
+    } else {
+        cf = cpu->oldCF;
+        of = result == (T)(sign-1);
+    }
+    U32 zf = result == 0;
+    U32 sf = (result & sign) != 0;
+
+    switch (condition) {
+    case CONDITION_O: return of;
+    case CONDITION_NO: return !of;
+    case CONDITION_B: return cf;
+    case CONDITION_NB: return !cf;
+    case CONDITION_Z: return zf;
+    case CONDITION_NZ: return !zf;
+    case CONDITION_BE: return zf || cf;
+    case CONDITION_NBE: return !zf && !cf;
+    case CONDITION_S: return sf;
+    case CONDITION_NS: return !sf;
+    case CONDITION_P: return parity_lookup[(U8)result] != 0;
+    case CONDITION_NP: return parity_lookup[(U8)result] == 0;
+    case CONDITION_L: return sf != of;
+    case CONDITION_NL: return sf == of;
+    case CONDITION_LE: return zf || sf != of;
+    default: return !zf && sf == of;
+    }
+}
+
+// the flags have already been calculated into cpu->flags
+inline U32 lazyFlagsConditionFromFlags(U32 flags, U32 condition) {
+    U32 sf = (flags & SF) != 0;
+    U32 of = (flags & OF) != 0;
+
+    switch (condition) {
+    case CONDITION_O: return of;
+    case CONDITION_NO: return !of;
+    case CONDITION_B: return (flags & CF) != 0;
+    case CONDITION_NB: return (flags & CF) == 0;
+    case CONDITION_Z: return (flags & ZF) != 0;
+    case CONDITION_NZ: return (flags & ZF) == 0;
+    case CONDITION_BE: return (flags & (ZF|CF)) != 0;
+    case CONDITION_NBE: return (flags & (ZF|CF)) == 0;
+    case CONDITION_S: return sf;
+    case CONDITION_NS: return !sf;
+    case CONDITION_P: return (flags & PF) != 0;
+    case CONDITION_NP: return (flags & PF) == 0;
+    case CONDITION_L: return sf != of;
+    case CONDITION_NL: return sf == of;
+    case CONDITION_LE: return (flags & ZF) || sf != of;
+    default: return !(flags & ZF) && sf == of;
+    }
+}
+
+// only calls the getters the condition needs
+inline U32 lazyFlagsConditionFromGetters(CPU* cpu, U32 condition) {
+    const LazyFlags* flags = cpu->lazyFlags;
+
+    switch (condition) {
+    case CONDITION_O: return flags->getOF(cpu) != 0;
+    case CONDITION_NO: return flags->getOF(cpu) == 0;
+    case CONDITION_B: return flags->getCF(cpu) != 0;
+    case CONDITION_NB: return flags->getCF(cpu) == 0;
+    case CONDITION_Z: return flags->getZF(cpu) != 0;
+    case CONDITION_NZ: return flags->getZF(cpu) == 0;
+    case CONDITION_BE: return flags->getZF(cpu) || flags->getCF(cpu);
+    case CONDITION_NBE: return !flags->getZF(cpu) && !flags->getCF(cpu);
+    case CONDITION_S: return flags->getSF(cpu) != 0;
+    case CONDITION_NS: return flags->getSF(cpu) == 0;
+    case CONDITION_P: return flags->getPF(cpu) != 0;
+    case CONDITION_NP: return flags->getPF(cpu) == 0;
+    case CONDITION_L: return (flags->getSF(cpu) != 0) != (flags->getOF(cpu) != 0);
+    case CONDITION_NL: return (flags->getSF(cpu) != 0) == (flags->getOF(cpu) != 0);
+    case CONDITION_LE: return flags->getZF(cpu) || (flags->getSF(cpu) != 0) != (flags->getOF(cpu) != 0);
+    default: return !flags->getZF(cpu) && (flags->getSF(cpu) != 0) == (flags->getOF(cpu) != 0);
+    }
+}
+
+// Evaluates a condition code for the current lazy flags.  The common flag calculations are a
+// switch on LazyFlags::type, the rest go through the virtual getters.
+inline U32 lazyFlagsCondition(CPU* cpu, U32 condition) {
+    switch (cpu->lazyFlags->type) {
+    case LAZY_FLAGS_TYPE_NONE: return lazyFlagsConditionFromFlags(cpu->flags, condition);
+    case LAZY_FLAGS_TYPE_ADD8: return lazyFlagsCondition<U8, LAZY_FLAGS_OP_ADD>(cpu, condition);
+    case LAZY_FLAGS_TYPE_ADD16: return lazyFlagsCondition<U16, LAZY_FLAGS_OP_ADD>(cpu, condition);
+    case LAZY_FLAGS_TYPE_ADD32: return lazyFlagsCondition<U32, LAZY_FLAGS_OP_ADD>(cpu, condition);
+    case LAZY_FLAGS_TYPE_SUB8: return lazyFlagsCondition<U8, LAZY_FLAGS_OP_SUB>(cpu, condition);
+    case LAZY_FLAGS_TYPE_SUB16: return lazyFlagsCondition<U16, LAZY_FLAGS_OP_SUB>(cpu, condition);
+    case LAZY_FLAGS_TYPE_SUB32: return lazyFlagsCondition<U32, LAZY_FLAGS_OP_SUB>(cpu, condition);
+    case LAZY_FLAGS_TYPE_LOGIC8: return lazyFlagsCondition<U8, LAZY_FLAGS_OP_LOGIC>(cpu, condition);
+    case LAZY_FLAGS_TYPE_LOGIC16: return lazyFlagsCondition<U16, LAZY_FLAGS_OP_LOGIC>(cpu, condition);
+    case LAZY_FLAGS_TYPE_LOGIC32: return lazyFlagsCondition<U32, LAZY_FLAGS_OP_LOGIC>(cpu, condition);
+    case LAZY_FLAGS_TYPE_INC8: return lazyFlagsCondition<U8, LAZY_FLAGS_OP_INC>(cpu, condition);
+    case LAZY_FLAGS_TYPE_INC16: return lazyFlagsCondition<U16, LAZY_FLAGS_OP_INC>(cpu, condition);
+    case LAZY_FLAGS_TYPE_INC32: return lazyFlagsCondition<U32, LAZY_FLAGS_OP_INC>(cpu, condition);
+    case LAZY_FLAGS_TYPE_DEC8: return lazyFlagsCondition<U8, LAZY_FLAGS_OP_DEC>(cpu, condition);
+    case LAZY_FLAGS_TYPE_DEC16: return lazyFlagsCondition<U16, LAZY_FLAGS_OP_DEC>(cpu, condition);
+    case LAZY_FLAGS_TYPE_DEC32: return lazyFlagsCondition<U32, LAZY_FLAGS_OP_DEC>(cpu, condition);
+    }
+    return lazyFlagsConditionFromGetters(cpu, condition);
+}
+
+#endif
@@ -6012,6 +6012,22 @@ bool DecodedOp::needsToSetFlags() {
     return DecodedOp::getNeededFlags(DecodedBlock::currentBlock, this, needsToSet)!=0;
 }
 
+// like getNeededFlags but block->op is included, getNeededFlags only looks at the ops after op
+static U32 getNeededFlagsOfBlock(DecodedBlock* block, U32 flags, U32 depth) {
+    DecodedOp* op = block->op;
+    U32 result = instructionInfo[op->inst].flagsUsed & flags;
+
+    if (!(instructionInfo[op->inst].flagsSets & MAYBE) || result) {
+        flags &= ~ instructionInfo[op->inst].flagsSets;
+        flags &= ~ instructionInfo[op->inst].flagsUndefined;
+    }
+    flags &= ~result;
+    if (flags) {
+        result |= DecodedOp::getNeededFlags(block, op, flags, depth);
+    }
+    return result;
+}
+
 U32 DecodedOp::getNeededFlags(DecodedBlock* block, DecodedOp* op, U32 flags, U32 depth) {
     DecodedOp* n = op->next;
     DecodedOp* lastOp = op;
@@ -6037,14 +6053,14 @@ U32 DecodedOp::getNeededFlags(DecodedBlock* block, DecodedOp* op, U32 flags, U32
     if (flags && (instructionInfo[lastOp->inst].branch & DECODE_BRANCH_1) && depth>0) {
         // :TODO: maybe decode the missing branch?
         if (block->next1 && (block->next2 || !(instructionInfo[lastOp->inst].branch & DECODE_BRANCH_2))) {
-            U32 needsToSet1 = DecodedOp::getNeededFlags(block->next1, block->next1->op, flags, depth-1);          
+            U32 needsToSet1 = getNeededFlagsOfBlock(block->next1, flags, depth-1);          
 
             U32 needsToSet2 = 0;
             if ((instructionInfo[lastOp->inst].branch & DECODE_BRANCH_2)) {
                 needsToSet2 = flags;
                 // :TODO: maybe decode the missing branch?
                 if (block->next2) {
-                    needsToSet2 = (DecodedOp::getNeededFlags(block->next2, block->next2->op, flags, depth-1));
+                    needsToSet2 = getNeededFlagsOfBlock(block->next2, flags, depth-1);
                 }
             }
             flags = needsToSet1 | needsToSet2;
@@ -6110,6 +6126,9 @@ void DecodedBlock::removeReferenceFrom(DecodedBlock* block) {
 	}
 }
 
+#ifdef BOXEDWINE_CPU_WORKERS
+THREAD_LOCAL
+#endif
 DecodedBlock* DecodedBlock::currentBlock;
 
 void decodeBlock(pfnFetchByte fetchByte, U32 eip, bool isBig, U32 maxInstructions, U32 maxLen, U32 stopIfThrowsException, DecodedBlock* block) {
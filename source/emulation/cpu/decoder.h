@@ -1498,6 +1498,9 @@ public:
 
 class DecodedBlock {
 public:   
+#ifdef BOXEDWINE_CPU_WORKERS
+    THREAD_LOCAL
+#endif
     static DecodedBlock* currentBlock;
     virtual ~DecodedBlock() {}
 
@@ -0,0 +1,310 @@
+#include "boxedwine.h"
+
+#ifdef BOXEDWINE_DEFAULT_MMU
+
+#include "../decoder.h"
+#include "decodedBlockCache.h"
+#include "crc.h"
+
+// change this whenever DecodedOp or the decoder changes, old cache files will be thrown away
+#define DECODED_BLOCK_CACHE_VERSION 1
+#define DECODED_BLOCK_CACHE_MAGIC 0x4B4C4244
+#define DECODED_BLOCK_RECORD_MAGIC 0x4B4C4252
+
+#define DECODED_BLOCK_HEADER_SIZE 12 // magic, version, InstructionCount
+#define DECODED_BLOCK_RECORD_SIZE 12 // magic, payload len, payload hash
+#define DECODED_BLOCK_PAYLOAD_SIZE 20 // key, bytes, opCount, number of ops
+#define DECODED_OP_SIZE 26
+
+static void put16(std::vector<U8>& data, U16 value) {
+    data.insert(data.end(), (U8*)&value, (U8*)&value+2);
+}
+
+static void put32(std::vector<U8>& data, U32 value) {
+    data.insert(data.end(), (U8*)&value, (U8*)&value+4);
+}
+
+static U16 get16(const U8*& p) {
+    U16 result;
+    memcpy(&result, p, 2);
+    p+=2;
+    return result;
+}
+
+static U32 get32(const U8*& p) {
+    U32 result;
+    memcpy(&result, p, 4);
+    p+=4;
+    return result;
+}
+
+static U64 get64(const U8*& p) {
+    U64 result;
+    memcpy(&result, p, 8);
+    p+=8;
+    return result;
+}
+
+// true if [address, address+len) is still backed by the shared read only copy of the file pages
+static bool isFromFile(const BoxedPtr<MappedFile>& mapped, U32 filePageCount, U32 address, U32 len) {
+    U32 lastPage = (address+len-1) >> K_PAGE_SHIFT;
+
+    for (U32 page = address >> K_PAGE_SHIFT; page<=lastPage; page++) {
+        U32 pageAddress = page << K_PAGE_SHIFT;
+        if (pageAddress-mapped->address>=mapped->len) {
+            return false;
+        }
+        U64 index = ((pageAddress-mapped->address)+mapped->offset) >> K_PAGE_SHIFT;
+        if (index>=filePageCount) {
+            return false;
+        }
+        U8* ram = getPhysicalReadAddress(pageAddress, 1);
+        if (!ram || ram!=mapped->systemCacheEntry->data[index]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+DecodedBlockCache::DecodedBlockCache(const std::shared_ptr<KFile>& file) : out(NULL) {
+    U64 len = file->length();
+    U32 hash = 0;
+    U8* buffer = new U8[64*1024];
+    S64 pos = file->getPos();
+
+    this->filePageCount = (U32)((len+K_PAGE_SIZE-1) >> K_PAGE_SHIFT);
+    file->seek(0);
+    while (true) {
+        S32 read = (S32)file->readNative(buffer, 64*1024);
+        if (read<=0) {
+            break;
+        }
+        hash = crc32bUpdate(hash, buffer, read);
+    }
+    file->seek(pos);
+    delete[] buffer;
+
+    char name[64];
+    snprintf(name, sizeof(name), "-%08X-%llX.blocks", hash, (unsigned long long)len);
+    this->cachePath = KSystem::decodedBlockCacheDir+Fs::nativePathSeperator+file->openFile->node->name+name;
+    this->readCacheFile();
+}
+
+DecodedBlockCache::~DecodedBlockCache() {
+    if (this->out) {
+        fclose(this->out);
+    }
+}
+
+void DecodedBlockCache::readCacheFile() {
+    bool rewrite = true;
+    FILE* f = fopen(this->cachePath.c_str(), "rb");
+
+    if (f) {
+        U8 header[DECODED_BLOCK_HEADER_SIZE];
+        const U8* p = header;
+
+        if (fread(header, 1, DECODED_BLOCK_HEADER_SIZE, f)==DECODED_BLOCK_HEADER_SIZE && get32(p)==DECODED_BLOCK_CACHE_MAGIC && get32(p)==DECODED_BLOCK_CACHE_VERSION && get32(p)==InstructionCount) {
+            U8 recordHeader[DECODED_BLOCK_RECORD_SIZE];
+            std::vector<U8> payload;
+
+            rewrite = false;
+            // a run that crashed or another instance writing at the same time can leave a bad record, keep what was good before it
+            while (fread(recordHeader, 1, DECODED_BLOCK_RECORD_SIZE, f)==DECODED_BLOCK_RECORD_SIZE) {
+                p = recordHeader;
+                U32 magic = get32(p);
+                U32 len = get32(p);
+                U32 hash = get32(p);
+
+                if (magic!=DECODED_BLOCK_RECORD_MAGIC || len<DECODED_BLOCK_PAYLOAD_SIZE || len>DECODED_BLOCK_PAYLOAD_SIZE+K_PAGE_SIZE*DECODED_OP_SIZE) {
+                    rewrite = true;
+                    break;
+                }
+                payload.resize(len);
+                if (fread(payload.data(), 1, len, f)!=len || crc32bUpdate(0, payload.data(), len)!=hash) {
+                    rewrite = true;
+                    break;
+                }
+                p = payload.data();
+                this->blocks[get64(p)] = payload;
+            }
+        }
+        fclose(f);
+    }
+    if (rewrite) {
+        this->out = fopen(this->cachePath.c_str(), "wb");
+        if (this->out) {
+            std::vector<U8> header;
+            put32(header, DECODED_BLOCK_CACHE_MAGIC);
+            put32(header, DECODED_BLOCK_CACHE_VERSION);
+            put32(header, InstructionCount);
+            fwrite(header.data(), 1, header.size(), this->out);
+            for (auto& n : this->blocks) {
+                std::vector<U8> record;
+                put32(record, DECODED_BLOCK_RECORD_MAGIC);
+                put32(record, (U32)n.second.size());
+                put32(record, crc32bUpdate(0, n.second.data(), (int)n.second.size()));
+                fwrite(record.data(), 1, record.size(), this->out);
+                fwrite(n.second.data(), 1, n.second.size(), this->out);
+            }
+        }
+    } else {
+        this->out = fopen(this->cachePath.c_str(), "ab");
+    }
+    if (!this->out) {
+        klog("could not open decoded block cache: %s", this->cachePath.c_str());
+    }
+}
+
+bool DecodedBlockCache::load(U64 fileOffset, bool big, DecodedBlock* block) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->mutex);
+    auto it = this->blocks.find(fileOffset << 1 | (big?1:0));
+    if (it==this->blocks.end()) {
+        return false;
+    }
+    const U8* p = it->second.data()+8;
+    U32 bytes = get32(p);
+    U32 opCount = get32(p);
+    U32 count = get32(p);
+    DecodedOp* prev = NULL;
+
+    if (it->second.size()!=DECODED_BLOCK_PAYLOAD_SIZE+count*DECODED_OP_SIZE || !count) {
+        return false;
+    }
+    for (U32 i=0;i<count;i++) {
+        DecodedOp* op = DecodedOp::alloc();
+        op->disp = get32(p);
+        op->imm = get32(p);
+#if defined _DEBUG || defined BOXEDWINE_BINARY_TRANSLATOR
+        op->extra = get32(p);
+        op->originalOp = get16(p);
+#else
+        p+=6;
+#endif
+#ifdef _DEBUG
+        op->inst = (Instruction)get16(p);
+#else
+        op->inst = get16(p);
+#endif
+        op->reg = *p++;
+        op->rm = *p++;
+        op->base = *p++;
+        op->sibIndex = *p++;
+        op->sibScale = *p++;
+        op->len = *p++;
+        op->lock = *p++;
+        op->repZero = *p++;
+        op->repNotZero = *p++;
+        op->ea16 = *p++;
+        if (prev) {
+            prev->next = op;
+        } else {
+            block->op = op;
+        }
+        prev = op;
+    }
+    block->bytes = bytes;
+    block->opCount = opCount;
+    return true;
+}
+
+void DecodedBlockCache::save(U64 fileOffset, bool big, DecodedBlock* block) {
+    std::vector<U8> payload;
+    U64 key = fileOffset << 1 | (big?1:0);
+    U32 count = 0;
+
+    for (DecodedOp* op = block->op; op; op = op->next) {
+        count++;
+    }
+    payload.reserve(DECODED_BLOCK_PAYLOAD_SIZE+count*DECODED_OP_SIZE);
+    put32(payload, (U32)key);
+    put32(payload, (U32)(key >> 32));
+    put32(payload, block->bytes);
+    put32(payload, block->opCount);
+    put32(payload, count);
+    for (DecodedOp* op = block->op; op; op = op->next) {
+        put32(payload, op->disp);
+        put32(payload, op->imm);
+#if defined _DEBUG || defined BOXEDWINE_BINARY_TRANSLATOR
+        put32(payload, op->extra);
+        put16(payload, op->originalOp);
+#else
+        put32(payload, 0);
+        put16(payload, 0);
+#endif
+        put16(payload, (U16)op->inst);
+        payload.push_back(op->reg);
+        payload.push_back(op->rm);
+        payload.push_back(op->base);
+        payload.push_back(op->sibIndex);
+        payload.push_back(op->sibScale);
+        payload.push_back(op->len);
+        payload.push_back(op->lock);
+        payload.push_back(op->repZero);
+        payload.push_back(op->repNotZero);
+        payload.push_back(op->ea16);
+    }
+
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->mutex);
+    if (this->blocks.count(key)) {
+        return;
+    }
+    if (this->out) {
+        std::vector<U8> record;
+        put32(record, DECODED_BLOCK_RECORD_MAGIC);
+        put32(record, (U32)payload.size());
+        put32(record, crc32bUpdate(0, payload.data(), (int)payload.size()));
+        fwrite(record.data(), 1, record.size(), this->out);
+        fwrite(payload.data(), 1, payload.size(), this->out);
+    }
+    this->blocks[key] = std::move(payload);
+}
+
+void DecodedBlockCache::onExecMapped(const BoxedPtr<MappedFileCache>& fileCache, const std::shared_ptr<KFile>& file) {
+    if (KSystem::decodedBlockCacheDir.length() && !fileCache->decodedBlocks) {
+        fileCache->decodedBlocks = new DecodedBlockCache(file);
+    }
+}
+
+bool DecodedBlockCache::getBlock(KThread* thread, U32 address, bool big, DecodedBlock* block) {
+    if (!KSystem::decodedBlockCacheDir.length()) {
+        return false;
+    }
+    BoxedPtr<MappedFile> mapped = thread->process->getMappedFile(address);
+    if (!mapped || !mapped->systemCacheEntry || !mapped->systemCacheEntry->decodedBlocks) {
+        return false;
+    }
+    DecodedBlockCache* cache = mapped->systemCacheEntry->decodedBlocks;
+    if (!cache->load(mapped->offset+(address-mapped->address), big, block)) {
+        return false;
+    }
+    // the decoder can look up to one op past the end of the block
+    if (!isFromFile(mapped, cache->filePageCount, address, block->bytes+K_MAX_X86_OP_LEN)) {
+        block->op->dealloc(true);
+        block->op = NULL;
+        return false;
+    }
+    return true;
+}
+
+void DecodedBlockCache::addBlock(KThread* thread, U32 address, bool big, DecodedBlock* block) {
+    if (!KSystem::decodedBlockCacheDir.length()) {
+        return;
+    }
+    for (DecodedOp* op = block->op; op; op = op->next) {
+        if (op->pfn) {
+            // callbacks hold host function pointers
+            return;
+        }
+    }
+    BoxedPtr<MappedFile> mapped = thread->process->getMappedFile(address);
+    if (!mapped || !mapped->systemCacheEntry || !mapped->systemCacheEntry->decodedBlocks) {
+        return;
+    }
+    DecodedBlockCache* cache = mapped->systemCacheEntry->decodedBlocks;
+    if (isFromFile(mapped, cache->filePageCount, address, block->bytes+K_MAX_X86_OP_LEN)) {
+        cache->save(mapped->offset+(address-mapped->address), big, block);
+    }
+}
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef __DECODED_BLOCK_CACHE_H__
+#define __DECODED_BLOCK_CACHE_H__
+
+#ifdef BOXEDWINE_DEFAULT_MMU
+
+class DecodedBlock;
+
+// Decoded ops for blocks that came straight out of a mapped file, saved to
+// KSystem::decodedBlockCacheDir so the next run doesn't have to decode them
+// again.  The disk file is named after a hash of the mapped file's contents,
+// if the file changes its old entries are simply never looked at again.
+//
+// A block is only used from (or added to) the cache if every page it was
+// decoded from is still the untouched, shared copy of the file page, so
+// relocated or patched code is always decoded from memory.
+class DecodedBlockCache {
+public:
+    // hashes the file and loads what a previous run saved for it
+    DecodedBlockCache(const std::shared_ptr<KFile>& file);
+    ~DecodedBlockCache();
+
+    // called when a file is mapped with exec permission
+    static void onExecMapped(const BoxedPtr<MappedFileCache>& fileCache, const std::shared_ptr<KFile>& file);
+
+    // returns false if the block at address wasn't cached and needs to be decoded
+    static bool getBlock(KThread* thread, U32 address, bool big, DecodedBlock* block);
+    static void addBlock(KThread* thread, U32 address, bool big, DecodedBlock* block);
+
+private:
+    bool load(U64 fileOffset, bool big, DecodedBlock* block);
+    void save(U64 fileOffset, bool big, DecodedBlock* block);
+    void readCacheFile();
+
+    std::string cachePath;
+    U32 filePageCount;
+    FILE* out;
+    std::unordered_map<U64, std::vector<U8> > blocks; // key is fileOffset << 1 | big
+    BOXEDWINE_MUTEX mutex;
+};
+
+#endif
+
+#endif
@@ -2,6 +2,8 @@
 
 #include "../decoder.h"
 #include "normalCPU.h"
+#include "../common/lazyFlagsCondition.h"
+#include "decodedBlockCache.h"
 #include "../../softmmu/soft_code_page.h"
 #include "../x32/x32CPU.h"
 #include "../armv7/armv7CPU.h"
@@ -14,8 +16,15 @@
 #endif
 #define NEXT() cpu->eip.u32+=op->len; op->next->pfn(cpu, op->next)
 #define NEXT_DONE() cpu->nextBlock = cpu->getNextBlock();
-#define NEXT_BRANCH1() cpu->eip.u32+=op->len; if (!DecodedBlock::currentBlock->next1) {DecodedBlock::currentBlock->next1 = cpu->getNextBlock(); DecodedBlock::currentBlock->next1->addReferenceFrom(DecodedBlock::currentBlock);} cpu->nextBlock = DecodedBlock::currentBlock->next1
-#define NEXT_BRANCH2() cpu->eip.u32+=op->len; if (!DecodedBlock::currentBlock->next2) {DecodedBlock::currentBlock->next2 = cpu->getNextBlock(); DecodedBlock::currentBlock->next2->addReferenceFrom(DecodedBlock::currentBlock);} cpu->nextBlock = DecodedBlock::currentBlock->next2
+#define NEXT_BRANCH1() cpu->eip.u32+=op->len; if (!DecodedBlock::currentBlock->next1) {BOXEDWINE_KERNEL_CRITICAL_SECTION; DecodedBlock::currentBlock->next1 = cpu->getNextBlock(); DecodedBlock::currentBlock->next1->addReferenceFrom(DecodedBlock::currentBlock); NormalCPU::removeUnusedFlags(DecodedBlock::currentBlock);} cpu->nextBlock = DecodedBlock::currentBlock->next1; NEXT_TRACE()
+#define NEXT_BRANCH2() cpu->eip.u32+=op->len; if (!DecodedBlock::currentBlock->next2) {BOXEDWINE_KERNEL_CRITICAL_SECTION; DecodedBlock::currentBlock->next2 = cpu->getNextBlock(); DecodedBlock::currentBlock->next2->addReferenceFrom(DecodedBlock::currentBlock); NormalCPU::removeUnusedFlags(DecodedBlock::currentBlock);} cpu->nextBlock = DecodedBlock::currentBlock->next2; NEXT_TRACE()
+
+// Once a block and the block it branches to have both run TRACE_HOT_COUNT times they are on a hot path
+// (a superblock) and the branch goes straight into the next block's ops instead of returning to run().
+// Taking a branch to a block that isn't hot yet is the side exit back to run().  Since the trace only
+// follows next1/next2, a block that gets modified or freed is unlinked from the trace like it always was.
+#define TRACE_HOT_COUNT 64
+#define NEXT_TRACE() if (cpu->traceBlocksLeft && cpu->nextBlock && !cpu->yield && cpu->nextBlock->runCount>=TRACE_HOT_COUNT && DecodedBlock::currentBlock->runCount>=TRACE_HOT_COUNT) {DecodedBlock* block = cpu->nextBlock; cpu->traceBlocksLeft--; DecodedBlock::currentBlock = block; block->runCount++; cpu->blockInstructionCount+=block->opCount; block->op->pfn(cpu, block->op);}
 
 #include "instructions.h"
 #include "normal_arith.h"
@@ -36,10 +45,15 @@
 #include "normal_other.h"
 #include "normal_jump.h"
 #include "normal_move.h"
+#include "normal_noflags.h"
 
 static OpCallback normalOps[NUMBER_OF_OPS];
+static OpCallback normalNoFlagsOps[NUMBER_OF_OPS];
 static U32 normalOpsInitialized;
 
+// kept short, without tail calls (-O1 and debug builds) each chained block is another stack frame
+U32 NormalCPU::maxBlocksPerTrace = 4;
+
 void OPCALL normal_sidt(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);    
     U32 eaa = eaa(cpu, op);
@@ -86,6 +100,22 @@ static void initNormalOps() {
     normalOps[LMSW] = 0;
     normalOps[INVLPG] = 0;
     normalOps[Callback] = 0;
+
+    initNormalNoFlagsOps(normalNoFlagsOps);
+}
+
+// Points each op that has a _noflags version at it if nothing reads its flags before they are set
+// again, otherwise back at the normal op.  It only looks one block past the end of this one, so the
+// result depends only on this block's own next1/next2, it needs to run again when either of them is
+// linked or unlinked.  A branch that isn't linked yet counts as reading every flag.
+void NormalCPU::removeUnusedFlags(DecodedBlock* block) {
+    for (DecodedOp* op = block->op; op; op = op->next) {
+        OpCallback noFlags = normalNoFlagsOps[op->inst];
+        if (noFlags) {
+            U32 flags = instructionInfo[op->inst].flagsSets & ~MAYBE;
+            op->pfn = (DecodedOp::getNeededFlags(block, op, flags, 1) ? normalOps[op->inst] : noFlags);
+        }
+    }
 }
 
 OpCallback NormalCPU::getFunctionForOp(DecodedOp* op) {
@@ -135,9 +165,10 @@ void NormalBlock::run(CPU* cpu) {
         kpanic("NormalBlock::run is about to crash");
     }
 #endif  
-    this->op->pfn(cpu, this->op);
+    // counted first, if the block chains into a hot block this block might be freed before the ops return
     this->runCount++;
     cpu->blockInstructionCount+=this->opCount;
+    this->op->pfn(cpu, this->op);
 }
 
 static NormalBlock* freeBlocks;
@@ -214,6 +245,8 @@ void NormalBlock::dealloc(bool delayed) {
         if (from->block->next2 == this) {
             from->block->next2 = NULL;
         }
+        // whatever replaces this block might read the flags
+        NormalCPU::removeUnusedFlags(from->block);
         from->dealloc();
         from = n;
     }
@@ -234,8 +267,16 @@ DecodedBlock* NormalCPU::getNextBlock() {
     DecodedBlock* block = this->thread->memory->getCodeBlock(startIp);
 
     if (!block) {
+        BOXEDWINE_KERNEL_CRITICAL_SECTION;
         block = NormalBlock::alloc();
+#ifdef BOXEDWINE_DEFAULT_MMU
+        if (!DecodedBlockCache::getBlock(this->thread, startIp, this->isBig(), block)) {
+            decodeBlock(fetchByte, startIp, this->isBig(), 0, K_PAGE_SIZE, 0, block);
+            DecodedBlockCache::addBlock(this->thread, startIp, this->isBig(), block);
+        }
+#else
         decodeBlock(fetchByte, startIp, this->isBig(), 0, K_PAGE_SIZE, 0, block);
+#endif
 
         DecodedOp* op = block->op;
         while (op) {
@@ -243,6 +284,7 @@ DecodedBlock* NormalCPU::getNextBlock() {
                 op->pfn = normalOps[op->inst];
             op = op->next;
         }
+        NormalCPU::removeUnusedFlags(block);
         this->thread->memory->addCodeBlock(startIp, block);
         if (this->firstOp) {
             op = DecodedOp::alloc();
@@ -257,6 +299,7 @@ DecodedBlock* NormalCPU::getNextBlock() {
 
 void NormalCPU::run() {    
     DecodedBlock::currentBlock = this->nextBlock;
+    this->traceBlocksLeft = NormalCPU::maxBlocksPerTrace;
     DecodedBlock::currentBlock->run(this);    
 #ifdef _DEBUG
     if (!this->nextBlock && !this->yield) {
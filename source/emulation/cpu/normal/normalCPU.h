@@ -16,7 +16,13 @@ public:
 
     static DecodedBlock* getBlockForInspectionButNotUsed(U32 address, bool big);
 
+    // switches ops in the block between their flag setting and _noflags versions
+    static void removeUnusedFlags(DecodedBlock* block);
+
     OpCallback firstOp;
+
+    // how many hot blocks can run back to back without going through run(), 0 turns it off
+    static U32 maxBlocksPerTrace;
 };
 
 #endif
\ No newline at end of file
@@ -18,448 +18,448 @@
 
 void OPCALL normal_cmovO_16_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_O)) {
         cpu->reg[op->reg].u16 = cpu->reg[op->rm].u16;
     }
     NEXT();
 }
 void OPCALL normal_cmovO_16_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_O)) {
         cpu->reg[op->reg].u16 = readw(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovO_32_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_O)) {
         cpu->reg[op->reg].u32 = cpu->reg[op->rm].u32;
     }
     NEXT();
 }
 void OPCALL normal_cmovO_32_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_O)) {
         cpu->reg[op->reg].u32 = readd(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovNO_16_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NO)) {
         cpu->reg[op->reg].u16 = cpu->reg[op->rm].u16;
     }
     NEXT();
 }
 void OPCALL normal_cmovNO_16_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NO)) {
         cpu->reg[op->reg].u16 = readw(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovNO_32_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NO)) {
         cpu->reg[op->reg].u32 = cpu->reg[op->rm].u32;
     }
     NEXT();
 }
 void OPCALL normal_cmovNO_32_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NO)) {
         cpu->reg[op->reg].u32 = readd(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovB_16_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getCF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_B)) {
         cpu->reg[op->reg].u16 = cpu->reg[op->rm].u16;
     }
     NEXT();
 }
 void OPCALL normal_cmovB_16_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getCF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_B)) {
         cpu->reg[op->reg].u16 = readw(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovB_32_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getCF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_B)) {
         cpu->reg[op->reg].u32 = cpu->reg[op->rm].u32;
     }
     NEXT();
 }
 void OPCALL normal_cmovB_32_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getCF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_B)) {
         cpu->reg[op->reg].u32 = readd(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovNB_16_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getCF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NB)) {
         cpu->reg[op->reg].u16 = cpu->reg[op->rm].u16;
     }
     NEXT();
 }
 void OPCALL normal_cmovNB_16_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getCF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NB)) {
         cpu->reg[op->reg].u16 = readw(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovNB_32_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getCF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NB)) {
         cpu->reg[op->reg].u32 = cpu->reg[op->rm].u32;
     }
     NEXT();
 }
 void OPCALL normal_cmovNB_32_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getCF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NB)) {
         cpu->reg[op->reg].u32 = readd(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovZ_16_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getZF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_Z)) {
         cpu->reg[op->reg].u16 = cpu->reg[op->rm].u16;
     }
     NEXT();
 }
 void OPCALL normal_cmovZ_16_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getZF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_Z)) {
         cpu->reg[op->reg].u16 = readw(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovZ_32_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getZF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_Z)) {
         cpu->reg[op->reg].u32 = cpu->reg[op->rm].u32;
     }
     NEXT();
 }
 void OPCALL normal_cmovZ_32_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getZF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_Z)) {
         cpu->reg[op->reg].u32 = readd(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovNZ_16_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getZF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NZ)) {
         cpu->reg[op->reg].u16 = cpu->reg[op->rm].u16;
     }
     NEXT();
 }
 void OPCALL normal_cmovNZ_16_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getZF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NZ)) {
         cpu->reg[op->reg].u16 = readw(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovNZ_32_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getZF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NZ)) {
         cpu->reg[op->reg].u32 = cpu->reg[op->rm].u32;
     }
     NEXT();
 }
 void OPCALL normal_cmovNZ_32_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getZF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NZ)) {
         cpu->reg[op->reg].u32 = readd(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovBE_16_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getZF() || cpu->getCF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_BE)) {
         cpu->reg[op->reg].u16 = cpu->reg[op->rm].u16;
     }
     NEXT();
 }
 void OPCALL normal_cmovBE_16_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getZF() || cpu->getCF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_BE)) {
         cpu->reg[op->reg].u16 = readw(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovBE_32_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getZF() || cpu->getCF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_BE)) {
         cpu->reg[op->reg].u32 = cpu->reg[op->rm].u32;
     }
     NEXT();
 }
 void OPCALL normal_cmovBE_32_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getZF() || cpu->getCF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_BE)) {
         cpu->reg[op->reg].u32 = readd(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovNBE_16_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getZF() && !cpu->getCF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NBE)) {
         cpu->reg[op->reg].u16 = cpu->reg[op->rm].u16;
     }
     NEXT();
 }
 void OPCALL normal_cmovNBE_16_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getZF() && !cpu->getCF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NBE)) {
         cpu->reg[op->reg].u16 = readw(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovNBE_32_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getZF() && !cpu->getCF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NBE)) {
         cpu->reg[op->reg].u32 = cpu->reg[op->rm].u32;
     }
     NEXT();
 }
 void OPCALL normal_cmovNBE_32_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getZF() && !cpu->getCF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NBE)) {
         cpu->reg[op->reg].u32 = readd(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovS_16_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getSF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_S)) {
         cpu->reg[op->reg].u16 = cpu->reg[op->rm].u16;
     }
     NEXT();
 }
 void OPCALL normal_cmovS_16_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getSF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_S)) {
         cpu->reg[op->reg].u16 = readw(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovS_32_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getSF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_S)) {
         cpu->reg[op->reg].u32 = cpu->reg[op->rm].u32;
     }
     NEXT();
 }
 void OPCALL normal_cmovS_32_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getSF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_S)) {
         cpu->reg[op->reg].u32 = readd(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovNS_16_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getSF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NS)) {
         cpu->reg[op->reg].u16 = cpu->reg[op->rm].u16;
     }
     NEXT();
 }
 void OPCALL normal_cmovNS_16_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getSF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NS)) {
         cpu->reg[op->reg].u16 = readw(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovNS_32_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getSF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NS)) {
         cpu->reg[op->reg].u32 = cpu->reg[op->rm].u32;
     }
     NEXT();
 }
 void OPCALL normal_cmovNS_32_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getSF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NS)) {
         cpu->reg[op->reg].u32 = readd(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovP_16_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getPF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_P)) {
         cpu->reg[op->reg].u16 = cpu->reg[op->rm].u16;
     }
     NEXT();
 }
 void OPCALL normal_cmovP_16_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getPF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_P)) {
         cpu->reg[op->reg].u16 = readw(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovP_32_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getPF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_P)) {
         cpu->reg[op->reg].u32 = cpu->reg[op->rm].u32;
     }
     NEXT();
 }
 void OPCALL normal_cmovP_32_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getPF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_P)) {
         cpu->reg[op->reg].u32 = readd(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovNP_16_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getPF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NP)) {
         cpu->reg[op->reg].u16 = cpu->reg[op->rm].u16;
     }
     NEXT();
 }
 void OPCALL normal_cmovNP_16_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getPF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NP)) {
         cpu->reg[op->reg].u16 = readw(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovNP_32_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getPF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NP)) {
         cpu->reg[op->reg].u32 = cpu->reg[op->rm].u32;
     }
     NEXT();
 }
 void OPCALL normal_cmovNP_32_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getPF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NP)) {
         cpu->reg[op->reg].u32 = readd(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovL_16_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getSF()!=cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_L)) {
         cpu->reg[op->reg].u16 = cpu->reg[op->rm].u16;
     }
     NEXT();
 }
 void OPCALL normal_cmovL_16_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getSF()!=cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_L)) {
         cpu->reg[op->reg].u16 = readw(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovL_32_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getSF()!=cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_L)) {
         cpu->reg[op->reg].u32 = cpu->reg[op->rm].u32;
     }
     NEXT();
 }
 void OPCALL normal_cmovL_32_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getSF()!=cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_L)) {
         cpu->reg[op->reg].u32 = readd(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovNL_16_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getSF()==cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NL)) {
         cpu->reg[op->reg].u16 = cpu->reg[op->rm].u16;
     }
     NEXT();
 }
 void OPCALL normal_cmovNL_16_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getSF()==cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NL)) {
         cpu->reg[op->reg].u16 = readw(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovNL_32_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getSF()==cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NL)) {
         cpu->reg[op->reg].u32 = cpu->reg[op->rm].u32;
     }
     NEXT();
 }
 void OPCALL normal_cmovNL_32_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getSF()==cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NL)) {
         cpu->reg[op->reg].u32 = readd(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovLE_16_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getZF() || cpu->getSF()!=cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_LE)) {
         cpu->reg[op->reg].u16 = cpu->reg[op->rm].u16;
     }
     NEXT();
 }
 void OPCALL normal_cmovLE_16_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getZF() || cpu->getSF()!=cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_LE)) {
         cpu->reg[op->reg].u16 = readw(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovLE_32_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getZF() || cpu->getSF()!=cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_LE)) {
         cpu->reg[op->reg].u32 = cpu->reg[op->rm].u32;
     }
     NEXT();
 }
 void OPCALL normal_cmovLE_32_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getZF() || cpu->getSF()!=cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_LE)) {
         cpu->reg[op->reg].u32 = readd(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovNLE_16_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getZF() && cpu->getSF()==cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NLE)) {
         cpu->reg[op->reg].u16 = cpu->reg[op->rm].u16;
     }
     NEXT();
 }
 void OPCALL normal_cmovNLE_16_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getZF() && cpu->getSF()==cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NLE)) {
         cpu->reg[op->reg].u16 = readw(eaa(cpu, op));
     }
     NEXT();
 }
 void OPCALL normal_cmovNLE_32_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getZF() && cpu->getSF()==cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NLE)) {
         cpu->reg[op->reg].u32 = cpu->reg[op->rm].u32;
     }
     NEXT();
 }
 void OPCALL normal_cmovNLE_32_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getZF() && cpu->getSF()==cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NLE)) {
         cpu->reg[op->reg].u32 = readd(eaa(cpu, op));
     }
     NEXT();
@@ -18,65 +18,65 @@
 
 void OPCALL normal_jumpO(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getOF()) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
+    if (lazyFlagsCondition(cpu, CONDITION_O)) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
 }
 void OPCALL normal_jumpNO(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getOF()) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
+    if (lazyFlagsCondition(cpu, CONDITION_NO)) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
 }
 void OPCALL normal_jumpB(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getCF()) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
+    if (lazyFlagsCondition(cpu, CONDITION_B)) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
 }
 void OPCALL normal_jumpNB(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getCF()) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
+    if (lazyFlagsCondition(cpu, CONDITION_NB)) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
 }
 void OPCALL normal_jumpZ(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getZF()) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
+    if (lazyFlagsCondition(cpu, CONDITION_Z)) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
 }
 void OPCALL normal_jumpNZ(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getZF()) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
+    if (lazyFlagsCondition(cpu, CONDITION_NZ)) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
 }
 void OPCALL normal_jumpBE(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getZF() || cpu->getCF()) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
+    if (lazyFlagsCondition(cpu, CONDITION_BE)) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
 }
 void OPCALL normal_jumpNBE(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getZF() && !cpu->getCF()) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
+    if (lazyFlagsCondition(cpu, CONDITION_NBE)) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
 }
 void OPCALL normal_jumpS(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getSF()) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
+    if (lazyFlagsCondition(cpu, CONDITION_S)) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
 }
 void OPCALL normal_jumpNS(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getSF()) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
+    if (lazyFlagsCondition(cpu, CONDITION_NS)) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
 }
 void OPCALL normal_jumpP(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getPF()) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
+    if (lazyFlagsCondition(cpu, CONDITION_P)) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
 }
 void OPCALL normal_jumpNP(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getPF()) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
+    if (lazyFlagsCondition(cpu, CONDITION_NP)) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
 }
 void OPCALL normal_jumpL(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getSF()!=cpu->getOF()) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
+    if (lazyFlagsCondition(cpu, CONDITION_L)) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
 }
 void OPCALL normal_jumpNL(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getSF()==cpu->getOF()) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
+    if (lazyFlagsCondition(cpu, CONDITION_NL)) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
 }
 void OPCALL normal_jumpLE(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getZF() || cpu->getSF()!=cpu->getOF()) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
+    if (lazyFlagsCondition(cpu, CONDITION_LE)) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
 }
 void OPCALL normal_jumpNLE(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getZF() && cpu->getSF()==cpu->getOF()) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
+    if (lazyFlagsCondition(cpu, CONDITION_NLE)) {cpu->eip.u32+=op->imm; NEXT_BRANCH1();} else {NEXT_BRANCH2();}
 }
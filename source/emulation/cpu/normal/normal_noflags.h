@@ -0,0 +1,584 @@
+/*
+ *  Copyright (C) 2016  The BoxedWine Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+// Same as the ops in normal_arith.h and normal_incdec.h but they leave the lazy flags alone, the pass in
+// normalCPU.cpp only uses them when nothing reads the flags before they are set again.
+
+void OPCALL normal_addr8r8_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    *cpu->reg8[op->reg] = *cpu->reg8[op->reg] + *cpu->reg8[op->rm];
+    NEXT();
+}
+void OPCALL normal_adde8r8_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writeb(eaa, readb(eaa) + *cpu->reg8[op->reg]);
+    NEXT();
+}
+void OPCALL normal_addr8e8_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    *cpu->reg8[op->reg] = *cpu->reg8[op->reg] + readb(eaa(cpu, op));
+    NEXT();
+}
+void OPCALL normal_add8_reg_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    *cpu->reg8[op->reg] = *cpu->reg8[op->reg] + op->imm;
+    NEXT();
+}
+void OPCALL normal_add8_mem_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writeb(eaa, readb(eaa) + op->imm);
+    NEXT();
+}
+void OPCALL normal_addr16r16_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u16 = cpu->reg[op->reg].u16 + cpu->reg[op->rm].u16;
+    NEXT();
+}
+void OPCALL normal_adde16r16_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writew(eaa, readw(eaa) + cpu->reg[op->reg].u16);
+    NEXT();
+}
+void OPCALL normal_addr16e16_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u16 = cpu->reg[op->reg].u16 + readw(eaa(cpu, op));
+    NEXT();
+}
+void OPCALL normal_add16_reg_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u16 = cpu->reg[op->reg].u16 + op->imm;
+    NEXT();
+}
+void OPCALL normal_add16_mem_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writew(eaa, readw(eaa) + op->imm);
+    NEXT();
+}
+void OPCALL normal_addr32r32_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u32 = cpu->reg[op->reg].u32 + cpu->reg[op->rm].u32;
+    NEXT();
+}
+void OPCALL normal_adde32r32_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writed(eaa, readd(eaa) + cpu->reg[op->reg].u32);
+    NEXT();
+}
+void OPCALL normal_addr32e32_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u32 = cpu->reg[op->reg].u32 + readd(eaa(cpu, op));
+    NEXT();
+}
+void OPCALL normal_add32_reg_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u32 = cpu->reg[op->reg].u32 + op->imm;
+    NEXT();
+}
+void OPCALL normal_add32_mem_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writed(eaa, readd(eaa) + op->imm);
+    NEXT();
+}
+void OPCALL normal_orr8r8_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    *cpu->reg8[op->reg] = *cpu->reg8[op->reg] | *cpu->reg8[op->rm];
+    NEXT();
+}
+void OPCALL normal_ore8r8_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writeb(eaa, readb(eaa) | *cpu->reg8[op->reg]);
+    NEXT();
+}
+void OPCALL normal_orr8e8_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    *cpu->reg8[op->reg] = *cpu->reg8[op->reg] | readb(eaa(cpu, op));
+    NEXT();
+}
+void OPCALL normal_or8_reg_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    *cpu->reg8[op->reg] = *cpu->reg8[op->reg] | op->imm;
+    NEXT();
+}
+void OPCALL normal_or8_mem_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writeb(eaa, readb(eaa) | op->imm);
+    NEXT();
+}
+void OPCALL normal_orr16r16_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u16 = cpu->reg[op->reg].u16 | cpu->reg[op->rm].u16;
+    NEXT();
+}
+void OPCALL normal_ore16r16_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writew(eaa, readw(eaa) | cpu->reg[op->reg].u16);
+    NEXT();
+}
+void OPCALL normal_orr16e16_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u16 = cpu->reg[op->reg].u16 | readw(eaa(cpu, op));
+    NEXT();
+}
+void OPCALL normal_or16_reg_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u16 = cpu->reg[op->reg].u16 | op->imm;
+    NEXT();
+}
+void OPCALL normal_or16_mem_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writew(eaa, readw(eaa) | op->imm);
+    NEXT();
+}
+void OPCALL normal_orr32r32_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u32 = cpu->reg[op->reg].u32 | cpu->reg[op->rm].u32;
+    NEXT();
+}
+void OPCALL normal_ore32r32_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writed(eaa, readd(eaa) | cpu->reg[op->reg].u32);
+    NEXT();
+}
+void OPCALL normal_orr32e32_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u32 = cpu->reg[op->reg].u32 | readd(eaa(cpu, op));
+    NEXT();
+}
+void OPCALL normal_or32_reg_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u32 = cpu->reg[op->reg].u32 | op->imm;
+    NEXT();
+}
+void OPCALL normal_or32_mem_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writed(eaa, readd(eaa) | op->imm);
+    NEXT();
+}
+void OPCALL normal_andr8r8_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    *cpu->reg8[op->reg] = *cpu->reg8[op->reg] & *cpu->reg8[op->rm];
+    NEXT();
+}
+void OPCALL normal_ande8r8_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writeb(eaa, readb(eaa) & *cpu->reg8[op->reg]);
+    NEXT();
+}
+void OPCALL normal_andr8e8_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    *cpu->reg8[op->reg] = *cpu->reg8[op->reg] & readb(eaa(cpu, op));
+    NEXT();
+}
+void OPCALL normal_and8_reg_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    *cpu->reg8[op->reg] = *cpu->reg8[op->reg] & op->imm;
+    NEXT();
+}
+void OPCALL normal_and8_mem_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writeb(eaa, readb(eaa) & op->imm);
+    NEXT();
+}
+void OPCALL normal_andr16r16_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u16 = cpu->reg[op->reg].u16 & cpu->reg[op->rm].u16;
+    NEXT();
+}
+void OPCALL normal_ande16r16_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writew(eaa, readw(eaa) & cpu->reg[op->reg].u16);
+    NEXT();
+}
+void OPCALL normal_andr16e16_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u16 = cpu->reg[op->reg].u16 & readw(eaa(cpu, op));
+    NEXT();
+}
+void OPCALL normal_and16_reg_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u16 = cpu->reg[op->reg].u16 & op->imm;
+    NEXT();
+}
+void OPCALL normal_and16_mem_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writew(eaa, readw(eaa) & op->imm);
+    NEXT();
+}
+void OPCALL normal_andr32r32_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u32 = cpu->reg[op->reg].u32 & cpu->reg[op->rm].u32;
+    NEXT();
+}
+void OPCALL normal_ande32r32_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writed(eaa, readd(eaa) & cpu->reg[op->reg].u32);
+    NEXT();
+}
+void OPCALL normal_andr32e32_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u32 = cpu->reg[op->reg].u32 & readd(eaa(cpu, op));
+    NEXT();
+}
+void OPCALL normal_and32_reg_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u32 = cpu->reg[op->reg].u32 & op->imm;
+    NEXT();
+}
+void OPCALL normal_and32_mem_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writed(eaa, readd(eaa) & op->imm);
+    NEXT();
+}
+void OPCALL normal_subr8r8_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    *cpu->reg8[op->reg] = *cpu->reg8[op->reg] - *cpu->reg8[op->rm];
+    NEXT();
+}
+void OPCALL normal_sube8r8_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writeb(eaa, readb(eaa) - *cpu->reg8[op->reg]);
+    NEXT();
+}
+void OPCALL normal_subr8e8_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    *cpu->reg8[op->reg] = *cpu->reg8[op->reg] - readb(eaa(cpu, op));
+    NEXT();
+}
+void OPCALL normal_sub8_reg_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    *cpu->reg8[op->reg] = *cpu->reg8[op->reg] - op->imm;
+    NEXT();
+}
+void OPCALL normal_sub8_mem_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writeb(eaa, readb(eaa) - op->imm);
+    NEXT();
+}
+void OPCALL normal_subr16r16_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u16 = cpu->reg[op->reg].u16 - cpu->reg[op->rm].u16;
+    NEXT();
+}
+void OPCALL normal_sube16r16_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writew(eaa, readw(eaa) - cpu->reg[op->reg].u16);
+    NEXT();
+}
+void OPCALL normal_subr16e16_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u16 = cpu->reg[op->reg].u16 - readw(eaa(cpu, op));
+    NEXT();
+}
+void OPCALL normal_sub16_reg_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u16 = cpu->reg[op->reg].u16 - op->imm;
+    NEXT();
+}
+void OPCALL normal_sub16_mem_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writew(eaa, readw(eaa) - op->imm);
+    NEXT();
+}
+void OPCALL normal_subr32r32_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u32 = cpu->reg[op->reg].u32 - cpu->reg[op->rm].u32;
+    NEXT();
+}
+void OPCALL normal_sube32r32_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writed(eaa, readd(eaa) - cpu->reg[op->reg].u32);
+    NEXT();
+}
+void OPCALL normal_subr32e32_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u32 = cpu->reg[op->reg].u32 - readd(eaa(cpu, op));
+    NEXT();
+}
+void OPCALL normal_sub32_reg_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u32 = cpu->reg[op->reg].u32 - op->imm;
+    NEXT();
+}
+void OPCALL normal_sub32_mem_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writed(eaa, readd(eaa) - op->imm);
+    NEXT();
+}
+void OPCALL normal_xorr8r8_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    *cpu->reg8[op->reg] = *cpu->reg8[op->reg] ^ *cpu->reg8[op->rm];
+    NEXT();
+}
+void OPCALL normal_xore8r8_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writeb(eaa, readb(eaa) ^ *cpu->reg8[op->reg]);
+    NEXT();
+}
+void OPCALL normal_xorr8e8_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    *cpu->reg8[op->reg] = *cpu->reg8[op->reg] ^ readb(eaa(cpu, op));
+    NEXT();
+}
+void OPCALL normal_xor8_reg_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    *cpu->reg8[op->reg] = *cpu->reg8[op->reg] ^ op->imm;
+    NEXT();
+}
+void OPCALL normal_xor8_mem_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writeb(eaa, readb(eaa) ^ op->imm);
+    NEXT();
+}
+void OPCALL normal_xorr16r16_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u16 = cpu->reg[op->reg].u16 ^ cpu->reg[op->rm].u16;
+    NEXT();
+}
+void OPCALL normal_xore16r16_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writew(eaa, readw(eaa) ^ cpu->reg[op->reg].u16);
+    NEXT();
+}
+void OPCALL normal_xorr16e16_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u16 = cpu->reg[op->reg].u16 ^ readw(eaa(cpu, op));
+    NEXT();
+}
+void OPCALL normal_xor16_reg_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u16 = cpu->reg[op->reg].u16 ^ op->imm;
+    NEXT();
+}
+void OPCALL normal_xor16_mem_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writew(eaa, readw(eaa) ^ op->imm);
+    NEXT();
+}
+void OPCALL normal_xorr32r32_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u32 = cpu->reg[op->reg].u32 ^ cpu->reg[op->rm].u32;
+    NEXT();
+}
+void OPCALL normal_xore32r32_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writed(eaa, readd(eaa) ^ cpu->reg[op->reg].u32);
+    NEXT();
+}
+void OPCALL normal_xorr32e32_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u32 = cpu->reg[op->reg].u32 ^ readd(eaa(cpu, op));
+    NEXT();
+}
+void OPCALL normal_xor32_reg_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u32 = cpu->reg[op->reg].u32 ^ op->imm;
+    NEXT();
+}
+void OPCALL normal_xor32_mem_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writed(eaa, readd(eaa) ^ op->imm);
+    NEXT();
+}
+void OPCALL normal_inc8_reg_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    *cpu->reg8[op->reg] = *cpu->reg8[op->reg] + 1;
+    NEXT();
+}
+void OPCALL normal_inc8_mem32_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writeb(eaa, readb(eaa) + 1);
+    NEXT();
+}
+void OPCALL normal_inc16_reg_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u16 = cpu->reg[op->reg].u16 + 1;
+    NEXT();
+}
+void OPCALL normal_inc16_mem32_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writew(eaa, readw(eaa) + 1);
+    NEXT();
+}
+void OPCALL normal_inc32_reg_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u32 = cpu->reg[op->reg].u32 + 1;
+    NEXT();
+}
+void OPCALL normal_inc32_mem32_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writed(eaa, readd(eaa) + 1);
+    NEXT();
+}
+void OPCALL normal_dec8_reg_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    *cpu->reg8[op->reg] = *cpu->reg8[op->reg] - 1;
+    NEXT();
+}
+void OPCALL normal_dec8_mem32_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writeb(eaa, readb(eaa) - 1);
+    NEXT();
+}
+void OPCALL normal_dec16_reg_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u16 = cpu->reg[op->reg].u16 - 1;
+    NEXT();
+}
+void OPCALL normal_dec16_mem32_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writew(eaa, readw(eaa) - 1);
+    NEXT();
+}
+void OPCALL normal_dec32_reg_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    cpu->reg[op->reg].u32 = cpu->reg[op->reg].u32 - 1;
+    NEXT();
+}
+void OPCALL normal_dec32_mem32_noflags(CPU* cpu, DecodedOp* op) {
+    START_OP(cpu, op);
+    U32 eaa = eaa(cpu, op);
+    writed(eaa, readd(eaa) - 1);
+    NEXT();
+}
+
+static void initNormalNoFlagsOps(OpCallback* ops) {
+#define INIT_CPU_NOFLAGS(e, f) ops[e] = normal_##f##_noflags;
+    INIT_CPU_NOFLAGS(AddR8R8, addr8r8)
+    INIT_CPU_NOFLAGS(AddE8R8, adde8r8)
+    INIT_CPU_NOFLAGS(AddR8E8, addr8e8)
+    INIT_CPU_NOFLAGS(AddR8I8, add8_reg)
+    INIT_CPU_NOFLAGS(AddE8I8, add8_mem)
+    INIT_CPU_NOFLAGS(AddR16R16, addr16r16)
+    INIT_CPU_NOFLAGS(AddE16R16, adde16r16)
+    INIT_CPU_NOFLAGS(AddR16E16, addr16e16)
+    INIT_CPU_NOFLAGS(AddR16I16, add16_reg)
+    INIT_CPU_NOFLAGS(AddE16I16, add16_mem)
+    INIT_CPU_NOFLAGS(AddR32R32, addr32r32)
+    INIT_CPU_NOFLAGS(AddE32R32, adde32r32)
+    INIT_CPU_NOFLAGS(AddR32E32, addr32e32)
+    INIT_CPU_NOFLAGS(AddR32I32, add32_reg)
+    INIT_CPU_NOFLAGS(AddE32I32, add32_mem)
+    INIT_CPU_NOFLAGS(OrR8R8, orr8r8)
+    INIT_CPU_NOFLAGS(OrE8R8, ore8r8)
+    INIT_CPU_NOFLAGS(OrR8E8, orr8e8)
+    INIT_CPU_NOFLAGS(OrR8I8, or8_reg)
+    INIT_CPU_NOFLAGS(OrE8I8, or8_mem)
+    INIT_CPU_NOFLAGS(OrR16R16, orr16r16)
+    INIT_CPU_NOFLAGS(OrE16R16, ore16r16)
+    INIT_CPU_NOFLAGS(OrR16E16, orr16e16)
+    INIT_CPU_NOFLAGS(OrR16I16, or16_reg)
+    INIT_CPU_NOFLAGS(OrE16I16, or16_mem)
+    INIT_CPU_NOFLAGS(OrR32R32, orr32r32)
+    INIT_CPU_NOFLAGS(OrE32R32, ore32r32)
+    INIT_CPU_NOFLAGS(OrR32E32, orr32e32)
+    INIT_CPU_NOFLAGS(OrR32I32, or32_reg)
+    INIT_CPU_NOFLAGS(OrE32I32, or32_mem)
+    INIT_CPU_NOFLAGS(AndR8R8, andr8r8)
+    INIT_CPU_NOFLAGS(AndE8R8, ande8r8)
+    INIT_CPU_NOFLAGS(AndR8E8, andr8e8)
+    INIT_CPU_NOFLAGS(AndR8I8, and8_reg)
+    INIT_CPU_NOFLAGS(AndE8I8, and8_mem)
+    INIT_CPU_NOFLAGS(AndR16R16, andr16r16)
+    INIT_CPU_NOFLAGS(AndE16R16, ande16r16)
+    INIT_CPU_NOFLAGS(AndR16E16, andr16e16)
+    INIT_CPU_NOFLAGS(AndR16I16, and16_reg)
+    INIT_CPU_NOFLAGS(AndE16I16, and16_mem)
+    INIT_CPU_NOFLAGS(AndR32R32, andr32r32)
+    INIT_CPU_NOFLAGS(AndE32R32, ande32r32)
+    INIT_CPU_NOFLAGS(AndR32E32, andr32e32)
+    INIT_CPU_NOFLAGS(AndR32I32, and32_reg)
+    INIT_CPU_NOFLAGS(AndE32I32, and32_mem)
+    INIT_CPU_NOFLAGS(SubR8R8, subr8r8)
+    INIT_CPU_NOFLAGS(SubE8R8, sube8r8)
+    INIT_CPU_NOFLAGS(SubR8E8, subr8e8)
+    INIT_CPU_NOFLAGS(SubR8I8, sub8_reg)
+    INIT_CPU_NOFLAGS(SubE8I8, sub8_mem)
+    INIT_CPU_NOFLAGS(SubR16R16, subr16r16)
+    INIT_CPU_NOFLAGS(SubE16R16, sube16r16)
+    INIT_CPU_NOFLAGS(SubR16E16, subr16e16)
+    INIT_CPU_NOFLAGS(SubR16I16, sub16_reg)
+    INIT_CPU_NOFLAGS(SubE16I16, sub16_mem)
+    INIT_CPU_NOFLAGS(SubR32R32, subr32r32)
+    INIT_CPU_NOFLAGS(SubE32R32, sube32r32)
+    INIT_CPU_NOFLAGS(SubR32E32, subr32e32)
+    INIT_CPU_NOFLAGS(SubR32I32, sub32_reg)
+    INIT_CPU_NOFLAGS(SubE32I32, sub32_mem)
+    INIT_CPU_NOFLAGS(XorR8R8, xorr8r8)
+    INIT_CPU_NOFLAGS(XorE8R8, xore8r8)
+    INIT_CPU_NOFLAGS(XorR8E8, xorr8e8)
+    INIT_CPU_NOFLAGS(XorR8I8, xor8_reg)
+    INIT_CPU_NOFLAGS(XorE8I8, xor8_mem)
+    INIT_CPU_NOFLAGS(XorR16R16, xorr16r16)
+    INIT_CPU_NOFLAGS(XorE16R16, xore16r16)
+    INIT_CPU_NOFLAGS(XorR16E16, xorr16e16)
+    INIT_CPU_NOFLAGS(XorR16I16, xor16_reg)
+    INIT_CPU_NOFLAGS(XorE16I16, xor16_mem)
+    INIT_CPU_NOFLAGS(XorR32R32, xorr32r32)
+    INIT_CPU_NOFLAGS(XorE32R32, xore32r32)
+    INIT_CPU_NOFLAGS(XorR32E32, xorr32e32)
+    INIT_CPU_NOFLAGS(XorR32I32, xor32_reg)
+    INIT_CPU_NOFLAGS(XorE32I32, xor32_mem)
+    INIT_CPU_NOFLAGS(IncR8, inc8_reg)
+    INIT_CPU_NOFLAGS(IncE8, inc8_mem32)
+    INIT_CPU_NOFLAGS(IncR16, inc16_reg)
+    INIT_CPU_NOFLAGS(IncE16, inc16_mem32)
+    INIT_CPU_NOFLAGS(IncR32, inc32_reg)
+    INIT_CPU_NOFLAGS(IncE32, inc32_mem32)
+    INIT_CPU_NOFLAGS(DecR8, dec8_reg)
+    INIT_CPU_NOFLAGS(DecE8, dec8_mem32)
+    INIT_CPU_NOFLAGS(DecR16, dec16_reg)
+    INIT_CPU_NOFLAGS(DecE16, dec16_mem32)
+    INIT_CPU_NOFLAGS(DecR32, dec32_reg)
+    INIT_CPU_NOFLAGS(DecE32, dec32_mem32)
+#undef INIT_CPU_NOFLAGS
+}
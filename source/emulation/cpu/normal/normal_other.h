@@ -184,18 +184,38 @@ void OPCALL normal_int80(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_int98(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    U32 index = cpu->peek32(0);
-    if (index<wine_callbackSize && wine_callback[index]) {
-        wine_callback[index](cpu);
-    } else {
-        kpanic("Uknown int 98 call: %d", index);
+#ifdef BOXEDWINE_CPU_WORKERS
+    // the callbacks drive SDL, the main thread will run this instruction again
+    if (moveToMainThread(cpu->thread)) {
+        cpu->nextBlock = NULL;
+        return;
+    }
+#endif
+    {
+        BOXEDWINE_KERNEL_CRITICAL_SECTION;
+        U32 index = cpu->peek32(0);
+        if (index<wine_callbackSize && wine_callback[index]) {
+            wine_callback[index](cpu);
+        } else {
+            kpanic("Uknown int 98 call: %d", index);
+        }
     }
     NEXT();
 }
 void OPCALL normal_int99(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    U32 index = cpu->peek32(0);
-    callOpenGL(cpu, index);
+#ifdef BOXEDWINE_CPU_WORKERS
+    // OpenGL contexts belong to the main thread, it will run this instruction again
+    if (moveToMainThread(cpu->thread)) {
+        cpu->nextBlock = NULL;
+        return;
+    }
+#endif
+    {
+        BOXEDWINE_KERNEL_CRITICAL_SECTION;
+        U32 index = cpu->peek32(0);
+        callOpenGL(cpu, index);
+    }
     NEXT();
 }
 void OPCALL normal_intIb(CPU* cpu, DecodedOp* op) {
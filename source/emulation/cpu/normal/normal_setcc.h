@@ -18,7 +18,7 @@
 
 void OPCALL normal_setO_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_O)) {
         *cpu->reg8[op->reg] = 1;
     } else {
         *cpu->reg8[op->reg] = 0;
@@ -27,7 +27,7 @@ void OPCALL normal_setO_reg(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setO_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_O)) {
         writeb(eaa(cpu, op), 1);
     } else {
         writeb(eaa(cpu, op), 0);
@@ -36,7 +36,7 @@ void OPCALL normal_setO_mem(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setNO_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NO)) {
         *cpu->reg8[op->reg] = 1;
     } else {
         *cpu->reg8[op->reg] = 0;
@@ -45,7 +45,7 @@ void OPCALL normal_setNO_reg(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setNO_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NO)) {
         writeb(eaa(cpu, op), 1);
     } else {
         writeb(eaa(cpu, op), 0);
@@ -54,7 +54,7 @@ void OPCALL normal_setNO_mem(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setB_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getCF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_B)) {
         *cpu->reg8[op->reg] = 1;
     } else {
         *cpu->reg8[op->reg] = 0;
@@ -63,7 +63,7 @@ void OPCALL normal_setB_reg(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setB_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getCF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_B)) {
         writeb(eaa(cpu, op), 1);
     } else {
         writeb(eaa(cpu, op), 0);
@@ -72,7 +72,7 @@ void OPCALL normal_setB_mem(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setNB_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getCF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NB)) {
         *cpu->reg8[op->reg] = 1;
     } else {
         *cpu->reg8[op->reg] = 0;
@@ -81,7 +81,7 @@ void OPCALL normal_setNB_reg(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setNB_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getCF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NB)) {
         writeb(eaa(cpu, op), 1);
     } else {
         writeb(eaa(cpu, op), 0);
@@ -90,7 +90,7 @@ void OPCALL normal_setNB_mem(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setZ_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getZF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_Z)) {
         *cpu->reg8[op->reg] = 1;
     } else {
         *cpu->reg8[op->reg] = 0;
@@ -99,7 +99,7 @@ void OPCALL normal_setZ_reg(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setZ_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getZF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_Z)) {
         writeb(eaa(cpu, op), 1);
     } else {
         writeb(eaa(cpu, op), 0);
@@ -108,7 +108,7 @@ void OPCALL normal_setZ_mem(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setNZ_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getZF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NZ)) {
         *cpu->reg8[op->reg] = 1;
     } else {
         *cpu->reg8[op->reg] = 0;
@@ -117,7 +117,7 @@ void OPCALL normal_setNZ_reg(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setNZ_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getZF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NZ)) {
         writeb(eaa(cpu, op), 1);
     } else {
         writeb(eaa(cpu, op), 0);
@@ -126,7 +126,7 @@ void OPCALL normal_setNZ_mem(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setBE_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getZF() || cpu->getCF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_BE)) {
         *cpu->reg8[op->reg] = 1;
     } else {
         *cpu->reg8[op->reg] = 0;
@@ -135,7 +135,7 @@ void OPCALL normal_setBE_reg(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setBE_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getZF() || cpu->getCF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_BE)) {
         writeb(eaa(cpu, op), 1);
     } else {
         writeb(eaa(cpu, op), 0);
@@ -144,7 +144,7 @@ void OPCALL normal_setBE_mem(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setNBE_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getZF() && !cpu->getCF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NBE)) {
         *cpu->reg8[op->reg] = 1;
     } else {
         *cpu->reg8[op->reg] = 0;
@@ -153,7 +153,7 @@ void OPCALL normal_setNBE_reg(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setNBE_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getZF() && !cpu->getCF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NBE)) {
         writeb(eaa(cpu, op), 1);
     } else {
         writeb(eaa(cpu, op), 0);
@@ -162,7 +162,7 @@ void OPCALL normal_setNBE_mem(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setS_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getSF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_S)) {
         *cpu->reg8[op->reg] = 1;
     } else {
         *cpu->reg8[op->reg] = 0;
@@ -171,7 +171,7 @@ void OPCALL normal_setS_reg(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setS_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getSF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_S)) {
         writeb(eaa(cpu, op), 1);
     } else {
         writeb(eaa(cpu, op), 0);
@@ -180,7 +180,7 @@ void OPCALL normal_setS_mem(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setNS_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getSF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NS)) {
         *cpu->reg8[op->reg] = 1;
     } else {
         *cpu->reg8[op->reg] = 0;
@@ -189,7 +189,7 @@ void OPCALL normal_setNS_reg(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setNS_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getSF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NS)) {
         writeb(eaa(cpu, op), 1);
     } else {
         writeb(eaa(cpu, op), 0);
@@ -198,7 +198,7 @@ void OPCALL normal_setNS_mem(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setP_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getPF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_P)) {
         *cpu->reg8[op->reg] = 1;
     } else {
         *cpu->reg8[op->reg] = 0;
@@ -207,7 +207,7 @@ void OPCALL normal_setP_reg(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setP_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getPF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_P)) {
         writeb(eaa(cpu, op), 1);
     } else {
         writeb(eaa(cpu, op), 0);
@@ -216,7 +216,7 @@ void OPCALL normal_setP_mem(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setNP_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getPF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NP)) {
         *cpu->reg8[op->reg] = 1;
     } else {
         *cpu->reg8[op->reg] = 0;
@@ -225,7 +225,7 @@ void OPCALL normal_setNP_reg(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setNP_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getPF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NP)) {
         writeb(eaa(cpu, op), 1);
     } else {
         writeb(eaa(cpu, op), 0);
@@ -234,7 +234,7 @@ void OPCALL normal_setNP_mem(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setL_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getSF()!=cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_L)) {
         *cpu->reg8[op->reg] = 1;
     } else {
         *cpu->reg8[op->reg] = 0;
@@ -243,7 +243,7 @@ void OPCALL normal_setL_reg(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setL_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getSF()!=cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_L)) {
         writeb(eaa(cpu, op), 1);
     } else {
         writeb(eaa(cpu, op), 0);
@@ -252,7 +252,7 @@ void OPCALL normal_setL_mem(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setNL_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getSF()==cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NL)) {
         *cpu->reg8[op->reg] = 1;
     } else {
         *cpu->reg8[op->reg] = 0;
@@ -261,7 +261,7 @@ void OPCALL normal_setNL_reg(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setNL_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getSF()==cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NL)) {
         writeb(eaa(cpu, op), 1);
     } else {
         writeb(eaa(cpu, op), 0);
@@ -270,7 +270,7 @@ void OPCALL normal_setNL_mem(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setLE_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getZF() || cpu->getSF()!=cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_LE)) {
         *cpu->reg8[op->reg] = 1;
     } else {
         *cpu->reg8[op->reg] = 0;
@@ -279,7 +279,7 @@ void OPCALL normal_setLE_reg(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setLE_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (cpu->getZF() || cpu->getSF()!=cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_LE)) {
         writeb(eaa(cpu, op), 1);
     } else {
         writeb(eaa(cpu, op), 0);
@@ -288,7 +288,7 @@ void OPCALL normal_setLE_mem(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setNLE_reg(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getZF() && cpu->getSF()==cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NLE)) {
         *cpu->reg8[op->reg] = 1;
     } else {
         *cpu->reg8[op->reg] = 0;
@@ -297,7 +297,7 @@ void OPCALL normal_setNLE_reg(CPU* cpu, DecodedOp* op) {
 }
 void OPCALL normal_setNLE_mem(CPU* cpu, DecodedOp* op) {
     START_OP(cpu, op);
-    if (!cpu->getZF() && cpu->getSF()==cpu->getOF()) {
+    if (lazyFlagsCondition(cpu, CONDITION_NLE)) {
         writeb(eaa(cpu, op), 1);
     } else {
         writeb(eaa(cpu, op), 0);
@@ -17,6 +17,203 @@
  */
 
 #include "boxedwine.h"
+
+// rep string ops with a 32-bit address size work on whole runs of elements that are in the same
+// page for both the source and the destination.  Pages that can't give out a host pointer (code
+// pages, copy on write pages before their first write, missing pages, ...) fall back to one
+// element at a time through the mmu, so faults and code page invalidation still happen exactly
+// where they did before.
+#define STRING_RUN_MIN_ELEMENTS 16
+
+#ifdef BOXEDWINE_DEFAULT_MMU
+// how many elements, starting with the one at address and moving in the direction of inc, fit in its page
+static U32 stringRunElements(U32 address, U32 size, S32 inc) {
+    U32 offset = address & K_PAGE_MASK;
+
+    if (offset+size>K_PAGE_SIZE) {
+        return 0;
+    }
+    if (inc>0) {
+        return (K_PAGE_SIZE-offset)/size;
+    }
+    return offset/size+1;
+}
+
+// count is trimmed to what fits in both pages, returns false if the next element has to go through the mmu
+static bool stringRun(U32 dAddress, U32 sAddress, bool hasSrc, U32 size, S32 inc, U32& count) {
+    if (count<STRING_RUN_MIN_ELEMENTS) {
+        return false;
+    }
+    U32 n = stringRunElements(dAddress, size, inc);
+    if (hasSrc) {
+        U32 sn = stringRunElements(sAddress, size, inc);
+        if (sn<n) {
+            n = sn;
+        }
+    }
+    if (n<count) {
+        count = n;
+    }
+    return count!=0;
+}
+
+// the lowest address of a run, runs going down start at their last element
+static U32 stringRunStart(U32 address, U32 count, U32 size, S32 inc) {
+    return (inc>0?address:address-(count-1)*size);
+}
+
+template <typename T>
+static bool movsRun(CPU* cpu, U32 dBase, U32 sBase) {
+    const U32 size = sizeof(T);
+    S32 inc = cpu->df*(S32)size;
+    U32 count = ECX;
+
+    if (!stringRun(dBase+EDI, sBase+ESI, true, size, inc, count)) {
+        return false;
+    }
+    U32 len = count*size;
+    U8* dst = getPhysicalWriteAddress(stringRunStart(dBase+EDI, count, size, inc), len);
+    if (!dst) {
+        return false;
+    }
+    U8* src = getPhysicalReadAddress(stringRunStart(sBase+ESI, count, size, inc), len);
+    if (!src) {
+        return false;
+    }
+    if (dst+len<=src || src+len<=dst || (inc>0 && dst<src) || (inc<0 && dst>src)) {
+        memmove(dst, src, len);
+    } else {
+        // the destination overlaps source elements that haven't been read yet, each element
+        // has to see what the ones before it wrote, rep movsb is used like this to fill memory
+        for (U32 i=0;i<len;i+=size) {
+            U32 offset = (inc>0?i:len-size-i);
+            memmove(dst+offset, src+offset, size);
+        }
+    }
+    EDI+=inc*count;
+    ESI+=inc*count;
+    ECX-=count;
+    return true;
+}
+
+template <typename T>
+static bool stosRun(CPU* cpu, U32 dBase, T value) {
+    const U32 size = sizeof(T);
+    S32 inc = cpu->df*(S32)size;
+    U32 count = ECX;
+
+    if (!stringRun(dBase+EDI, 0, false, size, inc, count)) {
+        return false;
+    }
+    U8* dst = getPhysicalWriteAddress(stringRunStart(dBase+EDI, count, size, inc), count*size);
+    if (!dst) {
+        return false;
+    }
+    if (size==1) {
+        memset(dst, (U8)value, count);
+    } else {
+        // every element is the same, so the direction doesn't matter, keep doubling what is already filled
+        U32 len = count*size;
+        U32 filled = size;
+
+        memcpy(dst, &value, size);
+        while (filled<len) {
+            U32 todo = (filled<len-filled?filled:len-filled);
+            memcpy(dst+filled, dst, todo);
+            filled+=todo;
+        }
+    }
+    EDI+=inc*count;
+    ECX-=count;
+    return true;
+}
+
+// stop is set if the last compare ended the rep, v1 and v2 are the last elements compared
+template <typename T>
+static bool cmpsRun(CPU* cpu, U32 dBase, U32 sBase, U32 rep_zero, T& v1, T& v2, bool& stop) {
+    const U32 size = sizeof(T);
+    S32 inc = cpu->df*(S32)size;
+    U32 count = ECX;
+
+    if (!stringRun(dBase+EDI, sBase+ESI, true, size, inc, count)) {
+        return false;
+    }
+    U8* dst = getPhysicalReadAddress(stringRunStart(dBase+EDI, count, size, inc), count*size);
+    if (!dst) {
+        return false;
+    }
+    U8* src = getPhysicalReadAddress(stringRunStart(sBase+ESI, count, size, inc), count*size);
+    if (!src) {
+        return false;
+    }
+    U32 i = 0;
+    while (i<count) {
+        U32 offset = (inc>0?i:count-1-i)*size;
+        memcpy(&v1, dst+offset, size);
+        memcpy(&v2, src+offset, size);
+        i++;
+        if ((v1==v2)!=rep_zero) {
+            stop = true;
+            break;
+        }
+    }
+    EDI+=inc*i;
+    ESI+=inc*i;
+    ECX-=i;
+    return true;
+}
+
+// stop is set if the last compare ended the rep, v1 is the last element compared
+template <typename T>
+static bool scasRun(CPU* cpu, U32 dBase, T value, U32 rep_zero, T& v1, bool& stop) {
+    const U32 size = sizeof(T);
+    S32 inc = cpu->df*(S32)size;
+    U32 count = ECX;
+
+    if (!stringRun(dBase+EDI, 0, false, size, inc, count)) {
+        return false;
+    }
+    U8* dst = getPhysicalReadAddress(stringRunStart(dBase+EDI, count, size, inc), count*size);
+    if (!dst) {
+        return false;
+    }
+    U32 i = 0;
+    if (size==1 && inc>0 && !rep_zero) {
+        // repne scasb going up, strlen and memchr
+        U8* found = (U8*)memchr(dst, (U8)value, count);
+        if (found) {
+            i = (U32)(found-dst)+1;
+            stop = true;
+        } else {
+            i = count;
+        }
+        v1 = dst[i-1];
+    } else {
+        while (i<count) {
+            U32 offset = (inc>0?i:count-1-i)*size;
+            memcpy(&v1, dst+offset, size);
+            i++;
+            if ((value==v1)!=rep_zero) {
+                stop = true;
+                break;
+            }
+        }
+    }
+    EDI+=inc*i;
+    ECX-=i;
+    return true;
+}
+#else
+template <typename T>
+static bool movsRun(CPU* cpu, U32 dBase, U32 sBase) {return false;}
+template <typename T>
+static bool stosRun(CPU* cpu, U32 dBase, T value) {return false;}
+template <typename T>
+static bool cmpsRun(CPU* cpu, U32 dBase, U32 sBase, U32 rep_zero, T& v1, T& v2, bool& stop) {return false;}
+template <typename T>
+static bool scasRun(CPU* cpu, U32 dBase, T value, U32 rep_zero, T& v1, bool& stop) {return false;}
+#endif
+
 void movsb16(CPU* cpu, U32 base) {
     U32 dBase = cpu->seg[ES].address;
     U32 sBase = cpu->seg[base].address;
@@ -50,13 +247,13 @@ void movsb32r(CPU* cpu, U32 base) {
     U32 dBase = cpu->seg[ES].address;
     U32 sBase = cpu->seg[base].address;
     S32 inc = cpu->df;
-    U32 count = ECX;
-    U32 i;
-    for (i=0;i<count;i++) {
-        writeb(dBase+EDI, readb(sBase+ESI));
-        EDI+=inc;
-        ESI+=inc;
-        ECX--;
+    while (ECX) {
+        if (!movsRun<U8>(cpu, dBase, sBase)) {
+            writeb(dBase+EDI, readb(sBase+ESI));
+            EDI+=inc;
+            ESI+=inc;
+            ECX--;
+        }
     }
 }
 void movsw16(CPU* cpu, U32 base) {
@@ -92,13 +289,13 @@ void movsw32r(CPU* cpu, U32 base) {
     U32 dBase = cpu->seg[ES].address;
     U32 sBase = cpu->seg[base].address;
     S32 inc = cpu->df << 1;
-    U32 count = ECX;
-    U32 i;
-    for (i=0;i<count;i++) {
-        writew(dBase+EDI, readw(sBase+ESI));
-        EDI+=inc;
-        ESI+=inc;
-        ECX--;
+    while (ECX) {
+        if (!movsRun<U16>(cpu, dBase, sBase)) {
+            writew(dBase+EDI, readw(sBase+ESI));
+            EDI+=inc;
+            ESI+=inc;
+            ECX--;
+        }
     }
 }
 void movsd16(CPU* cpu, U32 base) {
@@ -134,13 +331,13 @@ void movsd32r(CPU* cpu, U32 base) {
     U32 dBase = cpu->seg[ES].address;
     U32 sBase = cpu->seg[base].address;
     S32 inc = cpu->df << 2;
-    U32 count = ECX;
-    U32 i;
-    for (i=0;i<count;i++) {
-        writed(dBase+EDI, readd(sBase+ESI));
-        EDI+=inc;
-        ESI+=inc;
-        ECX--;
+    while (ECX) {
+        if (!movsRun<U32>(cpu, dBase, sBase)) {
+            writed(dBase+EDI, readd(sBase+ESI));
+            EDI+=inc;
+            ESI+=inc;
+            ECX--;
+        }
     }
 }
 void cmpsb16(CPU* cpu, U32 rep_zero, U32 base) {
@@ -204,13 +401,16 @@ void cmpsb32r(CPU* cpu, U32 rep_zero, U32 base) {
     if (count) {
         U8 v1=0;
         U8 v2=0;
-        for (U32 i=0;i<count;i++) {
-            v1 = readb(dBase+EDI);
-            v2 = readb(sBase+ESI);
-            EDI+=inc;
-            ESI+=inc;
-            ECX--;
-            if ((v1==v2)!=rep_zero) break;
+        bool stop = false;
+        while (ECX && !stop) {
+            if (!cmpsRun<U8>(cpu, dBase, sBase, rep_zero, v1, v2, stop)) {
+                v1 = readb(dBase+EDI);
+                v2 = readb(sBase+ESI);
+                EDI+=inc;
+                ESI+=inc;
+                ECX--;
+                stop = (v1==v2)!=rep_zero;
+            }
         }
         cpu->dst.u8 = v2;
         cpu->src.u8 = v1;
@@ -278,13 +478,16 @@ void cmpsw32r(CPU* cpu, U32 rep_zero, U32 base) {
     if (count) {
         U16 v1=0;
         U16 v2=0;
-        for (U32 i=0;i<count;i++) {
-            v1 = readw(dBase+EDI);
-            v2 = readw(sBase+ESI);
-            EDI+=inc;
-            ESI+=inc;
-            ECX--;
-            if ((v1==v2)!=rep_zero) break;
+        bool stop = false;
+        while (ECX && !stop) {
+            if (!cmpsRun<U16>(cpu, dBase, sBase, rep_zero, v1, v2, stop)) {
+                v1 = readw(dBase+EDI);
+                v2 = readw(sBase+ESI);
+                EDI+=inc;
+                ESI+=inc;
+                ECX--;
+                stop = (v1==v2)!=rep_zero;
+            }
         }
         cpu->dst.u16 = v2;
         cpu->src.u16 = v1;
@@ -352,13 +555,16 @@ void cmpsd32r(CPU* cpu, U32 rep_zero, U32 base) {
     if (count) {
         U32 v1=0;
         U32 v2=0;
-        for (U32 i=0;i<count;i++) {
-            v1 = readd(dBase+EDI);
-            v2 = readd(sBase+ESI);
-            EDI+=inc;
-            ESI+=inc;
-            ECX--;
-            if ((v1==v2)!=rep_zero) break;
+        bool stop = false;
+        while (ECX && !stop) {
+            if (!cmpsRun<U32>(cpu, dBase, sBase, rep_zero, v1, v2, stop)) {
+                v1 = readd(dBase+EDI);
+                v2 = readd(sBase+ESI);
+                EDI+=inc;
+                ESI+=inc;
+                ECX--;
+                stop = (v1==v2)!=rep_zero;
+            }
         }
         cpu->dst.u32 = v2;
         cpu->src.u32 = v1;
@@ -388,12 +594,12 @@ void stosb32(CPU* cpu) {
 void stosb32r(CPU* cpu) {
     U32 dBase = cpu->seg[ES].address;
     S32 inc = cpu->df;
-    U32 count = ECX;
-    U32 i;
-    for (i=0;i<count;i++) {
-        writeb(dBase+EDI, AL);
-        EDI+=inc;
-        ECX--;
+    while (ECX) {
+        if (!stosRun<U8>(cpu, dBase, AL)) {
+            writeb(dBase+EDI, AL);
+            EDI+=inc;
+            ECX--;
+        }
     }
 }
 void stosw16(CPU* cpu) {
@@ -418,12 +624,12 @@ void stosw32(CPU* cpu) {
 void stosw32r(CPU* cpu) {
     U32 dBase = cpu->seg[ES].address;
     S32 inc = cpu->df << 1;
-    U32 count = ECX;
-    U32 i;
-    for (i=0;i<count;i++) {
-        writew(dBase+EDI, AX);
-        EDI+=inc;
-        ECX--;
+    while (ECX) {
+        if (!stosRun<U16>(cpu, dBase, AX)) {
+            writew(dBase+EDI, AX);
+            EDI+=inc;
+            ECX--;
+        }
     }
 }
 void stosd16(CPU* cpu) {
@@ -448,12 +654,12 @@ void stosd32(CPU* cpu) {
 void stosd32r(CPU* cpu) {
     U32 dBase = cpu->seg[ES].address;
     S32 inc = cpu->df << 2;
-    U32 count = ECX;
-    U32 i;
-    for (i=0;i<count;i++) {
-        writed(dBase+EDI, EAX);
-        EDI+=inc;
-        ECX--;
+    while (ECX) {
+        if (!stosRun<U32>(cpu, dBase, EAX)) {
+            writed(dBase+EDI, EAX);
+            EDI+=inc;
+            ECX--;
+        }
     }
 }
 void lodsb16(CPU* cpu, U32 base) {
@@ -592,11 +798,14 @@ void scasb32r(CPU* cpu, U32 rep_zero) {
     U32 count = ECX;
     if (count) {
         U8 v1=0;
-        for (U32 i=0;i<count;i++) {
-            v1 = readb(dBase+EDI);
-            EDI+=inc;
-            ECX--;
-            if ((AL==v1)!=rep_zero) break;
+        bool stop = false;
+        while (ECX && !stop) {
+            if (!scasRun<U8>(cpu, dBase, AL, rep_zero, v1, stop)) {
+                v1 = readb(dBase+EDI);
+                EDI+=inc;
+                ECX--;
+                stop = (AL==v1)!=rep_zero;
+            }
         }
         cpu->dst.u8 = AL;
         cpu->src.u8 = v1;
@@ -650,11 +859,14 @@ void scasw32r(CPU* cpu, U32 rep_zero) {
     U32 count = ECX;
     if (count) {
         U16 v1=0;
-        for (U32 i=0;i<count;i++) {
-            v1 = readw(dBase+EDI);
-            EDI+=inc;
-            ECX--;
-            if ((AX==v1)!=rep_zero) break;
+        bool stop = false;
+        while (ECX && !stop) {
+            if (!scasRun<U16>(cpu, dBase, AX, rep_zero, v1, stop)) {
+                v1 = readw(dBase+EDI);
+                EDI+=inc;
+                ECX--;
+                stop = (AX==v1)!=rep_zero;
+            }
         }
         cpu->dst.u16 = AX;
         cpu->src.u16 = v1;
@@ -708,11 +920,14 @@ void scasd32r(CPU* cpu, U32 rep_zero) {
     U32 count = ECX;
     if (count) {
         U32 v1=0;
-        for (U32 i=0;i<count;i++) {
-            v1 = readd(dBase+EDI);
-            EDI+=inc;
-            ECX--;
-            if ((EAX==v1)!=rep_zero) break;
+        bool stop = false;
+        while (ECX && !stop) {
+            if (!scasRun<U32>(cpu, dBase, EAX, rep_zero, v1, stop)) {
+                v1 = readd(dBase+EDI);
+                EDI+=inc;
+                ECX--;
+                stop = (EAX==v1)!=rep_zero;
+            }
         }
         cpu->dst.u32 = EAX;
         cpu->src.u32 = v1;
@@ -1449,6 +1449,22 @@ void X64Asm::syncRegsToHost(S8 excludeReg) {
 
     // R12-R15 are non volitile on windows and linux
 
+    syncFlagsAndFpuToHost();
+}
+
+// For helpers that can only change EAX, ECX, EDX, ESP, the flags and the FPU state.  The host
+// registers that are non volitile across the call (RBX, RBP, R12-R15 and RSI/RDI on windows)
+// still hold the guest EBX, EBP, ESI/EDI and the segment/memory bases, so they don't need to be
+// reloaded.
+void X64Asm::syncVolatileRegsToHost(bool includeEbx) {
+    minSyncRegsToHost();
+    if (includeEbx) {
+        writeToRegFromMem(3, false, HOST_CPU, true, -1, false, 0, CPU_OFFSET_EBX, 4, false);
+    }
+    syncFlagsAndFpuToHost();
+}
+
+void X64Asm::syncFlagsAndFpuToHost() {
     U8 tmpReg = getTmpReg();
     writeToRegFromMem(tmpReg, true, HOST_CPU, true, -1, false, 0, CPU_OFFSET_FLAGS, 4, false);
     pushNativeReg(tmpReg, true);
@@ -1854,7 +1870,7 @@ void X64Asm::das() {
     lockParamReg(PARAM_1_REG, PARAM_1_REX);
     writeToRegFromReg(PARAM_1_REG, PARAM_1_REX, HOST_CPU, true, 8); // CPU* param    
     callHost((void*)::das);
-    syncRegsToHost();
+    syncVolatileRegsToHost();
 }
 
 void X64Asm::aaa() {
@@ -1862,14 +1878,14 @@ void X64Asm::aaa() {
     lockParamReg(PARAM_1_REG, PARAM_1_REX);
     writeToRegFromReg(PARAM_1_REG, PARAM_1_REX, HOST_CPU, true, 8); // CPU* param    
     callHost((void*)::aaa);
-    syncRegsToHost();
+    syncVolatileRegsToHost();
 }
 
 void X64Asm::aas() {
     syncRegsFromHost(); 
     writeToRegFromReg(PARAM_1_REG, PARAM_1_REX, HOST_CPU, true, 8); // CPU* param    
     callHost((void*)::aas);
-    syncRegsToHost();
+    syncVolatileRegsToHost();
 }
 
 void X64Asm::aad(U8 value) {
@@ -1882,7 +1898,7 @@ void X64Asm::aad(U8 value) {
     writeToRegFromReg(PARAM_1_REG, PARAM_1_REX, HOST_CPU, true, 8); // CPU* param    
 
     callHost((void*)::aad);
-    syncRegsToHost();  
+    syncVolatileRegsToHost();  
 }
 
 /*
@@ -2075,15 +2091,29 @@ void X64Asm::popA32() {
 }
 
 void X64Asm::jumpConditional(U8 condition, U32 eip) {    
-    if (this->stopAfterInstruction!=(S32)this->ipAddressCount && (this->calculatedEipLen==0 || (eip>=this->startOfDataIp && eip<this->startOfDataIp+this->calculatedEipLen))) {
-        write8(0x0F);
-        write8(0x80+condition);
-        write32(0);
-        addTodoLinkJump(eip, 4, true);
-    } else {
-        write8(0x70+condition);
-        doLoop(eip);
+    if (!this->cpu->isBig()) {
+        eip = eip & 0xffff;
+    }
+    // jcc rel32 to the indirect jump below, if eip ends up in this chunk commit() will point it directly at eip
+    // instead and remove the jmp short and the indirect jump
+    write8(0x0F);
+    write8(0x80+condition);
+    write32(0);
+    U32 jccPos = this->bufferPos;
+    U32 todoIndex = (U32)this->todoJump.size();
+    addTodoLinkJump(eip, 4, true, true);
+
+    // condition wasn't met, skip over the indirect jump and continue with the next instruction
+    write8(0xEB);
+    U32 pos = this->bufferPos;
+    write8(0);
+    jumpTo(eip);
+    if (this->bufferPos-pos-1>127) {
+        kpanic("X64Asm::jumpConditional tried to jump too far");
     }
+    this->buffer[pos] = this->bufferPos-pos-1;
+    write32Buffer(this->buffer+jccPos-4, pos+1-jccPos);
+    this->todoJump[todoIndex].fallbackLen = this->bufferPos-jccPos;
 }
 
 void X64Asm::write64Buffer(U8* buffer, U64 value) {
@@ -2110,8 +2140,8 @@ void X64Asm::write16Buffer(U8* buffer, U16 value) {
 
 }
 
-void X64Asm::addTodoLinkJump(U32 eip, U32 size, bool sameChunk) {
-    this->todoJump.push_back(TodoJump(eip, this->bufferPos-(size==4?4:11), size, sameChunk, this->ipAddressCount));
+void X64Asm::addTodoLinkJump(U32 eip, U32 size, bool sameChunk, bool deferred) {
+    this->todoJump.push_back(TodoJump(eip, this->bufferPos-(size==4?4:11), size, sameChunk, this->ipAddressCount, deferred));
 }
 
 void X64Asm::jumpTo(U32 eip) {  
@@ -2123,28 +2153,17 @@ void X64Asm::jumpTo(U32 eip) {
 #endif
     // :TODO: is this necessary?  who uses it?
     this->writeToMemFromValue(eip, HOST_CPU, true, -1, false, 0, CPU_OFFSET_EIP, 4, false);
-    if (this->stopAfterInstruction!=(S32)this->ipAddressCount && (this->calculatedEipLen==0 || (eip>=this->startOfDataIp && eip<this->startOfDataIp+this->calculatedEipLen))) {
-        write8(0xE9);
-        write32(0);
-        addTodoLinkJump(eip, 4, true);
-    } else {
-        // when a chunk gets modified/replaced other chunks that point to it via this jump need to get updated
-        // it is not possible to modify the executable code directly in an atomic way, so instead of embedding
-        // where we will jump directly into the instruction, we will encode an instruction that reads the jump
-        // address from memory (data).  That memory location can be atomically updated.
-        if (0) {
-            // this can result in random crashes, but it gives about a 5% boost, maybe in the future I can figure out when to use it
-            write8(0xE9);
-            write32(0);
-            addTodoLinkJump(eip, 4, false);
-        } else {
-            writeToRegFromValue(HOST_TMP, true, 0x0101010101010101l, 8);
-            write8(0x41);
-            write8(0xff);
-            write8(0x20 | HOST_TMP);
-            addTodoLinkJump(eip, 8, false);
-        }
-    }
+    // when a chunk gets modified/replaced other chunks that point to it via this jump need to get updated
+    // it is not possible to modify the executable code directly in an atomic way, so instead of embedding
+    // where we will jump directly into the instruction, we will encode an instruction that reads the jump
+    // address from memory (data).  That memory location can be atomically updated.
+    //
+    // if eip turns out to be in this chunk, commit() will turn this into a direct jump
+    writeToRegFromValue(HOST_TMP, true, 0x0101010101010101l, 8);
+    write8(0x41);
+    write8(0xff);
+    write8(0x20 | HOST_TMP);
+    addTodoLinkJump(eip, 8, false, true);
 }
 
 void x64_changed(x64CPU* cpu) {
@@ -2880,7 +2899,7 @@ void X64Asm::logOp(U32 eip) {
 
     callHost((void*)x64log);
 
-    syncRegsToHost();
+    syncVolatileRegsToHost();
 }
 
 void X64Asm::syscall(U32 opLen) {
@@ -3308,7 +3327,7 @@ void X64Asm::verw(U8 rm) {
     writeToRegFromReg(PARAM_1_REG, PARAM_1_REX, HOST_CPU, true, 8); // CPU* param
             
     callHost((void*)common_verw);
-    syncRegsToHost();
+    syncVolatileRegsToHost();
 }
 
 void X64Asm::verr(U8 rm) {
@@ -3323,7 +3342,7 @@ void X64Asm::verr(U8 rm) {
     writeToRegFromReg(PARAM_1_REG, PARAM_1_REX, HOST_CPU, true, 8); // CPU* param
             
     callHost((void*)common_verr);
-    syncRegsToHost();
+    syncVolatileRegsToHost();
 }
 
 static void x64_invalidOp(CPU* cpu, U32 op) {
@@ -3365,7 +3384,7 @@ void X64Asm::cpuid() {
     writeToRegFromReg(PARAM_1_REG, PARAM_1_REX, HOST_CPU, true, 8); // CPU* param
             
     callHost((void*)common_cpuid);
-    syncRegsToHost();
+    syncVolatileRegsToHost(true); // common_cpuid also sets EBX
 }
 
 void X64Asm::setNativeFlags(U32 flags, U32 mask) {
@@ -3734,7 +3753,7 @@ void X64Asm::callFpuNoArg(PFN_FPU pfn) {
     writeToRegFromReg(PARAM_1_REG, PARAM_1_REX, HOST_CPU, true, 8); // CPU* param
 
     callHost((void*)pfn);
-    syncRegsToHost();
+    syncVolatileRegsToHost();
 }
 
 void X64Asm::callFpuWithAddress(PFN_FPU_ADDRESS pfn, U8 rm) {
@@ -3747,7 +3766,7 @@ void X64Asm::callFpuWithAddress(PFN_FPU_ADDRESS pfn, U8 rm) {
     writeToRegFromReg(PARAM_1_REG, PARAM_1_REX, HOST_CPU, true, 8); // CPU* param
 
     callHost((void*)pfn);
-    syncRegsToHost();
+    syncVolatileRegsToHost();
 }
 
 void X64Asm::callFpuWithAddressWrite(PFN_FPU_ADDRESS pfn, U8 rm, U32 len) {
@@ -3764,7 +3783,7 @@ void X64Asm::callFpuWithAddressWrite(PFN_FPU_ADDRESS pfn, U8 rm, U32 len) {
     writeToRegFromValue(PARAM_3_REG, PARAM_3_REX, len, 4);
 
     callHost((void*)common_fpu_write_address);
-    syncRegsToHost();
+    syncVolatileRegsToHost();
 }
 
 void X64Asm::callFpuWithArg(PFN_FPU_REG pfn, U32 arg) {
@@ -3777,7 +3796,7 @@ void X64Asm::callFpuWithArg(PFN_FPU_REG pfn, U32 arg) {
     writeToRegFromReg(PARAM_1_REG, PARAM_1_REX, HOST_CPU, true, 8); // CPU* param
 
     callHost((void*)pfn);
-    syncRegsToHost();
+    syncVolatileRegsToHost();
 }
 
 void X64Asm::saveNativeState() {
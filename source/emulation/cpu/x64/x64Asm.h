@@ -198,6 +198,8 @@ private:
     void popReg(U8 reg, bool isRegRex, S8 bytes, bool commit);
     void syncRegsFromHost(bool eipInR9=false);
     void syncRegsToHost(S8 excludeReg=-1);
+    void syncVolatileRegsToHost(bool includeEbx=false);
+    void syncFlagsAndFpuToHost();
     void minSyncRegsFromHost();
     void minSyncRegsToHost();
     void adjustStack(U8 tmpReg, S32 bytes);
@@ -224,7 +226,7 @@ private:
     void setDisplacement32(U32 disp32);
     void setDisplacement8(U8 disp8);  
 
-    void addTodoLinkJump(U32 eip, U32 size, bool sameChunk);       
+    void addTodoLinkJump(U32 eip, U32 size, bool sameChunk, bool deferred=false);       
     void doLoop(U32 eip);
     void doLoop16(U8 inst, U32 eip);
     void jmpReg(U8 reg, bool isRex, bool mightNeedCS);
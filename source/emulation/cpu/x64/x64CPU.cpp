@@ -18,6 +18,16 @@ CPU* CPU::allocCPU() {
 
 // hard to guage the benifit, seems like 1% to 3% with quake 2 and quake 3
 bool x64CPU::hasBMI2 = true;
+std::atomic<U64> x64CPU::translatedBytes;
+std::atomic<U64> x64CPU::translationTime;
+
+U64 x64CPU::getTranslatedBytesPerSecond() {
+    U64 time = x64CPU::translationTime;
+    if (!time) {
+        return 0;
+    }
+    return x64CPU::translatedBytes * 1000000 / time;
+}
 bool x64Intialized = false;
 
 x64CPU::x64CPU() : exitToStartThreadLoop(0) {
@@ -120,7 +130,6 @@ void* x64CPU::init() {
     data.writeToRegFromValue(6, false, ESI, 4);
     data.writeToRegFromValue(7, false, EDI, 4);        
     
-    data.calculatedEipLen = 1; // will force the long x64 chunk jump
     data.doJmp(false);
     std::shared_ptr<BtCodeChunk> chunk = data.commit(true);
     result = chunk->getHostAddress();
@@ -177,44 +186,19 @@ std::shared_ptr<BtCodeChunk> x64CPU::translateChunk(U32 ip) {
 }
 
 std::shared_ptr<BtCodeChunk> x64CPU::translateChunk(X64Asm* parent, U32 ip) {
-    X64Asm data1(this);
-    data1.ip = ip;
-    data1.startOfDataIp = ip;       
-    data1.parent = parent;
-    translateData(&data1);
-
+    U64 startTime = KSystem::getMicroCounter();
     X64Asm data(this);
     data.ip = ip;
-    data.startOfDataIp = ip;  
-    data.calculatedEipLen = data1.ip - data1.startOfDataIp;
+    data.startOfDataIp = ip;
     data.parent = parent;
-    translateData(&data, &data1);        
-    S32 failedJumpOpIndex = this->preLinkCheck(&data);
+    translateData(&data);
 
-    if (failedJumpOpIndex==-1) {
-        std::shared_ptr<BtCodeChunk> chunk = data.commit(false);
-        link(&data, chunk);
-        return chunk;
-    } else {
-        X64Asm data2(this);
-        data2.ip = ip;
-        data2.startOfDataIp = ip;       
-        data2.parent = parent;
-        data2.stopAfterInstruction = failedJumpOpIndex;
-        translateData(&data2);
-
-        X64Asm data3(this);
-        data3.ip = ip;
-        data3.startOfDataIp = ip;  
-        data3.calculatedEipLen = data2.ip - data2.startOfDataIp;
-        data3.parent = parent;
-        data3.stopAfterInstruction = failedJumpOpIndex;
-        translateData(&data3, &data2);
-
-        std::shared_ptr<BtCodeChunk> chunk = data3.commit(false);
-        link(&data3, chunk);
-        return chunk;
-    }    
+    // commit will turn the jumps that landed inside this chunk into direct jumps
+    std::shared_ptr<BtCodeChunk> chunk = data.commit(false);
+    link(&data, chunk);
+    x64CPU::translationTime += KSystem::getMicroCounter() - startTime;
+    x64CPU::translatedBytes += data.ip - data.startOfDataIp;
+    return chunk;
 }
 
 void* x64CPU::translateEipInternal(X64Asm* parent, U32 ip) {
@@ -250,28 +234,6 @@ void x64CPU::addReturnFromTest() {
 }
 #endif
 
-S32 x64CPU::preLinkCheck(X64Asm* data) {
-    for (S32 i=0;i<(S32)data->todoJump.size();i++) {
-        U32 eip = this->seg[CS].address+data->todoJump[i].eip;        
-        U8 size = data->todoJump[i].offsetSize;
-
-        if (size==4 && data->todoJump[i].sameChunk) {
-            bool found = false;
-
-            for (U32 ip=0;ip<data->ipAddressCount;ip++) {
-                if (data->ipAddress[ip] == eip) {
-                    found = true;
-                    break;
-                }
-            }
-            if (!found) {
-                return data->todoJump[i].opIndex;
-            }
-        }
-    }
-    return -1;
-}
-
 void x64CPU::link(X64Asm* data, std::shared_ptr<BtCodeChunk>& fromChunk, U32 offsetIntoChunk) {
     U32 i;
     if (!fromChunk) {
@@ -359,7 +321,7 @@ void* x64CPU::translateEip(U32 ip) {
     return result;
 }
 
-void x64CPU::translateInstruction(X64Asm* data, X64Asm* firstPass) {
+void x64CPU::translateInstruction(X64Asm* data) {
     data->startOfOpIp = data->ip;  
 #ifdef _DEBUG
     //data->logOp(data->ip);
@@ -387,7 +349,7 @@ void x64CPU::translateInstruction(X64Asm* data, X64Asm* firstPass) {
     data->tmp3InUse = false;
 }
 
-void x64CPU::translateData(X64Asm* data, X64Asm* firstPass) {
+void x64CPU::translateData(X64Asm* data) {
     U32 codePage = (data->ip+data->cpu->seg[CS].address) >> K_PAGE_SHIFT;
     if (this->thread->memory->dynamicCodePageUpdateCount[codePage]==MAX_DYNAMIC_CODE_PAGE_COUNT) {
         data->dynamic = true;
@@ -399,36 +361,32 @@ void x64CPU::translateData(X64Asm* data, X64Asm* firstPass) {
             data->jumpTo(data->ip);
             break;
         }
-        if (firstPass) {
-            U32 nextEipLen = firstPass->calculateEipLen(data->ip+data->cpu->seg[CS].address);
-            U32 page = (data->ip+data->cpu->seg[CS].address+nextEipLen) >> K_PAGE_SHIFT;
-
-            if (page!=codePage) {
-                codePage = page;
-                if (data->dynamic) {                    
-                    if (this->thread->memory->dynamicCodePageUpdateCount[codePage] == MAX_DYNAMIC_CODE_PAGE_COUNT) {
-                        // continue to cross from my dynamic page into another dynamic page
-                    } else {
-                        // we will continue to emit code that will self check for modified code, even though the page we spill into is not dynamic
-                    }
+        // the length of the instruction isn't known until it has been translated, so assume the longest
+        // possible instruction when checking if it will spill into the next page
+        U32 page = (address+K_MAX_X86_OP_LEN-1) >> K_PAGE_SHIFT;
+
+        if (page!=codePage) {
+            codePage = page;
+            if (data->dynamic) {                    
+                if (this->thread->memory->dynamicCodePageUpdateCount[codePage] == MAX_DYNAMIC_CODE_PAGE_COUNT) {
+                    // continue to cross from my dynamic page into another dynamic page
                 } else {
-                    if (this->thread->memory->dynamicCodePageUpdateCount[codePage] == MAX_DYNAMIC_CODE_PAGE_COUNT) {
-                        // we crossed a page boundry from a non dynamic page to a dynamic page
-                        data->dynamic = true; // the instructions from this point on will do their own check
-                    } else {
-                        // continue to cross from one non dynamic page into another non dynamic page
-                    }
+                    // we will continue to emit code that will self check for modified code, even though the page we spill into is not dynamic
+                }
+            } else {
+                if (this->thread->memory->dynamicCodePageUpdateCount[codePage] == MAX_DYNAMIC_CODE_PAGE_COUNT) {
+                    // we crossed a page boundry from a non dynamic page to a dynamic page
+                    data->dynamic = true; // the instructions from this point on will do their own check
+                } else {
+                    // continue to cross from one non dynamic page into another non dynamic page
                 }
             }
         }
         data->mapAddress(address, data->bufferPos);
-        translateInstruction(data, firstPass);
+        translateInstruction(data);
         if (data->done) {
             break;
         }
-        if (data->stopAfterInstruction!=-1 && (int)data->ipAddressCount==data->stopAfterInstruction) {
-            break;
-        }
         data->resetForNewOp();
     }     
 }
@@ -672,6 +630,12 @@ U64 x64CPU::handleAccessException(U64 rip, U64 address, bool readAddress, std::f
                 dynamicCodeExceptionCount++;                    
                 return this->handleCodePatch(rip, emulatedAddress, getReg(6), getReg(7), doSyncFrom, doSyncTo);                    
             }
+#ifndef BOXEDWINE_MSVC
+            // a file mapping that the guest has since made writable
+            if (!readAddress && widenNativeFilePage(this->thread->memory, emulatedAddress>>K_PAGE_SHIFT, false)) {
+                return rip;
+            }
+#endif
         }   
 #ifdef _DEBUG
         void* fromHost = this->thread->memory->getExistingHostAddress(this->fromEip);
@@ -5,6 +5,7 @@
 #include "../common/cpu.h"
 #include "x64CodeChunk.h"
 #include "../binaryTranslation/btCpu.h"
+#include <atomic>
 
 class X64Asm;
 
@@ -47,6 +48,11 @@ public:
 #endif
     static bool hasBMI2;
 
+    // guest bytes translated by translateChunk and how many microseconds that took, for all threads
+    static std::atomic<U64> translatedBytes;
+    static std::atomic<U64> translationTime;
+    static U64 getTranslatedBytesPerSecond();
+
 #ifdef _DEBUG
     U32 fromEip;
 #endif
@@ -54,12 +60,11 @@ public:
     void addReturnFromTest();
 #endif
 
-    void translateInstruction(X64Asm* data, X64Asm* firstPass);    
+    void translateInstruction(X64Asm* data);    
     void link(X64Asm* data, std::shared_ptr<BtCodeChunk>& fromChunk, U32 offsetIntoChunk=0);
-    S32 preLinkCheck(X64Asm* data); // returns the index of the jump that failed
     virtual void makePendingCodePagesReadOnly();
     virtual std::shared_ptr<BtCodeChunk> translateChunk(U32 ip);
-    void translateData(X64Asm* data, X64Asm* firstPass=NULL);
+    void translateData(X64Asm* data);
     std::shared_ptr<BtCodeChunk> translateChunk(X64Asm* parent, U32 ip);
 
     U64 reTranslateChunk();
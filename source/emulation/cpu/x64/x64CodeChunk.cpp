@@ -12,11 +12,15 @@ bool X64CodeChunk::retranslateSingleInstruction(BtCPU* btCPU, void* address) {
     data.ip = eip;
     data.startOfDataIp = eip;
     data.dynamic = this->dynamic;
-    cpu->translateInstruction(&data, NULL);
+    cpu->translateInstruction(&data);
     U32 eipLen = data.ip - data.startOfOpIp;
     U32 hostLen = data.bufferPos;
     if (eipLen == this->emulatedInstructionLen[index] && hostLen == this->hostInstructionLen[index]) {
         memcpy(startofHostInstruction, data.buffer, hostLen);
+        // any jumps in the instruction still need to be pointed at where they go
+        data.resolveDeferredJumps();
+        std::shared_ptr<BtCodeChunk> chunk = shared_from_this();
+        cpu->link(&data, chunk, (U32)((U8*)startofHostInstruction-(U8*)this->hostAddress));
         return true;
     }
     return false;
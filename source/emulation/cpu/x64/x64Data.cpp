@@ -5,6 +5,7 @@
 #include "x64Data.h"
 #include "x64CodeChunk.h"
 #include "../../hardmmu/hard_memory.h"
+#include <algorithm>
 
 X64Data::X64Data(x64CPU* cpu) : cpu(cpu) {
     this->ipAddress = this->ipAddressBuffer;
@@ -20,8 +21,6 @@ X64Data::X64Data(x64CPU* cpu) : cpu(cpu) {
     this->ip = 0;
     this->startOfDataIp = 0;
     this->startOfOpIp = 0;
-    this->calculatedEipLen = 0;
-    this->stopAfterInstruction = -1;
     this->dynamic = false;
 }
 
@@ -138,16 +137,91 @@ void X64Data::resetForNewOp() {
     this->isG8bitWritten = false;
 }
 
-U8 X64Data::calculateEipLen(U32 eip) {    
-    for (U32 i=0;i<this->ipAddressCount;i++) {
-        if (this->ipAddress[i]==eip) {
-            if (i==this->ipAddressCount-1) {
-                return this->ip-this->ipAddress[i];
+bool X64Data::isStartOfInstruction(U32 eip) {
+    // instructions are translated in order, so ipAddress is sorted unless 16-bit code wrapped around, 
+    // in which case a jump that could have been direct will just go through memory
+    U32* end = this->ipAddress+this->ipAddressCount;
+    U32* found = std::lower_bound(this->ipAddress, end, eip);
+    return found!=end && *found==eip;
+}
+
+// Jumps to other guest addresses are written before it is known how far the chunk will go, so they are
+// all written as an indirect jump through memory, which works for any eip.  Now that every instruction
+// in the chunk is known, jumps that land on one of them are turned into direct jumps, link() will fill
+// in the offsets.
+//
+// A conditional jump that lands in the chunk doesn't need the indirect jump after it, those bytes are
+// removed so that it is a plain jcc rel32 again.  Dynamic chunks keep them, retranslateSingleInstruction
+// needs each instruction to be the same size as when it was first translated.
+void X64Data::resolveDeferredJumps() {
+    std::vector<std::pair<U32, U32>> removed; // where and how many bytes
+    U32 count = 0;
+
+    for (U32 i=0;i<this->todoJump.size();i++) {
+        TodoJump jump = this->todoJump[i];
+
+        if (removed.size() && jump.bufferPos>=removed.back().first && jump.bufferPos<removed.back().first+removed.back().second) {
+            // the indirect jump of a conditional jump that was removed
+            continue;
+        }
+        if (jump.deferred) {
+            bool inChunk = this->isStartOfInstruction(this->cpu->seg[CS].address+jump.eip);
+
+            jump.deferred = false;
+            if (jump.offsetSize==4) {
+                // a conditional jump, it already points at an indirect jump to eip that follows it
+                if (!inChunk) {
+                    continue;
+                }
+                if (jump.fallbackLen && !this->dynamic) {
+                    removed.push_back(std::make_pair(jump.bufferPos+4, jump.fallbackLen));
+                }
+            } else if (inChunk) {
+                // mov HOST_TMP, imm64 / jmp [HOST_TMP] becomes jmp rel32, the bytes after it are never reached
+                U32 pos = jump.bufferPos-2;
+                this->buffer[pos] = 0xE9;
+                jump.bufferPos = pos+1;
+                jump.offsetSize = 4;
+                jump.sameChunk = true;
             }
-            return this->ipAddress[i+1]-this->ipAddress[i];
         }
+        this->todoJump[count++] = jump;
+    }
+    this->todoJump.resize(count);
+    if (removed.size()) {
+        this->removeBytes(removed);
+    }
+}
+
+// removed is sorted by position, each one is a range of bytes that can't be reached
+void X64Data::removeBytes(const std::vector<std::pair<U32, U32>>& removed) {
+    U32 to = removed[0].first;
+
+    for (U32 i=0;i<removed.size();i++) {
+        U32 from = removed[i].first+removed[i].second;
+        U32 end = (i+1<removed.size()?removed[i+1].first:this->bufferPos);
+        memmove(this->buffer+to, this->buffer+from, end-from);
+        to+=end-from;
+    }
+    this->bufferPos = to;
+
+    // everything after a removed range moves back by its size
+    U32 shift = 0;
+    U32 next = 0;
+    for (U32 i=0;i<this->ipAddressCount;i++) {
+        while (next<removed.size() && removed[next].first<this->ipAddressBufferPos[i]) {
+            shift+=removed[next++].second;
+        }
+        this->ipAddressBufferPos[i]-=shift;
+    }
+    shift = 0;
+    next = 0;
+    for (U32 i=0;i<this->todoJump.size();i++) {
+        while (next<removed.size() && removed[next].first<this->todoJump[i].bufferPos) {
+            shift+=removed[next++].second;
+        }
+        this->todoJump[i].bufferPos-=shift;
     }
-    return 0;
 }
 
 void X64Data::mapAddress(U32 ip, U32 bufferPos) {
@@ -174,6 +248,7 @@ void X64Data::mapAddress(U32 ip, U32 bufferPos) {
 }
 
 std::shared_ptr<X64CodeChunk> X64Data::commit(bool makeLive) {
+    this->resolveDeferredJumps();
     std::shared_ptr<X64CodeChunk> chunk = std::make_shared<X64CodeChunk>(this->ipAddressCount, this->ipAddress, this->ipAddressBufferPos, this->buffer, this->bufferPos, this->startOfDataIp, this->ip-this->startOfDataIp, this->dynamic);
     if (makeLive) {
         chunk->makeLive();
@@ -40,13 +40,17 @@
 
 class TodoJump {
 public:
-    TodoJump() : eip(0), bufferPos(0), offsetSize(0), sameChunk(true) {}
-    TodoJump(U32 eip, U32 bufferPos, U8 offsetSize, bool sameChunk, U32 opIndex) : eip(eip), bufferPos(bufferPos), offsetSize(offsetSize), sameChunk(sameChunk), opIndex(opIndex) {}
+    TodoJump() : eip(0), bufferPos(0), offsetSize(0), sameChunk(true), opIndex(0), deferred(false), fallbackLen(0) {}
+    TodoJump(U32 eip, U32 bufferPos, U8 offsetSize, bool sameChunk, U32 opIndex, bool deferred) : eip(eip), bufferPos(bufferPos), offsetSize(offsetSize), sameChunk(sameChunk), opIndex(opIndex), deferred(deferred), fallbackLen(0) {}
     U32 eip;
     U32 bufferPos;
     U8 offsetSize;
     bool sameChunk;
     U32 opIndex;
+    // eip might be in the chunk being translated, commit() decides once the whole chunk is known
+    bool deferred;
+    // bytes after a conditional jump that are only needed if eip isn't in the chunk, commit() removes them if it is
+    U32 fallbackLen;
 };
 
 class X64Data {
@@ -72,7 +76,6 @@ public:
     U32 ip;
     U32 startOfDataIp;
     U32 startOfOpIp;
-    U32 calculatedEipLen;
     bool done;
     U32 op;
     U32 inst; // full op, like 0x200 while op would be 0x00
@@ -109,9 +112,9 @@ public:
     x64CPU* cpu;
 
     std::vector<TodoJump> todoJump;
-    S32 stopAfterInstruction;
-
-    U8 calculateEipLen(U32 eip);
+    bool isStartOfInstruction(U32 eip);
+    void resolveDeferredJumps();
+    void removeBytes(const std::vector<std::pair<U32, U32>>& removed);
 
     U32* ipAddress;
     U32* ipAddressBufferPos;
@@ -105,26 +105,11 @@ void Memory::reset(U32 page, U32 pageCount) {
 }
 
 void Memory::clone(Memory* from) {
-    int i=0;    
-
-    for (i=0;i<0x100000;i++) {
-        if (from->isPageAllocated(i)) {
-            if ((from->flags[i] & PAGE_SHARED) && (from->flags[i] & PAGE_WRITE)) {
-                static U32 shown = 0;
-                if (!shown) {
-                    klog("forking a process with shared memory is not fully supported with BOXEDWINE_64BIT_MMU");
-                    shown=1;
-                }
-            }
-            allocNativeMemory(this, i, 1, from->flags[i]);
-            memcpy(getNativeAddress(this, i << K_PAGE_SHIFT), getNativeAddress(from, i << K_PAGE_SHIFT), K_PAGE_SIZE);
-        } else {
-            this->flags[i] = from->flags[i];
-        }     
-    }
+    cloneNativeMemory(this, from);
 }
 
 void zeroMemory(U32 address, int len) {
+    prepareNativeWrite(KThread::currentThread()->process->memory, address, len);
     memset(getNativeAddress(KThread::currentThread()->process->memory, address), 0, len);
 }
 
@@ -133,6 +118,7 @@ void readMemory(U8* data, U32 address, int len) {
 }
 
 void writeMemory(U32 address, U8* data, int len) {
+    prepareNativeWrite(KThread::currentThread()->process->memory, address, len);
     memcpy(getNativeAddress(KThread::currentThread()->process->memory, address), data, len);
 }
 
@@ -158,6 +144,12 @@ U32 Memory::mapNativeMemory(void* hostAddress, U32 size) {
 }
 
 void Memory::allocPages(U32 page, U32 pageCount, U8 permissions, FD fd, U64 offset, const BoxedPtr<MappedFile>& mappedFile) {
+    // pages are faulted in from the file by the host as they are touched and shared mappings are written back by the host
+#ifndef BOXEDWINE_MSVC
+    if (mappedFile && mappedFile->file && mapNativeFile(this, page, pageCount, permissions, mappedFile->file, offset)) {
+        return;
+    }
+#endif
     if ((permissions & PAGE_PERMISSION_MASK) || mappedFile) {
         allocNativeMemory(this, page, pageCount, permissions);
     } else {
@@ -175,8 +167,7 @@ void Memory::allocPages(U32 page, U32 pageCount, U8 permissions, FD fd, U64 offs
             }
             addedWritePermission = true;
         }
-        // :TODO: need to implement writing back to the file
-        // :TODO: need to sync shared pages acrosss processes for hard_memory.cpp
+        // :TODO: need to implement writing back to the file when the host couldn't map it
         KThread::currentThread()->process->pread64(fd, page<<K_PAGE_SHIFT, pageCount << K_PAGE_SHIFT, offset);
         if (addedWritePermission) {
             for (U32 i=0;i<pageCount;i++) {
@@ -247,15 +238,20 @@ bool Memory::isValidWriteAddress(U32 address, U32 len) {
             return false;
         }
     }
-    return true;
+    // a shared file mapping the host can't write to, see widenNativeFilePage
+    return prepareNativeWrite(this, address, len);
 }
 
 bool Memory::isPageAllocated(U32 page) {
     return (this->flags[page] & PAGE_ALLOCATED) != 0;
 }
 
-void memcopyFromNative(U32 address, const void* p, U32 len) {
+bool memcopyFromNative(U32 address, const void* p, U32 len) {
+    if (!prepareNativeWrite(KThread::currentThread()->process->memory, address, len)) {
+        return false;
+    }
     memcpy(getNativeAddress(KThread::currentThread()->process->memory, address), p, len);
+    return true;
 }
 
 void memcopyToNative(U32 address, void* p, U32 len) {
@@ -263,6 +259,7 @@ void memcopyToNative(U32 address, void* p, U32 len) {
 }
 
 void writeNativeString(U32 address, const char* str) {	
+    prepareNativeWrite(KThread::currentThread()->process->memory, address, (U32)strlen(str)+1);
     strcpy((char*)getNativeAddress(KThread::currentThread()->process->memory, address), str);
 }
 
@@ -338,6 +335,8 @@ void writeb(U32 address, U8 value) {
     U32 page = address >> K_PAGE_SHIFT;
     U8 flags = m->nativeFlags[page];
 
+    prepareNativeWrite(m, address, 1);
+
     if (flags & NATIVE_FLAG_CODEPAGE_READONLY) {
         BtCodeMemoryWrite w((BtCPU*)KThread::currentThread()->cpu, address, 1);
         *(U8*)getNativeAddress(m, address) = value;
@@ -347,6 +346,7 @@ void writeb(U32 address, U8 value) {
         kpanic("writeb about to crash");
     }
 #else
+    prepareNativeWrite(KThread::currentThread()->memory, address, 1);
     *(U8*)getNativeAddress(KThread::currentThread()->memory, address) = value;
 #endif
 }
@@ -373,6 +373,8 @@ void writew( U32 address, U16 value) {
     Memory* m = KThread::currentThread()->memory;
     U8 flags = m->nativeFlags[address >> K_PAGE_SHIFT];
 
+    prepareNativeWrite(m, address, 2);
+
     if (flags & NATIVE_FLAG_CODEPAGE_READONLY) {
         BtCodeMemoryWrite w((BtCPU*)KThread::currentThread()->cpu, address, 2);
         *(U16*)getNativeAddress(m, address) = value;
@@ -382,6 +384,7 @@ void writew( U32 address, U16 value) {
         kpanic("writew about to crash");
     }
 #else
+    prepareNativeWrite(KThread::currentThread()->memory, address, 2);
     *(U16*)getNativeAddress(KThread::currentThread()->memory, address) = value;
 #endif
 }
@@ -407,6 +410,8 @@ void writed(U32 address, U32 value) {
     U32 page = address >> K_PAGE_SHIFT;
     U8 flags = m->nativeFlags[page];
 
+    prepareNativeWrite(m, address, 4);
+
     if (flags & NATIVE_FLAG_CODEPAGE_READONLY) {
         BtCodeMemoryWrite w((BtCPU*)KThread::currentThread()->cpu, address, 4);
         *(U32*)getNativeAddress(m, address) = value;
@@ -416,6 +421,7 @@ void writed(U32 address, U32 value) {
         kpanic("writed about to crash");
     }
 #else
+    prepareNativeWrite(KThread::currentThread()->memory, address, 4);
     *(U32*)getNativeAddress(KThread::currentThread()->memory, address) = value;
 #endif
 }
@@ -430,6 +436,8 @@ void writeq(U32 address, U64 value) {
     U32 page = address >> K_PAGE_SHIFT;
     U8 flags = m->nativeFlags[page];
 
+    prepareNativeWrite(m, address, 8);
+
     if (flags & NATIVE_FLAG_CODEPAGE_READONLY) {
         BtCodeMemoryWrite w((BtCPU*)KThread::currentThread()->cpu, address, 8);
         *(U64*)getNativeAddress(m, address) = value;
@@ -439,6 +447,7 @@ void writeq(U32 address, U64 value) {
         kpanic("writeq about to crash");
     }
 #else
+    prepareNativeWrite(KThread::currentThread()->memory, address, 8);
     *(U64*)getNativeAddress(KThread::currentThread()->memory, address) = value;
 #endif
 }
@@ -611,17 +620,20 @@ static void OPCALL emptyOp(CPU* cpu, DecodedOp* op) {
 void Memory::clearCodePageFromCache(U32 page) {
 #ifdef BOXEDWINE_BINARY_TRANSLATOR
     if (KSystem::useLargeAddressSpace) {
-        KThread* thread = KThread::currentThread();
-        std::shared_ptr<KProcess> process;
+        // releaseNativeMemory calls this for every page, only look up the process when there is something to reset
+        if (this->isEipPageCommitted(page)) {
+            KThread* thread = KThread::currentThread();
+            std::shared_ptr<KProcess> process;
 
-        if (thread) {
-            process = thread->process;
-        }
-        if (process && this->isEipPageCommitted(page)) {
-            U64 offset = (U64)(page << K_PAGE_SHIFT) * sizeof(void*);
-            U64* address64 = (U64*)((U8*)this->eipToHostInstructionAddressSpaceMapping + offset);
-            for (U32 j = 0; j < K_PAGE_SIZE; j++, address64++) {
-                *address64 = (U64)process->reTranslateChunkAddressFromR9;
+            if (thread) {
+                process = thread->process;
+            }
+            if (process) {
+                U64 offset = (U64)(page << K_PAGE_SHIFT) * sizeof(void*);
+                U64* address64 = (U64*)((U8*)this->eipToHostInstructionAddressSpaceMapping + offset);
+                for (U32 j = 0; j < K_PAGE_SIZE; j++, address64++) {
+                    *address64 = (U64)process->reTranslateChunkAddressFromR9;
+                }
             }
         }
     } else {
@@ -695,7 +707,7 @@ U8* getPhysicalReadAddress(U32 address, U32 len) {
 }
 
 U8* getPhysicalWriteAddress(U32 address, U32 len) {
-    if (!address)
+    if (!address || !prepareNativeWrite(KThread::currentThread()->process->memory, address, len))
         return NULL;
     return (U8*)getNativeAddress(KThread::currentThread()->process->memory, address);
 }
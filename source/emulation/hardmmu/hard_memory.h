@@ -23,6 +23,21 @@
 
 #define NATIVE_FLAG_COMMITTED 0x01
 #define NATIVE_FLAG_CODEPAGE_READONLY 0x02
+#define NATIVE_FLAG_FILE_MAPPED 0x04 // backed by a host mmap of the file instead of anonymous memory
+#define NATIVE_FLAG_HOST_SHARED 0x08 // the host mapping is MAP_SHARED, writes go straight to the file behind it
+#define NATIVE_FLAG_HOST_READONLY 0x10 // file mapped without PROT_WRITE because the guest couldn't write to it, see widenNativeFilePage
+
+// A host file that committed pages are mapped from, either a memory file that anonymous pages are
+// allocated in or a guest file that was mapped directly.
+class NativeMemoryFile {
+public:
+    NativeMemoryFile(S32 handle, const std::shared_ptr<KFile>& file, S64 offset) : handle(handle), file(file), offset(offset) {}
+    ~NativeMemoryFile();
+
+    S32 handle;
+    std::shared_ptr<KFile> file; // keeps the handle of a guest file open, NULL for a memory file
+    S64 offset; // file offset of page 0, the page at i is at offset+(i << K_PAGE_SHIFT)
+};
 
 INLINE void* getNativeAddress(Memory* memory, U32 address) {
     U32 page = address >> K_PAGE_SHIFT;
@@ -43,6 +58,15 @@ void reserveNativeMemory(Memory* memory);
 void releaseNativeMemory(Memory* memory);
 void allocNativeMemory(Memory* memory, U32 page, U32 pageCount, U32 flags);
 void freeNativeMemory(Memory* memory, U32 page, U32 pageCount);
+#ifndef BOXEDWINE_MSVC
+// maps the host file directly into the process, returns false if the host can't, the caller should then copy the file in
+bool mapNativeFile(Memory* memory, U32 page, U32 pageCount, U32 flags, const std::shared_ptr<KFile>& file, U64 offset);
+// Called on a write fault, makes a NATIVE_FLAG_HOST_READONLY page writable on the host if the guest
+// can write to it now, or if emulator is true and it is a private mapping.  Returns false if the page stays read only.
+bool widenNativeFilePage(Memory* memory, U32 page, bool emulator);
+#endif
+// memory is a newly created Memory, gives it a copy on write view of everything committed in from
+void cloneNativeMemory(Memory* memory, Memory* from);
 void makeCodePageReadOnly(Memory* memory, U32 page);
 bool clearCodePageReadOnly(Memory* memory, U32 page);
 U32 getHostPageSize();
@@ -50,5 +74,21 @@ U32 getHostAllocationSize();
 #ifdef BOXEDWINE_X64
 void commitHostAddressSpaceMapping(Memory* memory, U32 page, U32 pageCount, U64 defaultValue);
 #endif
+
+// the emulator is about to write to guest memory itself, it can't recover from a host write fault like the guest's code can.
+// Returns false if part of the range can't be made writable on the host, a syscall should then fail with -K_EFAULT.
+INLINE bool prepareNativeWrite(Memory* memory, U32 address, U32 len) {
+#ifndef BOXEDWINE_MSVC
+    if (!len) {
+        return true;
+    }
+    for (U32 page = address >> K_PAGE_SHIFT; page <= (address + len - 1) >> K_PAGE_SHIFT; page++) {
+        if ((memory->nativeFlags[page] & NATIVE_FLAG_HOST_READONLY) && !widenNativeFilePage(memory, page, true)) {
+            return false;
+        }
+    }
+#endif
+    return true;
+}
 #endif
 #endif
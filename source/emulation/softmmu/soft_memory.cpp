@@ -39,9 +39,16 @@
 
 //#undef LOG_OPS
 
-Page** Memory::currentMMU;
+#ifdef BOXEDWINE_CPU_WORKERS
+THREAD_LOCAL Memory* Memory::currentMemory;
+THREAD_LOCAL U8** Memory::currentMMUReadPtr;
+THREAD_LOCAL U8** Memory::currentMMUWritePtr;
+#else
+Memory* Memory::currentMemory;
 U8** Memory::currentMMUReadPtr;
 U8** Memory::currentMMUWritePtr;
+#endif
+Page* Memory::invalidLeaf[K_MMU_LEAF_SIZE];
 
 void Memory::log_pf(KThread* thread, U32 address) {
     U32 start = 0;
@@ -105,11 +112,16 @@ void Memory::addCallback(OpCallback func) {
 }
 
 Memory::Memory() : nativeAddressStart(0) {
-    for (int i=0;i<K_NUMBER_OF_PAGES;i++) {
-        this->mmu[i] = invalidPage;
-        this->mmuReadPtr[i] = NULL;
-        this->mmuWritePtr[i] = NULL;
+    if (!invalidLeaf[0]) {
+        for (int i=0;i<K_MMU_LEAF_SIZE;i++) {
+            invalidLeaf[i] = invalidPage;
+        }
     }
+    for (int i=0;i<K_MMU_DIR_SIZE;i++) {
+        this->mmu[i] = invalidLeaf;
+    }
+    this->mmuReadPtr = (U8**)calloc(K_NUMBER_OF_PAGES, sizeof(U8*));
+    this->mmuWritePtr = (U8**)calloc(K_NUMBER_OF_PAGES, sizeof(U8*));
 
     if (!callbackRam) {
         callbackRam = ramPageAlloc();
@@ -122,14 +134,27 @@ Memory::Memory() : nativeAddressStart(0) {
     this->dynamicExecutableMemoryPos = 0;
     this->dynamicExecutableMemoryLen = 0;
 #endif
+#ifdef BOXEDWINE_CPU_WORKERS
+    this->cpuWorker = 0;
+    this->mainThreadOnly = false;
+#endif
 
     this->refCount = 1;
 }
 
 Memory::~Memory() {
-    for (int i=0;i<K_NUMBER_OF_PAGES;i++) {
-        this->mmu[i]->close();
+    for (int i=0;i<K_MMU_DIR_SIZE;i++) {
+        Page** leaf = this->mmu[i];
+
+        if (leaf!=invalidLeaf) {
+            for (int j=0;j<K_MMU_LEAF_SIZE;j++) {
+                leaf[j]->close();
+            }
+            delete[] leaf;
+        }
     }
+    free(this->mmuReadPtr);
+    free(this->mmuWritePtr);
 #ifdef BOXEDWINE_DYNAMIC
     for (U32 i=0;i<this->dynamicExecutableMemory.size();i++) {
         //freeExecutable64kBlock(this->dynamicExecutableMemory[i]);
@@ -138,8 +163,18 @@ Memory::~Memory() {
 }
 
 void Memory::reset() {
-    for (int i=0;i<K_NUMBER_OF_PAGES;i++) {
-        this->setPage(i, invalidPage);
+    for (int i=0;i<K_MMU_DIR_SIZE;i++) {
+        Page** leaf = this->mmu[i];
+
+        if (leaf!=invalidLeaf) {
+            for (int j=0;j<K_MMU_LEAF_SIZE;j++) {
+                leaf[j]->close();
+            }
+            delete[] leaf;
+            this->mmu[i] = invalidLeaf;
+            memset(this->mmuReadPtr+(i << K_MMU_LEAF_SHIFT), 0, K_MMU_LEAF_SIZE*sizeof(U8*));
+            memset(this->mmuWritePtr+(i << K_MMU_LEAF_SHIFT), 0, K_MMU_LEAF_SIZE*sizeof(U8*));
+        }
     }
     this->setPage(CALL_BACK_ADDRESS>>K_PAGE_SHIFT, NativePage::alloc(callbackRam, CALL_BACK_ADDRESS, PAGE_READ|PAGE_EXEC));
 }
@@ -151,7 +186,12 @@ void Memory::reset(U32 page, U32 pageCount) {
 }
 
 void Memory::clone(Memory* from) {
-    for (int i=0;i<0x100000;i++) {
+    for (int i=0;i<K_NUMBER_OF_PAGES;i++) {
+        if (from->mmu[i >> K_MMU_LEAF_SHIFT]==invalidLeaf) {
+            // nothing is mapped in this 4MB, skip to the next leaf
+            i |= K_MMU_LEAF_MASK;
+            continue;
+        }
         Page* page = from->getPage(i);
 
         if (page->type == Page::Type::On_Demand_Page) {
@@ -377,7 +417,11 @@ bool Memory::isPageAllocated(U32 page) {
 U8* getPhysicalReadAddress(U32 address, U32 len) {
     int index = address >> 12;
     if (len<=K_PAGE_SIZE-(address & K_PAGE_MASK)) {
-        return Memory::currentMMU[index]->getReadAddress(address, len);
+        if (Memory::currentMMUReadPtr[index]) {
+            return &Memory::currentMMUReadPtr[index][address & K_PAGE_MASK];
+        }
+        BOXEDWINE_KERNEL_CRITICAL_SECTION;
+        return Memory::currentMemory->getPage(index)->getReadAddress(address, len);
     }
     return NULL;
 }
@@ -385,7 +429,11 @@ U8* getPhysicalReadAddress(U32 address, U32 len) {
 U8* getPhysicalWriteAddress(U32 address, U32 len) {
     int index = address >> 12;
     if (len<=K_PAGE_SIZE-(address & K_PAGE_MASK)) {
-        return Memory::currentMMU[index]->getWriteAddress(address, len);
+        if (Memory::currentMMUWritePtr[index]) {
+            return &Memory::currentMMUWritePtr[index][address & K_PAGE_MASK];
+        }
+        BOXEDWINE_KERNEL_CRITICAL_SECTION;
+        return Memory::currentMemory->getPage(index)->getWriteAddress(address, len);
     }
     return NULL;
 }
@@ -393,12 +441,16 @@ U8* getPhysicalWriteAddress(U32 address, U32 len) {
 U8* getPhysicalAddress(U32 address, U32 len) {
     int index = address >> 12;
     if (len<=K_PAGE_SIZE-(address & K_PAGE_MASK)) {
-        return Memory::currentMMU[index]->getReadWriteAddress(address, len);
+        if (Memory::currentMMUReadPtr[index] && Memory::currentMMUWritePtr[index]) {
+            return &Memory::currentMMUWritePtr[index][address & K_PAGE_MASK];
+        }
+        BOXEDWINE_KERNEL_CRITICAL_SECTION;
+        return Memory::currentMemory->getPage(index)->getReadWriteAddress(address, len);
     }
     return NULL;
 }
 
-void memcopyFromNative(U32 address, const void* pv, U32 len) {
+bool memcopyFromNative(U32 address, const void* pv, U32 len) {
 #ifdef UNALIGNED_MEMORY
     U32 i;
     U8* p = (U8*)pv;
@@ -420,7 +472,7 @@ void memcopyFromNative(U32 address, const void* pv, U32 len) {
                 memcpy(ram, p, todo);
                 len-=todo;
                 if (!len) {
-                    return;
+                    return true;
                 }
                 address+=todo;
                 p+=todo;
@@ -439,6 +491,7 @@ void memcopyFromNative(U32 address, const void* pv, U32 len) {
         writeb(address+i, p[i]);
     }
 #endif
+    return true;
 }
 
 void memcopyToNative(U32 address, void* pv, U32 len) {
@@ -640,14 +693,26 @@ U32 Memory::getPageFlags(U32 page) {
 }
 
 void Memory::onThreadChanged() {
-    Memory::currentMMU = this->mmu;
+    Memory::currentMemory = this;
     Memory::currentMMUReadPtr = this->mmuReadPtr;
     Memory::currentMMUWritePtr = this->mmuWritePtr;
 }
 
 void Memory::setPage(U32 index, Page* page) {
-    Page* p = this->mmu[index]; 
-    this->mmu[index] = page; 
+    Page** leaf = this->mmu[index >> K_MMU_LEAF_SHIFT];
+
+    if (leaf==invalidLeaf) {
+        if (page==invalidPage) {
+            return;
+        }
+        leaf = new Page*[K_MMU_LEAF_SIZE];
+        for (int i=0;i<K_MMU_LEAF_SIZE;i++) {
+            leaf[i] = invalidPage;
+        }
+        this->mmu[index >> K_MMU_LEAF_SHIFT] = leaf;
+    }
+    Page* p = leaf[index & K_MMU_LEAF_MASK];
+    leaf[index & K_MMU_LEAF_MASK] = page;
     this->mmuReadPtr[index] = page->getCurrentReadPtr();
     this->mmuWritePtr[index] = page->getCurrentWritePtr();
     p->close();
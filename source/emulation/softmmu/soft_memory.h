@@ -25,15 +25,18 @@ inline U8 readb(U32 address) {
     int index = address >> 12;
     if (Memory::currentMMUReadPtr[index])
         return Memory::currentMMUReadPtr[index][address & 0xFFF];
-    return Memory::currentMMU[index]->readb(address);
+    BOXEDWINE_KERNEL_CRITICAL_SECTION;
+    return Memory::currentMemory->getPage(index)->readb(address);
 }
 
 inline void writeb(U32 address, U8 value) {
     int index = address >> 12;
     if (Memory::currentMMUWritePtr[index])
         Memory::currentMMUWritePtr[index][address & 0xFFF] = value;
-    else
-        Memory::currentMMU[index]->writeb(address, value);
+    else {
+        BOXEDWINE_KERNEL_CRITICAL_SECTION;
+        Memory::currentMemory->getPage(index)->writeb(address, value);
+    }
 }
 
 inline U16 readw(U32 address) {
@@ -43,7 +46,8 @@ inline U16 readw(U32 address) {
         if (Memory::currentMMUReadPtr[index])
             return *(U16*)(&Memory::currentMMUReadPtr[index][address & 0xFFF]);
 #endif
-        return Memory::currentMMU[index]->readw(address);
+        BOXEDWINE_KERNEL_CRITICAL_SECTION;
+        return Memory::currentMemory->getPage(index)->readw(address);
     }
     return readb(address) | (readb(address+1) << 8);
 }
@@ -56,7 +60,10 @@ inline void writew(U32 address, U16 value) {
             *(U16*)(&Memory::currentMMUWritePtr[index][address & 0xFFF]) = value;
         else
 #endif
-            Memory::currentMMU[index]->writew(address, value);
+        {
+            BOXEDWINE_KERNEL_CRITICAL_SECTION;
+            Memory::currentMemory->getPage(index)->writew(address, value);
+        }
     } else {
         writeb(address, (U8)value);
         writeb(address+1, (U8)(value >> 8));
@@ -70,7 +77,8 @@ inline U32 readd(U32 address) {
         if (Memory::currentMMUReadPtr[index])
             return *(U32*)(&Memory::currentMMUReadPtr[index][address & 0xFFF]);
 #endif
-        return Memory::currentMMU[index]->readd(address);
+        BOXEDWINE_KERNEL_CRITICAL_SECTION;
+        return Memory::currentMemory->getPage(index)->readd(address);
     } else {
         return readb(address) | (readb(address+1) << 8) | (readb(address+2) << 16) | (readb(address+3) << 24);
     }
@@ -84,7 +92,10 @@ inline void writed(U32 address, U32 value) {
             *(U32*)(&Memory::currentMMUWritePtr[index][address & 0xFFF]) = value;
         else
 #endif
-            Memory::currentMMU[index]->writed(address, value);		
+        {
+            BOXEDWINE_KERNEL_CRITICAL_SECTION;
+            Memory::currentMemory->getPage(index)->writed(address, value);
+        }
     } else {
         writeb(address, value);
         writeb(address+1, value >> 8);
@@ -7,6 +7,7 @@
 #endif
 
 #include <stdio.h>
+#include <string_view>
 #include <fcntl.h>
 #include <sys/stat.h>
 
@@ -19,7 +20,39 @@ BOXEDWINE_MUTEX Fs::nextNodeIdMutex;
 BoxedPtr<FsFileNode> Fs::rootNode;
 std::string Fs::nativePathSeperator;
 
+// Results of getNodeFromLocalPath keyed by the full path, including misses.  An entry remembers each
+// directory the walk looked in and its childrenGeneration, adding or removing a child in one of them
+// makes the entry stale, changes anywhere else in the tree don't.  Children loaded from the native
+// file system on first use don't count as a change since they were always there.
+class FsPathCacheEntry {
+public:
+    FsPathCacheEntry() : isLink(false) {}
+    BoxedPtr<FsNode> node; // NULL if the path doesn't exist
+    bool isLink;
+    std::vector<std::pair<BoxedPtr<FsNode>, U32> > dirs;
+
+    bool isValid() {
+        for (auto& dir : this->dirs) {
+            if (dir.first->childrenGeneration!=dir.second) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+#define PATH_CACHE_MAX_ENTRIES 8192
+
+static std::unordered_map<std::string, FsPathCacheEntry> pathCache[2]; // index is followLink
+static std::string pathCacheKey; // reused so that a lookup doesn't allocate, protected by pathCacheMutex
+static BOXEDWINE_MUTEX pathCacheMutex;
+
 void Fs::shutDown() {
+    {
+        BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(pathCacheMutex);
+        pathCache[0].clear();
+        pathCache[1].clear();
+    }
 	rootNode = NULL;
 }
 bool Fs::initFileSystem(const std::string& rootPath) {
@@ -89,102 +122,224 @@ BoxedPtr<FsNode> Fs::addVirtualFile(const std::string& path, OpenVirtualNode fun
 }
 
 BoxedPtr<FsNode> Fs::getNodeFromLocalPath(const std::string& currentDirectory, const std::string& path, bool followLink, bool* isLink) {
+    std::unordered_map<std::string, FsPathCacheEntry>& cache = pathCache[followLink?1:0];
+
+    {
+        BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(pathCacheMutex);
+        getFullPath(currentDirectory, path, pathCacheKey);
+        auto it = cache.find(pathCacheKey);
+        if (it!=cache.end()) {
+            if (it->second.isValid()) {
+                if (isLink && it->second.isLink) {
+                    *isLink = true;
+                }
+                return it->second.node;
+            }
+            cache.erase(it);
+        }
+    }
+
     BoxedPtr<FsNode> lastNode;
-    std::vector<std::string> missingParts;
-    return Fs::getNodeFromLocalPath(currentDirectory, path, lastNode, missingParts, followLink, isLink);
+    FsPathCacheEntry entry;
+    entry.node = Fs::getNodeFromLocalPath(currentDirectory, path, lastNode, NULL, followLink, &entry.isLink, &entry);
+
+    if (isLink && entry.isLink) {
+        *isLink = true;
+    }
+    // if one of the directories changed while walking them, the entry is already stale
+    if (Fs::rootNode && entry.isValid()) {
+        BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(pathCacheMutex);
+        if (cache.size()>=PATH_CACHE_MAX_ENTRIES) {
+            cache.clear();
+        }
+        // another thread could have used the key while this one was walking
+        getFullPath(currentDirectory, path, pathCacheKey);
+        cache[pathCacheKey] = entry;
+    }
+    return entry.node;
 }
 
 std::string Fs::getFullPath(const std::string& currentDirectory, const std::string& path) {
     std::string fullpath;
+    getFullPath(currentDirectory, path, fullpath);
+    return fullpath;
+}
 
-    if (stringStartsWith(path, "/"))
-        fullpath = path;
-    else
-        fullpath = currentDirectory+"/"+path;
+void Fs::getFullPath(const std::string& currentDirectory, const std::string& path, std::string& fullpath) {
+    if (stringStartsWith(path, "/")) {
+        fullpath.assign(path);
+    } else {
+        fullpath.assign(currentDirectory);
+        fullpath.append("/");
+        fullpath.append(path);
+    }
     if (stringHasEnding(fullpath, "/."))
-        fullpath = fullpath.substr(0, fullpath.length()-2);
-    return fullpath;
+        fullpath.resize(fullpath.length()-2);
 }
 
-bool cleanPath(std::vector<std::string>& parts) {
-    for (U32 i=0;i<parts.size();) {
-        if (parts[i].length()==0) { // ignore double slashes
-            parts.erase(parts.begin()+i, parts.begin()+i+1);
-            continue;
+#define FS_MAX_LINKS 40 // like Linux, more than this many links in one path is probably a loop
+
+// The parts of a path that getNodeFromLocalPath hasn't walked yet, read in place from the strings
+// they are in.  A link's target is read before what was left of the path that led to it, that is
+// sources[count-1] is read first.  Empty parts and "." are skipped.
+class FsPathParts {
+public:
+    FsPathParts() : count(0) {}
+
+    void push(std::string_view source) {
+        this->sources[this->count++] = source;
+    }
+
+    // a part is cancelled if a ".." after it takes it back out, like "b" in "a/b/../c"
+    bool nextPart(std::string_view& part) {
+        while (takePart(this->sources, this->count, part)) {
+            // a ".." with nothing before it in what is left to be walked, the caller goes up a directory
+            if (part==".." || !this->isCancelled()) {
+                return true;
+            }
+            // skip everything up to and including the ".." that cancelled it, it is all balanced
+            U32 depth = 0;
+            std::string_view skipped;
+            while (takePart(this->sources, this->count, skipped)) {
+                if (skipped=="..") {
+                    if (depth==0) {
+                        break;
+                    }
+                    depth--;
+                } else {
+                    depth++;
+                }
+            }
         }
-        if (parts[i]==".") {
-            i++;
-            continue;
+        return false;
+    }
+
+    // true if there is nothing left that will be walked after the part that was just returned
+    bool isLastPart() {
+        std::string_view sources[FS_MAX_LINKS+2];
+        U32 count = this->copy(sources);
+        std::string_view part;
+        S32 depth = 0;
+
+        while (takePart(sources, count, part)) {
+            if (part=="..") {
+                depth--;
+            } else {
+                depth++;
+            }
         }
-        if (parts[i]=="..") {
-            if (i==0)
-                return false;
-            parts.erase(parts.begin()+i-1, parts.begin()+i+1);
-            i--;
-            continue;
+        return depth<=0;
+    }
+
+private:
+    std::string_view sources[FS_MAX_LINKS+2];
+    U32 count;
+
+    U32 copy(std::string_view* to) {
+        for (U32 i=0;i<this->count;i++) {
+            to[i] = this->sources[i];
         }
-        i++;
+        return this->count;
     }
-    return true;
-}
 
-BoxedPtr<FsNode> Fs::getNodeFromLocalPath(const std::string& currentDirectory, const std::string& path, BoxedPtr<FsNode>& lastNode, std::vector<std::string>& missingParts, bool followLink, bool* isLink) {
-    std::string fullpath = Fs::getFullPath(currentDirectory, path);
+    // true if the part that was just taken is followed by a ".." that matches it
+    bool isCancelled() {
+        std::string_view sources[FS_MAX_LINKS+2];
+        U32 count = this->copy(sources);
+        std::string_view part;
+        U32 depth = 0;
+
+        while (takePart(sources, count, part)) {
+            if (part=="..") {
+                if (depth==0) {
+                    return true;
+                }
+                depth--;
+            } else {
+                depth++;
+            }
+        }
+        return false;
+    }
 
-    if (fullpath.length()==0 || fullpath=="/")
-        return Fs::rootNode;
-    std::vector<std::string> parts;
-    Fs::splitPath(fullpath, parts);
-    BoxedPtr<FsNode> node = Fs::rootNode;
-    if (!node) {
-        return NULL;
+    static bool takePart(std::string_view* sources, U32& count, std::string_view& part) {
+        while (count) {
+            std::string_view& source = sources[count-1];
+            size_t start = source.find_first_not_of('/');
+
+            if (start==std::string_view::npos) {
+                count--;
+                continue;
+            }
+            size_t end = source.find('/', start);
+            if (end==std::string_view::npos) {
+                end = source.length();
+            }
+            part = source.substr(start, end-start);
+            source.remove_prefix(end);
+            if (part!=".") {
+                return true;
+            }
+        }
+        return false;
     }
-    std::vector<BoxedPtr<FsNode> > nodes;
+};
 
-    nodes.push_back(node);
+BoxedPtr<FsNode> Fs::getNodeFromLocalPath(const std::string& currentDirectory, const std::string& path, BoxedPtr<FsNode>& lastNode, std::vector<std::string>* missingParts, bool followLink, bool* isLink, FsPathCacheEntry* cacheEntry) {
+    BoxedPtr<FsNode> node = Fs::rootNode;
+    BoxedPtr<FsNode> links[FS_MAX_LINKS]; // keeps the link strings that parts points into alive
+    U32 linkCount = 0;
+    FsPathParts parts;
+    std::string_view part;
+    std::string name; // reused for each lookup, most names fit without allocating
 
-    if (!cleanPath(parts))
+    if (!node) {
         return NULL;
-    for (U32 i=0;i<parts.size();) {
-        if (parts[i].length()==0) { // ignore double slashes
-            i++;
+    }
+    parts.push(path);
+    if (!stringStartsWith(path, "/")) {
+        parts.push(currentDirectory);
+    }
+    while (parts.nextPart(part)) {
+        if (part=="..") {
+            node = node->getParent();
+            if (!node) {
+                return NULL;
+            }
             continue;
         }
-        if (parts[i]==".") {
-            i++;
-            continue;
+        if (cacheEntry) {
+            // read before looking, a child added after this makes the entry stale
+            cacheEntry->dirs.push_back(std::make_pair(node, (U32)node->childrenGeneration));
         }
-        node = node->getChildByName(parts[i]);
-        if (!node) {
-            for (;i<parts.size();i++) {
-                missingParts.push_back(parts[i]);
+        name.assign(part);
+        BoxedPtr<FsNode> child = node->getChildByName(name);
+        if (!child) {
+            if (missingParts) {
+                missingParts->push_back(std::string(part));
+                while (parts.nextPart(part)) {
+                    missingParts->push_back(std::string(part));
+                }
             }
-            lastNode = nodes.back();
+            lastNode = node;
             return NULL;
         }
-        nodes.push_back(node);
-        if (node->isLink() && (followLink || i<parts.size()-1)) {
-            if (i==parts.size()-1 && isLink) {
+        bool last = parts.isLastPart();
+        if (child->isLink() && (followLink || !last)) {
+            if (last && isLink) {
                 *isLink = true;
             }
-
-            std::vector<std::string> linkParts;
-            Fs::splitPath(node->link, linkParts);
-            parts.erase(parts.begin()+i, parts.begin()+i+1);
-            parts.insert(parts.begin()+i, linkParts.begin(), linkParts.end());
-            if (stringStartsWith(node->link, "/")) {
-                parts.erase(parts.begin(), parts.begin()+i);
-            }   
-            if (!cleanPath(parts))
+            if (linkCount==FS_MAX_LINKS) {
                 return NULL;
-
-            nodes.clear();
-            node = Fs::rootNode;
-            nodes.push_back(node);
-            i=0;
+            }
+            links[linkCount++] = child;
+            parts.push(child->link);
+            if (stringStartsWith(child->link, "/")) {
+                node = Fs::rootNode;
+            }
             continue;
         }
-        i++;
+        node = child;
     }
     return node;
 }
@@ -290,7 +445,7 @@ bool Fs::isNativePathDirectory(const std::string& path) {
 U32 Fs::makeLocalDirs(const std::string& path) {
     BoxedPtr<FsNode> lastNode;
     std::vector<std::string> missingParts;
-    BoxedPtr<FsNode> node = Fs::getNodeFromLocalPath("", path, lastNode, missingParts, false);    
+    BoxedPtr<FsNode> node = Fs::getNodeFromLocalPath("", path, lastNode, &missingParts, false);    
     std::vector<BoxedPtr<FsNode> > nodes;
     bool notFound = false;
 
@@ -333,13 +488,6 @@ U32 Fs::makeLocalDirs(const std::string& path) {
     return 0;
 }
 
-void Fs::splitPath(const std::string& path, std::vector<std::string>& parts) {
-    if (stringStartsWith(path, "/"))
-        stringSplit(parts,path.substr(1),'/');
-    else
-        stringSplit(parts,path,'/');
-}
-
 U32 Fs::readNativeFile(const std::string& nativePath, U8* buffer, U32 bufferLen) {
     int f = ::open(nativePath.c_str(), O_RDONLY);
     if (f>0) {
@@ -46,6 +46,7 @@
 typedef FsOpenNode* (*OpenVirtualNode)(const BoxedPtr<FsNode>& node, U32 flags, U32 data);
 
 class FsFileNode;
+class FsPathCacheEntry;
 
 class Fs {
 public:   
@@ -68,13 +69,13 @@ public:
     static std::string getFileNameFromPath(const std::string& path);
     static std::string getFileNameFromNativePath(const std::string& path);
     static U32 readNativeFile(const std::string& nativePath, U8* buffer, U32 bufferLen);
-    static void splitPath(const std::string& path, std::vector<std::string>& parts);
     static bool doesNativePathExist(const std::string& path);
     static bool isNativeDirectoryEmpty(const std::string& path);
     static U64 getNativeDirectorySize(const std::string& path, bool recursive);
     static U64 getNativeFileSize(const std::string& path);
     static bool isNativePathDirectory(const std::string& path);
     static std::string getFullPath(const std::string& currentDirectory, const std::string& path);
+    static void getFullPath(const std::string& currentDirectory, const std::string& path, std::string& fullpath);
     static std::string getNativePathFromParentAndLocalFilename(const BoxedPtr<FsNode>& parent, const std::string fileName);    
     static std::vector<std::string> getFilesInNativeDirectoryWhereFileMatches(const std::string& dirPath, const std::string& startsWith, const std::string& endsWith, bool ignoreCase);
     static void trimTrailingSlash(std::string& s);
@@ -86,7 +87,7 @@ public:
 private:
     friend class KUnixSocketObject;
 
-    static BoxedPtr<FsNode> getNodeFromLocalPath(const std::string& currentDirectory, const std::string& path, BoxedPtr<FsNode>& lastNode, std::vector<std::string>& missingParts, bool followLink, bool* isLink=NULL);
+    static BoxedPtr<FsNode> getNodeFromLocalPath(const std::string& currentDirectory, const std::string& path, BoxedPtr<FsNode>& lastNode, std::vector<std::string>* missingParts, bool followLink, bool* isLink=NULL, FsPathCacheEntry* cacheEntry=NULL);
 
     static U32 nextNodeId;    
     static BOXEDWINE_MUTEX nextNodeIdMutex;
@@ -2,6 +2,9 @@
 #include "fsfileopennode.h"
 #include UNISTD
 #include <fcntl.h>
+#ifndef BOXEDWINE_MSVC
+#include <sys/uio.h>
+#endif
 #include "fsfilenode.h"
 
 FsFileOpenNode::FsFileOpenNode(BoxedPtr<FsFileNode> node, U32 flags, U32 handle) : FsOpenNode(node, flags), fileNode(node), handle(handle) {
@@ -91,6 +94,10 @@ bool FsFileOpenNode::canMap() {
     return true;
 }
 
+S32 FsFileOpenNode::getNativeHandle() {
+    return (S32)this->handle;
+}
+
 U32 FsFileOpenNode::readNative(U8* buffer, U32 len) {
     return (U32)::read(this->handle, buffer, len);
 }
@@ -98,3 +105,35 @@ U32 FsFileOpenNode::readNative(U8* buffer, U32 len) {
 U32 FsFileOpenNode::writeNative(U8* buffer, U32 len) {
     return (U32)::write(this->handle, buffer, len);
 }
+
+U32 FsFileOpenNode::readvNative(KIoVec& io) {
+#ifdef BOXEDWINE_MSVC
+    return FsOpenNode::readvNative(io);
+#else
+    if (io.spans.size()==1) {
+        return this->readNative(io.spans[0].buffer, io.spans[0].len);
+    }
+    std::vector<struct iovec> vec(io.spans.size());
+    for (U32 i=0;i<vec.size();i++) {
+        vec[i].iov_base = io.spans[i].buffer;
+        vec[i].iov_len = io.spans[i].len;
+    }
+    return (U32)::readv(this->handle, vec.data(), (int)vec.size());
+#endif
+}
+
+U32 FsFileOpenNode::writevNative(KIoVec& io) {
+#ifdef BOXEDWINE_MSVC
+    return FsOpenNode::writevNative(io);
+#else
+    if (io.spans.size()==1) {
+        return this->writeNative(io.spans[0].buffer, io.spans[0].len);
+    }
+    std::vector<struct iovec> vec(io.spans.size());
+    for (U32 i=0;i<vec.size();i++) {
+        vec[i].iov_base = io.spans[i].buffer;
+        vec[i].iov_len = io.spans[i].len;
+    }
+    return (U32)::writev(this->handle, vec.data(), (int)vec.size());
+#endif
+}
@@ -24,6 +24,9 @@ public:
     virtual bool isReadReady();
     virtual U32 readNative(U8* buffer, U32 len);
     virtual U32 writeNative(U8* buffer, U32 len);
+    virtual U32 readvNative(KIoVec& io);
+    virtual U32 writevNative(KIoVec& io);
+    virtual S32 getNativeHandle();
     virtual void close();
     virtual void reopen();
     virtual bool isOpen();
@@ -11,9 +11,11 @@ FsNode::FsNode(Type type, U32 id, U32 rdev, const std::string& path, const std::
     rdev(rdev),
     hardLinkCount(1),
     type(type),  
+    childrenGeneration(0),
     parent(parent),
     isDir(isDirectory),  
-    hasLoadedChildrenFromFileSystem(false)
+    hasLoadedChildrenFromFileSystem(false),
+    isLoadingChildren(false)
  {   
 }
 
@@ -30,15 +32,43 @@ bool FsNode::canWrite() {
     return (getMode() & K__S_IWRITE)!=0;
 }
 
+// only ascii is folded, the same as stringCaseInSensativeEquals in the default locale
+static std::string toLowerCaseName(const std::string& name) {
+    std::string result = name;
+    for (auto& c : result) {
+        if (c>='A' && c<='Z') {
+            c+='a'-'A';
+        }
+    }
+    return result;
+}
+
+void FsNode::eraseChild(const std::string& name) {
+    auto it = this->childrenByName.find(name);
+    if (it==this->childrenByName.end()) {
+        return;
+    }
+    auto range = this->childrenByLowerCaseName.equal_range(toLowerCaseName(name));
+    for (auto i=range.first;i!=range.second;++i) {
+        if (i->second.get()==it->second.get()) {
+            this->childrenByLowerCaseName.erase(i);
+            break;
+        }
+    }
+    this->childrenByName.erase(it);
+    this->childrenGeneration++;
+}
+
 void FsNode::removeNodeFromParent() {
     BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->parent->childrenByNameMutex);
-    this->parent->childrenByName.erase(this->name);
+    this->parent->eraseChild(this->name);
 }
 
 void FsNode::loadChildren() {
     // don't need to protect from threads since this is private
     if (!this->hasLoadedChildrenFromFileSystem) {
         this->hasLoadedChildrenFromFileSystem = true;
+        this->isLoadingChildren = true;
         if (this->nativePath.length()) {
             std::vector<Platform::ListNodeResult> results;
             Platform::listNodes(nativePath, results);
@@ -66,6 +96,7 @@ void FsNode::loadChildren() {
                 }           
             }
         }
+        this->isLoadingChildren = false;
     }
 }
 
@@ -80,10 +111,13 @@ BoxedPtr<FsNode> FsNode::getChildByName(const std::string& name) {
 BoxedPtr<FsNode> FsNode::getChildByNameIgnoreCase(const std::string& name) {
     BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->childrenByNameMutex);
     this->loadChildren();
-    for (auto& n : this->childrenByName) {
-        if (stringCaseInSensativeEquals(n.first, name)) {
-            return n.second;
-        }
+    auto exact = this->childrenByName.find(name);
+    if (exact!=this->childrenByName.end()) {
+        return exact->second;
+    }
+    auto it = this->childrenByLowerCaseName.find(toLowerCaseName(name));
+    if (it!=this->childrenByLowerCaseName.end()) {
+        return it->second;
     }
     return NULL;
 }
@@ -97,13 +131,18 @@ U32 FsNode::getChildCount() {
 void FsNode::addChild(BoxedPtr<FsNode> node) {
     BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->childrenByNameMutex);
     this->loadChildren();
+    this->eraseChild(node->name);
     this->childrenByName[node->name] = node;
+    this->childrenByLowerCaseName.insert(std::make_pair(toLowerCaseName(node->name), node));
+    if (!this->isLoadingChildren) {
+        this->childrenGeneration++;
+    }
 }
 
 void FsNode::removeChildByName(const std::string& name) {
     BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->childrenByNameMutex);
     this->loadChildren();
-    this->childrenByName.erase(name);
+    this->eraseChild(name);
 }
 
 void FsNode::getAllChildren(std::vector<BoxedPtr<FsNode> > & results) {
@@ -51,6 +51,8 @@ public:
     U32 hardLinkCount;    
     const Type type;
     std::weak_ptr<KObject> kobject;
+    // bumped after a child is added or removed, the path cache in fs.cpp uses it to tell if a lookup through this directory is stale
+    std::atomic<U32> childrenGeneration;
 
     BoxedPtr<FsNode> getChildByName(const std::string& name);
     BoxedPtr<FsNode> getChildByNameIgnoreCase(const std::string& name);
@@ -73,14 +75,18 @@ protected:
 private:
     const bool isDir;
     bool hasLoadedChildrenFromFileSystem;    
+    bool isLoadingChildren;
 
     std::unordered_map<std::string, BoxedPtr<FsNode> > childrenByName;
+    // same children keyed by lower case name, a multimap since only case can differ between names
+    std::unordered_multimap<std::string, BoxedPtr<FsNode> > childrenByLowerCaseName;
     BOXEDWINE_MUTEX childrenByNameMutex;
 
     std::vector<KFileLock> locks;       
     BOXEDWINE_MUTEX locksMutex;    
 
     void loadChildren();
+    void eraseChild(const std::string& name); // caller must hold childrenByNameMutex
 };
 
 #endif
@@ -12,76 +12,78 @@ U32 FsOpenNode::read(U32 address, U32 len) {
     if (!len) {
         return 0;
     }
-    if (K_PAGE_SIZE-(address & (K_PAGE_SIZE-1)) >= len) {
-        U8* ram = getPhysicalWriteAddress(address, len);
-        U32 result;
-        S64 pos = this->getFilePointer();
+    KIoVec io(false);
+    bool onePage = K_PAGE_SIZE-(address & (K_PAGE_SIZE-1)) >= len;
+    S64 pos = (onePage?this->getFilePointer():0);
 
-        if (ram) {
-            result = this->readNative(ram, len);	
-        } else {
-            char tmp[K_PAGE_SIZE];
-            result = this->readNative((U8*)tmp, len);
-            memcopyFromNative(address, tmp, result);
-        }        
-        // :TODO: why does this happen
-        //
-        // installing dpkg with dpkg
-        // 1) dpkg will be mapped into memory (kfmmap on demand)
-        // 2) dpkg will remove dpkg, this triggers the logic to close the handle move the file to /tmp then re-open it
-        // 3) dpkg continues to run then hits a new part of the code that causes an on demand load
-        // 4) on windows 7 x64 this resulted in a full read of one page, but the result returned by read was less that 4096, it was 0xac8 (2760)
-        if (result<len) {
-            if (this->getFilePointer()==pos+len) {
-                result = len;
-            }
+    io.add(address, len);
+    U32 result = io.transfer([this](KIoVec& io) {
+        return this->readvNative(io);
+    });
+    // :TODO: why does this happen
+    //
+    // installing dpkg with dpkg
+    // 1) dpkg will be mapped into memory (kfmmap on demand)
+    // 2) dpkg will remove dpkg, this triggers the logic to close the handle move the file to /tmp then re-open it
+    // 3) dpkg continues to run then hits a new part of the code that causes an on demand load
+    // 4) on windows 7 x64 this resulted in a full read of one page, but the result returned by read was less that 4096, it was 0xac8 (2760)
+    if (onePage && result<len) {
+        if (this->getFilePointer()==pos+len) {
+            result = len;
         }
-        return result;
-    } else {		
-        U32 result = 0;
-        while (len) {
-            U32 todo = K_PAGE_SIZE-(address & (K_PAGE_SIZE-1));
-            S32 didRead;
-            U8* ram = getPhysicalWriteAddress(address, todo);
+    }
+    return result;
+}
+
+U32 FsOpenNode::write(U32 address, U32 len) {
+    KIoVec io(true);
+
+    io.add(address, len);
+    return io.transfer([this](KIoVec& io) {
+        return this->writevNative(io);
+    });
+}
 
-            if (todo>len)
-                todo = len;
-            if (ram) {
-                didRead=this->readNative(ram, todo);		
-            } else {
-                char tmp[K_PAGE_SIZE];
-                didRead = this->readNative((U8*)tmp, todo);
-                memcopyFromNative(address, tmp, didRead);
+U32 FsOpenNode::readvNative(KIoVec& io) {
+    U32 result = 0;
+
+    for (auto& span : io.spans) {
+        S32 didRead = (S32)this->readNative(span.buffer, span.len);
+        if (didRead<=0) {
+            if (!result) {
+                return (U32)didRead;
             }
-            if (didRead<=0)
-                break;
-            len-=didRead;
-            address+=didRead;
-            result+=didRead;
+            break;
+        }
+        result+=didRead;
+        if ((U32)didRead<span.len) {
+            break;
         }
-        return result;
     }
+    return result;
 }
 
-U32 FsOpenNode::write(U32 address, U32 len) {
-    U32 wrote = 0;
-    while (len) {
-        U32 todo = K_PAGE_SIZE-(address & (K_PAGE_SIZE-1));
-        U8* ram = getPhysicalReadAddress(address, todo);
-        char tmp[K_PAGE_SIZE];
+S32 FsOpenNode::getNativeHandle() {
+    return -1;
+}
 
-        if (todo>len)
-            todo = len;
-        if (ram)
-            wrote+=this->writeNative(ram, todo);
-        else {
-            memcopyToNative(address, tmp, todo);
-            wrote+=this->writeNative((U8*)tmp, todo);		
+U32 FsOpenNode::writevNative(KIoVec& io) {
+    U32 result = 0;
+
+    for (auto& span : io.spans) {
+        S32 wrote = (S32)this->writeNative(span.buffer, span.len);
+        if (wrote<=0) {
+            if (!result) {
+                return (U32)wrote;
+            }
+            break;
+        }
+        result+=wrote;
+        if ((U32)wrote<span.len) {
+            break;
         }
-        len-=todo;
-        address+=todo;
     }
-    return wrote;
+    return result;
 }
 
 void FsOpenNode::loadDirEntries() {
@@ -30,6 +30,9 @@ public:
     virtual bool isReadReady()=0;    
     virtual U32 readNative(U8* buffer, U32 len)=0;
     virtual U32 writeNative(U8* buffer, U32 len)=0;
+    virtual U32 readvNative(KIoVec& io); // default calls readNative for each span
+    virtual U32 writevNative(KIoVec& io); // default calls writeNative for each span
+    virtual S32 getNativeHandle(); // host file descriptor that can be passed to the host's mmap, default is -1
     virtual void close()=0;
     virtual void reopen()=0;
     virtual bool isOpen()=0;
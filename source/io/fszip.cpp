@@ -10,6 +10,12 @@ extern "C"
 #include "fszip.h"
 #include "fszipnode.h"
 #include <time.h> 
+#ifdef BOXEDWINE_ZIP_PAGE_CACHE
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 void FsZip::setupZipRead(U64 zipOffset, U64 zipFileOffset) {
 #ifdef BOXEDWINE_ZLIB
@@ -40,6 +46,7 @@ bool FsZip::init(const std::string& zipPath, const std::string& mount) {
         strippedMount = mount.substr(0, mount.length() - 1);
     }
     this->lastZipOffset = 0xFFFFFFFFFFFFFFFFl;
+    this->zipPath = zipPath;
     if (zipPath.length()) {
         unz_global_info global_info;
         U32 i;
@@ -121,9 +128,141 @@ bool FsZip::init(const std::string& zipPath, const std::string& mount) {
 FsZip::~FsZip() {
 #ifdef BOXEDWINE_ZLIB
     unzClose(this->zipfile);
+    for (auto& handle : this->idleHandles) {
+        unzClose(handle);
+    }
 #endif
 }
 
+unzFile FsZip::getHandle() {
+    {
+        BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->cacheMutex);
+        if (this->idleHandles.size()) {
+            unzFile result = this->idleHandles.back();
+            this->idleHandles.pop_back();
+            return result;
+        }
+    }
+    return unzOpen(this->zipPath.c_str());
+}
+
+void FsZip::releaseHandle(unzFile handle) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->cacheMutex);
+    this->idleHandles.push_back(handle);
+}
+
+bool FsZip::inflateFile(U64 zipOffset, U64 length, U8* data) {
+    unzFile handle = this->getHandle();
+    if (!handle) {
+        return false;
+    }
+    bool ok = unzSetOffset64(handle, zipOffset)==UNZ_OK && unzOpenCurrentFile(handle)==UNZ_OK;
+    U64 pos = 0;
+
+    while (ok && pos<length) {
+        U32 todo = (U32)(length-pos>1024*1024?1024*1024:length-pos);
+        int read = unzReadCurrentFile(handle, data+pos, todo);
+        if (read<=0) {
+            ok = false;
+            break;
+        }
+        pos+=read;
+    }
+    unzCloseCurrentFile(handle);
+    this->releaseHandle(handle);
+    if (!ok) {
+        klog("Could not inflate file at offset %llX from %s", (unsigned long long)zipOffset, this->zipPath.c_str());
+    }
+    return ok;
+}
+
+std::shared_ptr< std::vector<U8> > FsZip::getInflatedFile(U64 zipOffset, U64 length) {
+    {
+        BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->cacheMutex);
+        auto it = this->cachedFiles.find(zipOffset);
+        if (it!=this->cachedFiles.end()) {
+            this->cachedFilesLru.splice(this->cachedFilesLru.begin(), this->cachedFilesLru, it->second.lruPos);
+            return it->second.data;
+        }
+    }
+
+    std::shared_ptr< std::vector<U8> > data = std::make_shared< std::vector<U8> >((size_t)length);
+    if (!this->inflateFile(zipOffset, length, data->data())) {
+        return NULL;
+    }
+
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->cacheMutex);
+    auto it = this->cachedFiles.find(zipOffset);
+    if (it!=this->cachedFiles.end()) {
+        // another thread inflated it at the same time
+        return it->second.data;
+    }
+    while (this->cachedFilesSize+length>FS_ZIP_CACHE_SIZE && this->cachedFilesLru.size()) {
+        auto old = this->cachedFiles.find(this->cachedFilesLru.back());
+        this->cachedFilesSize-=old->second.data->size();
+        this->cachedFiles.erase(old);
+        this->cachedFilesLru.pop_back();
+    }
+    this->cachedFilesLru.push_front(zipOffset);
+    FsZipCachedFile& cached = this->cachedFiles[zipOffset];
+    cached.data = data;
+    cached.lruPos = this->cachedFilesLru.begin();
+    this->cachedFilesSize+=length;
+    return data;
+}
+
+#ifdef BOXEDWINE_ZIP_PAGE_CACHE
+FsZipPageCache::~FsZipPageCache() {
+    close(this->handle);
+}
+
+std::shared_ptr<FsZipPageCache> FsZip::getPageCache(U64 zipOffset, U64 length) {
+    {
+        BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->cacheMutex);
+        auto it = this->pageCaches.find(zipOffset);
+        if (it!=this->pageCaches.end()) {
+            std::shared_ptr<FsZipPageCache> result = it->second.lock();
+            if (result) {
+                return result;
+            }
+            this->pageCaches.erase(it);
+        }
+    }
+    if (!length) {
+        return NULL;
+    }
+    S32 handle = (S32)syscall(SYS_memfd_create, "boxedwine-zip", 3); // MFD_CLOEXEC|MFD_ALLOW_SEALING
+    if (handle<0) {
+        return NULL;
+    }
+    std::shared_ptr<FsZipPageCache> result = std::make_shared<FsZipPageCache>(handle);
+    if (ftruncate(handle, length)) {
+        return NULL;
+    }
+    void* p = mmap(NULL, length, PROT_READ|PROT_WRITE, MAP_SHARED, handle, 0);
+    if (p==MAP_FAILED) {
+        return NULL;
+    }
+    bool ok = this->inflateFile(zipOffset, length, (U8*)p);
+    munmap(p, length);
+    // every process that maps the file shares these pages, so none of them may change it, a writable
+    // shared mapping is refused by the host and private ones get their own copy of a page on write
+    if (!ok || fcntl(handle, F_ADD_SEALS, F_SEAL_SHRINK|F_SEAL_GROW|F_SEAL_WRITE|F_SEAL_SEAL)) {
+        return NULL;
+    }
+
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->cacheMutex);
+    std::weak_ptr<FsZipPageCache>& cached = this->pageCaches[zipOffset];
+    std::shared_ptr<FsZipPageCache> existing = cached.lock();
+    if (existing) {
+        // another thread inflated it at the same time
+        return existing;
+    }
+    cached = result;
+    return result;
+}
+#endif
+
 bool FsZip::readFileFromZip(const std::string& zipFile, const std::string& file, std::string& result) {
     unzFile z = unzOpen(zipFile.c_str());
     unz_global_info global_info;
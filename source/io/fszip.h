@@ -25,21 +25,72 @@ public:
     U64 offset;
 };
 
+// files up to this size are inflated in one go and kept in memory, bigger ones are streamed
+#define FS_ZIP_CACHE_MAX_FILE_SIZE (16*1024*1024)
+// total size of the inflated files kept around, least recently used are dropped first
+#define FS_ZIP_CACHE_SIZE (64*1024*1024)
+
+class FsZipCachedFile {
+public:
+    std::shared_ptr< std::vector<U8> > data;
+    std::list<U64>::iterator lruPos;
+};
+
+#if defined(BOXEDWINE_64BIT_MMU) && defined(__linux__)
+#define BOXEDWINE_ZIP_PAGE_CACHE
+
+// An inflated file in a sealed host memory file.  The hard mmu maps it like a file on disk, so the
+// host faults its pages in as they are touched and every process that maps the file shares them.
+class FsZipPageCache {
+public:
+    FsZipPageCache(S32 handle) : handle(handle) {}
+    ~FsZipPageCache();
+
+    S32 handle;
+};
+#endif
+
 class FsZip : public std::enable_shared_from_this<FsZip> {
 public:
     ~FsZip();
     bool init(const std::string& zipPath, const std::string& mount);
     unzFile zipfile;
 
+    // zipfile and the stream position below are shared by every streamed read
+    BOXEDWINE_MUTEX zipfileMutex;
     U64 lastZipOffset = 0xFFFFFFFFFFFFFFFFl;
     U64 lastZipFileOffset;
 
     void setupZipRead(U64 zipOffset, U64 zipFileOffset);
 
+    // returns the whole inflated file, NULL if it could not be read
+    std::shared_ptr< std::vector<U8> > getInflatedFile(U64 zipOffset, U64 length);
+#ifdef BOXEDWINE_ZIP_PAGE_CACHE
+    // returns the page cache of the file, NULL if it could not be created
+    std::shared_ptr<FsZipPageCache> getPageCache(U64 zipOffset, U64 length);
+#endif
+
     static bool readFileFromZip(const std::string& zipFile, const std::string& file, std::string& result);
     static bool extractFileFromZip(const std::string& zipFile, const std::string& file, const std::string& path);
     static std::string unzip(const std::string& zipFile, const std::string& path, std::function<void(U32, std::string)> percentDone);
     static bool iterateFiles(const std::string& zipFile, std::function<void(const std::string&)> it);
+
+private:
+    unzFile getHandle();
+    void releaseHandle(unzFile handle);
+    bool inflateFile(U64 zipOffset, U64 length, U8* data);
+
+    std::string zipPath;
+
+    // each thread inflating a file uses its own handle so that they don't wait on each other
+    std::vector<unzFile> idleHandles;
+    std::unordered_map<U64, FsZipCachedFile> cachedFiles; // key is the file's offset in the zip
+    std::list<U64> cachedFilesLru; // most recently used first
+    U64 cachedFilesSize = 0;
+#ifdef BOXEDWINE_ZIP_PAGE_CACHE
+    std::unordered_map<U64, std::weak_ptr<FsZipPageCache> > pageCaches; // kept while a process maps the file
+#endif
+    BOXEDWINE_MUTEX cacheMutex;
 };
 #endif
 #endif
@@ -7,7 +7,7 @@
 #include "fszip.h"
 
 
-FsZipOpenNode::FsZipOpenNode(BoxedPtr<FsNode> node, std::shared_ptr<FsZipNode>& zipNode, U32 flags, U64 offset) : FsOpenNode(node, flags), zipNode(zipNode), pos(0), offset(offset) {
+FsZipOpenNode::FsZipOpenNode(BoxedPtr<FsNode> node, std::shared_ptr<FsZipNode>& zipNode, U32 flags, U64 offset) : FsOpenNode(node, flags), zipNode(zipNode), pos(0), offset(offset), streamed(false) {
 }
 
 S64 FsZipOpenNode::length() {
@@ -74,8 +74,28 @@ bool FsZipOpenNode::canMap() {
 
 U32 FsZipOpenNode::readNative(U8* buffer, U32 len) {
     U32 result;
-    BOXEDWINE_CRITICAL_SECTION;
 
+    if (!this->data && !this->streamed) {
+        U64 fileLength = this->node->length();
+        if (fileLength<=FS_ZIP_CACHE_MAX_FILE_SIZE) {
+            this->data = this->zipNode->fsZip->getInflatedFile(this->offset, fileLength);
+        }
+        this->streamed = !this->data;
+    }
+    if (this->data) {
+        if (this->pos>=(S64)this->data->size()) {
+            return 0;
+        }
+        result = (U32)(this->data->size()-this->pos);
+        if (result>len) {
+            result = len;
+        }
+        memcpy(buffer, this->data->data()+this->pos, result);
+        this->pos+=result;
+        return result;
+    }
+
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->zipNode->fsZip->zipfileMutex);
     this->zipNode->fsZip->setupZipRead(this->offset, this->pos);    
     result = unzReadCurrentFile(this->zipNode->fsZip->zipfile, buffer, len);
     this->pos+=result;
@@ -88,6 +108,15 @@ U32 FsZipOpenNode::writeNative(U8* buffer, U32 len) {
     return 0;
 }
 
+#ifdef BOXEDWINE_ZIP_PAGE_CACHE
+S32 FsZipOpenNode::getNativeHandle() {
+    if (!this->pageCache) {
+        this->pageCache = this->zipNode->fsZip->getPageCache(this->offset, this->node->length());
+    }
+    return this->pageCache?this->pageCache->handle:-1;
+}
+#endif
+
 void FsZipOpenNode::reopen() {
     this->pos = 0;
 }
@@ -2,6 +2,7 @@
 #define __FSZIPOPENNODE_H__
 
 #include "fsopennode.h"
+#include "fszip.h"
 
 class FsZipNode;
 
@@ -22,6 +23,9 @@ public:
     virtual bool isReadReady();
     virtual U32 readNative(U8* buffer, U32 len);
     virtual U32 writeNative(U8* buffer, U32 len);
+#ifdef BOXEDWINE_ZIP_PAGE_CACHE
+    virtual S32 getNativeHandle();
+#endif
     virtual void close();
     virtual void reopen();
     virtual bool isOpen();
@@ -30,6 +34,12 @@ private:
     std::shared_ptr<FsZipNode> zipNode;
     S64 pos;
     U64 offset;
+    std::shared_ptr< std::vector<U8> > data; // the whole inflated file, if it isn't too big
+    bool streamed;
+#ifdef BOXEDWINE_ZIP_PAGE_CACHE
+    std::shared_ptr<FsZipPageCache> pageCache; // created the first time the file is mapped
+#endif
+
 };
 
 #endif
\ No newline at end of file
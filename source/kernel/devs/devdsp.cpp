@@ -41,6 +41,8 @@ public:
     virtual U32 writeNative(U8* buffer, U32 len);
     virtual void waitForEvents(BOXEDWINE_CONDITION& parentCondition, U32 events);    
 
+    U32 getFragmentMillies();
+
     std::shared_ptr<KNativeAudio> audio;
     U32 freq;
     U32 channels;
@@ -65,11 +67,37 @@ U32 DevDsp::writeNative(U8* buffer, U32 len) {
         if (!this->audio->isOpen()) {
             this->audio->openAudio(this->format, this->freq, this->channels);
         }
-        this->audio->writeAudio(buffer, len);
+        while (true) {
+            U32 result = this->audio->writeAudio(buffer, len);
+            if (result || !len) {
+                KThread::currentThread()->condStartWaitTime = 0;
+                return result;
+            }
+            if (this->flags & K_O_NONBLOCK) {
+                return -K_EWOULDBLOCK;
+            }
+            // the audio thread doesn't signal when it drains the buffer, so just wait about a fragment's worth of time
+            result = KThread::currentThread()->sleep(this->getFragmentMillies());
+            if (result) {
+                return result;
+            }
+        }
     }
     return len;
 }
 
+U32 DevDsp::getFragmentMillies() {
+    U32 bytesPerSecond = this->freq * this->channels;
+    if (this->format == AFMT_S16_LE || this->format == AFMT_S16_BE || this->format == AFMT_U16_LE || this->format == AFMT_U16_BE) {
+        bytesPerSecond *= 2;
+    }
+    if (!bytesPerSecond) {
+        return 1;
+    }
+    U32 result = (U32)((U64)this->audio->getFragmentSize() * 1000 / bytesPerSecond);
+    return result ? result : 1;
+}
+
 U32 DevDsp::ioctl(U32 request) {
     U32 len = (request >> 16) & 0x3FFF;
     KThread* thread = KThread::currentThread();
@@ -190,13 +218,13 @@ U32 DevDsp::ioctl(U32 request) {
 
     case 0x500C: // SNDCTL_DSP_GETOSPACE
     {
-        S32 osLen = ((S32)this->audio->getBufferSize()-(S32)this->audio->getFragmentSize());
-        if (osLen<0)
-            osLen = 0;
-		writed(IOCTL_ARG1, ((this->audio->getBufferCapacity() - this->audio->getBufferSize()) / this->audio->getFragmentSize())); // fragments
-		writed(IOCTL_ARG1 + 4, this->audio->getBufferCapacity() / this->audio->getFragmentSize());
-		writed(IOCTL_ARG1 + 8, this->audio->getFragmentSize());
-		writed(IOCTL_ARG1 + 12, this->audio->getBufferCapacity() - osLen);
+        U32 capacity = this->audio->getBufferCapacity();
+        U32 space = capacity - this->audio->getBufferSize();
+        U32 fragSize = this->audio->getFragmentSize();
+		writed(IOCTL_ARG1, space / fragSize); // fragments
+		writed(IOCTL_ARG1 + 4, capacity / fragSize);
+		writed(IOCTL_ARG1 + 8, fragSize);
+		writed(IOCTL_ARG1 + 12, space);
         return 0;
     }
     case 0x500F: // SNDCTL_DSP_GETCAPS
@@ -240,13 +268,7 @@ U32 DevDsp::ioctl(U32 request) {
     case 0x5016: // SNDCTL_DSP_SETDUPLEX
         return -K_EINVAL;
     case 0x5017: // SNDCTL_DSP_GETODELAY 
-        /*
-        if (write) {
-			writed(IOCTL_ARG1, (U32)audioBuffer.size());
-            return 0;
-        }
-        */
-        klog("DevDsp::ioctl was not expecting SNDCTL_DSP_GETODELAY");
+        writed(IOCTL_ARG1, this->audio->getBufferSize());
         return 0;
     case 0x580C: // SNDCTL_ENGINEINFO
         if (write) {
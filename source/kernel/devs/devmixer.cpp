@@ -19,6 +19,7 @@
 
 #include "oss.h"
 #include "../../io/fsvirtualopennode.h"
+#include "knativeaudio.h"
 
 class DevMixer : public FsVirtualOpenNode {
 public:
@@ -36,11 +37,33 @@ U32 DevMixer::ioctl(U32 request) {
     U32 len = (request >> 16) & 0x3FFF;
     KThread* thread = KThread::currentThread();
     CPU* cpu = thread->cpu;
-    //bool read = (request & 0x40000000) != 0;
+    bool read = (request & 0x40000000) != 0;
     bool write = (request & 0x80000000) != 0;
     U32 i;
 
     switch (request & 0xFFFF) {
+    case 0x4D00: // SOUND_MIXER_READ_VOLUME / SOUND_MIXER_WRITE_VOLUME
+    case 0x4D04: // SOUND_MIXER_READ_PCM / SOUND_MIXER_WRITE_PCM
+        if (read) {
+            KNativeAudio::setVolume(request & 0xFF, readd(IOCTL_ARG1));
+        }
+        if (write) {
+            writed(IOCTL_ARG1, KNativeAudio::getVolume(request & 0xFF));
+        }
+        return 0;
+    case 0x4DFB: // SOUND_MIXER_READ_STEREODEVS
+    case 0x4DFE: // SOUND_MIXER_READ_DEVMASK
+        if (write) {
+            writed(IOCTL_ARG1, SOUND_MASK_VOLUME | SOUND_MASK_PCM);
+        }
+        return 0;
+    case 0x4DFC: // SOUND_MIXER_READ_CAPS
+    case 0x4DFD: // SOUND_MIXER_READ_RECMASK
+    case 0x4DFF: // SOUND_MIXER_READ_RECSRC
+        if (write) {
+            writed(IOCTL_ARG1, 0);
+        }
+        return 0;
     case 0x5801: // SNDCTL_SYSINFO
         if (write) {
             U32 p = IOCTL_ARG1;
@@ -31,6 +31,12 @@
 #define DSP_CAP_MULTI            0x00004000      /* support multiple open */
 #define DSP_CAP_BIND             0x00008000      /* channel binding to front/rear/cneter/lfe */
 
+#define SOUND_MIXER_NRDEVICES    25
+#define SOUND_MIXER_VOLUME       0
+#define SOUND_MIXER_PCM          4
+#define SOUND_MASK_VOLUME        (1 << SOUND_MIXER_VOLUME)
+#define SOUND_MASK_PCM           (1 << SOUND_MIXER_PCM)
+
 typedef struct oss_sysinfo
 {
   char product[32];		/* For example OSS/Free, OSS/Linux or OSS/Solaris */
@@ -21,13 +21,20 @@
 #include "kscheduler.h"
 
 #include <string.h>
+#include <algorithm>
 
-KEPoll::KEPoll() : KObject(KTYPE_EPOLL) {
+KEPoll::KEPoll() : KObject(KTYPE_EPOLL), lockCond("KEPoll::lockCond") {
 }
 
 KEPoll::~KEPoll() {
-     for( const auto& n : this->data ) {
-         delete n.second;
+    for (const auto& n : this->entries) {
+        KEPollEntry* entry = n.second;
+        std::shared_ptr<KObject> object = entry->object.lock();
+        if (object) {
+            object->removeEPollEntry(entry);
+        }
+        entry->readyNode.remove();
+        delete entry;
     }
 }
 
@@ -60,21 +67,31 @@ U32 KEPoll::setLock(KFileLock* lock, bool wait) {
 }
 
 bool KEPoll::isOpen() {
-    kpanic("KEPoll::isOpen not implemented yet");
-    return false;
+    return true;
 }
 
 void KEPoll::waitForEvents(BOXEDWINE_CONDITION& parentCondition, U32 events) {
-    kpanic("KEPoll::waitForEvents not implemented yet");
+    if (events & K_POLLIN) {
+        BOXEDWINE_CONDITION_ADD_CHILD_CONDITION(parentCondition, this->lockCond, nullptr);
+    }
 }
 
+// an epoll fd is readable if epoll_wait would return something, this can be a false positive for 
+// entries on the ready list that are no longer ready
 bool KEPoll::isReadReady() {
-    kpanic("KEPoll::isReadReady not implemented yet");
+    if (!this->readyList.isEmpty()) {
+        return true;
+    }
+    for (KListNode<KEPollEntry*>* node = this->polledList.front(); node; node = node->getNext()) {
+        std::shared_ptr<KObject> object = node->data->object.lock();
+        if (object && !node->data->disabled && this->getReadyEvents(node->data, object)) {
+            return true;
+        }
+    }
     return false;
 }
 
 bool KEPoll::isWriteReady() {
-    kpanic("KEPoll::isWriteReady not implemented yet");
     return false;
 }
 
@@ -129,77 +146,275 @@ void KEPoll::close() {
 #define K_EPOLL_CTL_DEL 2
 #define K_EPOLL_CTL_MOD 3
 
+#define K_EPOLLONESHOT (1u << 30)
+#define K_EPOLLET (1u << 31)
+
+void KEPoll::signalReady(KEPollEntry* entry) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_CONDITION(this->lockCond);
+    if (!entry->readyNode.isInList()) {
+        this->readyList.addToBack(&entry->readyNode);
+    }
+    BOXEDWINE_CONDITION_SIGNAL_ALL(this->lockCond);
+    this->signalEPoll(); // this epoll might be in another epoll
+}
+
+// must not be called while holding this->lockCond, KObject::signalEPoll locks in the opposite order
+void KEPoll::removeEntry(KEPollEntry* entry) {
+    std::shared_ptr<KObject> object = entry->object.lock();
+    if (object) {
+        object->removeEPollEntry(entry);
+    }
+    {
+        BOXEDWINE_CRITICAL_SECTION_WITH_CONDITION(this->lockCond);
+        entry->readyNode.remove();
+        this->entries.erase(entry->fd);
+    }
+    delete entry;
+}
+
+U32 KEPoll::getReadyEvents(KEPollEntry* entry, const std::shared_ptr<KObject>& object) {
+    if (!object->isOpen()) {
+        return K_POLLHUP;
+    }
+    U32 result = 0;
+    if ((entry->events & K_POLLIN) && object->isReadReady()) {
+        result |= K_POLLIN;
+    }
+    if ((entry->events & K_POLLOUT) && object->isWriteReady()) {
+        result |= K_POLLOUT;
+    }
+    return result;
+}
+
 U32 KEPoll::ctl(U32 op, FD fd, U32 address) {
     KFileDescriptor* targetFD = KThread::currentThread()->process->getFileDescriptor(fd);
-    Data* existing = NULL;
+    KEPollEntry* existing = NULL;
 
     if (!targetFD) {
         return -K_EBADF;
     }
-
-    if (this->data.count(fd))
-        existing = this->data[fd];
+    if (targetFD->kobject.get() == this) {
+        return -K_EINVAL;
+    }
+    {
+        BOXEDWINE_CRITICAL_SECTION_WITH_CONDITION(this->lockCond);
+        auto it = this->entries.find(fd);
+        if (it != this->entries.end()) {
+            existing = it->second;
+        }
+    }
+    // the fd was closed and the number was reused without EPOLL_CTL_DEL
+    if (existing && existing->object.lock() != targetFD->kobject) {
+        this->removeEntry(existing);
+        existing = NULL;
+    }
 
     switch (op) {
-        case K_EPOLL_CTL_ADD:
+        case K_EPOLL_CTL_ADD: {
             if (existing) {
                 return -K_EEXIST;
             }
-            existing = new Data();
-            existing->fd = fd;
-            existing->events = readd(address);
-            existing->data = readq(address + 4);
-            this->data[fd] = existing;
+            KEPollEntry* entry = new KEPollEntry(this, targetFD->kobject, fd);
+            entry->events = readd(address);
+            entry->data = readq(address + 4);
+            // native sockets only find out about readiness when something is waiting on them and 
+            // files don't have a concept of it
+            entry->polled = (targetFD->kobject->type == KTYPE_FILE || targetFD->kobject->type == KTYPE_NATIVE_SOCKET);
+            if (!entry->polled) {
+                targetFD->kobject->addEPollEntry(entry);
+            }
+            BOXEDWINE_CRITICAL_SECTION_WITH_CONDITION(this->lockCond);
+            this->entries[fd] = entry;
+            // the next wait will check it
+            if (entry->polled) {
+                this->polledList.addToBack(&entry->readyNode);
+            } else {
+                this->readyList.addToBack(&entry->readyNode);
+            }
+            BOXEDWINE_CONDITION_SIGNAL_ALL(this->lockCond);
             break;
+        }
         case K_EPOLL_CTL_DEL:
             if (!existing)
                 return -K_ENOENT;
-            this->data.erase(fd);
-            delete existing;
+            this->removeEntry(existing);
             break;
-        case K_EPOLL_CTL_MOD:
+        case K_EPOLL_CTL_MOD: {
             if (!existing)
                 return -K_ENOENT;
+            BOXEDWINE_CRITICAL_SECTION_WITH_CONDITION(this->lockCond);
             existing->events = readd(address);
             existing->data = readq(address + 4);
+            existing->lastEvents = 0;
+            existing->disabled = false;
+            if (!existing->polled && !existing->readyNode.isInList()) {
+                this->readyList.addToBack(&existing->readyNode);
+            }
+            BOXEDWINE_CONDITION_SIGNAL_ALL(this->lockCond);
             break;
+        }
         default:
             return -K_EINVAL;
     }
     return 0;
 }
 
-U32 KEPoll::wait(U32 events, U32 maxevents, U32 timeout) {    
-    S32 result = 0;
-    U32 i;
-    THREAD_LOCAL static KPollData pollData[256];	
-    U32 pollCount=0;
+// The caller holds this->lockCond and the locks object->waitForEvents takes for this entry
+U32 KEPoll::reportEntry(KEPollEntry* entry, const std::shared_ptr<KObject>& object, U32 events, U32 index) {
+    U32 revents = this->getReadyEvents(entry, object);
+    U32 lastEvents = entry->lastEvents;
 
-    for( const auto& n : this->data ) {
-        if (pollCount>=256) {
-            kpanic("Wasn't expect a poll count of more than 256");
-            break;
+    entry->lastEvents = revents;
+    if (!revents) {
+        return 0;
+    }
+    // an entry on the ready list was signaled, so that is the edge, but a polled entry only has its 
+    // current state to go by
+    if (entry->polled && (entry->events & K_EPOLLET) && !(revents & ~lastEvents)) {
+        return 0;
+    }
+    writed(events + index * 12, revents);
+    writeq(events + index * 12 + 4, entry->data);
+    if (entry->events & K_EPOLLONESHOT) {
+        entry->disabled = true;
+    }
+    return revents;
+}
+
+// The caller holds this->lockCond
+void KEPoll::getWaitObjects(KList<KEPollEntry*>& list, std::vector<KEPollWaitObject>& objects) {
+    for (KListNode<KEPollEntry*>* node = list.front(); node; node = node->getNext()) {
+        KEPollEntry* entry = node->data;
+        std::shared_ptr<KObject> object = entry->object.lock();
+        if (object && !entry->disabled) {
+            objects.push_back(KEPollWaitObject(object, entry->events));
+        }
+    }
+}
+
+static bool compareWaitObjects(const KEPollWaitObject& a, const KEPollWaitObject& b) {
+    return a.object.get() < b.object.get();
+}
+
+// was the lock for everything this entry waits on taken
+static bool isWaitObject(const std::vector<KEPollWaitObject>& objects, KEPollEntry* entry, const std::shared_ptr<KObject>& object) {
+    auto it = std::lower_bound(objects.begin(), objects.end(), KEPollWaitObject(object, 0), compareWaitObjects);
+    return it != objects.end() && it->object == object && !(entry->events & ~it->events);
+}
+
+U32 KEPoll::wait(U32 events, U32 maxevents, U32 timeout) {
+    if ((S32)maxevents <= 0) {
+        return -K_EINVAL;
+    }
+    std::vector<KEPollWaitObject> objects;
+
+    while (true) {
+        U32 result = 0;
+        bool missed = false;
+        KThread* thread = KThread::currentThread();
+        BOXEDWINE_CRITICAL_SECTION_WITH_CONDITION(thread->pollCond);
+        bool interrupted = !thread->inSignal && thread->interrupted;
+
+        if (interrupted)
+            thread->interrupted = false;
+
+        // Gather locks before we check the data so that we don't miss one.  An object holds its own lock 
+        // when it calls signalReady, which takes this->lockCond, so the objects' locks have to be taken 
+        // first.  The lists are only read here to find the objects, entries that show up after this 
+        // are skipped below and checked on the next time around.
+        objects.clear();
+        {
+            BOXEDWINE_CRITICAL_SECTION_WITH_CONDITION(this->lockCond);
+            this->getWaitObjects(this->readyList, objects);
+            this->getWaitObjects(this->polledList, objects);
+        }
+        std::sort(objects.begin(), objects.end(), compareWaitObjects);
+        for (U32 i = 0; i < objects.size();) {
+            // dup'd fds can be registered separately
+            U32 next = i + 1;
+            while (next < objects.size() && objects[next].object == objects[i].object) {
+                objects[i].events |= objects[next++].events;
+            }
+            objects[i].object->waitForEvents(thread->pollCond, objects[i].events);
+            i = next;
         }
-        Data* next = n.second;
-        pollData[pollCount].events = next->events;
-        pollData[pollCount].fd = next->fd;
-        pollData[pollCount].data = next->data;
-        pollCount++;	
-    }
-    result = internal_poll(pollData, pollCount, timeout);
-    if (result >= 0) {
-        result = 0;
-        for (i=0;i<pollCount;i++) {
-            if (pollData[i].revents!=0) {
-                writed(events + result * 12, pollData[i].revents);        
-                writeq(events + result * 12 + 4, pollData[i].data);
+        BOXEDWINE_CONDITION_ADD_CHILD_CONDITION(thread->pollCond, this->lockCond, nullptr);
+
+        // Only entries that were signaled since the last wait are here, plus level triggered entries that 
+        // were ready last time.  Those are put back at the end of the list so that they will be checked 
+        // again next time, so stop once we get back to them.
+        KListNode<KEPollEntry*>* last = this->readyList.back();
+        while (result < maxevents && this->readyList.front()) {
+            KListNode<KEPollEntry*>* node = this->readyList.front();
+            KEPollEntry* entry = node->data;
+            std::shared_ptr<KObject> object = entry->object.lock();
+            bool done = (node == last);
+
+            node->remove();
+            if (!object || entry->disabled) {
+                // the object is gone or EPOLLONESHOT already fired
+            } else if (!isWaitObject(objects, entry, object)) {
+                missed = true;
+                this->readyList.addToBack(node);
+            } else if (this->reportEntry(entry, object, events, result)) {
                 result++;
-                if (result>=(S32)maxevents) {
-                    kwarn("possible starvation in epoll, more events are ready than can be received.");
-                    break;
+                if (!(entry->events & (K_EPOLLET | K_EPOLLONESHOT))) {
+                    this->readyList.addToBack(node);
                 }
-            }        
+            }
+            if (done) {
+                break;
+            }
+        }
+        for (KListNode<KEPollEntry*>* node = this->polledList.front(); node && result < maxevents; node = node->getNext()) {
+            std::shared_ptr<KObject> object = node->data->object.lock();
+            if (!object || node->data->disabled) {
+                continue;
+            }
+            if (!isWaitObject(objects, node->data, object)) {
+                missed = true;
+            } else if (this->reportEntry(node->data, object, events, result)) {
+                result++;
+            }
+        }
+        if (result>0) {
+            thread->condStartWaitTime = 0;
+            thread->pollCond.unlockAndRemoveChildren();
+            return result;
         }
+        if (missed) {
+            thread->pollCond.unlockAndRemoveChildren();
+            continue;
+        }
+        if (timeout==0) {
+            thread->pollCond.unlockAndRemoveChildren();
+            return 0;
+        }
+        if (interrupted) {
+            thread->condStartWaitTime = 0;
+            thread->pollCond.unlockAndRemoveChildren();
+            return -K_EINTR;
+        }
+        if (!thread->condStartWaitTime) {
+            thread->condStartWaitTime = KSystem::getMilliesSinceStart();
+        } else {
+            U32 diff = KSystem::getMilliesSinceStart()-thread->condStartWaitTime;
+            if (diff>timeout) {
+                thread->condStartWaitTime = 0;
+                thread->pollCond.unlockAndRemoveChildren();
+                return 0;
+            }
+            timeout-=diff;
+        }
+        if (timeout>0xF0000000) {
+            BOXEDWINE_CONDITION_WAIT(thread->pollCond);
+        } else {
+            BOXEDWINE_CONDITION_WAIT_TIMEOUT(thread->pollCond, timeout);
+        }
+#ifdef BOXEDWINE_MULTI_THREADED
+        if (KThread::currentThread()->terminating) {
+            return -K_EINTR;
+        }
+#endif
     }
-    return result;
 }
@@ -94,6 +94,42 @@ U32 KFile::readNative(U8* buffer, U32 len) {
     return this->openFile->readNative(buffer, len);
 }
 
+U32 KFile::writev(U32 iov, S32 iovcnt) {
+    KIoVec io(true);
+    U32 result = io.addIov(iov, iovcnt);
+
+    if (result) {
+        return result;
+    }
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(filePosMutex);
+    return io.transfer([this](KIoVec& io) {
+        return this->openFile->writevNative(io);
+    });
+}
+
+U32 KFile::writevNative(KIoVec& io) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(filePosMutex);
+    return this->openFile->writevNative(io);
+}
+
+U32 KFile::readv(U32 iov, S32 iovcnt) {
+    KIoVec io(false);
+    U32 result = io.addIov(iov, iovcnt);
+
+    if (result) {
+        return result;
+    }
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(filePosMutex);
+    return io.transfer([this](KIoVec& io) {
+        return this->openFile->readvNative(io);
+    });
+}
+
+U32 KFile::readvNative(KIoVec& io) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(filePosMutex);
+    return this->openFile->readvNative(io);
+}
+
 U32 KFile::stat(U32 address, bool is64) {
     FsOpenNode* openNode = this->openFile;
     BoxedPtr<FsNode> node = openNode->node;
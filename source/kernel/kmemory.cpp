@@ -1,5 +1,13 @@
 #include "boxedwine.h"
+#ifdef BOXEDWINE_DEFAULT_MMU
+#include "../emulation/cpu/normal/decodedBlockCache.h"
+#endif
 
 MappedFileCache::~MappedFileCache() {
     delete[] this->data;
+#ifdef BOXEDWINE_DEFAULT_MMU
+    if (this->decodedBlocks) {
+        delete this->decodedBlocks;
+    }
+#endif
 }
\ No newline at end of file
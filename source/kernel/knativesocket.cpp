@@ -13,6 +13,7 @@ static int winsock_intialized;
 #else
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
@@ -456,6 +457,58 @@ U32 KNativeSocketObject::readNative(U8* buffer, U32 len) {
     return handleNativeSocketError(t, false);
 }
 
+U32 KNativeSocketObject::writevNative(KIoVec& io) {
+#ifdef WIN32
+    return KObject::writevNative(io);
+#else
+    if (io.spans.size()==1) {
+        return this->writeNative(io.spans[0].buffer, io.spans[0].len);
+    }
+    std::vector<struct iovec> vec(io.spans.size());
+    struct msghdr msg = {0};
+
+    for (U32 i=0;i<vec.size();i++) {
+        vec[i].iov_base = io.spans[i].buffer;
+        vec[i].iov_len = io.spans[i].len;
+    }
+    msg.msg_iov = vec.data();
+    msg.msg_iovlen = vec.size();
+    S32 result = (S32)::sendmsg(this->nativeSocket, &msg, this->flags);
+    if (result>=0) {
+        this->error = 0;
+        return result;
+    }
+    std::shared_ptr< KNativeSocketObject> t = std::dynamic_pointer_cast<KNativeSocketObject>(shared_from_this());
+    return handleNativeSocketError(t, true);
+#endif
+}
+
+U32 KNativeSocketObject::readvNative(KIoVec& io) {
+#ifdef WIN32
+    return KObject::readvNative(io);
+#else
+    if (io.spans.size()==1) {
+        return this->readNative(io.spans[0].buffer, io.spans[0].len);
+    }
+    std::vector<struct iovec> vec(io.spans.size());
+    struct msghdr msg = {0};
+
+    for (U32 i=0;i<vec.size();i++) {
+        vec[i].iov_base = io.spans[i].buffer;
+        vec[i].iov_len = io.spans[i].len;
+    }
+    msg.msg_iov = vec.data();
+    msg.msg_iovlen = vec.size();
+    S32 result = (S32)::recvmsg(this->nativeSocket, &msg, this->flags);
+    if (result>=0) {
+        this->error = 0;
+        return result;
+    }
+    std::shared_ptr< KNativeSocketObject> t = std::dynamic_pointer_cast<KNativeSocketObject>(shared_from_this());
+    return handleNativeSocketError(t, false);
+#endif
+}
+
 U32 KNativeSocketObject::stat(U32 address, bool is64) {
     KSystem::writeStat("", address, is64, 1, 0, K_S_IFSOCK|K__S_IWRITE|K__S_IREAD, 0, 0, 4096, 0, 0, 1);
     return 0;
@@ -736,13 +789,7 @@ U32 KNativeSocketObject::sendmsg(KFileDescriptor* fd, U32 address, U32 flags) {
             kpanic("KNativeSocketObject::sendmsg does not support sending file handles");
         }				
     }
-    U32 result = 0;
-    for (U32 i=0;i<hdr.msg_iovlen;i++) {
-        U32 p = readd(hdr.msg_iov + 8 * i);
-        U32 len = readd(hdr.msg_iov + 8 * i + 4);
-        result+=fd->kobject->write(p, len);
-    }
-    return result;
+    return fd->kobject->writev(hdr.msg_iov, hdr.msg_iovlen);
 }
 
 U32 KNativeSocketObject::recvmsg(KFileDescriptor* fd, U32 address, U32 flags) {
@@ -751,11 +798,10 @@ U32 KNativeSocketObject::recvmsg(KFileDescriptor* fd, U32 address, U32 flags) {
     U32 result = 0;
 
     readMsgHdr(address, &hdr);        
-    for (U32 i = 0; i < hdr.msg_iovlen; i++) {
-        U32 p = readd(hdr.msg_iov + 8 * i);
-        U32 len = readd(hdr.msg_iov + 8 * i + 4);
-
-        if (this->type == K_SOCK_DGRAM && this->domain==K_AF_INET && hdr.msg_namelen>=sizeof(struct sockaddr_in)) {
+    if (this->type == K_SOCK_DGRAM && this->domain==K_AF_INET && hdr.msg_namelen>=sizeof(struct sockaddr_in)) {
+        for (U32 i = 0; i < hdr.msg_iovlen; i++) {
+            U32 p = readd(hdr.msg_iov + 8 * i);
+            U32 len = readd(hdr.msg_iov + 8 * i + 4);
             struct sockaddr_in in;
             S32 r;
             socklen_t inLen = sizeof(struct sockaddr_in);
@@ -776,9 +822,9 @@ U32 KNativeSocketObject::recvmsg(KFileDescriptor* fd, U32 address, U32 flags) {
                 std::shared_ptr< KNativeSocketObject> t = std::dynamic_pointer_cast<KNativeSocketObject>(shared_from_this());
                 result = handleNativeSocketError(t, false);
             }
-        } else {
-            result += this->read(p, len);
         }
+    } else {
+        result = this->readv(hdr.msg_iov, hdr.msg_iovlen);
     }
     if (this->type==K_SOCK_STREAM)
         writed(address + 4, 0); // msg_namelen, set to 0 for connected sockets
@@ -1,5 +1,6 @@
 #include "boxedwine.h"
 #include "kobject.h"
+#include "kepoll.h"
 
 KObject::KObject(U32 type) : type(type) {
     if (KThread::currentThread()) {
@@ -9,83 +10,263 @@ KObject::KObject(U32 type) : type(type) {
     }
 }
 
-U32 KObject::writev(U32 iov, S32 iovcnt) {
-    U32 len=0;
-    S32 i;
+void KIoVec::add(U32 address, U32 len) {
+    if (len) {
+        KIoSpan range;
+        range.buffer = NULL;
+        range.address = address;
+        range.len = len;
+        range.bounced = false;
+        this->ranges.push_back(range);
+        this->totalLen+=len;
+    }
+}
 
-    for (i=0;i<iovcnt;i++) {
+U32 KIoVec::addIov(U32 iov, S32 iovcnt) {
+    if (iovcnt<0 || iovcnt>K_IOV_MAX) {
+        return -K_EINVAL;
+    }
+    for (S32 i=0;i<iovcnt;i++) {
         U32 buf = readd(iov + i * 8);
-        U32 toWrite = readd(iov + i * 8 + 4);
-        S32 result;
+        U32 len = readd(iov + i * 8 + 4);
 
-        result = this->write(buf, toWrite);
-        if (result<0) {
-            if (i>0) {
-                kwarn("writev partial fail: TODO file pointer should not change");
-            }
-            return result;
+        if ((S32)len<0 || (S32)(this->totalLen+len)<0) {
+            return -K_EINVAL;
         }
-        len+=result;
+        this->add(buf, len);
     }
-    return len;
+    return 0;
 }
 
-U32 KObject::read(U32 address, U32 len) {
-    if (K_PAGE_SIZE-(address & (K_PAGE_SIZE-1)) >= len) {
-        U8* ram = getPhysicalWriteAddress(address, len);
-        U32 result;
-
-        if (ram) {
-            result = this->readNative(ram, len);	
-        } else {
-            char tmp[K_PAGE_SIZE];
-            result = this->readNative((U8*)tmp, len);
-            memcopyFromNative(address, tmp, result);
-        }        
-        return result;
-    } else {		
-        U32 result = 0;
+// fills spans with as much of the guest memory starting pos bytes in as will fit in one host call
+U32 KIoVec::resolve(U32 pos) {
+    U32 bounceLen = 0;
+    U32 windowLen = 0;
+    U32 i = 0;
+
+    this->spans.clear();
+    while (i<this->ranges.size() && pos>=this->ranges[i].len) {
+        pos-=this->ranges[i].len;
+        i++;
+    }
+    for (;i<this->ranges.size();i++) {
+        U32 address = this->ranges[i].address+pos;
+        U32 len = this->ranges[i].len-pos;
+
+        pos = 0;
         while (len) {
             U32 todo = K_PAGE_SIZE-(address & (K_PAGE_SIZE-1));
-            S32 didRead;
-            U8* ram = getPhysicalWriteAddress(address, todo);
-
             if (todo>len)
                 todo = len;
+            U8* ram = (this->toHost?getPhysicalReadAddress(address, todo):getPhysicalWriteAddress(address, todo));
+            KIoSpan* last = (this->spans.size()?&this->spans.back():NULL);
+
             if (ram) {
-                didRead=this->readNative(ram, todo);		
+                if (last && !last->bounced && last->buffer+last->len==ram) {
+                    last->len+=todo;
+                } else if (this->spans.size()==K_IOV_MAX) {
+                    break;
+                } else {
+                    KIoSpan span;
+                    span.buffer = ram;
+                    span.address = address;
+                    span.len = todo;
+                    span.bounced = false;
+                    this->spans.push_back(span);
+                }
             } else {
-                char tmp[K_PAGE_SIZE];
-                didRead = this->readNative((U8*)tmp, todo);
-                memcopyFromNative(address, tmp, didRead);
+                if (bounceLen+todo>K_IO_BOUNCE_SIZE) {
+                    break;
+                }
+                if (last && last->bounced && last->address+last->len==address) {
+                    last->len+=todo;
+                } else if (this->spans.size()==K_IOV_MAX) {
+                    break;
+                } else {
+                    KIoSpan span;
+                    span.buffer = NULL;
+                    span.address = address;
+                    span.len = todo;
+                    span.bounced = true;
+                    this->spans.push_back(span);
+                }
+                bounceLen+=todo;
+            }
+            address+=todo;
+            len-=todo;
+            windowLen+=todo;
+        }
+        if (len) {
+            break;
+        }
+    }
+    if (bounceLen) {
+        U32 offset = 0;
+
+        if (this->bounce.size()<bounceLen) {
+            this->bounce.resize(bounceLen);
+        }
+        for (auto& span : this->spans) {
+            if (span.bounced) {
+                span.buffer = this->bounce.data()+offset;
+                offset+=span.len;
+                if (this->toHost) {
+                    memcopyToNative(span.address, span.buffer, span.len);
+                }
             }
-            if (didRead<=0)
-                break;
-            len-=didRead;
-            address+=didRead;
-            result+=didRead;
         }
-        return result;
     }
+    return windowLen;
 }
 
-U32 KObject::write(U32 address, U32 len) {
-    U32 wrote = 0;
-    while (len) {
-        U32 todo = K_PAGE_SIZE-(address & (K_PAGE_SIZE-1));
-        U8* ram = getPhysicalReadAddress(address, todo);
-        char tmp[K_PAGE_SIZE];
-
-        if (todo>len)
-            todo = len;
-        if (ram)
-            wrote+=this->writeNative(ram, todo);
-        else {
-            memcopyToNative(address, tmp, todo);
-            wrote+=this->writeNative((U8*)tmp, todo);		
+// copies the first len bytes of the current window back to the guest if they were bounced, returns false if the guest memory can't be written
+bool KIoVec::commit(U32 len) {
+    if (this->toHost) {
+        return true;
+    }
+    for (auto& span : this->spans) {
+        if (!len) {
+            break;
+        }
+        U32 todo = (span.len<len?span.len:len);
+        if (span.bounced && !memcopyFromNative(span.address, span.buffer, todo)) {
+            return false;
         }
         len-=todo;
-        address+=todo;
     }
-    return wrote;
-}
\ No newline at end of file
+    return true;
+}
+
+U32 KIoVec::transfer(std::function<U32(KIoVec& io)> io) {
+    U32 result = 0;
+
+    // like Linux, don't read from the object into a buffer the guest can't write to
+    if (!this->toHost) {
+        Memory* memory = KThread::currentThread()->memory;
+
+        for (auto& range : this->ranges) {
+            if (!memory->isValidWriteAddress(range.address, range.len)) {
+                return -K_EFAULT;
+            }
+        }
+    }
+    while (result<this->totalLen) {
+        U32 todo = this->resolve(result);
+        S32 done = (S32)io(*this);
+
+        if (done<=0) {
+            if (!result) {
+                return (U32)done;
+            }
+            break;
+        }
+        if (!this->commit(done)) {
+            if (!result) {
+                return -K_EFAULT;
+            }
+            break;
+        }
+        result+=done;
+        if ((U32)done<todo) {
+            break;
+        }
+    }
+    return result;
+}
+
+U32 KObject::writevNative(KIoVec& io) {
+    U32 result = 0;
+
+    for (auto& span : io.spans) {
+        S32 wrote = (S32)this->writeNative(span.buffer, span.len);
+        if (wrote<=0) {
+            if (!result) {
+                return (U32)wrote;
+            }
+            break;
+        }
+        result+=wrote;
+        if ((U32)wrote<span.len) {
+            break;
+        }
+    }
+    return result;
+}
+
+U32 KObject::readvNative(KIoVec& io) {
+    U32 result = 0;
+
+    for (auto& span : io.spans) {
+        S32 didRead = (S32)this->readNative(span.buffer, span.len);
+        if (didRead<=0) {
+            if (!result) {
+                return (U32)didRead;
+            }
+            break;
+        }
+        result+=didRead;
+        if ((U32)didRead<span.len) {
+            break;
+        }
+    }
+    return result;
+}
+
+U32 KObject::writev(U32 iov, S32 iovcnt) {
+    KIoVec io(true);
+    U32 result = io.addIov(iov, iovcnt);
+
+    if (result) {
+        return result;
+    }
+    return io.transfer([this](KIoVec& io) {
+        return this->writevNative(io);
+    });
+}
+
+U32 KObject::readv(U32 iov, S32 iovcnt) {
+    KIoVec io(false);
+    U32 result = io.addIov(iov, iovcnt);
+
+    if (result) {
+        return result;
+    }
+    return io.transfer([this](KIoVec& io) {
+        return this->readvNative(io);
+    });
+}
+
+U32 KObject::read(U32 address, U32 len) {
+    KIoVec io(false);
+
+    io.add(address, len);
+    return io.transfer([this](KIoVec& io) {
+        return this->readvNative(io);
+    });
+}
+
+U32 KObject::write(U32 address, U32 len) {
+    KIoVec io(true);
+
+    io.add(address, len);
+    return io.transfer([this](KIoVec& io) {
+        return this->writevNative(io);
+    });
+}
+
+void KObject::addEPollEntry(KEPollEntry* entry) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->epollMutex);
+    this->epollEntries.addToBack(&entry->objectNode);
+}
+
+void KObject::removeEPollEntry(KEPollEntry* entry) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->epollMutex);
+    entry->objectNode.remove();
+}
+
+void KObject::signalEPoll() {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->epollMutex);
+    for (KListNode<KEPollEntry*>* node = this->epollEntries.front(); node; node = node->getNext()) {
+        node->data->epoll->signalReady(node->data);
+    }
+}
@@ -20,6 +20,7 @@
 
 #include "kscheduler.h"
 #include "loader.h"
+#include "kvdso.h"
 #include "kstat.h"
 #include "bufferaccess.h"
 #include "ksignal.h"
@@ -27,6 +28,7 @@
 #include "../io/fsmemnode.h"
 #include "../io/fsmemopennode.h"
 #include "../io/fsfilenode.h"
+#include "../emulation/cpu/normal/decodedBlockCache.h"
 
 #ifdef BOXEDWINE_BINARY_TRANSLATOR
 #include "../emulation/cpu/binaryTranslation/btCodeMemoryWrite.h"
@@ -80,6 +82,7 @@ KProcess::KProcess(U32 id) : id(id),
     phnum(0),
     phentsize(0),
     entry(0),
+    vdsoAddress(0),
     eventQueueFD(0),
     exitOrExecCond("KProcess::exitOrExecCond"),
     hasSetStackMask(false),
@@ -326,6 +329,7 @@ void KProcess::clone(const std::shared_ptr<KProcess>& from) {
     this->phdr = from->phdr;
     this->phnum = from->phnum;
     this->entry = from->entry;
+    this->vdsoAddress = from->vdsoAddress;
 
     for (i=0;i<6;i++) {
         this->hasSetSeg[i] = from->hasSetSeg[i];
@@ -393,6 +397,10 @@ static void pushThreadStack(KThread* thread, CPU* cpu, int argc, U32* a, int env
     cpu->push32(25); // AT_RANDOM
     cpu->push32(100);
     cpu->push32( 17); // AT_CLKTCK
+    if (process->vdsoAddress) {
+        cpu->push32(process->vdsoAddress);
+        cpu->push32(33); // AT_SYSINFO_EHDR
+    }
     //push32(cpu, HWCAP_I386_FPU|HWCAP_I386_VME|HWCAP_I386_TSC|HWCAP_I386_CX8|HWCAP_I386_CMOV|HWCAP_I386_FCMOV);
     //push32(cpu, 16); // AT_HWCAP
     cpu->push32(platform);
@@ -460,6 +468,7 @@ static void setupThreadStack(KThread* thread, CPU* cpu, const std::string& progr
         a[i]=ESP;
     }
 
+    KVdso::map(thread);
     pushThreadStack(thread, cpu, (U32)args.size(), a, (U32)env.size(), e);
 }
 
@@ -708,6 +717,16 @@ U32 KProcess::getModuleEip(U32 eip) {
     return 0;
 }
 
+BoxedPtr<MappedFile> KProcess::getMappedFile(U32 eip) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(mappedFilesMutex);
+    for (auto& n : this->mappedFiles) {
+        BoxedPtr<MappedFile> mappedFile = n.second;
+        if (eip>=mappedFile->address && eip<mappedFile->address+mappedFile->len)
+            return mappedFile;
+    }
+    return NULL;
+}
+
 U32 KProcess::alarm(U32 seconds) {
     U32 prev = this->timer.millies;
     if (seconds == 0) {
@@ -718,11 +737,10 @@ U32 KProcess::alarm(U32 seconds) {
     } else {
         this->timer.resetMillies = 0;
         if (this->timer.millies!=0) {
-            this->timer.millies = seconds*1000 + KSystem::getMilliesSinceStart();
-        } else {
-            this->timer.millies = seconds*1000 + KSystem::getMilliesSinceStart();
-            addTimer(&this->timer);
+            removeTimer(&this->timer);
         }
+        this->timer.millies = seconds*1000 + KSystem::getMilliesSinceStart();
+        addTimer(&this->timer);
     }
     if (prev) {
         return (prev - KSystem::getMilliesSinceStart())/1000;
@@ -816,8 +834,18 @@ U32 KProcess::execve(const std::string& path, std::vector<std::string>& args, co
 		this->memory->reset();
 	}
 	else {
-		this->memory->decRefCount();
+		Memory* previousMemory = this->memory;
 		this->memory = new Memory();
+#ifdef BOXEDWINE_CPU_WORKERS
+		if (KThread::currentThread()->cpuWorker) {
+			// the worker running this thread holds the run lock of its memory and a reference to it
+			this->memory->runMutex.lock();
+			this->memory->incRefCount();
+			previousMemory->runMutex.unlock();
+			previousMemory->decRefCount();
+		}
+#endif
+		previousMemory->decRefCount();
 		this->memory->onThreadChanged();
 		KThread::currentThread()->memory = this->memory;
 	}
@@ -1421,6 +1449,9 @@ U32 KProcess::mmap(U32 addr, U32 len, S32 prot, S32 flags, FD fildes, U64 off) {
                 memset(cache->data, 0, size*sizeof(U8*));
             }
             mappedFile->systemCacheEntry = cache;
+            if (exec) {
+                DecodedBlockCache::onExecMapped(cache, mappedFile->file);
+            }
 #endif
             KThread::currentThread()->process->mappedFiles[mappedFile->address] = mappedFile;
             this->memory->allocPages(pageStart, pageCount, permissions, fildes, off, mappedFile);
@@ -1549,11 +1580,11 @@ U32 KProcess::setitimer(U32 which, U32 newValue, U32 oldValue) {
         } else {
             this->timer.resetMillies = resetMillies;			
             if (this->timer.millies!=0) {
-                this->timer.millies = millies + KSystem::getMilliesSinceStart();
-            } else {
-                this->timer.millies = millies + KSystem::getMilliesSinceStart();
-                addTimer(&this->timer);
+                // the timer wheel files timers by their due time, so it has to be taken out before it changes
+                removeTimer(&this->timer);
             }
+            this->timer.millies = millies + KSystem::getMilliesSinceStart();
+            addTimer(&this->timer);
         }
     }	
     return 0;
@@ -1928,6 +1959,24 @@ U32 KProcess::writev(FD handle, U32 iov, S32 iovcnt) {
     return fd->kobject->writev(iov, iovcnt);    
 }
 
+U32 KProcess::readv(FD handle, U32 iov, S32 iovcnt) {
+    KFileDescriptor* fd = this->getFileDescriptor(handle);
+
+    if (fd==0) {
+        return -K_EBADF;
+    }
+    if (!fd->canRead()) {
+        return -K_EINVAL;
+    }
+#ifdef BOXEDWINE_BINARY_TRANSLATOR
+    BtCodeMemoryWrite w((BtCPU*)KThread::currentThread()->cpu);
+    for (S32 i=0;i<iovcnt && i<K_IOV_MAX;i++) {
+        w.invalidateCode(readd(iov + i * 8), readd(iov + i * 8 + 4));
+    }
+#endif
+    return fd->kobject->readv(iov, iovcnt);
+}
+
 U32 KProcess::memfd_create(const std::string& name, U32 flags) {
     FsMemNode* node = new FsMemNode(1, 1, name);
     FsMemOpenNode* openNode = new FsMemOpenNode(flags, node);
@@ -2297,6 +2346,9 @@ U32 KProcess::epollcreate(U32 size, U32 flags) {
 
 U32 KProcess::epollctl(FD epfd, U32 op, FD fd, U32 address) {
     KFileDescriptor* epollFD = this->getFileDescriptor(epfd);
+    if (!epollFD) {
+        return -K_EBADF;
+    }
     if (fd==epfd || epollFD->kobject->type != KTYPE_EPOLL) {
         return -K_EINVAL;
     }
@@ -2603,6 +2655,9 @@ void KProcess::signalFd(KThread* thread, U32 signal) {
                 BOXEDWINE_CONDITION_SIGNAL(p->lockCond);
                 BOXEDWINE_CONDITION_UNLOCK(p->lockCond);
             }
+            if (p->mask & signal) {
+                p->signalEPoll();
+            }
         }
     }
 }
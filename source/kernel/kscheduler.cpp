@@ -21,6 +21,9 @@
 #include "devfb.h"
 #include "kscheduler.h"
 #include "knativewindow.h"
+#ifdef BOXEDWINE_CPU_WORKERS
+#include "knativethread.h"
+#endif
 
 #include <stdio.h>
 
@@ -28,16 +31,326 @@
 
 KList<KThread*> scheduledThreads;
 KList<KThread*> waitThreads;
-KList<KTimer*> timers;
+KTimerWheel timers;
+S32 contextTime = 100000;
+#ifdef BOXEDWINE_CPU_WORKERS
+static THREAD_LOCAL S32 contextTimeRemaining = 100000;
+#else
+S32 contextTimeRemaining = 100000;
+#endif
+
+#ifdef BOXEDWINE_CPU_WORKERS
+// With -workers the guest threads are run by a pool of host threads, the cpu workers, instead of
+// only by the main thread.  Each worker has its own queue and takes threads from the back of the
+// other queues when nothing in its own can run.  The threads that share a Memory are kept in one
+// queue and only one of them runs at a time, since that memory and its code cache are not safe to
+// use from two host threads.  Threads of different processes run at the same time.
+//
+// Guest code runs with the kernel lock held shared, everything else here, including picking and
+// queueing threads, happens with it held exclusively, see BoxedWineKernelLock.  The main thread is
+// worker 0, it keeps the lock while it handles timers and SDL events and only runs the threads of
+// processes that have called into SDL or OpenGL, since those calls have to be made from it.
+class KCpuWorker {
+public:
+    KCpuWorker(U32 index) : index(index), nativeThread(NULL), idle(false), wake(false), elapsedTimeMIPS(0), elapsedInstructionsMIPS(0) {}
+
+    const U32 index;
+    KList<KThread*> queue;
+    KNativeThread* nativeThread;
+    bool idle;
+
+    // an idle worker waits on this without the kernel lock
+    KNativeMutex wakeMutex;
+    KNativeCondition wakeCond;
+    bool wake;
+
+    U64 elapsedTimeMIPS;
+    U64 elapsedInstructionsMIPS;
+};
+
+static std::vector<KCpuWorker*> cpuWorkers;
+static THREAD_LOCAL KCpuWorker* currentCpuWorker;
+static bool cpuWorkersDone;
+static U32 nextCpuWorker;
+static U64 cpuWorkersRdtsc;
+
+static void wakeCpuWorker(KCpuWorker* worker) {
+    if (worker->idle) {
+        worker->wakeMutex.lock();
+        worker->wake = true;
+        worker->wakeCond.signal();
+        worker->wakeMutex.unlock();
+    }
+}
+
+// gives up the kernel lock while it waits
+static void waitForCpuWorkerWork(KCpuWorker* worker, U32 maxMillies) {
+    worker->idle = true;
+    BoxedWineKernelLock::unlock();
+    worker->wakeMutex.lock();
+    if (!worker->wake) {
+        worker->wakeCond.waitWithTimeout(worker->wakeMutex, maxMillies);
+    }
+    worker->wake = false;
+    worker->wakeMutex.unlock();
+    BoxedWineKernelLock::lock();
+    worker->idle = false;
+}
+
+static KCpuWorker* getCpuWorkerQueue(KThread* thread) {
+    Memory* memory = thread->memory;
+
+    if (memory->mainThreadOnly) {
+        return cpuWorkers[0];
+    }
+    if (!memory->cpuWorker) {
+        memory->cpuWorker = 1 + (nextCpuWorker++ % ((U32)cpuWorkers.size() - 1));
+    }
+    return cpuWorkers[memory->cpuWorker];
+}
+
+static KThread* pickCpuWorkerThread(KCpuWorker* worker) {
+    KListNode<KThread*>* node = worker->queue.front();
+
+    while (node) {
+        KListNode<KThread*>* next = node->getNext();
+        KThread* thread = node->data;
+        KCpuWorker* queue = getCpuWorkerQueue(thread);
+
+        if (queue != worker) {
+            // its process was taken by another worker or has to run on the main thread now
+            node->remove();
+            queue->queue.addToBack(node);
+            wakeCpuWorker(queue);
+        } else if (thread->memory->runMutex.tryLock()) {
+            return thread;
+        }
+        node = next;
+    }
+    if (!worker->index) {
+        return NULL;
+    }
+    U32 count = (U32)cpuWorkers.size() - 1;
+    for (U32 i = 1; i < count; i++) {
+        KCpuWorker* from = cpuWorkers[(worker->index - 1 + i) % count + 1];
+
+        for (node = from->queue.back(); node; node = node->getPrev()) {
+            Memory* memory = node->data->memory;
+
+            if (!memory->mainThreadOnly && memory->runMutex.tryLock()) {
+                // take all the threads of the process so that they keep taking turns on one worker
+                memory->cpuWorker = worker->index;
+                from->queue.for_each([memory, worker](KListNode<KThread*>* n) {
+                    if (n->data->memory == memory) {
+                        n->remove();
+                        worker->queue.addToBack(n);
+                    }
+                });
+                return node->data;
+            }
+        }
+    }
+    return NULL;
+}
+
+static void scheduleCpuWorkerThread(KThread* thread) {
+    if (thread->cpuWorker) {
+        // its worker will queue it when it stops running it
+        return;
+    }
+    KCpuWorker* worker = getCpuWorkerQueue(thread);
+    worker->queue.addToFront(&thread->scheduledThreadNode);
+    if (worker->idle) {
+        wakeCpuWorker(worker);
+    } else if (worker->index) {
+        // it could be a while before its own worker gets to it
+        for (U32 i = 1; i < cpuWorkers.size(); i++) {
+            if (cpuWorkers[i]->idle) {
+                wakeCpuWorker(cpuWorkers[i]);
+                break;
+            }
+        }
+    }
+}
+
+extern THREAD_LOCAL U64 sysCallTime;
+
+// the thread was picked by pickCpuWorkerThread, so its memory's runMutex is held
+static void runCpuWorkerThread(KCpuWorker* worker, KThread* thread) {
+    ChangeThread c(thread);
+    Memory* memory = thread->memory;
+
+    memory->incRefCount(); // exec can replace it while the thread runs
+    thread->scheduledThreadNode.remove();
+    thread->cpuWorker = worker;
+    thread->cpu->instructionCount = cpuWorkersRdtsc;
+    sysCallTime = 0;
+    contextTimeRemaining = contextTime;
+
+    U64 startTime = KSystem::getMicroCounter();
+    BoxedWineKernelLock::unlock();
+    BoxedWineKernelLock::lockShared();
+    platformRunThreadSlice(thread);
+    BoxedWineKernelLock::unlockShared();
+    BoxedWineKernelLock::lock();
+    U64 diff = KSystem::getMicroCounter() - startTime;
+
+    if (thread->cpu->instructionCount > cpuWorkersRdtsc) {
+        cpuWorkersRdtsc = thread->cpu->instructionCount;
+    }
+    worker->elapsedTimeMIPS += diff;
+    worker->elapsedInstructionsMIPS += thread->cpu->blockInstructionCount;
+    thread->userTime += diff - sysCallTime;
+    thread->kernelTime += sysCallTime;
+    thread->cpuWorker = NULL;
+
+    memory = thread->memory;
+    if (thread->terminating) {
+        delete thread;
+    } else {
+        // signals sent to it by other workers while it was running
+        thread->runSignals();
+        if (!thread->waitingCond && !thread->scheduledThreadNode.isInList()) {
+            getCpuWorkerQueue(thread)->queue.addToBack(&thread->scheduledThreadNode);
+        }
+    }
+    memory->runMutex.unlock();
+    memory->decRefCount();
+}
+
+static int runCpuWorker(void* data) {
+    KCpuWorker* worker = (KCpuWorker*)data;
+
+    currentCpuWorker = worker;
+    BoxedWineKernelLock::lock();
+    while (!cpuWorkersDone) {
+        KThread* thread = pickCpuWorkerThread(worker);
+        if (thread) {
+            runCpuWorkerThread(worker, thread);
+        } else {
+            waitForCpuWorkerWork(worker, 20);
+        }
+    }
+    BoxedWineKernelLock::unlock();
+    return 0;
+}
+
+// the main thread holds the kernel lock from here until stopCpuWorkers, except while it waits or
+// runs a thread
+void startCpuWorkers(U32 count) {
+    if (!count) {
+        return;
+    }
+    for (U32 i = 0; i <= count; i++) {
+        cpuWorkers.push_back(new KCpuWorker(i));
+    }
+    currentCpuWorker = cpuWorkers[0];
+    cpuWorkersDone = false;
+    BoxedWineKernelLock::enabled = true;
+    BoxedWineKernelLock::lock();
+    while (!scheduledThreads.isEmpty()) {
+        KListNode<KThread*>* node = scheduledThreads.front();
+        node->remove();
+        getCpuWorkerQueue(node->data)->queue.addToBack(node);
+    }
+    for (U32 i = 1; i <= count; i++) {
+        cpuWorkers[i]->nativeThread = KNativeThread::createAndStartThread(runCpuWorker, "CpuWorker", cpuWorkers[i]);
+    }
+}
+
+void stopCpuWorkers() {
+    if (cpuWorkers.empty()) {
+        return;
+    }
+    cpuWorkersDone = true;
+    for (U32 i = 1; i < cpuWorkers.size(); i++) {
+        wakeCpuWorker(cpuWorkers[i]);
+    }
+    BoxedWineKernelLock::unlock();
+    for (U32 i = 1; i < cpuWorkers.size(); i++) {
+        cpuWorkers[i]->nativeThread->wait();
+        delete cpuWorkers[i]->nativeThread;
+    }
+    BoxedWineKernelLock::enabled = false;
+    for (auto& worker : cpuWorkers) {
+        while (!worker->queue.isEmpty()) {
+            KListNode<KThread*>* node = worker->queue.front();
+            node->remove();
+            scheduledThreads.addToBack(node);
+        }
+        delete worker;
+    }
+    cpuWorkers.clear();
+    currentCpuWorker = NULL;
+}
+
+void waitForMainThreadWork(U32 maxMillies) {
+    waitForCpuWorkerWork(cpuWorkers[0], maxMillies);
+}
+
+bool moveToMainThread(KThread* thread) {
+    if (!currentCpuWorker || !currentCpuWorker->index) {
+        return false;
+    }
+    BOXEDWINE_KERNEL_CRITICAL_SECTION;
+    thread->memory->mainThreadOnly = true;
+    thread->cpu->yield = true;
+    return true;
+}
+
+bool isThreadRunningOnOtherCpuWorker(KThread* thread) {
+    return thread->cpuWorker && thread->cpuWorker != currentCpuWorker;
+}
+
+// the main thread runs the threads whose process has called into SDL or OpenGL
+static bool runMainThreadSlice() {
+    KCpuWorker* worker = cpuWorkers[0];
+    U64 elapsedTime = 0;
+    bool ran = false;
+
+    while (elapsedTime<9000) {
+        KThread* thread = pickCpuWorkerThread(worker);
+        if (!thread) {
+            break;
+        }
+        U64 threadStartTime = KSystem::getMicroCounter();
+        KNativeWindow::getNativeWindow()->glUpdateContextForThread(thread);
+        runCpuWorkerThread(worker, thread);
+        elapsedTime+=KSystem::getMicroCounter()-threadStartTime;
+        ran = true;
+    }
+    return ran;
+}
+#endif
 
 void addTimer(KTimer* timer) {
-    timers.addToBack(&timer->node);
-    timer->active = true;
+    timers.add(timer);
+#ifdef BOXEDWINE_CPU_WORKERS
+    if (!cpuWorkers.empty()) {
+        // the main thread runs the timers
+        wakeCpuWorker(cpuWorkers[0]);
+    }
+#endif
 }
 
 void removeTimer(KTimer* timer) {
-    timer->node.remove();
-    timer->active = false;
+    timers.remove(timer);
+}
+
+U32 getMilliesUntilNextTimer(U32 maxMillies) {
+    U32 deadline;
+
+    if (!timers.getNextDeadline(&deadline)) {
+        return maxMillies;
+    }
+    S32 result = (S32)(deadline-KSystem::getMilliesSinceStart());
+    if (result<=0) {
+        return 0;
+    }
+    if ((U32)result<maxMillies) {
+        return (U32)result;
+    }
+    return maxMillies;
 }
 
 void scheduleThread(KThread* thread) {
@@ -50,6 +363,12 @@ void scheduleThread(KThread* thread) {
     }
 #endif
     thread->cpu->yield = false;
+#ifdef BOXEDWINE_CPU_WORKERS
+    if (!cpuWorkers.empty()) {
+        scheduleCpuWorkerThread(thread);
+        return;
+    }
+#endif
     scheduledThreads.addToFront(&thread->scheduledThreadNode);
 }
 
@@ -61,6 +380,14 @@ void unscheduleThread(KThread* thread) {
 void terminateOtherThread(const std::shared_ptr<KProcess>& process, U32 threadId) {
     KThread* thread = process->getThreadById(threadId);
     if (thread) {
+#ifdef BOXEDWINE_CPU_WORKERS
+        if (isThreadRunningOnOtherCpuWorker(thread)) {
+            // its worker deletes it once it stops running it
+            thread->terminating = true;
+            thread->cpu->yield = true;
+            return;
+        }
+#endif
         unscheduleThread(thread);
         delete thread;
     }
@@ -71,8 +398,6 @@ void terminateCurrentThread(KThread* thread) {
 	unscheduleThread(thread);
 }
 
-S32 contextTime = 100000;
-S32 contextTimeRemaining = 100000;
 int count;
 extern struct Block emptyBlock;
 
@@ -83,16 +408,29 @@ void runThreadSlice(KThread* thread) {
     cpu->blockInstructionCount = 0;
     cpu->yield = false;
     cpu->nextBlock = cpu->getNextBlock(); // another thread that just ran could have modified this
+#ifdef BOXEDWINE_CPU_WORKERS
+    U32 kernelLockDepth = BoxedWineKernelLock::getDepth();
+#endif
 #ifdef BOXEDWINE_HAS_SETJMP
     if (setjmp(cpu->runBlockJump)==0) {
 #endif
         do {
             cpu->run();
+#ifdef BOXEDWINE_CPU_WORKERS
+            // the kernel ran on another worker while this one waited, the block this thread was
+            // going to run next could have been freed
+            if (BoxedWineKernelLock::yieldShared() && !cpu->yield && !thread->terminating) {
+                cpu->nextBlock = cpu->getNextBlock();
+            }
+#endif
         } while ((int)cpu->blockInstructionCount < contextTimeRemaining && !cpu->yield);	
 
 #ifdef BOXEDWINE_HAS_SETJMP
     } else {
         cpu->nextBlock = NULL;
+#ifdef BOXEDWINE_CPU_WORKERS
+        BoxedWineKernelLock::unwindTo(kernelLockDepth);
+#endif
     }
 #endif
 
@@ -100,24 +438,22 @@ void runThreadSlice(KThread* thread) {
 }
 
 void runTimers() {
-    U32 millies = KSystem::getMilliesSinceStart();
-    timers.for_each([millies] (KListNode<KTimer*>* node) {
-        KTimer* timer = node->data;
-
-        if (timer->millies<=millies) {
-            if (timer->run()) {                
-                timer->node.remove();
-            }
-        }
-    });
+    timers.run(KSystem::getMilliesSinceStart());
 }
 
+#ifndef BOXEDWINE_CPU_WORKERS
 extern U64 sysCallTime;
+#endif
 U64 elapsedTimeMIPS;
 U64 elapsedInstructionsMIPS;
 
-bool runSlice() {    
+bool runSlice() {
     runTimers();
+#ifdef BOXEDWINE_CPU_WORKERS
+    if (!cpuWorkers.empty()) {
+        return runMainThreadSlice();
+    }
+#endif
 
     if (scheduledThreads.isEmpty())
         return false;
@@ -179,6 +515,14 @@ bool runSlice() {
 
 U32 getMIPS() {
     U32 result = 0;
+#ifdef BOXEDWINE_CPU_WORKERS
+    for (auto& worker : cpuWorkers) {
+        elapsedTimeMIPS += worker->elapsedTimeMIPS;
+        elapsedInstructionsMIPS += worker->elapsedInstructionsMIPS;
+        worker->elapsedTimeMIPS = 0;
+        worker->elapsedInstructionsMIPS = 0;
+    }
+#endif
     if (elapsedTimeMIPS) {
         result = (U32)(elapsedInstructionsMIPS/elapsedTimeMIPS);
         elapsedTimeMIPS = 0;
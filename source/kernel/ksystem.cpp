@@ -21,6 +21,7 @@
 #include "bufferaccess.h"
 #include "kstat.h"
 #include "kscheduler.h"
+#include "kvdso.h"
 #include "../emulation/softmmu/soft_ram.h"
 #include "../emulation/cpu/normal/normalCPU.h"
 #include "knativesystem.h"
@@ -50,11 +51,16 @@ std::string KSystem::title;
 // some simple opengl apps seem to have a hard time starting if this is false
 // Not sure if this is a Boxedwine issue or if its normal for Windows to behave different for OpenGL if the window is hidden
 bool KSystem::showWindowImmediately = false;
+std::string KSystem::decodedBlockCacheDir;
 #ifdef BOXEDWINE_BINARY_TRANSLATOR
 bool KSystem::useLargeAddressSpace = true;
 #endif
 #ifdef BOXEDWINE_MULTI_THREADED
 U32 KSystem::cpuAffinityCountForApp = 1;
+bool KSystem::glThread = false;
+#endif
+#ifdef BOXEDWINE_CPU_WORKERS
+U32 KSystem::cpuWorkers = 0;
 #endif
 U32 KSystem::pollRate = DEFAULT_POLL_RATE;
 
@@ -159,6 +165,8 @@ U32 KSystem::ugetrlimit(U32 resource, U32 rlim) {
 }
 
 U32 KSystem::clock_gettime(U32 clock_id, U32 tp) {    
+    // the vDSO only makes the syscall when its time page is too old to use
+    KVdso::update(KThread::currentThread());
     if (clock_id==0 || clock_id==5) { // CLOCK_REALTIME / CLOCK_REALTIME_COARSE
         U64 m = KSystem::getSystemTimeAsMicroSeconds();
         writed(tp, (U32)(m / 1000000l));
@@ -392,6 +400,7 @@ U32 KSystem::getpgid(U32 pid) {
 }
 
 U32 KSystem::gettimeofday(U32 tv, U32 tz) {
+    KVdso::update(KThread::currentThread());
     U64 m = Platform::getSystemTimeAsMicroSeconds();
     
     writed(tv, (U32)(m / 1000000l));
@@ -25,13 +25,11 @@
 #include <string.h>
 #include <setjmp.h>
 
-#ifdef BOXEDWINE_BINARY_TRANSLATOR
+#if defined(BOXEDWINE_BINARY_TRANSLATOR) || defined(BOXEDWINE_CPU_WORKERS)
 THREAD_LOCAL
 #endif
 KThread* KThread::runningThread;
 
-BOXEDWINE_MUTEX KThread::futexesMutex;
-
 KThread::~KThread() {    
     this->cleanup();
     CPU* cpu = this->cpu;
@@ -43,7 +41,7 @@ void KThread::cleanup() {
     BOXEDWINE_CONDITION_SIGNAL_ALL_NEED_LOCK(this->waitingForSignalToEndCond);
     if (!KSystem::shutingDown && this->clear_child_tid && this->process && this->process->memory->isValidWriteAddress(this->clear_child_tid, 4)) {
         writed(this->clear_child_tid, 0);
-        this->futex(this->clear_child_tid, 1, 1, 0);        
+        this->futex(this->clear_child_tid, 1, 1, 0, 0, 0);        
     }
 	this->clear_child_tid = 0;
 #ifndef BOXEDWINE_MULTI_THREADED
@@ -121,9 +119,13 @@ KThread::KThread(U32 id, const std::shared_ptr<KProcess>& process) :
 #ifndef BOXEDWINE_MULTI_THREADED
     scheduledThreadNode(this),
     waitThreadNode(this),            
+#ifdef BOXEDWINE_CPU_WORKERS
+    cpuWorker(NULL),
+#endif
 #endif
     condStartWaitTime(0),
-    sleepCond("KThread::sleepCond")
+    sleepCond("KThread::sleepCond"),
+    futexWaiter(this)
     {
     int i;
 
@@ -183,9 +185,15 @@ U32 KThread::signal(U32 signal, bool wait) {
             this->cpu->reg[0].u32 = 0; 
             this->cpu->eip.u32+=2;
         } 
-#ifdef BOXEDWINE_MULTI_THREADED                     
+#if defined(BOXEDWINE_MULTI_THREADED) || defined(BOXEDWINE_CPU_WORKERS)
+#ifdef BOXEDWINE_MULTI_THREADED
         else {
             // :TODO: how to interrupt the thread (the current approache assumes the thread will yield to the signal)
+#else
+        else if (isThreadRunningOnOtherCpuWorker(this)) {
+            // its worker runs the signal once it stops running it, see kscheduler.cpp
+            this->cpu->yield = true;
+#endif
             {
                 BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->pendingSignalsMutex);
                 this->pendingSignals |= ((U64)1 << (signal-1));
@@ -214,134 +222,256 @@ U32 KThread::signal(U32 signal, bool wait) {
 
 #define FUTEX_WAIT 0
 #define FUTEX_WAKE 1
-#define FUTEX_WAIT_PRIVATE 128
-#define FUTEX_WAKE_PRIVATE 129
-
-struct futex {
+#define FUTEX_REQUEUE 3
+#define FUTEX_CMP_REQUEUE 4
+#define FUTEX_WAIT_BITSET 9
+#define FUTEX_WAKE_BITSET 10
+#define FUTEX_PRIVATE_FLAG 128
+#define FUTEX_CLOCK_REALTIME 256
+#define FUTEX_CMD_MASK ~(FUTEX_PRIVATE_FLAG | FUTEX_CLOCK_REALTIME)
+#define FUTEX_BITSET_MATCH_ANY 0xFFFFFFFF
+
+#define FUTEX_EXPIRE_NEVER 0xFFFFFFFF
+
+// Waiters are hashed by host address into buckets, each bucket has its own lock so that
+// unrelated futexes don't contend with each other.  There is no limit on how many threads 
+// can wait at the same time since each thread brings its own KFutexWaiter.
+//
+// lock order is always bucket mutex then waiter cond
+#define FUTEX_HASH_BITS 8
+#define FUTEX_HASH_SIZE (1 << FUTEX_HASH_BITS)
+
+class KFutexBucket {
 public:
-    futex() : cond("futex") {}
-    KThread* thread;
-    U8* address;  
-    U32 expireTimeInMillies;
-    bool wake;
-    BOXEDWINE_CONDITION cond;
+    BOXEDWINE_MUTEX mutex;
+    KList<KFutexWaiter*> waiters;
 };
 
-#define MAX_FUTEXES 128
-
-struct futex system_futex[MAX_FUTEXES];
+static KFutexBucket futexBuckets[FUTEX_HASH_SIZE];
 
-struct futex* getFutex(KThread* thread, U8* address) {
-    int i=0;
+static KFutexBucket* getFutexBucket(U8* address) {
+    U64 key = (U64)(uintptr_t)address >> 2;
+    return &futexBuckets[(U32)((key * 0x9E3779B97F4A7C15l) >> (64 - FUTEX_HASH_BITS))];
+}
 
-    for (i=0;i<MAX_FUTEXES;i++) {
-        if (system_futex[i].address == address && system_futex[i].thread==thread) {
-            return &system_futex[i];
+// the waiter can be requeued to a different bucket while we wait for the lock, so retry until the bucket we locked is the one it is in
+static KFutexBucket* lockFutexWaiterBucket(KFutexWaiter* f) {
+    while (true) {
+        KFutexBucket* bucket = getFutexBucket(f->address);
+        BOXEDWINE_MUTEX_LOCK(bucket->mutex);
+        if (getFutexBucket(f->address) == bucket) {
+            return bucket;
         }
+        BOXEDWINE_MUTEX_UNLOCK(bucket->mutex);
     }
-    return 0;
 }
 
-struct futex* allocFutex(KThread* thread, U8* address, U32 millies) {
-    BOXEDWINE_CRITICAL_SECTION;
-    int i=0;
-
-    for (i=0;i<MAX_FUTEXES;i++) {
-        if (system_futex[i].thread==0) {
-            system_futex[i].thread = thread;
-            system_futex[i].address = address;
-            system_futex[i].expireTimeInMillies = millies;
-            system_futex[i].wake = false;
-            return &system_futex[i];
-        }
+static void lockFutexBuckets(KFutexBucket* b1, KFutexBucket* b2) {
+    if (b1 == b2) {
+        BOXEDWINE_MUTEX_LOCK(b1->mutex);
+    } else if (b1 < b2) {
+        BOXEDWINE_MUTEX_LOCK(b1->mutex);
+        BOXEDWINE_MUTEX_LOCK(b2->mutex);
+    } else {
+        BOXEDWINE_MUTEX_LOCK(b2->mutex);
+        BOXEDWINE_MUTEX_LOCK(b1->mutex);
     }
-    kpanic("ran out of futexes");
-    return 0;
 }
 
-void freeFutex(struct futex* f) {
-    f->thread = 0;
-    f->address = 0;
+static void unlockFutexBuckets(KFutexBucket* b1, KFutexBucket* b2) {
+    BOXEDWINE_MUTEX_UNLOCK(b1->mutex);
+    if (b1 != b2) {
+        BOXEDWINE_MUTEX_UNLOCK(b2->mutex);
+    }
 }
 
-void KThread::clearFutexes() {
-    U32 i;
+// bucket must be locked
+static void wakeFutexWaiter(KFutexWaiter* f) {
+    f->node.remove();
+    BOXEDWINE_CRITICAL_SECTION_WITH_CONDITION(f->cond);
+    f->wake = true;
+    BOXEDWINE_CONDITION_SIGNAL(f->cond);
+}
 
-    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(KThread::futexesMutex);
-    for (i=0;i<MAX_FUTEXES;i++) {
-        if (system_futex[i].thread == this) {
-            freeFutex(&system_futex[i]);
+// bucket must be locked
+static U32 wakeFutexWaiters(KFutexBucket* bucket, U8* address, U32 count, U32 bitset) {
+    U32 result = 0;
+    KListNode<KFutexWaiter*>* node = bucket->waiters.front();
+
+    while (node && result < count) {
+        KListNode<KFutexWaiter*>* next = node->getNext();
+        KFutexWaiter* f = node->data;
+        if (f->address == address && (f->bitset & bitset)) {
+            wakeFutexWaiter(f);
+            result++;
         }
+        node = next;
     }
+    return result;
 }
 
-U32 KThread::futex(U32 addr, U32 op, U32 value, U32 pTime) {    
-    U8* ramAddress = getPhysicalReadAddress(addr, 4);
+// returns true if the waiter was still queued, false means that someone else already woke it
+static bool removeFutexWaiter(KFutexWaiter* f) {
+    KFutexBucket* bucket = lockFutexWaiterBucket(f);
+    bool result = f->node.isInList();
+    f->node.remove();
+    BOXEDWINE_MUTEX_UNLOCK(bucket->mutex);
+    return result;
+}
 
-    if (ramAddress==0) {
-        kpanic("Could not find futex address: %0.8X", addr);
+static U32 getFutexRelativeExpireTime(U32 pTime) {
+    if (pTime == 0) {
+        return FUTEX_EXPIRE_NEVER;
+    }
+    U64 seconds = readd(pTime);
+    U32 nano = readd(pTime + 4);
+    U64 millies = seconds * 1000 + nano / 1000000;
+    if (millies >= 0x7FFFFFFF) {
+        return FUTEX_EXPIRE_NEVER;
     }
-    if (op==FUTEX_WAIT || op==FUTEX_WAIT_PRIVATE) {
-        struct futex* f=getFutex(this, ramAddress);
-        U32 expireTime;
+    return (U32)millies + KSystem::getMilliesSinceStart();
+}
 
-        if (pTime == 0) {
-            expireTime = 0xFFFFFFFF;
-        } else {
-            U32 seconds = readd(pTime);
-            U32 nano = readd(pTime + 4);
-            expireTime = seconds * 1000 + nano / 1000000 + KSystem::getMilliesSinceStart();
-        }
-        bool checkValue = false;
+// FUTEX_WAIT_BITSET uses an absolute time
+static U32 getFutexAbsoluteExpireTime(U32 pTime, bool realTime) {
+    if (pTime == 0) {
+        return FUTEX_EXPIRE_NEVER;
+    }
+    U64 seconds = readd(pTime);
+    U32 nano = readd(pTime + 4);
+    U64 target = seconds * 1000000 + nano / 1000;
+    U64 now = realTime ? KSystem::getSystemTimeAsMicroSeconds() : KSystem::getMicroCounter();
+    U64 millies = (target > now) ? (target - now) / 1000 : 0;
+    if (millies >= 0x7FFFFFFF) {
+        return FUTEX_EXPIRE_NEVER;
+    }
+    return (U32)millies + KSystem::getMilliesSinceStart();
+}
+
+void KThread::clearFutexes() {
+    KFutexWaiter* f = &this->futexWaiter;
+
+    removeFutexWaiter(f);
+    f->wake = false;
+    f->guestAddress = 0;
+}
 
-        if (!f) {
-            checkValue = true;
-            f = allocFutex(this, ramAddress, expireTime);
+U32 KThread::futexWait(U32 addr, U8* ramAddress, U32 value, U32 expireTime, U32 bitset) {
+    KFutexWaiter* f = &this->futexWaiter;
+
+    // In the single threaded build a wait will return -K_WAIT and the syscall will be called again once
+    // the condition is signaled, so the existing wait needs to be found instead of starting a new one.
+    // If we were requeued, f->address will no longer match ramAddress, but f->guestAddress will still match addr.
+    if (f->guestAddress != addr || (!f->node.isInList() && !f->wake)) {
+        // a signal handler can interrupt a wait and then wait on something else
+        clearFutexes();
+
+        KFutexBucket* bucket = getFutexBucket(ramAddress);
+        BOXEDWINE_MUTEX_LOCK(bucket->mutex);
+        if (readd(addr) != value) {
+            BOXEDWINE_MUTEX_UNLOCK(bucket->mutex);
+            return -K_EWOULDBLOCK;
         }
-        while (true) {
+        f->address = ramAddress;
+        f->guestAddress = addr;
+        f->expireTimeInMillies = expireTime;
+        f->bitset = bitset;
+        f->wake = false;
+        bucket->waiters.addToBack(&f->node);
+        BOXEDWINE_MUTEX_UNLOCK(bucket->mutex);
+    }
+    while (true) {
+        bool expired = false;
+        {
             BOXEDWINE_CRITICAL_SECTION_WITH_CONDITION(f->cond);
-            if (checkValue) {
-                checkValue = false;
-                if (readd(addr) != value) { // needs to be protected
-                    freeFutex(f);
-                    return -K_EWOULDBLOCK;
-                } 
-            }
             if (f->wake) {
-                freeFutex(f);
+                f->wake = false;
+                f->guestAddress = 0;
                 return 0;
-            }            
-            if (f->expireTimeInMillies<0x7FFFFFFF) {
+            }
+            if (f->expireTimeInMillies < 0x7FFFFFFF) {
                 S32 diff = f->expireTimeInMillies - KSystem::getMilliesSinceStart();
-                if (diff<=0) {
-                    freeFutex(f);
-                    return -K_ETIMEDOUT;
+                if (diff <= 0) {
+                    expired = true;
+                } else {
+                    BOXEDWINE_CONDITION_WAIT_TIMEOUT(f->cond, (U32)diff);
                 }
-                BOXEDWINE_CONDITION_WAIT_TIMEOUT(f->cond, (U32)diff);
             } else {
                 BOXEDWINE_CONDITION_WAIT(f->cond);
             }
+        }
+        // can't remove the waiter while holding f->cond, that would violate the lock order
+        if (expired && removeFutexWaiter(f)) {
+            f->guestAddress = 0;
+            return -K_ETIMEDOUT;
+        }
 #ifdef BOXEDWINE_MULTI_THREADED
-			if (this->terminating) {
-				return -K_EINTR; // probably doesn't matter
-			}
+        if (this->terminating) {
+            clearFutexes();
+            return -K_EINTR; // probably doesn't matter
+        }
 #endif
+    }
+}
+
+U32 KThread::futex(U32 addr, U32 op, U32 value, U32 pTime, U32 addr2, U32 value3) {
+    U8* ramAddress = getPhysicalReadAddress(addr, 4);
+    U32 cmd = op & FUTEX_CMD_MASK;
+
+    if (ramAddress==0) {
+        kpanic("Could not find futex address: %0.8X", addr);
+    }
+    if (cmd==FUTEX_WAIT) {
+        return this->futexWait(addr, ramAddress, value, getFutexRelativeExpireTime(pTime), FUTEX_BITSET_MATCH_ANY);
+    } else if (cmd==FUTEX_WAIT_BITSET) {
+        if (!value3) {
+            return -K_EINVAL;
+        }
+        return this->futexWait(addr, ramAddress, value, getFutexAbsoluteExpireTime(pTime, (op & FUTEX_CLOCK_REALTIME)!=0), value3);
+    } else if (cmd==FUTEX_WAKE || cmd==FUTEX_WAKE_BITSET) {
+        U32 bitset = (cmd==FUTEX_WAKE)?FUTEX_BITSET_MATCH_ANY:value3;
+        if (!bitset) {
+            return -K_EINVAL;
+        }
+        KFutexBucket* bucket = getFutexBucket(ramAddress);
+        BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(bucket->mutex);
+        return wakeFutexWaiters(bucket, ramAddress, value, bitset);
+    } else if (cmd==FUTEX_REQUEUE || cmd==FUTEX_CMP_REQUEUE) {
+        U8* ramAddress2 = getPhysicalReadAddress(addr2, 4);
+        U32 requeueCount = pTime; // val2 is passed in the timeout slot
+        if (ramAddress2==0) {
+            return -K_EFAULT;
+        }
+        KFutexBucket* bucket = getFutexBucket(ramAddress);
+        KFutexBucket* bucket2 = getFutexBucket(ramAddress2);
+        lockFutexBuckets(bucket, bucket2);
+        if (cmd==FUTEX_CMP_REQUEUE && readd(addr) != value3) {
+            unlockFutexBuckets(bucket, bucket2);
+            return -K_EAGAIN;
         }
-    } else if (op==FUTEX_WAKE_PRIVATE || op==FUTEX_WAKE) {
-        int i;
-        U32 count = 0;
-        for (i=0;i<MAX_FUTEXES && count<value;i++) {
-            if (system_futex[i].address==ramAddress && !system_futex[i].wake) {
-                BOXEDWINE_CRITICAL_SECTION_WITH_CONDITION(system_futex[i].cond);
-                system_futex[i].wake = true;
-                BOXEDWINE_CONDITION_SIGNAL(system_futex[i].cond);
-                count++;
+        U32 result = wakeFutexWaiters(bucket, ramAddress, value, FUTEX_BITSET_MATCH_ANY);
+        U32 requeued = 0;
+        KListNode<KFutexWaiter*>* node = bucket->waiters.front();
+
+        while (node && requeued < requeueCount) {
+            KListNode<KFutexWaiter*>* next = node->getNext();
+            KFutexWaiter* f = node->data;
+            if (f->address == ramAddress) {
+                if (bucket != bucket2) {
+                    f->node.remove();
+                    bucket2->waiters.addToBack(&f->node);
+                }
+                f->address = ramAddress2;
+                requeued++;
             }
+            node = next;
         }
-        return count;
+        unlockFutexBuckets(bucket, bucket2);
+        // FUTEX_REQUEUE only reports the woken threads, FUTEX_CMP_REQUEUE includes the requeued ones
+        return (cmd==FUTEX_CMP_REQUEUE)?result + requeued:result;
     } else {
         kwarn("syscall __NR_futex op %d not implemented", op);
-        return -1;
+        return -K_ENOSYS;
     }
 }
 
@@ -350,6 +480,7 @@ static U8 fetchByte(U32* eip) {
 }
 
 void KThread::signalIllegalInstruction(int code) {
+    BOXEDWINE_KERNEL_CRITICAL_SECTION;
     KSigAction* action = &this->process->sigActions[K_SIGILL];
     if (action->handlerAndSigAction == K_SIG_DFL) {
         DecodedBlock block;
@@ -369,6 +500,13 @@ void KThread::signalIllegalInstruction(int code) {
 }
 
 bool KThread::runSignals() {
+#ifdef BOXEDWINE_CPU_WORKERS
+    if (isThreadRunningOnOtherCpuWorker(this)) {
+        // its worker will call this once it stops running it
+        this->cpu->yield = true;
+        return false;
+    }
+#endif
     U64 todoProcess = this->process->pendingSignals & ~(this->inSignal?this->inSigMask:this->sigMask);
     U64 todoThread = this->pendingSignals & ~(this->inSignal?this->inSigMask:this->sigMask);
 
@@ -385,8 +523,8 @@ bool KThread::runSignals() {
                 }
             }
             if ((todoThread & ((U64)1 << i))!=0) {
-                BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->process->pendingSignalsMutex);
-                if ((this->process->pendingSignals & ((U64)1 << i))!=0) {
+                BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(this->pendingSignalsMutex);
+                if ((this->pendingSignals & ((U64)1 << i))!=0) {
                     this->pendingSignals &= ~(1 << i);
                     this->runSignal(i+1, -1, 0);
                     return true;
@@ -637,6 +775,7 @@ U32 KThread::sigreturn() {
 }
 
 void OPCALL onExitSignal(CPU* cpu, DecodedOp* op) {
+    BOXEDWINE_KERNEL_CRITICAL_SECTION;
     U32 context;	
     U64 count = cpu->instructionCount;
 
@@ -679,6 +818,7 @@ void OPCALL onExitSignal(CPU* cpu, DecodedOp* op) {
 
 // interrupted and condStartWaitTime are pushed because syscall's during the signal will clobber them
 void KThread::runSignal(U32 signal, U32 trapNo, U32 errorNo) {
+    BOXEDWINE_KERNEL_CRITICAL_SECTION;
     KSigAction* action = &this->process->sigActions[signal];
     if (action->handlerAndSigAction==K_SIG_DFL) {
 
@@ -4,4 +4,147 @@ KTimer::~KTimer() {
     if (this->active) {
         removeTimer(this);
     }
-}
\ No newline at end of file
+}
+#define K_TIMER_WHEEL_MASK (K_TIMER_WHEEL_SLOTS-1)
+#define K_TIMER_WHEEL_MAX_DELTA ((1u << (K_TIMER_WHEEL_BITS*K_TIMER_WHEEL_LEVELS))-1)
+
+KTimerWheel::KTimerWheel() : current(0), count(0) {
+    memset(this->occupied, 0, sizeof(this->occupied));
+}
+
+void KTimerWheel::add(KTimer* timer) {
+    this->place(timer);
+    this->count++;
+    timer->active = true;
+}
+
+void KTimerWheel::remove(KTimer* timer) {
+    if (timer->node.isInList()) {
+        timer->node.remove();
+        this->count--;
+    }
+    timer->active = false;
+}
+
+void KTimerWheel::place(KTimer* timer) {
+    U32 expires = timer->millies;
+    S32 delta = (S32)(expires-this->current);
+    U32 level = 0;
+
+    if (delta<0) {
+        // already due, it will fire on the next tick
+        expires = this->current;
+        delta = 0;
+    } else if ((U32)delta>K_TIMER_WHEEL_MAX_DELTA) {
+        expires = this->current+K_TIMER_WHEEL_MAX_DELTA;
+        delta = K_TIMER_WHEEL_MAX_DELTA;
+    }
+    while (level<K_TIMER_WHEEL_LEVELS-1 && (U32)delta>=(1u << (K_TIMER_WHEEL_BITS*(level+1)))) {
+        level++;
+    }
+    U32 slot = (expires >> (K_TIMER_WHEEL_BITS*level)) & K_TIMER_WHEEL_MASK;
+    this->slots[level][slot].addToBack(&timer->node);
+    this->occupied[level] |= (1ull << slot);
+}
+
+// called when every level below has wrapped around, spreads the next slot of this level back down
+void KTimerWheel::cascade(U32 level) {
+    U32 slot = (this->current >> (K_TIMER_WHEEL_BITS*level)) & K_TIMER_WHEEL_MASK;
+    KList<KTimer*>& list = this->slots[level][slot];
+
+    while (!list.isEmpty()) {
+        KListNode<KTimer*>* node = list.front();
+        node->remove();
+        this->place(node->data);
+    }
+    this->occupied[level] &= ~(1ull << slot);
+    if (slot==0 && level+1<K_TIMER_WHEEL_LEVELS) {
+        this->cascade(level+1);
+    }
+}
+
+void KTimerWheel::fire(U32 slot) {
+    KList<KTimer*> pending;
+    KList<KTimer*>& list = this->slots[0][slot];
+
+    this->occupied[0] &= ~(1ull << slot);
+    // run can add and remove any timer, including ones in this slot, so take them all out first
+    while (!list.isEmpty()) {
+        KListNode<KTimer*>* node = list.front();
+        node->remove();
+        pending.addToBack(node);
+    }
+    while (!pending.isEmpty()) {
+        KListNode<KTimer*>* node = pending.front();
+        KTimer* timer = node->data;
+
+        node->remove();
+        this->count--;
+        if (timer->run()) {
+            timer->active = false;
+        } else if (timer->active && !node->isInList()) {
+            // the timer set a new time for itself
+            this->place(timer);
+            this->count++;
+        }
+    }
+}
+
+void KTimerWheel::run(U32 now) {
+    while (this->count && (S32)(now-this->current)>=0) {
+        U32 slot = this->current & K_TIMER_WHEEL_MASK;
+
+        if (slot==0) {
+            this->cascade(1);
+        }
+        while (slot<K_TIMER_WHEEL_SLOTS && !(this->occupied[0] & (1ull << slot))) {
+            slot++;
+        }
+        U32 next = (this->current & ~K_TIMER_WHEEL_MASK)+slot;
+        if ((S32)(now-next)<0) {
+            break;
+        }
+        this->current = next;
+        if (slot<K_TIMER_WHEEL_SLOTS) {
+            this->current++;
+            this->fire(slot);
+        }
+    }
+    if ((S32)(now-this->current)>=0) {
+        this->current = now+1;
+    }
+}
+
+bool KTimerWheel::getNextDeadline(U32* millies) {
+    bool found = false;
+
+    for (U32 level=0;level<K_TIMER_WHEEL_LEVELS;level++) {
+        U32 shift = K_TIMER_WHEEL_BITS*level;
+        U32 index = (this->current >> shift) & K_TIMER_WHEEL_MASK;
+        // unless it is about to cascade, the current slot of a level above 0 is a full turn away, so it is checked last
+        U32 start = ((this->current & ((1u << shift)-1))?index+1:index);
+
+        for (U32 i=0;i<K_TIMER_WHEEL_SLOTS;i++) {
+            U32 slot = (start+i) & K_TIMER_WHEEL_MASK;
+            KListNode<KTimer*>* node;
+
+            if (!(this->occupied[level] & (1ull << slot))) {
+                continue;
+            }
+            node = this->slots[level][slot].front();
+            if (!node) {
+                continue;
+            }
+            while (node) {
+                U32 m = node->data->millies;
+                if (!found || (S32)(m-*millies)<0) {
+                    *millies = m;
+                    found = true;
+                }
+                node = node->getNext();
+            }
+            break;
+        }
+    }
+    return found;
+}
@@ -5,7 +5,9 @@
 #include "kstat.h"
 
 KUnixSocketObject::KUnixSocketObject(U32 pid, U32 domain, U32 type, U32 protocol) : KSocketObject(KTYPE_UNIX_SOCKET, domain, type, protocol), 
-    lockCond("KUnixSocketObject::lockCond")
+    lockCond("KUnixSocketObject::lockCond"),
+    nextRecord(0),
+    nextObject(0)
 {
 }
 
@@ -23,6 +25,7 @@ KUnixSocketObject::~KUnixSocketObject() {
             con->inClosed = true;
             con->outClosed = true;
             BOXEDWINE_CONDITION_SIGNAL_ALL(con->lockCond);
+            con->signalEPoll();
         }
     }        
     
@@ -46,6 +49,7 @@ KUnixSocketObject::~KUnixSocketObject() {
         if (s) {
             s->connecting.reset();
             BOXEDWINE_CONDITION_SIGNAL_ALL_NEED_LOCK(s->lockCond);
+            s->signalEPoll();
         }
     }    
     BOXEDWINE_CONDITION_SIGNAL_ALL(this->lockCond);
@@ -83,9 +87,9 @@ bool KUnixSocketObject::isOpen() {
     return this->listening || !this->connection.expired();
 }
 
+// the caller holds this->lockCond, waitForEvents takes it for K_POLLIN
 bool KUnixSocketObject::isReadReady() {
-    //BOXEDWINE_CRITICAL_SECTION_WITH_CONDITION(this->lockCond);
-    return this->inClosed || this->recvBuffer.size() || this->pendingConnections.size() || this->msgs.size();
+    return this->inClosed || !this->recvBuffer.isEmpty() || this->nextRecord<this->records.size() || this->pendingConnections.size();
 }
 
 bool KUnixSocketObject::isWriteReady() {
@@ -117,74 +121,70 @@ void KUnixSocketObject::waitForEvents(BOXEDWINE_CONDITION& parentCondition, U32
     }
 }
 
-U32 KUnixSocketObject::internal_write(const std::shared_ptr<KUnixSocketObject>& con, BOXEDWINE_CONDITION& cond, U32 buffer, U32 len) {
-    U32 count=0;
-    
-    if (this->type == K_SOCK_DGRAM) {
-        if (!strcmp(this->destAddress.data, "/dev/log")) {
-            char tmp[MAX_FILEPATH_LEN];
-            printf("%s\n", getNativeString(buffer, tmp, sizeof(tmp)));
-        }
-        return len;
+U32 KUnixSocketObject::writeDgram(U32 buffer, U32 len) {
+    if (!strcmp(this->destAddress.data, "/dev/log")) {
+        char tmp[MAX_FILEPATH_LEN];
+        printf("%s\n", getNativeString(buffer, tmp, sizeof(tmp)));
     }
+    return len;
+}
+
+U32 KUnixSocketObject::internal_write(const std::shared_ptr<KUnixSocketObject>& con, KIoVec& io) {
     if (this->outClosed || !con)
         return -K_EPIPE;  
     
-    //printf("internal_write: %0.8X size=%d capacity=%d writeLen=%d", (int)&this->connection->recvBuffer, (int)this->connection->recvBuffer.size(), (int)this->connection->recvBuffer.capacity(), len);
+    return io.transfer([&con](KIoVec& io) {
+        U32 count = 0;
 
-    while (len) {
-        S8 tmp[4096];
-        U32 todo = len;
-
-        if (todo>4096)
-            todo = 4096;
-        if (!KThread::currentThread()->memory->isValidReadAddress(buffer, todo)) {
-            kwarn("KUnixSocketObject::internal_write about to crash reading buffer to buffer");
+        for (auto& span : io.spans) {
+            con->recvBuffer.write(span.buffer, span.len);
+            count+=span.len;
         }
-        memcopyToNative(buffer, tmp, todo);
-        con->recvBuffer.insert(con->recvBuffer.end(), tmp, tmp + todo);
-        buffer+=todo;
-        len-=todo;
-        count+=todo;
-    }     
-    return count;
+        return count;
+    });
 }
 
 U32 KUnixSocketObject::writev(U32 iov, S32 iovcnt) {
-    U32 len=0;
-    S32 i;
-    std::shared_ptr<KUnixSocketObject> con = this->connection.lock();
+    if (this->type == K_SOCK_DGRAM) {
+        U32 len = 0;
+
+        for (S32 i=0;i<iovcnt;i++) {
+            len+=this->writeDgram(readd(iov + i * 8), readd(iov + i * 8 + 4));
+        }
+        return len;
+    }
+    KIoVec io(true);
+    U32 result = io.addIov(iov, iovcnt);
 
+    if (result) {
+        return result;
+    }
+    std::shared_ptr<KUnixSocketObject> con = this->connection.lock();
     BOXEDWINE_CONDITION& cond = (con?con->lockCond:this->lockCond);
     BOXEDWINE_CRITICAL_SECTION_WITH_CONDITION(cond);
 
-    for (i=0;i<iovcnt;i++) {
-        U32 buf = readd(iov + i * 8);
-        U32 toWrite = readd(iov + i * 8 + 4);
-        S32 result;
-
-        result = this->internal_write(con, cond, buf, toWrite);
-        if (result<0) {
-            if (i>0) {
-                return len;
-            }
-            return result;
-        }
-        len+=result;
-    }    
+    result = this->internal_write(con, io);
     if (con) {
         BOXEDWINE_CONDITION_SIGNAL_ALL(cond);
+        con->signalEPoll();
     }
-    return len;
+    return result;
 }
 
 U32 KUnixSocketObject::write(U32 buffer, U32 len) {
+    if (this->type == K_SOCK_DGRAM) {
+        return this->writeDgram(buffer, len);
+    }
+    KIoVec io(true);
+    io.add(buffer, len);
+
     std::shared_ptr<KUnixSocketObject> con = this->connection.lock();
     BOXEDWINE_CONDITION& cond = (con?con->lockCond:this->lockCond);
     BOXEDWINE_CRITICAL_SECTION_WITH_CONDITION(cond);
-    U32 result = this->internal_write(con, cond, buffer, len);    
+    U32 result = this->internal_write(con, io);    
     if (con) {
         BOXEDWINE_CONDITION_SIGNAL_ALL(con->lockCond);
+        con->signalEPoll();
     }
     return result;
 }
@@ -201,8 +201,9 @@ U32 KUnixSocketObject::writeNative(U8* buffer, U32 len) {
         return -K_EPIPE;
 
     BOXEDWINE_CRITICAL_SECTION_WITH_CONDITION(con->lockCond); 
-    con->recvBuffer.insert(con->recvBuffer.end(), buffer, buffer + len);
+    con->recvBuffer.write(buffer, len);
     BOXEDWINE_CONDITION_SIGNAL_ALL(con->lockCond);
+    con->signalEPoll();
     return len;
 }
 
@@ -219,9 +220,9 @@ U32 KUnixSocketObject::unixsocket_write_native_nowait(const std::shared_ptr<KObj
         return -K_EPIPE;
 
     BOXEDWINE_CRITICAL_SECTION_WITH_CONDITION(con->lockCond);
-    //printf("SOCKET write len=%d bufferSize=%d pos=%d\n", len, s->connection->recvBufferLen, s->connection->recvBufferWritePos);
-    con->recvBuffer.insert(con->recvBuffer.end(), value, value + len);
+    con->recvBuffer.write(value, len);
     BOXEDWINE_CONDITION_SIGNAL_ALL(con->lockCond);
+    con->signalEPoll();
 
     return len;
 }
@@ -231,7 +232,7 @@ U32 KUnixSocketObject::readNative(U8* buffer, U32 len) {
     if (!this->inClosed && !con)
         return -K_EPIPE;
     BOXEDWINE_CRITICAL_SECTION_WITH_CONDITION(this->lockCond);
-    while (this->recvBuffer.size()==0) {
+    while (this->recvBuffer.isEmpty() && this->nextRecord==this->records.size()) {
         if (this->inClosed) {
             return 0;
         }
@@ -245,26 +246,102 @@ U32 KUnixSocketObject::readNative(U8* buffer, U32 len) {
 		}
 #endif
     }
-    //printf("readNative: %0.8X size=%d capacity=%d writeLen=%d", (int)&this->recvBuffer, (int)this->recvBuffer.size(), (int)this->recvBuffer.capacity(), len);
-    if (len > this->recvBuffer.size()) {
-        len = (U32)this->recvBuffer.size();
+    KUnixSocketRecord* record;
+    U32 limit = this->getReceiveLimit(&record);
+    if (len > limit) {
+        len = limit;
     }
-    std::copy(this->recvBuffer.begin(), this->recvBuffer.begin() + len, buffer);
-    this->recvBuffer.erase(this->recvBuffer.begin(), this->recvBuffer.begin() + len);
+    len = this->recvBuffer.read(buffer, len);
+    this->finishReceive(record, len, 0, 0);
     if (con) {
         BOXEDWINE_CONDITION_SIGNAL_ALL(this->lockCond);
     }
-    //printf("    readNative: %0.8X size=%d capacity=%d writeLen=%d", (int)&this->recvBuffer, (int)this->recvBuffer.size(), (int)this->recvBuffer.capacity(), len);
     return len;
 }
 
 U32 KUnixSocketObject::read(U32 buffer, U32 len) {
-    U32 count = 0;
+    KIoVec io(false);
+
+    io.add(buffer, len);
+    return this->internal_read(io, 0, 0, NULL);
+}
+
+U32 KUnixSocketObject::readv(U32 iov, S32 iovcnt) {
+    KIoVec io(false);
+    U32 result = io.addIov(iov, iovcnt);
+
+    if (result) {
+        return result;
+    }
+    return this->internal_read(io, 0, 0, NULL);
+}
+
+// how much can be received before crossing into the next message, record is set if a message starts at the current read position
+U32 KUnixSocketObject::getReceiveLimit(KUnixSocketRecord** record) {
+    U32 limit = this->recvBuffer.size();
+
+    *record = NULL;
+    if (this->nextRecord<this->records.size()) {
+        KUnixSocketRecord& r = this->records[this->nextRecord];
+        U32 offset = r.pos - this->recvBuffer.getReadPos();
+
+        if (offset==0) {
+            *record = &r;
+            limit = r.len;
+        } else if (offset<limit) {
+            limit = offset;
+        }
+    }
+    return limit;
+}
+
+// hands out the file descriptors attached to record, if there is no room for them in control they are dropped like on Linux, returns the control length used
+U32 KUnixSocketObject::finishReceive(KUnixSocketRecord* record, U32 len, U32 control, U32 controlLen) {
+    U32 controlWritten = 0;
+
+    if (!record) {
+        return 0;
+    }
+    for (U32 i=0;i<record->objectCount;i++) {
+        KSocketMsgObject& object = this->objects[this->nextObject+i];
+
+        if (control && controlWritten+16<=controlLen) {
+            KFileDescriptor* recvFd = KThread::currentThread()->process->allocFileDescriptor(object.object, object.accessFlags, 0, -1, 0);
+            writeCMsgHdr(control + controlWritten, 16, K_SOL_SOCKET, K_SCM_RIGHTS);
+            writed(control + controlWritten + 12, recvFd->handle);
+            controlWritten+=16;
+        }
+        object.object.reset();
+    }
+    this->nextObject+=record->objectCount;
+    record->objectCount = 0;
+    if (this->type != K_SOCK_STREAM) {
+        // datagrams are consumed whole, what didn't fit is truncated
+        this->recvBuffer.skip(record->len - len);
+        len = record->len;
+    }
+    record->pos+=len;
+    record->len-=len;
+    if (!record->len) {
+        this->nextRecord++;
+        if (this->nextRecord==this->records.size()) {
+            this->records.clear();
+            this->nextRecord = 0;
+        }
+    }
+    if (this->nextObject==this->objects.size()) {
+        this->objects.clear();
+        this->nextObject = 0;
+    }
+    return controlWritten;
+}
+
+U32 KUnixSocketObject::internal_read(KIoVec& io, U32 control, U32 controlLen, U32* controlWritten) {
     std::shared_ptr<KUnixSocketObject> con = this->connection.lock();
     if (!this->inClosed && !con)
         return -K_EPIPE;
     BOXEDWINE_CRITICAL_SECTION_WITH_CONDITION(this->lockCond);
-    while (this->recvBuffer.size()==0) {
+    while (this->recvBuffer.isEmpty() && this->nextRecord==this->records.size()) {
         if (this->inClosed) {
             return 0;
         }
@@ -278,28 +355,25 @@ U32 KUnixSocketObject::read(U32 buffer, U32 len) {
 		}
 #endif
     }
-    // :TODO: remove extra copy
-    while (len && this->recvBuffer.size()!=0) {
-        S8 tmp[4096];
-        U32 todo = len;
-
-        if (todo > 4096)
-            todo = 4096;
-        if (todo > this->recvBuffer.size())
-            todo = (U32)this->recvBuffer.size();
+    KUnixSocketRecord* record;
+    U32 limit = this->getReceiveLimit(&record);
+    U32 count = io.transfer([this, &limit](KIoVec& io) {
+        U32 count = 0;
 
-        std::copy(this->recvBuffer.begin(), this->recvBuffer.begin() + todo, tmp);
-        this->recvBuffer.erase(this->recvBuffer.begin(), this->recvBuffer.begin() + todo);
+        for (auto& span : io.spans) {
+            U32 todo = this->recvBuffer.read(span.buffer, (span.len < limit ? span.len : limit));
 
-        if (!KThread::currentThread()->memory->isValidWriteAddress(buffer, todo)) {
-            kwarn("KUnixSocketObject::read about to crash writing to buffer");
+            count += todo;
+            limit -= todo;
+            if (todo < span.len)
+                break;
         }
-        memcopyFromNative(buffer, tmp, todo);
-
-        buffer += todo;
-        count += todo;
-        len -= todo;
-    }      
+        return count;
+    });
+    U32 written = this->finishReceive(record, count, control, controlLen);
+    if (controlWritten) {
+        *controlWritten = written;
+    }
     if (con) {
         BOXEDWINE_CONDITION_SIGNAL_ALL(this->lockCond);
     }
@@ -445,6 +519,7 @@ U32 KUnixSocketObject::connect(KFileDescriptor* fd, U32 address, U32 len) {
                 destination->pendingConnections.push_back(t);
                 BOXEDWINE_CONDITION_SIGNAL_ALL(destination->lockCond);
                 BOXEDWINE_CONDITION_UNLOCK(destination->lockCond);
+                destination->signalEPoll();
 
                 if (!this->blocking) {
                     return -K_EINPROGRESS;
@@ -525,6 +600,7 @@ U32 KUnixSocketObject::accept(KFileDescriptor* fd, U32 address, U32 len, U32 fla
     resultSocket->connection = pendingConnection; // weak reference
     
     BOXEDWINE_CONDITION_SIGNAL_ALL(pendingConnection->lockCond);
+    pendingConnection->signalEPoll();
 
     return result->handle;
 }
@@ -590,6 +666,8 @@ U32 KUnixSocketObject::shutdown(KFileDescriptor* fd, U32 how) {
         BOXEDWINE_CONDITION_SIGNAL_ALL_NEED_LOCK(con->lockCond);
     }
     BOXEDWINE_CONDITION_SIGNAL_ALL_NEED_LOCK(this->lockCond);
+    con->signalEPoll();
+    this->signalEPoll();
     return 0;
 }
 
@@ -663,7 +741,6 @@ U32 KUnixSocketObject::getsockopt(KFileDescriptor* fd, U32 level, U32 name, U32
 U32 KUnixSocketObject::sendmsg(KFileDescriptor* fd, U32 address, U32 flags) {
     MsgHdr hdr;
     KThread* thread = KThread::currentThread();
-    U32 result = 0;
     std::shared_ptr<KUnixSocketObject> con = this->connection.lock();
 
     if (!con) {
@@ -678,8 +755,13 @@ U32 KUnixSocketObject::sendmsg(KFileDescriptor* fd, U32 address, U32 flags) {
         return -K_EPIPE;
     readMsgHdr(address, &hdr);
 
-    std::shared_ptr<KSocketMsg> msg = std::make_shared<KSocketMsg>();
+    KIoVec io(true);
+    U32 result = io.addIov(hdr.msg_iov, hdr.msg_iovlen);
+    U32 objectCount = 0;
 
+    if (result) {
+        return result;
+    }
     if (hdr.msg_control) {
         CMsgHdr cmsg;			
 
@@ -700,96 +782,42 @@ U32 KUnixSocketObject::sendmsg(KFileDescriptor* fd, U32 address, U32 flags) {
                 KSocketMsgObject d;
                 d.object = f->kobject;
                 d.accessFlags = f->accessFlags;
-                msg->objects.push_back(d);
+                con->objects.push_back(d);
+                objectCount++;
             }
         }				
     }
-    for (U32 i=0;i<hdr.msg_iovlen;i++) {
-        U32 p = readd(hdr.msg_iov + 8 * i);
-        U32 len = readd(hdr.msg_iov + 8 * i + 4);
-
-        msg->data.push_back((U8)len);
-        msg->data.push_back((U8)(len >> 8));
-        msg->data.push_back((U8)(len >> 16));
-        msg->data.push_back((U8)(len >> 24));
-        while (len) {
-            msg->data.push_back(readb(p++));
-            len--;
-            result++;
-        }
+    if (objectCount || this->type != K_SOCK_STREAM) {
+        KUnixSocketRecord record;
+        record.pos = con->recvBuffer.getWritePos();
+        record.len = io.totalLen;
+        record.objectCount = objectCount;
+        con->records.push_back(record);
     }
-    con->msgs.push(msg);
+    result = this->internal_write(con, io);
     BOXEDWINE_CONDITION_SIGNAL_ALL(con->lockCond);
+    con->signalEPoll();
 
     return result;
 }
 
 U32 KUnixSocketObject::recvmsg(KFileDescriptor* fd, U32 address, U32 flags) {
     MsgHdr hdr;
-    U32 result = 0;
+    KIoVec io(false);
+    U32 controlLen = 0;
 
     if (this->domain==K_AF_NETLINK)
         return -K_EIO;
-    BOXEDWINE_CRITICAL_SECTION_WITH_CONDITION(this->lockCond);
-    while (!this->msgs.size()) {
-        if (this->recvBuffer.size()) {
-            readMsgHdr(address, &hdr);        
-            for (U32 i = 0; i < hdr.msg_iovlen; i++) {
-                U32 p = readd(hdr.msg_iov + 8 * i);
-                U32 len = readd(hdr.msg_iov + 8 * i + 4);
-                
-                result+=this->read(p, len);
-            }
-            if (this->type==K_SOCK_STREAM)
-                writed(address + 4, 0); // msg_namelen, set to 0 for connected sockets
-            writed(address + 20, 0); // msg_controllen
-            return result;
-        }
-        if (this->inClosed) {
-            return 0;
-        }
-        if (!this->blocking) {
-            return -K_EWOULDBLOCK;
-        }
-        // :TODO: what about a time out
-        BOXEDWINE_CONDITION_WAIT(this->lockCond);
-#ifdef BOXEDWINE_MULTI_THREADED
-		if (KThread::currentThread()->terminating) {
-			return -K_EINTR;
-		}
-#endif
-    }
-
     readMsgHdr(address, &hdr);
-    std::shared_ptr<KSocketMsg> msg = this->msgs.front();
-    this->msgs.pop();
-
-    if (hdr.msg_control) {
-        KThread* thread = KThread::currentThread();
-        U32 i=0;
-
-        for (;i<hdr.msg_controllen/16 && i<msg->objects.size();i++) {
-            KFileDescriptor* recvFd = thread->process->allocFileDescriptor(msg->objects[i].object, msg->objects[i].accessFlags, 0, -1, 0);
-            writeCMsgHdr(hdr.msg_control + i * 16, 16, K_SOL_SOCKET, K_SCM_RIGHTS);
-            writed(hdr.msg_control + i * 16 + 12, recvFd->handle);
-        }
-        writed(address + 20, i * 20);
-    }
-    U32 pos = 0;
-    for (U32 i=0;i<hdr.msg_iovlen;i++) {
-        U32 p = readd(hdr.msg_iov + 8 * i);
-        U32 len = readd(hdr.msg_iov + 8 * i + 4);
-        U32 dataLen = msg->data[pos] | (((U32)msg->data[pos + 1]) << 8) | (((U32)msg->data[pos + 2]) << 16) | (((U32)msg->data[pos + 3]) << 24);
-        pos+=4;
-        if (len<dataLen) {
-            kpanic("unhandled socket msg logic");
-        }
-        memcopyFromNative(p, msg->data.data() + pos, dataLen);
-        pos+=dataLen;
-        result+=dataLen;
-    }  
-    if (!this->connection.expired()) {
-        BOXEDWINE_CONDITION_SIGNAL_ALL(this->lockCond);
+    U32 result = io.addIov(hdr.msg_iov, hdr.msg_iovlen);
+    if (result) {
+        return result;
+    }
+    result = this->internal_read(io, hdr.msg_control, hdr.msg_controllen, &controlLen);
+    if ((S32)result>=0) {
+        if (this->type==K_SOCK_STREAM)
+            writed(address + 4, 0); // msg_namelen, set to 0 for connected sockets
+        writed(address + 20, controlLen); // msg_controllen
     }
     return result;
 }
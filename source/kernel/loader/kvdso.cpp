@@ -0,0 +1,407 @@
+/*
+ *  Copyright (C) 2016  The BoxedWine Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "boxedwine.h"
+
+#include "kelf.h"
+#include "kvdso.h"
+
+// The other cpu cores handle int 0x80 with a plain function call and rdtsc is their instruction
+// count, the vDSO would only be slower there.  The binary translator has to leave the translated
+// code for a syscall and its rdtsc is the host's.
+#if defined BOXEDWINE_X64 && !defined LOG_OPS
+
+#ifdef BOXEDWINE_MSVC
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+// time page, the page just before the image
+#define VDSO_SEQ 0 // odd while the host is writing the rest
+#define VDSO_RATE 4 // microseconds per rdtsc tick, 0.32 fixed point, 0 means make the syscall
+#define VDSO_TSC 8 // rdtsc when the times below were taken
+#define VDSO_MONOTONIC 16 // microseconds
+#define VDSO_REALTIME 24 // microseconds
+#define VDSO_TIME_PAGE_SIZE 32
+
+// the guest code finds the time page relative to its own address, so it always starts here
+#define VDSO_CODE_OFFSET 0x200
+
+#define VDSO_SYM_SIZE 16
+#define VDSO_DYN_COUNT 7
+
+static U8 vdsoCode[] = {
+    // read the time, in: ebp = VDSO_MONOTONIC or VDSO_REALTIME, out: edx:eax = microseconds, CF set if the syscall has to be used
+    0xe8, 0x00, 0x00, 0x00, 0x00,            // 0: call 5
+    0x5f,                                    // 5: pop edi
+    0x81, 0xef, 0x05, 0x12, 0x00, 0x00,      // 6: sub edi,0x1205, edi is now the time page
+    0x8b, 0x37,                              // c: mov esi,[edi]
+    0xf7, 0xc6, 0x01, 0x00, 0x00, 0x00,      // e: test esi,0x1
+    0x75, 0xf6,                              // 14: jne c
+    0x8b, 0x4f, 0x04,                        // 16: mov ecx,[edi+0x4]
+    0x85, 0xc9,                              // 19: test ecx,ecx
+    0x74, 0x1d,                              // 1b: je 3a
+    0x0f, 0x31,                              // 1d: rdtsc
+    0x2b, 0x47, 0x08,                        // 1f: sub eax,[edi+0x8]
+    0x1b, 0x57, 0x0c,                        // 22: sbb edx,[edi+0xc]
+    0x75, 0x13,                              // 25: jne 3a, too long ago (or went backwards) to interpolate
+    0xf7, 0xe1,                              // 27: mul ecx
+    0x89, 0xd0,                              // 29: mov eax,edx
+    0x31, 0xd2,                              // 2b: xor edx,edx
+    0x03, 0x04, 0x2f,                        // 2d: add eax,[edi+ebp]
+    0x13, 0x54, 0x2f, 0x04,                  // 30: adc edx,[edi+ebp+0x4]
+    0x3b, 0x37,                              // 34: cmp esi,[edi]
+    0x75, 0xd4,                              // 36: jne c
+    0xf8,                                    // 38: clc
+    0xc3,                                    // 39: ret
+    0xf9,                                    // 3a: stc
+    0xc3,                                    // 3b: ret
+    // __vdso_clock_gettime(clockid, struct timespec*), offset 0x3c
+    0x55,                                    // 3c: push ebp
+    0x56,                                    // 3d: push esi
+    0x57,                                    // 3e: push edi
+    0x53,                                    // 3f: push ebx
+    0x8b, 0x44, 0x24, 0x14,                  // 40: mov eax,[esp+0x14]
+    0xbd, 0x18, 0x00, 0x00, 0x00,            // 44: mov ebp,0x18
+    0x85, 0xc0,                              // 49: test eax,eax
+    0x74, 0x19,                              // 4b: je 66
+    0x83, 0xf8, 0x05,                        // 4d: cmp eax,0x5
+    0x74, 0x14,                              // 50: je 66
+    0xbd, 0x10, 0x00, 0x00, 0x00,            // 52: mov ebp,0x10
+    0x83, 0xf8, 0x01,                        // 57: cmp eax,0x1
+    0x74, 0x0a,                              // 5a: je 66
+    0x83, 0xf8, 0x04,                        // 5c: cmp eax,0x4
+    0x74, 0x05,                              // 5f: je 66
+    0x83, 0xf8, 0x06,                        // 61: cmp eax,0x6
+    0x75, 0x21,                              // 64: jne 87
+    0xe8, 0x95, 0xff, 0xff, 0xff,            // 66: call 0
+    0x72, 0x1a,                              // 6b: jb 87
+    0xb9, 0x40, 0x42, 0x0f, 0x00,            // 6d: mov ecx,0xf4240
+    0xf7, 0xf1,                              // 72: div ecx
+    0x8b, 0x4c, 0x24, 0x18,                  // 74: mov ecx,[esp+0x18]
+    0x89, 0x01,                              // 78: mov [ecx],eax
+    0x69, 0xd2, 0xe8, 0x03, 0x00, 0x00,      // 7a: imul edx,edx,0x3e8
+    0x89, 0x51, 0x04,                        // 80: mov [ecx+0x4],edx
+    0x31, 0xc0,                              // 83: xor eax,eax
+    0xeb, 0x0f,                              // 85: jmp 96
+    0xb8, 0x09, 0x01, 0x00, 0x00,            // 87: mov eax,0x109, __NR_clock_gettime
+    0x8b, 0x5c, 0x24, 0x14,                  // 8c: mov ebx,[esp+0x14]
+    0x8b, 0x4c, 0x24, 0x18,                  // 90: mov ecx,[esp+0x18]
+    0xcd, 0x80,                              // 94: int 0x80
+    0x5b,                                    // 96: pop ebx
+    0x5f,                                    // 97: pop edi
+    0x5e,                                    // 98: pop esi
+    0x5d,                                    // 99: pop ebp
+    0xc3,                                    // 9a: ret
+    // __vdso_clock_gettime64(clockid, struct __kernel_timespec*), offset 0x9b
+    0x55,                                    // 9b: push ebp
+    0x56,                                    // 9c: push esi
+    0x57,                                    // 9d: push edi
+    0x53,                                    // 9e: push ebx
+    0x8b, 0x44, 0x24, 0x14,                  // 9f: mov eax,[esp+0x14]
+    0xbd, 0x18, 0x00, 0x00, 0x00,            // a3: mov ebp,0x18
+    0x85, 0xc0,                              // a8: test eax,eax
+    0x74, 0x19,                              // aa: je c5
+    0x83, 0xf8, 0x05,                        // ac: cmp eax,0x5
+    0x74, 0x14,                              // af: je c5
+    0xbd, 0x10, 0x00, 0x00, 0x00,            // b1: mov ebp,0x10
+    0x83, 0xf8, 0x01,                        // b6: cmp eax,0x1
+    0x74, 0x0a,                              // b9: je c5
+    0x83, 0xf8, 0x04,                        // bb: cmp eax,0x4
+    0x74, 0x05,                              // be: je c5
+    0x83, 0xf8, 0x06,                        // c0: cmp eax,0x6
+    0x75, 0x16,                              // c3: jne db
+    0xe8, 0x36, 0xff, 0xff, 0xff,            // c5: call 0
+    0x72, 0x0f,                              // ca: jb db
+    0xb9, 0x40, 0x42, 0x0f, 0x00,            // cc: mov ecx,0xf4240
+    0xf7, 0xf1,                              // d1: div ecx
+    0x69, 0xd2, 0xe8, 0x03, 0x00, 0x00,      // d3: imul edx,edx,0x3e8
+    0xeb, 0x1c,                              // d9: jmp f7
+    0xb8, 0x09, 0x01, 0x00, 0x00,            // db: mov eax,0x109, __NR_clock_gettime
+    0x8b, 0x5c, 0x24, 0x14,                  // e0: mov ebx,[esp+0x14]
+    0x8b, 0x4c, 0x24, 0x18,                  // e4: mov ecx,[esp+0x18]
+    0xcd, 0x80,                              // e8: int 0x80
+    0x85, 0xc0,                              // ea: test eax,eax
+    0x75, 0x22,                              // ec: jne 110
+    0x8b, 0x4c, 0x24, 0x18,                  // ee: mov ecx,[esp+0x18]
+    0x8b, 0x01,                              // f2: mov eax,[ecx]
+    0x8b, 0x51, 0x04,                        // f4: mov edx,[ecx+0x4]
+    0x8b, 0x4c, 0x24, 0x18,                  // f7: mov ecx,[esp+0x18]
+    0x89, 0x01,                              // fb: mov [ecx],eax
+    0xc7, 0x41, 0x04, 0x00, 0x00, 0x00, 0x00, // fd: mov [ecx+0x4],0x0
+    0x89, 0x51, 0x08,                        // 104: mov [ecx+0x8],edx
+    0xc7, 0x41, 0x0c, 0x00, 0x00, 0x00, 0x00, // 107: mov [ecx+0xc],0x0
+    0x31, 0xc0,                              // 10e: xor eax,eax
+    0x5b,                                    // 110: pop ebx
+    0x5f,                                    // 111: pop edi
+    0x5e,                                    // 112: pop esi
+    0x5d,                                    // 113: pop ebp
+    0xc3,                                    // 114: ret
+    // __vdso_gettimeofday(struct timeval*, struct timezone*), offset 0x115
+    0x55,                                    // 115: push ebp
+    0x56,                                    // 116: push esi
+    0x57,                                    // 117: push edi
+    0x53,                                    // 118: push ebx
+    0x8b, 0x4c, 0x24, 0x14,                  // 119: mov ecx,[esp+0x14]
+    0x85, 0xc9,                              // 11d: test ecx,ecx
+    0x74, 0x27,                              // 11f: je 148
+    0x83, 0x7c, 0x24, 0x18, 0x00,            // 121: cmp [esp+0x18],0x0
+    0x75, 0x20,                              // 126: jne 148
+    0xbd, 0x18, 0x00, 0x00, 0x00,            // 128: mov ebp,0x18
+    0xe8, 0xce, 0xfe, 0xff, 0xff,            // 12d: call 0
+    0x72, 0x14,                              // 132: jb 148
+    0xb9, 0x40, 0x42, 0x0f, 0x00,            // 134: mov ecx,0xf4240
+    0xf7, 0xf1,                              // 139: div ecx
+    0x8b, 0x4c, 0x24, 0x14,                  // 13b: mov ecx,[esp+0x14]
+    0x89, 0x01,                              // 13f: mov [ecx],eax
+    0x89, 0x51, 0x04,                        // 141: mov [ecx+0x4],edx
+    0x31, 0xc0,                              // 144: xor eax,eax
+    0xeb, 0x0f,                              // 146: jmp 157
+    0xb8, 0x4e, 0x00, 0x00, 0x00,            // 148: mov eax,0x4e, __NR_gettimeofday
+    0x8b, 0x5c, 0x24, 0x14,                  // 14d: mov ebx,[esp+0x14]
+    0x8b, 0x4c, 0x24, 0x18,                  // 151: mov ecx,[esp+0x18]
+    0xcd, 0x80,                              // 155: int 0x80
+    0x5b,                                    // 157: pop ebx
+    0x5f,                                    // 158: pop edi
+    0x5e,                                    // 159: pop esi
+    0x5d,                                    // 15a: pop ebp
+    0xc3,                                    // 15b: ret
+    // __vdso_time(time_t*), offset 0x15c
+    0x55,                                    // 15c: push ebp
+    0x56,                                    // 15d: push esi
+    0x57,                                    // 15e: push edi
+    0x53,                                    // 15f: push ebx
+    0xbd, 0x18, 0x00, 0x00, 0x00,            // 160: mov ebp,0x18
+    0xe8, 0x96, 0xfe, 0xff, 0xff,            // 165: call 0
+    0x72, 0x13,                              // 16a: jb 17f
+    0xb9, 0x40, 0x42, 0x0f, 0x00,            // 16c: mov ecx,0xf4240
+    0xf7, 0xf1,                              // 171: div ecx
+    0x8b, 0x4c, 0x24, 0x14,                  // 173: mov ecx,[esp+0x14]
+    0x85, 0xc9,                              // 177: test ecx,ecx
+    0x74, 0x0f,                              // 179: je 18a
+    0x89, 0x01,                              // 17b: mov [ecx],eax
+    0xeb, 0x0b,                              // 17d: jmp 18a
+    0xb8, 0x0d, 0x00, 0x00, 0x00,            // 17f: mov eax,0xd, __NR_time
+    0x8b, 0x5c, 0x24, 0x14,                  // 184: mov ebx,[esp+0x14]
+    0xcd, 0x80,                              // 188: int 0x80
+    0x5b,                                    // 18a: pop ebx
+    0x5f,                                    // 18b: pop edi
+    0x5e,                                    // 18c: pop esi
+    0x5d,                                    // 18d: pop ebp
+    0xc3,                                    // 18e: ret
+};
+
+#define VDSO_CLOCK_GETTIME 0x3c
+#define VDSO_CLOCK_GETTIME64 0x9b
+#define VDSO_GETTIMEOFDAY 0x115
+#define VDSO_TIME 0x15c
+
+static void put32(std::vector<U8>& data, U32 value) {
+    data.insert(data.end(), (U8*)&value, (U8*)&value+4);
+}
+
+static void putSymbol(std::vector<U8>& data, U32 name, U32 offset) {
+    put32(data, name);
+    put32(data, VDSO_CODE_OFFSET+offset);
+    put32(data, 0);
+    data.push_back(0x12); // STB_GLOBAL, STT_FUNC
+    data.push_back(0);
+    // anything but SHN_UNDEF or SHN_ABS, glibc doesn't look at the sections
+    data.push_back(1);
+    data.push_back(0);
+}
+
+// Just enough of a shared object for glibc's vDSO lookup: one PT_LOAD, a dynamic section and
+// unversioned symbols in a hash table with a single bucket.  Every address is relative to 0, the
+// loader adds where it was mapped.
+static std::vector<U8> buildImage() {
+    std::vector<U8> image;
+    const char strings[] = "\0linux-gate.so.1\0__vdso_clock_gettime\0__vdso_clock_gettime64\0__vdso_gettimeofday\0__vdso_time";
+    const U32 symbolCount = 5; // including the null symbol
+    const U32 dynOffset = sizeof(struct k_Elf32_Ehdr)+2*sizeof(struct k_Elf32_Phdr);
+    const U32 hashOffset = dynOffset+VDSO_DYN_COUNT*8;
+    const U32 symOffset = hashOffset+(2+1+symbolCount)*4;
+    const U32 strOffset = symOffset+symbolCount*VDSO_SYM_SIZE;
+    const U32 imageSize = VDSO_CODE_OFFSET+sizeof(vdsoCode);
+    struct k_Elf32_Ehdr hdr = {};
+    struct k_Elf32_Phdr phdr[2] = {};
+
+    hdr.e_ident[0] = 0x7F;
+    hdr.e_ident[1] = 'E';
+    hdr.e_ident[2] = 'L';
+    hdr.e_ident[3] = 'F';
+    hdr.e_ident[4] = 1; // 32-bit
+    hdr.e_ident[5] = 1; // little endian
+    hdr.e_ident[6] = 1; // EV_CURRENT
+    hdr.e_type = 3; // ET_DYN
+    hdr.e_machine = 3; // EM_386
+    hdr.e_version = 1;
+    hdr.e_phoff = sizeof(struct k_Elf32_Ehdr);
+    hdr.e_ehsize = sizeof(struct k_Elf32_Ehdr);
+    hdr.e_phentsize = sizeof(struct k_Elf32_Phdr);
+    hdr.e_phnum = 2;
+    hdr.e_shentsize = sizeof(struct k_Elf32_Shdr);
+
+    phdr[0].p_type = 1; // PT_LOAD
+    phdr[0].p_filesz = imageSize;
+    phdr[0].p_memsz = imageSize;
+    phdr[0].p_flags = 5; // PF_R | PF_X
+    phdr[0].p_align = K_PAGE_SIZE;
+
+    phdr[1].p_type = 2; // PT_DYNAMIC
+    phdr[1].p_offset = dynOffset;
+    phdr[1].p_vaddr = dynOffset;
+    phdr[1].p_paddr = dynOffset;
+    phdr[1].p_filesz = VDSO_DYN_COUNT*8;
+    phdr[1].p_memsz = VDSO_DYN_COUNT*8;
+    phdr[1].p_flags = 4; // PF_R
+    phdr[1].p_align = 4;
+
+    image.insert(image.end(), (U8*)&hdr, (U8*)&hdr+sizeof(hdr));
+    image.insert(image.end(), (U8*)phdr, (U8*)phdr+sizeof(phdr));
+
+    put32(image, 4); // DT_HASH
+    put32(image, hashOffset);
+    put32(image, 5); // DT_STRTAB
+    put32(image, strOffset);
+    put32(image, 6); // DT_SYMTAB
+    put32(image, symOffset);
+    put32(image, 10); // DT_STRSZ
+    put32(image, sizeof(strings));
+    put32(image, 11); // DT_SYMENT
+    put32(image, VDSO_SYM_SIZE);
+    put32(image, 14); // DT_SONAME
+    put32(image, 1);
+    put32(image, 0); // DT_NULL
+    put32(image, 0);
+
+    // nbucket, nchain, the one bucket then the chain, which just links every symbol
+    put32(image, 1);
+    put32(image, symbolCount);
+    put32(image, 1);
+    for (U32 i = 0; i < symbolCount; i++) {
+        put32(image, (i+1<symbolCount)?i+1:0);
+    }
+    image.insert(image.end(), VDSO_SYM_SIZE, 0);
+    putSymbol(image, 17, VDSO_CLOCK_GETTIME);
+    putSymbol(image, 38, VDSO_CLOCK_GETTIME64);
+    putSymbol(image, 61, VDSO_GETTIMEOFDAY);
+    putSymbol(image, 81, VDSO_TIME);
+    image.insert(image.end(), strings, strings+sizeof(strings));
+    if (image.size()>VDSO_CODE_OFFSET) {
+        kpanic("vDSO headers don't fit before the code");
+    }
+    image.resize(VDSO_CODE_OFFSET);
+    image.insert(image.end(), vdsoCode, vdsoCode+sizeof(vdsoCode));
+    return image;
+}
+
+// sets tsc to what rdtsc returns right now and returns how many microseconds one tick is as a
+// 0.32 fixed point number, or 0 if the rate isn't known yet
+static U32 getTickRate(U64* tsc) {
+    // the translated code runs the host's rdtsc, its rate is measured against the guest's micro
+    // counter once enough time has gone by for that to be accurate
+    static bool started;
+    static U64 startTsc;
+    static U64 startMicro;
+    static U32 rate;
+
+    *tsc = __rdtsc();
+    if (!rate) {
+        U64 micro = KSystem::getMicroCounter();
+        if (!started) {
+            started = true;
+            startTsc = *tsc;
+            startMicro = micro;
+        } else if (micro-startMicro>=100000 && *tsc-startTsc>micro-startMicro) {
+            rate = (U32)(((micro-startMicro) << 32)/(*tsc-startTsc));
+        }
+    }
+    return rate;
+}
+
+static BOXEDWINE_MUTEX vdsoMutex;
+
+void KVdso::update(KThread* thread) {
+    U32 address = thread->process->vdsoAddress;
+
+    if (!address) {
+        return;
+    }
+    U32 data = address-K_PAGE_SIZE;
+    // the guest could have unmapped or protected it
+    if (!thread->memory->isValidWriteAddress(data, VDSO_TIME_PAGE_SIZE)) {
+        return;
+    }
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(vdsoMutex);
+    U64 tsc;
+    U32 rate = getTickRate(&tsc);
+    U64 monotonic = KSystem::getMicroCounter();
+    U64 realtime = KSystem::getSystemTimeAsMicroSeconds();
+    U32 oldRate = readd(data+VDSO_RATE);
+    U64 elapsed = tsc-readq(data+VDSO_TSC);
+
+    if (oldRate && elapsed<=0xFFFFFFFF) {
+        // the guest could have already seen a time past what the host says now, it can't go
+        // backwards so carry on from there and run slower until the host catches up
+        U64 seen = readq(data+VDSO_MONOTONIC)+((elapsed*oldRate) >> 32);
+        if (seen>monotonic) {
+            realtime+=seen-monotonic;
+            monotonic = seen;
+            rate>>=1;
+        }
+    }
+    U32 seq = readd(data+VDSO_SEQ);
+    writed(data+VDSO_SEQ, seq+1);
+    std::atomic_thread_fence(std::memory_order_release);
+    writed(data+VDSO_RATE, rate);
+    writeq(data+VDSO_TSC, tsc);
+    writeq(data+VDSO_MONOTONIC, monotonic);
+    writeq(data+VDSO_REALTIME, realtime);
+    std::atomic_thread_fence(std::memory_order_release);
+    writed(data+VDSO_SEQ, seq+2);
+}
+
+U32 KVdso::map(KThread* thread) {
+    static const std::vector<U8> image = buildImage();
+    KProcess* process = thread->process.get();
+
+    U32 address = process->mmap(0, K_PAGE_SIZE*2, K_PROT_READ | K_PROT_WRITE, K_MAP_PRIVATE | K_MAP_ANONYMOUS, -1, 0);
+    if (address>=(U32)-K_PAGE_SIZE) {
+        process->vdsoAddress = 0;
+        return 0;
+    }
+    address+=K_PAGE_SIZE;
+    memcopyFromNative(address, image.data(), (U32)image.size());
+    process->mprotect(address, K_PAGE_SIZE, K_PROT_READ | K_PROT_EXEC);
+    process->vdsoAddress = address;
+    update(thread);
+    return address;
+}
+
+#else
+
+U32 KVdso::map(KThread* thread) {
+    return 0;
+}
+
+void KVdso::update(KThread* thread) {
+}
+
+#endif
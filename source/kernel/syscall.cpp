@@ -22,6 +22,7 @@
 #include "ksignal.h"
 #include "ksocket.h"
 #include "kepoll.h"
+#include "kvdso.h"
 
 #include <stdarg.h>
 #include <random>
@@ -30,6 +31,9 @@
 #include "../../lib/poco/Foundation/include/Poco/Thread.h"
 #endif
 
+#ifdef BOXEDWINE_CPU_WORKERS
+THREAD_LOCAL
+#endif
 U64 sysCallTime;
 extern struct Block emptyBlock;
 //#undef LOG_SYSCALLS
@@ -219,6 +223,7 @@ static U32 syscall_chdir(CPU* cpu, U32 eipCount) {
 }
 
 static U32 syscall_time(CPU* cpu, U32 eipCount) {
+    KVdso::update(cpu->thread);
     U32 result = (U32)(KSystem::getSystemTimeAsMicroSeconds() / 1000000l);
     if (ARG1)
         writed(ARG1, result);
@@ -750,6 +755,13 @@ static U32 syscall_msync(CPU* cpu, U32 eipCount) {
     return result;
 }
 
+static U32 syscall_readv(CPU* cpu, U32 eipCount) {
+    SYS_LOG1(SYSCALL_READ, cpu, "readv: filds=%d iov=0x%X iovcn=%d", ARG1, ARG2, ARG3);
+    U32 result = cpu->thread->process->readv(ARG1, ARG2, ARG3);
+    SYS_LOG(SYSCALL_READ, cpu, " result=%d(0x%X)\n", result, result);
+    return result;
+}
+
 static U32 syscall_writev(CPU* cpu, U32 eipCount) {
     SYS_LOG1(SYSCALL_WRITE, cpu, "writev: filds=%d iov=0x%X iovcn=%d", ARG1, ARG2, ARG3);    
     U32 result = cpu->thread->process->writev(ARG1, ARG2, ARG3);
@@ -1119,16 +1131,18 @@ static U32 syscall_flistxattr(CPU* cpu, U32 eipCount) {
     return result;
 }
 
-#define FUTEX_WAIT 0
-#define FUTEX_WAKE 1
-#define FUTEX_WAIT_PRIVATE 128
-#define FUTEX_WAKE_PRIVATE 129
+#define FUTEX_PRIVATE_FLAG 128
+#define FUTEX_CLOCK_REALTIME 256
 
 static const char* getFutexOp(U32 op) {
-    if (op==0) return "WAIT";
-    if (op==1) return "WAKE";
-    if (op==128) return "WAIT PRIVATE";
-    if (op==129) return "WAKE PRIVATE";
+    switch (op & ~(FUTEX_PRIVATE_FLAG | FUTEX_CLOCK_REALTIME)) {
+    case 0: return (op & FUTEX_PRIVATE_FLAG)?"WAIT PRIVATE":"WAIT";
+    case 1: return (op & FUTEX_PRIVATE_FLAG)?"WAKE PRIVATE":"WAKE";
+    case 3: return (op & FUTEX_PRIVATE_FLAG)?"REQUEUE PRIVATE":"REQUEUE";
+    case 4: return (op & FUTEX_PRIVATE_FLAG)?"CMP_REQUEUE PRIVATE":"CMP_REQUEUE";
+    case 9: return (op & FUTEX_PRIVATE_FLAG)?"WAIT_BITSET PRIVATE":"WAIT_BITSET";
+    case 10: return (op & FUTEX_PRIVATE_FLAG)?"WAKE_BITSET PRIVATE":"WAKE_BITSET";
+    }
     static std::string tmp;
     tmp = std::to_string(op);
     return tmp.c_str();
@@ -1136,7 +1150,7 @@ static const char* getFutexOp(U32 op) {
 
 static U32 syscall_futex(CPU* cpu, U32 eipCount) {
     SYS_LOG1(SYSCALL_FUTEX, cpu, "futex start: address=%X op=%s value=%d\n", ARG1, getFutexOp(ARG2), ARG3);
-    U32 result = cpu->thread->futex(ARG1, ARG2, ARG3, ARG4);
+    U32 result = cpu->thread->futex(ARG1, ARG2, ARG3, ARG4, ARG5, ARG6);
     SYS_LOG1(SYSCALL_FUTEX, cpu, "futex   end: address=%X op=%s value=%d result=%d(0x%X)\n", ARG1, getFutexOp(ARG2), ARG3, result, result);
     return result;
 }
@@ -1697,7 +1711,7 @@ static const SyscallFunc syscallFunc[] = {
     syscall_newselect,  // 142 __NR_newselect
     syscall_flock,      // 143 __NR_flock
     syscall_msync,      // 144 __NR_msync
-    0,                  // 145
+    syscall_readv,      // 145  __NR_readv
     syscall_writev,     // 146  __NR_writev
     0,                  // 147
     syscall_fdatasync,  // 148 __NR_fdatasync
@@ -1933,6 +1947,7 @@ extern S32 contextTime; // about the # instruction per 10 ms
 #endif
 void ksyscall(CPU* cpu, U32 eipCount) {
     U32 result;
+    BOXEDWINE_KERNEL_CRITICAL_SECTION;
     
     if (cpu->thread->terminating) {
         terminateCurrentThread(cpu->thread); // there is a race condition, just signal it again
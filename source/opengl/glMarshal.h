@@ -11,39 +11,39 @@
 // be used
 
 #ifdef BOXEDWINE_64BIT_MMU
-#define marshald(cpu, address, count) (GLdouble*)getPhysicalAddress(address, 0)
-#define marshalf(cpu, address, count) (GLfloat*)getPhysicalAddress(address, 0)
-#define marshali(cpu, address, count) (GLint*)getPhysicalAddress(address, 0)
-#define marshalc(cpu, address, count) (GLchar*)getPhysicalAddress(address, 0)
-#define marshalac(cpu, address, count) (GLcharARB*)getPhysicalAddress(address, 0)
-#define marshale(cpu, address, count) (GLenum*)getPhysicalAddress(address, 0)
-#define marshal2e(cpu, address, count) (GLenum*)getPhysicalAddress(address, 0)
-#define marshal3e(cpu, address, count) (GLenum*)getPhysicalAddress(address, 0)
-#define marshalui(cpu, address, count) (GLuint*)getPhysicalAddress(address, 0)
-#define marshals(cpu, address, count) (GLshort*)getPhysicalAddress(address, 0)
-#define marshalus(cpu, address, count) (GLushort*)getPhysicalAddress(address, 0)
-#define marshalb(cpu, address, count) (GLbyte*)getPhysicalAddress(address, 0)
-#define marshalub(cpu, address, count) (GLubyte*)getPhysicalAddress(address, 0)
-#define marshalbool(cpu, address, count) (GLboolean*)getPhysicalAddress(address, 0)
-#define marshal2d(cpu, address, count) (GLdouble*)getPhysicalAddress(address, 0)
-#define marshal2f(cpu, address, count) (GLfloat*)getPhysicalAddress(address, 0)
-#define marshal2i(cpu, address, count) (GLint*)getPhysicalAddress(address, 0)
-#define marshal3i(cpu, address, count) (GLint*)getPhysicalAddress(address, 0)
-#define marshal4i(cpu, address, count) (GLint*)getPhysicalAddress(address, 0)
-#define marshal5i(cpu, address, count) (GLint*)getPhysicalAddress(address, 0)
-#define marshal3f(cpu, address, count) (GLfloat*)getPhysicalAddress(address, 0)
-#define marshal3ui(cpu, address, count) (GLuint*)getPhysicalAddress(address, 0)
-#define marshali64(cpu, address, count) (GLint64*)getPhysicalAddress(address, 0)
-#define marshalui64(cpu, address, count) (GLuint64*)getPhysicalAddress(address, 0)
-
-#define marshal2ui(cpu, address, count) (GLuint*)getPhysicalAddress(address, 0)
-#define marshal3ui(cpu, address, count) (GLuint*)getPhysicalAddress(address, 0)
-#define marshal4ui(cpu, address, count) (GLuint*)getPhysicalAddress(address, 0)
-#define marshal2s(cpu, address, count) (GLshort*)getPhysicalAddress(address, 0)
-#define marshal2us(cpu, address, count) (GLushort*)getPhysicalAddress(address, 0)
-#define marshal2b(cpu, address, count) (GLbyte*)getPhysicalAddress(address, 0)
-#define marshal2ub(cpu, address, count) (GLubyte*)getPhysicalAddress(address, 0)
-#define marshal2bool(cpu, address, count) (GLboolean*)getPhysicalAddress(address, 0)
+#define marshald(cpu, address, count) (GLdouble*)GL_POINTER(address)
+#define marshalf(cpu, address, count) (GLfloat*)GL_POINTER(address)
+#define marshali(cpu, address, count) (GLint*)GL_POINTER(address)
+#define marshalc(cpu, address, count) (GLchar*)GL_POINTER(address)
+#define marshalac(cpu, address, count) (GLcharARB*)GL_POINTER(address)
+#define marshale(cpu, address, count) (GLenum*)GL_POINTER(address)
+#define marshal2e(cpu, address, count) (GLenum*)GL_POINTER(address)
+#define marshal3e(cpu, address, count) (GLenum*)GL_POINTER(address)
+#define marshalui(cpu, address, count) (GLuint*)GL_POINTER(address)
+#define marshals(cpu, address, count) (GLshort*)GL_POINTER(address)
+#define marshalus(cpu, address, count) (GLushort*)GL_POINTER(address)
+#define marshalb(cpu, address, count) (GLbyte*)GL_POINTER(address)
+#define marshalub(cpu, address, count) (GLubyte*)GL_POINTER(address)
+#define marshalbool(cpu, address, count) (GLboolean*)GL_POINTER(address)
+#define marshal2d(cpu, address, count) (GLdouble*)GL_POINTER(address)
+#define marshal2f(cpu, address, count) (GLfloat*)GL_POINTER(address)
+#define marshal2i(cpu, address, count) (GLint*)GL_POINTER(address)
+#define marshal3i(cpu, address, count) (GLint*)GL_POINTER(address)
+#define marshal4i(cpu, address, count) (GLint*)GL_POINTER(address)
+#define marshal5i(cpu, address, count) (GLint*)GL_POINTER(address)
+#define marshal3f(cpu, address, count) (GLfloat*)GL_POINTER(address)
+#define marshal3ui(cpu, address, count) (GLuint*)GL_POINTER(address)
+#define marshali64(cpu, address, count) (GLint64*)GL_POINTER(address)
+#define marshalui64(cpu, address, count) (GLuint64*)GL_POINTER(address)
+
+#define marshal2ui(cpu, address, count) (GLuint*)GL_POINTER(address)
+#define marshal3ui(cpu, address, count) (GLuint*)GL_POINTER(address)
+#define marshal4ui(cpu, address, count) (GLuint*)GL_POINTER(address)
+#define marshal2s(cpu, address, count) (GLshort*)GL_POINTER(address)
+#define marshal2us(cpu, address, count) (GLushort*)GL_POINTER(address)
+#define marshal2b(cpu, address, count) (GLbyte*)GL_POINTER(address)
+#define marshal2ub(cpu, address, count) (GLubyte*)GL_POINTER(address)
+#define marshal2bool(cpu, address, count) (GLboolean*)GL_POINTER(address)
 #define marshalBackd(cpu, address, buffer, count) {}
 #define marshalBackc(cpu, address, buffer, count) {}
 #define marshalBackac(cpu, address, buffer, count) {}
@@ -74,6 +74,8 @@ GLvoid* marshalPixels(CPU* cpu, U32 is3d, GLsizei width, GLsizei height, GLsizei
 #define marshalPixel(cpu, format, type, pixel) (GLvoid*)getPhysicalAddress(pixel, 0)
 
 #define updateVertexPointers(cpu, count)
+#define updateVertexPointersForRange(cpu, first, count)
+#define updateVertexPointersForElements(cpu, count, type, indices)
 #define marshalVetextPointer(cpu, size, type, stride, ptr) marshalp_and_check_array_buffer(cpu, 0, ptr, 0)
 #define marshalNormalPointer(cpu, type, stride, ptr) marshalp_and_check_array_buffer(cpu, 0, ptr, 0)
 #define marshalColorPointer(cpu, size, type, stride, ptr) marshalp_and_check_array_buffer(cpu, 0, ptr, 0)
@@ -187,6 +189,9 @@ GLvoid* marshalPixels(CPU* cpu, U32 is3d, GLsizei width, GLsizei height, GLsizei
 void marshalBackPixels(CPU* cpu, U32 is3d, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, U32 address, GLvoid* pixels);
 
 void updateVertexPointers(CPU* cpu, U32 count);
+// uses the elements a draw references to stream the client arrays into a buffer object when the driver can map one persistently
+void updateVertexPointersForRange(CPU* cpu, U32 first, U32 count);
+void updateVertexPointersForElements(CPU* cpu, U32 count, GLenum type, const GLvoid* indices);
 GLvoid* marshalVetextPointer(CPU* cpu, GLint size, GLenum type, GLsizei stride, U32 ptr);
 GLvoid* marshalNormalPointer(CPU* cpu, GLenum type, GLsizei stride, U32 ptr);
 GLvoid* marshalColorPointer(CPU* cpu, GLint size, GLenum type, GLsizei stride, U32 ptr);
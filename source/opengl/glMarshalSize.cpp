@@ -575,6 +575,9 @@ int getSize(GLenum pname) {
    }
 }
 
+#endif
+
+// also used by the render thread to copy the params of queued calls
 int glcommon_glLightv_size(GLenum e)
 {
     switch (e) {
@@ -628,6 +631,7 @@ int glcommon_glMaterialv_size(GLenum e)
     }
 }
 
+#ifndef BOXEDWINE_64BIT_MMU
 // from mesa
 GLint components_in_format(GLenum format )
 {
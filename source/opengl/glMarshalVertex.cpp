@@ -120,6 +120,287 @@ void updateVertexPointers(CPU* cpu, U32 count) {
     }
 }
 
+#ifndef DISABLE_GL_EXTENSIONS
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+// Instead of copying the client arrays into marshal buffers that the driver then copies again, a
+// draw can copy the elements it uses straight into a persistently mapped buffer.  Each context has
+// one, it is used as a ring of segments.  When the ring moves on to the next segment, the one it
+// leaves gets a fence and it isn't written again until the draws that read it are done.
+#define GL_VERTEX_STREAM_SEGMENTS 4
+#define GL_VERTEX_STREAM_SEGMENT_SIZE (2*1024*1024)
+#define GL_VERTEX_STREAM_ALIGN 16
+
+class GlVertexStream {
+public:
+    GlVertexStream() : initialized(false), buffer(0), mapped(NULL), segment(0), pos(0) {
+        memset(fences, 0, sizeof(fences));
+    }
+    bool initialized;
+    GLuint buffer;
+    U8* mapped; // NULL if the driver can't map a buffer persistently
+    GLsync fences[GL_VERTEX_STREAM_SEGMENTS];
+    U32 segment;
+    U32 pos; // first free byte in the buffer
+};
+
+class GlStreamedArray {
+public:
+    GLenum array;
+    OpenGLVetexPointer* p;
+    U32 skip; // bytes before the first element the draw uses
+    U32 len;
+    U32 offset; // passed to the pointer call, so the first element the draw uses is at offset+skip
+};
+
+static BOXEDWINE_MUTEX vertexStreamMutex;
+static std::unordered_map<void*, GlVertexStream*> vertexStreams;
+
+static GlVertexStream* getVertexStream(CPU* cpu) {
+    void* context = cpu->thread->currentContext;
+    GlVertexStream* stream;
+
+    if (!context) {
+        return NULL;
+    }
+    {
+        BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(vertexStreamMutex);
+        stream = vertexStreams[context];
+        if (!stream) {
+            stream = new GlVertexStream();
+            vertexStreams[context] = stream;
+        }
+    }
+    if (!stream->initialized) {
+        stream->initialized = true;
+        if (ext_glBufferStorage && ext_glMapBufferRange && ext_glFenceSync && ext_glClientWaitSync && ext_glDeleteSync && ext_glGenBuffers && ext_glBindBuffer) {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+            ext_glGenBuffers(1, &stream->buffer);
+            ext_glBindBuffer(GL_ARRAY_BUFFER, stream->buffer);
+            ext_glBufferStorage(GL_ARRAY_BUFFER, GL_VERTEX_STREAM_SEGMENTS*GL_VERTEX_STREAM_SEGMENT_SIZE, NULL, flags);
+            stream->mapped = (U8*)ext_glMapBufferRange(GL_ARRAY_BUFFER, 0, GL_VERTEX_STREAM_SEGMENTS*GL_VERTEX_STREAM_SEGMENT_SIZE, flags);
+            ext_glBindBuffer(GL_ARRAY_BUFFER, 0);
+            if (!stream->mapped) {
+                klog("OpenGL: could not map a buffer for client vertex arrays, they will be copied each draw");
+            }
+        }
+    }
+    return stream;
+}
+
+bool hasVertexStream(void* context) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(vertexStreamMutex);
+    return vertexStreams.find(context)!=vertexStreams.end();
+}
+
+// context has to be current, the buffer might be shared with other contexts so it is deleted before the context is
+void vertexStreamContextDeleted(void* context) {
+    GlVertexStream* stream;
+    {
+        BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(vertexStreamMutex);
+        auto it = vertexStreams.find(context);
+        if (it==vertexStreams.end()) {
+            return;
+        }
+        stream = it->second;
+        vertexStreams.erase(it);
+    }
+    for (U32 i=0;i<GL_VERTEX_STREAM_SEGMENTS;i++) {
+        if (stream->fences[i]) {
+            ext_glDeleteSync(stream->fences[i]);
+        }
+    }
+    if (stream->buffer && ext_glDeleteBuffers) {
+        // deleting the buffer also unmaps it
+        ext_glDeleteBuffers(1, &stream->buffer);
+    }
+    delete stream;
+}
+
+static bool addStreamedArray(GlStreamedArray* arrays, U32& arrayCount, GLenum array, OpenGLVetexPointer* p, U32 components, U32 first, U32 count) {
+    if (!p->refreshEachCall || !p->ptr || !GL_FUNC(glIsEnabled)(array)) {
+        return true;
+    }
+    U32 elementSize = components*getDataSize(p->type);
+    U32 stride = (p->stride?p->stride:elementSize);
+    U64 skip = (U64)first*stride;
+    U64 len = (U64)(count-1)*stride+elementSize;
+
+    if (!elementSize || skip+len>GL_VERTEX_STREAM_SEGMENTS*GL_VERTEX_STREAM_SEGMENT_SIZE) {
+        return false;
+    }
+    GlStreamedArray& a = arrays[arrayCount++];
+    a.array = array;
+    a.p = p;
+    a.skip = (U32)skip;
+    a.len = (U32)len;
+    return true;
+}
+
+// lays out the arrays from pos without going past end, a pointer offset can't be negative so each array starts at least skip bytes into the buffer
+static bool placeStreamedArrays(GlStreamedArray* arrays, U32 arrayCount, U32& pos, U32 end) {
+    U32 next = pos;
+
+    for (U32 i=0;i<arrayCount;i++) {
+        GlStreamedArray& a = arrays[i];
+        U32 offset = (next>a.skip?next-a.skip:0);
+
+        offset = (offset+GL_VERTEX_STREAM_ALIGN-1) & ~(GL_VERTEX_STREAM_ALIGN-1);
+        if ((U64)offset+a.skip+a.len>end) {
+            return false;
+        }
+        a.offset = offset;
+        next = offset+a.skip+a.len;
+    }
+    pos = next;
+    return true;
+}
+
+static bool allocStreamedArrays(GlVertexStream* stream, GlStreamedArray* arrays, U32 arrayCount) {
+    U32 pos = stream->pos;
+
+    if (placeStreamedArrays(arrays, arrayCount, pos, (stream->segment+1)*GL_VERTEX_STREAM_SEGMENT_SIZE)) {
+        stream->pos = pos;
+        return true;
+    }
+    U32 next = (stream->segment+1) % GL_VERTEX_STREAM_SEGMENTS;
+    pos = next*GL_VERTEX_STREAM_SEGMENT_SIZE;
+    if (!placeStreamedArrays(arrays, arrayCount, pos, pos+GL_VERTEX_STREAM_SEGMENT_SIZE)) {
+        return false;
+    }
+    stream->fences[stream->segment] = ext_glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    if (stream->fences[next]) {
+        GLenum result;
+        do {
+            result = ext_glClientWaitSync(stream->fences[next], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        } while (result==GL_TIMEOUT_EXPIRED);
+        ext_glDeleteSync(stream->fences[next]);
+        stream->fences[next] = NULL;
+    }
+    stream->segment = next;
+    stream->pos = pos;
+    return true;
+}
+
+static void setStreamedPointer(const GlStreamedArray& a) {
+    OpenGLVetexPointer* p = a.p;
+    GLvoid* offset = (GLvoid*)(uintptr_t)a.offset;
+
+    switch (a.array) {
+    case GL_VERTEX_ARRAY: GL_FUNC(glVertexPointer)(p->size, p->type, p->stride, offset); break;
+    case GL_NORMAL_ARRAY: GL_FUNC(glNormalPointer)(p->type, p->stride, offset); break;
+    case GL_COLOR_ARRAY: GL_FUNC(glColorPointer)(p->size, p->type, p->stride, offset); break;
+    case GL_INDEX_ARRAY: GL_FUNC(glIndexPointer)(p->type, p->stride, offset); break;
+    case GL_TEXTURE_COORD_ARRAY: GL_FUNC(glTexCoordPointer)(p->size, p->type, p->stride, offset); break;
+    case GL_EDGE_FLAG_ARRAY: GL_FUNC(glEdgeFlagPointer)(p->stride, offset); break;
+    case GL_FOG_COORD_ARRAY: ext_glFogCoordPointer(p->type, p->stride, offset); break;
+    case GL_SECONDARY_COLOR_ARRAY: ext_glSecondaryColorPointer(p->size, p->type, p->stride, offset); break;
+    }
+}
+
+// Copies elements [first, first+count) of each enabled client array into the stream and points the
+// arrays at the copy.  Returns false if the draw needs updateVertexPointers instead.
+static bool streamVertexPointers(CPU* cpu, U32 first, U32 count) {
+    KThread* thread = cpu->thread;
+    GlStreamedArray arrays[8];
+    U32 arrayCount = 0;
+    bool ok = true;
+
+    // these aren't streamed, if they need to be refreshed then so does everything else
+    if (!count || thread->glFogPointerEXT.refreshEachCall || thread->glSecondaryColorPointerEXT.refreshEachCall || thread->glEdgeFlagPointerEXT.refreshEachCall) {
+        return false;
+    }
+    // checked first since creating the stream changes the GL_ARRAY_BUFFER binding
+    if (ARRAY_BUFFER()) {
+        return false;
+    }
+    GlVertexStream* stream = getVertexStream(cpu);
+    if (!stream || !stream->mapped) {
+        return false;
+    }
+    ok &= addStreamedArray(arrays, arrayCount, GL_VERTEX_ARRAY, &thread->glVertextPointer, thread->glVertextPointer.size, first, count);
+    ok &= addStreamedArray(arrays, arrayCount, GL_NORMAL_ARRAY, &thread->glNormalPointer, 3, first, count);
+    ok &= addStreamedArray(arrays, arrayCount, GL_COLOR_ARRAY, &thread->glColorPointer, (thread->glColorPointer.size==GL_BGRA?4:thread->glColorPointer.size), first, count);
+    ok &= addStreamedArray(arrays, arrayCount, GL_INDEX_ARRAY, &thread->glIndexPointer, 1, first, count);
+    ok &= addStreamedArray(arrays, arrayCount, GL_TEXTURE_COORD_ARRAY, &thread->glTexCoordPointer, thread->glTexCoordPointer.size, first, count);
+    ok &= addStreamedArray(arrays, arrayCount, GL_EDGE_FLAG_ARRAY, &thread->glEdgeFlagPointer, 1, first, count);
+    if (ext_glFogCoordPointer) {
+        ok &= addStreamedArray(arrays, arrayCount, GL_FOG_COORD_ARRAY, &thread->glFogPointer, 1, first, count);
+    }
+    if (ext_glSecondaryColorPointer) {
+        ok &= addStreamedArray(arrays, arrayCount, GL_SECONDARY_COLOR_ARRAY, &thread->glSecondaryColorPointer, (thread->glSecondaryColorPointer.size==GL_BGRA?4:thread->glSecondaryColorPointer.size), first, count);
+    }
+    if (!ok || !arrayCount || !allocStreamedArrays(stream, arrays, arrayCount)) {
+        return false;
+    }
+    ext_glBindBuffer(GL_ARRAY_BUFFER, stream->buffer);
+    for (U32 i=0;i<arrayCount;i++) {
+        const GlStreamedArray& a = arrays[i];
+        memcopyToNative(a.p->ptr+a.skip, stream->mapped+a.offset+a.skip, a.len);
+        setStreamedPointer(a);
+    }
+    ext_glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return true;
+}
+#else
+bool hasVertexStream(void* context) {
+    return false;
+}
+
+void vertexStreamContextDeleted(void* context) {
+}
+#endif
+
+void updateVertexPointersForRange(CPU* cpu, U32 first, U32 count) {
+#ifndef DISABLE_GL_EXTENSIONS
+    if (streamVertexPointers(cpu, first, count)) {
+        return;
+    }
+#endif
+    updateVertexPointers(cpu, count);
+}
+
+template <typename T>
+static void getIndexRange(const T* indices, U32 count, U32& min, U32& max) {
+    min = indices[0];
+    max = indices[0];
+    for (U32 i=1;i<count;i++) {
+        U32 index = indices[i];
+        if (index<min) {
+            min = index;
+        } else if (index>max) {
+            max = index;
+        }
+    }
+}
+
+void updateVertexPointersForElements(CPU* cpu, U32 count, GLenum type, const GLvoid* indices) {
+#ifndef DISABLE_GL_EXTENSIONS
+    if (count && indices) {
+        U32 min = 0;
+        U32 max = 0;
+        bool known = true;
+
+        switch (type) {
+        case GL_UNSIGNED_BYTE: getIndexRange((const GLubyte*)indices, count, min, max); break;
+        case GL_UNSIGNED_SHORT: getIndexRange((const GLushort*)indices, count, min, max); break;
+        case GL_UNSIGNED_INT: getIndexRange((const GLuint*)indices, count, min, max); break;
+        default: known = false; break;
+        }
+        if (known && streamVertexPointers(cpu, min, max-min+1)) {
+            return;
+        }
+    }
+#endif
+    updateVertexPointers(cpu, count);
+}
+
 GLvoid* marshalVetextPointer(CPU* cpu, GLint size, GLenum type, GLsizei stride, U32 ptr) {
     if (ARRAY_BUFFER()) {        
         cpu->thread->glVertextPointer.refreshEachCall = 0;
@@ -45,9 +45,15 @@ float fARG(CPU* cpu, U32 arg) {
     return i.f;
 }
 
-double dARG(CPU* cpu, int address) {
+double dARG(CPU* cpu, U32 index) {
     struct long2Double i;
-    i.l = readq(address);
+#ifdef BOXEDWINE_GL_THREAD
+    if (glReplayCall) {
+        i.l = glReplayCall->doubles[index];
+        return i.d;
+    }
+#endif
+    i.l = readq(GL_ARG(index));
     return i.d;
 }
 
@@ -425,6 +431,25 @@ void glcommon_glInterleavedArrays(CPU* cpu) {
 #endif    
 }
 
+// GLAPI void APIENTRY glDrawElements( GLenum mode, GLsizei count, GLenum type, const GLvoid *indices ) {
+void glcommon_glDrawElements(CPU* cpu) {
+    GLenum mode = ARG1;
+    GLsizei count = ARG2;
+    GLenum type = ARG3;
+    const GLvoid* indices;
+
+    if (ELEMENT_ARRAY_BUFFER()) {
+        indices = (const GLvoid*)pARG4;
+        updateVertexPointers(cpu, count);
+    } else {
+        // the indices say which part of the client arrays the draw needs
+        indices = marshalType(cpu, type, count, ARG4);
+        updateVertexPointersForElements(cpu, count, type, indices);
+    }
+    GL_FUNC(glDrawElements)(mode, count, type, indices);
+    GL_LOG("glDrawElements GLenum mode=%d, GLsizei count=%d, GLenum type=%d, const GLvoid *indices=%.08x", ARG1, ARG2, ARG3, ARG4);
+}
+
 // GLAPI void APIENTRY glReadPixels( GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, GLvoid *pixels ) {
 void glcommon_glReadPixels(CPU* cpu) {
     GLvoid* pixels;
@@ -499,6 +524,12 @@ void gl_init(const std::string& allowExtensions) {
 #ifdef BOXEDWINE_ES
     esgl_init();
 #endif        
+
+#ifdef BOXEDWINE_GL_THREAD
+    if (GlCommandQueue::isEnabled()) {
+        GlCommandQueue::init();
+    }
+#endif
 }
 
 #else
@@ -515,6 +546,12 @@ void callOpenGL(CPU* cpu, U32 index) {
     KNativeWindow::getNativeWindow()->preOpenGLCall(index);
     if (index < int99CallbackSize && int99Callback[index]) {
         lastGlCallTime = KSystem::getMilliesSinceStart();
+#ifdef BOXEDWINE_GL_THREAD
+        if (GlCommandQueue::isEnabled() && cpu->thread->currentContext) {
+            GlCommandQueue::call(cpu, index);
+            return;
+        }
+#endif
         int99Callback[index](cpu);
     } else 
 #endif
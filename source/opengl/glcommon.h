@@ -47,70 +47,81 @@ struct long2Double {
     };
 };
 
+#include "sdl/glCommandQueue.h"
+
+#ifdef BOXEDWINE_GL_THREAD
+// when the render thread replays a queued call the arguments come from the copy that was queued
+#define GL_ARG(n) (glReplayCall?glReplayCall->args[n]:cpu->peek32(n))
+#define GL_POINTER(address) (glReplayCall?glReplayCall->getPointer(address):getPhysicalAddress(address, 0))
+#else
+#define GL_ARG(n) cpu->peek32(n)
+#define GL_POINTER(address) getPhysicalAddress(address, 0)
+#endif
+
 // index 0 is the gl call number
-#define ARG1 cpu->peek32(1)
-#define ARG2 cpu->peek32(2)
-#define ARG3 cpu->peek32(3)
-#define ARG4 cpu->peek32(4)
-#define ARG5 cpu->peek32(5)
-#define ARG6 cpu->peek32(6)
-#define ARG7 cpu->peek32(7)
-#define ARG8 cpu->peek32(8)
-#define ARG9 cpu->peek32(9)
-#define ARG10 cpu->peek32(10)
-#define ARG11 cpu->peek32(11)
-#define ARG12 cpu->peek32(12)
-#define ARG13 cpu->peek32(13)
-#define ARG14 cpu->peek32(14)
-#define ARG15 cpu->peek32(15)
-
-#define pARG1 ((uintptr_t)cpu->peek32(1))
-#define pARG2 ((uintptr_t)cpu->peek32(2))
-#define pARG3 ((uintptr_t)cpu->peek32(3))
-#define pARG4 ((uintptr_t)cpu->peek32(4))
-#define pARG5 ((uintptr_t)cpu->peek32(5))
-#define pARG6 ((uintptr_t)cpu->peek32(6))
-#define pARG7 ((uintptr_t)cpu->peek32(7))
-#define pARG8 ((uintptr_t)cpu->peek32(8))
-#define pARG9 ((uintptr_t)cpu->peek32(9))
-#define pARG10 ((uintptr_t)cpu->peek32(10))
-#define pARG11 ((uintptr_t)cpu->peek32(11))
-#define pARG12 ((uintptr_t)cpu->peek32(12))
-#define pARG13 ((uintptr_t)cpu->peek32(13))
-#define pARG14 ((uintptr_t)cpu->peek32(14))
-#define pARG15 ((uintptr_t)cpu->peek32(15))
-
-#define bARG1 (cpu->peek32(1) & 0xFF)
-#define bARG2 (cpu->peek32(2) & 0xFF)
-#define bARG3 (cpu->peek32(3) & 0xFF)
-#define bARG4 (cpu->peek32(4) & 0xFF)
-#define bARG5 (cpu->peek32(5) & 0xFF)
-#define bARG6 (cpu->peek32(6) & 0xFF)
-#define bARG7 (cpu->peek32(7) & 0xFF)
-#define bARG8 (cpu->peek32(8) & 0xFF)
-#define bARG9 (cpu->peek32(9) & 0xFF)
-#define bARG10 (cpu->peek32(10) & 0xFF)
-#define bARG11 (cpu->peek32(11) & 0xFF)
-#define bARG12 (cpu->peek32(12) & 0xFF)
-#define bARG13 (cpu->peek32(13) & 0xFF)
-#define bARG14 (cpu->peek32(14) & 0xFF)
-#define bARG15 (cpu->peek32(15) & 0xFF)
-
-#define sARG1 (cpu->peek32(1) & 0xFFFF)
-#define sARG2 (cpu->peek32(2) & 0xFFFF)
-#define sARG3 (cpu->peek32(3) & 0xFFFF)
-#define sARG4 (cpu->peek32(4) & 0xFFFF)
-#define sARG5 (cpu->peek32(5) & 0xFFFF)
-#define sARG6 (cpu->peek32(6) & 0xFFFF)
-#define sARG7 (cpu->peek32(7) & 0xFFFF)
-#define sARG8 (cpu->peek32(8) & 0xFFFF)
-#define sARG9 (cpu->peek32(9) & 0xFFFF)
-#define sARG10 (cpu->peek32(10) & 0xFFFF)
-#define sARG11 (cpu->peek32(11) & 0xFFFF)
-#define sARG12 (cpu->peek32(12) & 0xFFFF)
-#define sARG13 (cpu->peek32(13) & 0xFFFF)
-#define sARG14 (cpu->peek32(14) & 0xFFFF)
-#define sARG15 (cpu->peek32(15) & 0xFFFF)
+#define ARG1 GL_ARG(1)
+#define ARG2 GL_ARG(2)
+#define ARG3 GL_ARG(3)
+#define ARG4 GL_ARG(4)
+#define ARG5 GL_ARG(5)
+#define ARG6 GL_ARG(6)
+#define ARG7 GL_ARG(7)
+#define ARG8 GL_ARG(8)
+#define ARG9 GL_ARG(9)
+#define ARG10 GL_ARG(10)
+#define ARG11 GL_ARG(11)
+#define ARG12 GL_ARG(12)
+#define ARG13 GL_ARG(13)
+#define ARG14 GL_ARG(14)
+#define ARG15 GL_ARG(15)
+
+#define pARG1 ((uintptr_t)GL_ARG(1))
+#define pARG2 ((uintptr_t)GL_ARG(2))
+#define pARG3 ((uintptr_t)GL_ARG(3))
+#define pARG4 ((uintptr_t)GL_ARG(4))
+#define pARG5 ((uintptr_t)GL_ARG(5))
+#define pARG6 ((uintptr_t)GL_ARG(6))
+#define pARG7 ((uintptr_t)GL_ARG(7))
+#define pARG8 ((uintptr_t)GL_ARG(8))
+#define pARG9 ((uintptr_t)GL_ARG(9))
+#define pARG10 ((uintptr_t)GL_ARG(10))
+#define pARG11 ((uintptr_t)GL_ARG(11))
+#define pARG12 ((uintptr_t)GL_ARG(12))
+#define pARG13 ((uintptr_t)GL_ARG(13))
+#define pARG14 ((uintptr_t)GL_ARG(14))
+#define pARG15 ((uintptr_t)GL_ARG(15))
+
+#define bARG1 (GL_ARG(1) & 0xFF)
+#define bARG2 (GL_ARG(2) & 0xFF)
+#define bARG3 (GL_ARG(3) & 0xFF)
+#define bARG4 (GL_ARG(4) & 0xFF)
+#define bARG5 (GL_ARG(5) & 0xFF)
+#define bARG6 (GL_ARG(6) & 0xFF)
+#define bARG7 (GL_ARG(7) & 0xFF)
+#define bARG8 (GL_ARG(8) & 0xFF)
+#define bARG9 (GL_ARG(9) & 0xFF)
+#define bARG10 (GL_ARG(10) & 0xFF)
+#define bARG11 (GL_ARG(11) & 0xFF)
+#define bARG12 (GL_ARG(12) & 0xFF)
+#define bARG13 (GL_ARG(13) & 0xFF)
+#define bARG14 (GL_ARG(14) & 0xFF)
+#define bARG15 (GL_ARG(15) & 0xFF)
+
+#define sARG1 (GL_ARG(1) & 0xFFFF)
+#define sARG2 (GL_ARG(2) & 0xFFFF)
+#define sARG3 (GL_ARG(3) & 0xFFFF)
+#define sARG4 (GL_ARG(4) & 0xFFFF)
+#define sARG5 (GL_ARG(5) & 0xFFFF)
+#define sARG6 (GL_ARG(6) & 0xFFFF)
+#define sARG7 (GL_ARG(7) & 0xFFFF)
+#define sARG8 (GL_ARG(8) & 0xFFFF)
+#define sARG9 (GL_ARG(9) & 0xFFFF)
+#define sARG10 (GL_ARG(10) & 0xFFFF)
+#define sARG11 (GL_ARG(11) & 0xFFFF)
+#define sARG12 (GL_ARG(12) & 0xFFFF)
+#define sARG13 (GL_ARG(13) & 0xFFFF)
+#define sARG14 (GL_ARG(14) & 0xFFFF)
+#define sARG15 (GL_ARG(15) & 0xFFFF)
 
 #define hARG1 ARG1
 #define hARG2 ARG2
@@ -155,20 +166,20 @@ struct long2Double {
 #define fARG14 fARG(cpu, ARG14)
 #define fARG15 fARG(cpu, ARG15)
 
-#define dARG1 dARG(cpu, ARG1)
-#define dARG2 dARG(cpu, ARG2)
-#define dARG3 dARG(cpu, ARG3)
-#define dARG4 dARG(cpu, ARG4)
-#define dARG5 dARG(cpu, ARG5)
-#define dARG6 dARG(cpu, ARG6)
-#define dARG7 dARG(cpu, ARG7)
-#define dARG8 dARG(cpu, ARG8)
-#define dARG9 dARG(cpu, ARG9)
-#define dARG10 dARG(cpu, ARG10)
-#define dARG11 dARG(cpu, ARG11)
+#define dARG1 dARG(cpu, 1)
+#define dARG2 dARG(cpu, 2)
+#define dARG3 dARG(cpu, 3)
+#define dARG4 dARG(cpu, 4)
+#define dARG5 dARG(cpu, 5)
+#define dARG6 dARG(cpu, 6)
+#define dARG7 dARG(cpu, 7)
+#define dARG8 dARG(cpu, 8)
+#define dARG9 dARG(cpu, 9)
+#define dARG10 dARG(cpu, 10)
+#define dARG11 dARG(cpu, 11)
 
 float fARG(CPU* cpu, U32 arg);
-double dARG(CPU* cpu, int address);
+double dARG(CPU* cpu, U32 index);
 
 #define GL_FUNCTION(func, RET, PARAMS, ARGS, PRE, POST, LOG)
 #define GL_FUNCTION_CUSTOM(func, RET, PARAMS)
@@ -0,0 +1,719 @@
+/*
+ *  Copyright (C) 2016  The BoxedWine Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+#include "boxedwine.h"
+
+#if defined(BOXEDWINE_OPENGL_SDL) && defined(BOXEDWINE_MULTI_THREADED) && defined(BOXEDWINE_64BIT_MMU)
+#include GLH
+#include <SDL.h>
+#include "../glcommon.h"
+#include "../glMarshal.h"
+#include "knativethread.h"
+
+#include <string_view>
+
+// ops in the ring buffer that are not an index into int99Callback
+#define GL_QUEUE_SYNC 0xFFFFFFFF // followed by a GlSync*
+#define GL_QUEUE_SWAP 0xFFFFFFFE
+
+#define GL_QUEUE_BUFFER_SIZE (1024*1024)
+// op, args, doubles, pointer lengths and pointer data
+#define GL_QUEUE_MAX_COMMAND (4+15*4+15*8+GL_REPLAY_MAX_POINTERS*4+GL_REPLAY_MAX_POINTER_DATA)
+
+typedef int (*GlSizeFunction)(GLenum e);
+
+class GlQueuedPointer {
+public:
+    U32 slot = 0;
+    U32 elementSize = 0;
+    U32 count = 0; // used if countFunction is NULL
+    GlSizeFunction countFunction = NULL;
+    U32 countSlot = 0;
+};
+
+// what has to be copied from the emulated thread to queue a call
+class GlQueuedCall {
+public:
+    U32 index = 0;
+    Int99Callback callback = NULL; // glcommon's version of the call, only that one knows about GlReplayCall
+    bool queued = false;
+    U32 argCount = 0;
+    U32 doubleMask = 0; // bit n is set if dARGn is used
+    U32 pointerCount = 0;
+    GlQueuedPointer pointers[GL_REPLAY_MAX_POINTERS] = {};
+};
+
+// something an emulated thread waits for the render thread to run
+class GlSync {
+public:
+    GlSync(const std::function<void()>& f, void* window, void* context) : f(f), window(window), context(context), done(false) {}
+
+    std::function<void()> f;
+    void* window;
+    void* context;
+    bool done; // protected by doneCond
+};
+
+static constexpr struct {
+    const char* name;
+    GlSizeFunction pfn;
+} glSizeFunctions[] = {
+    {"glcommon_glLightv_size", glcommon_glLightv_size},
+    {"glcommon_glLightModelv_size", glcommon_glLightModelv_size},
+    {"glcommon_glMaterialv_size", glcommon_glMaterialv_size},
+};
+#define GL_SIZE_FUNCTION_MAX 4 // the most any of the glSizeFunctions return
+
+THREAD_LOCAL GlReplayCall* glReplayCall;
+
+static GlQueuedCall queuedCalls[GL_FUNC_COUNT];
+static KNativeThread* renderThread; // protected by queuesMutex
+static bool renderThreadRunning; // protected by queuesMutex
+static THREAD_LOCAL bool onRenderThread;
+static void* renderContext; // only used by the render thread
+
+static BOXEDWINE_MUTEX queuesMutex;
+static std::vector<GlCommandQueue*> queues; // only the render thread adds and removes queues
+static std::unordered_map<void*, GlCommandQueue*> queueByContext;
+static std::vector<GlSync*> pendingSyncs; // runOnRenderThread, these aren't ordered with any one context
+static std::atomic<U32> queuesGeneration;
+
+static THREAD_LOCAL void* cachedContext;
+static THREAD_LOCAL GlCommandQueue* cachedQueue;
+static THREAD_LOCAL U32 cachedGeneration;
+
+static BOXEDWINE_CONDITION renderCond("GlRenderThread");
+static std::atomic<bool> renderThreadSleeping;
+static BOXEDWINE_CONDITION doneCond("GlCommandQueue");
+
+U8* GlReplayCall::getPointer(U32 address) {
+    for (U32 i=0;i<this->pointerCount;i++) {
+        if (this->pointerAddress[i]==address) {
+            return this->pointerData[i];
+        }
+    }
+    kpanic("GlReplayCall::getPointer %x was not copied when the call was queued", address);
+    return NULL;
+}
+
+static constexpr std::string_view trim(std::string_view s) {
+    size_t start = s.find_first_not_of(' ');
+    if (start==std::string_view::npos) {
+        return std::string_view();
+    }
+    return s.substr(start, s.find_last_not_of(' ')-start+1);
+}
+
+// "(a, b(c, d))" -> "a", "b(c, d)", fails if there are more than maxResults
+static constexpr bool splitArgs(std::string_view args, std::string_view* results, U32 maxResults, U32& count) {
+    if (args.length()<2 || args[0]!='(' || args[args.length()-1]!=')') {
+        return false;
+    }
+    size_t start = 1;
+    int depth = 0;
+
+    count = 0;
+    for (size_t i=1;i<args.length()-1;i++) {
+        char c = args[i];
+        if (c=='(') {
+            depth++;
+        } else if (c==')') {
+            depth--;
+        } else if (c==',' && depth==0) {
+            if (count==maxResults) {
+                return false;
+            }
+            results[count++] = trim(args.substr(start, i-start));
+            start = i+1;
+        }
+    }
+    std::string_view last = trim(args.substr(start, args.length()-1-start));
+    if (last.length() || count) {
+        if (count==maxResults) {
+            return false;
+        }
+        results[count++] = last;
+    }
+    return depth==0;
+}
+
+// "ARG3" -> 3
+static constexpr bool parseSlot(std::string_view s, U32& slot) {
+    if (s.length()<4 || s.substr(0, 3)!="ARG") {
+        return false;
+    }
+    slot = 0;
+    for (size_t i=3;i<s.length();i++) {
+        if (s[i]<'0' || s[i]>'9') {
+            return false;
+        }
+        slot = slot*10+(s[i]-'0');
+    }
+    return slot>0 && slot<16;
+}
+
+static constexpr U32 getMarshalElementSize(std::string_view type) {
+    // marshal2f is the same as marshalf, it just uses a different temp buffer in 32-bit builds
+    if (type.length() && type[0]>='2' && type[0]<='5') {
+        type = type.substr(1);
+    }
+    if (type=="d") {
+        return 8;
+    }
+    if (type=="f" || type=="i" || type=="ui" || type=="e") {
+        return 4;
+    }
+    if (type=="s" || type=="us") {
+        return 2;
+    }
+    if (type=="b" || type=="ub" || type=="bool") {
+        return 1;
+    }
+    return 0;
+}
+
+// "marshalf(cpu, ARG3, glcommon_glMaterialv_size(ARG2))"
+static constexpr bool parsePointer(std::string_view token, GlQueuedPointer& pointer, U32& maxBytes) {
+    size_t open = token.find('(');
+    std::string_view params[4] = {};
+    U32 paramCount = 0;
+
+    if (open==std::string_view::npos || !splitArgs(token.substr(open), params, 4, paramCount) || paramCount!=3 || params[0]!="cpu" || !parseSlot(params[1], pointer.slot)) {
+        return false;
+    }
+    pointer.elementSize = getMarshalElementSize(token.substr(7, open-7));
+    if (!pointer.elementSize) {
+        return false;
+    }
+    std::string_view count = params[2];
+    if (count.length() && count.find_first_not_of("0123456789")==std::string_view::npos) {
+        pointer.count = 0;
+        for (char c : count) {
+            pointer.count = pointer.count*10+(c-'0');
+        }
+        pointer.countFunction = NULL;
+        maxBytes = pointer.count*pointer.elementSize;
+        return true;
+    }
+    size_t countOpen = count.find('(');
+    if (countOpen==std::string_view::npos || count[count.length()-1]!=')' || !parseSlot(count.substr(countOpen+1, count.length()-countOpen-2), pointer.countSlot)) {
+        return false;
+    }
+    for (auto& f : glSizeFunctions) {
+        if (count.substr(0, countOpen)==f.name) {
+            pointer.count = 0;
+            pointer.countFunction = f.pfn;
+            maxBytes = GL_SIZE_FUNCTION_MAX*pointer.elementSize;
+            return true;
+        }
+    }
+    return false;
+}
+
+// works out what has to be copied to queue a GL_FUNCTION from its stringified arguments
+static constexpr GlQueuedCall describeCall(U32 index, Int99Callback callback, std::string_view ret, std::string_view pre, std::string_view post, std::string_view args) {
+    GlQueuedCall call;
+    std::string_view tokens[16] = {};
+    U32 tokenCount = 0;
+    U32 pointerBytes = 0;
+
+    call.index = index;
+    call.callback = callback;
+    // anything that happens before or after the call, like marshalling back a result, has to run on the emulated thread's behalf
+    if (ret!="void" || pre.length() || post.length() || !splitArgs(args, tokens, 16, tokenCount)) {
+        return call;
+    }
+    for (U32 i=0;i<tokenCount;i++) {
+        std::string_view token = tokens[i];
+        U32 slot = 0;
+
+        if (token.substr(0, 7)=="marshal") {
+            U32 maxBytes = 0;
+
+            if (call.pointerCount==GL_REPLAY_MAX_POINTERS) {
+                return call;
+            }
+            GlQueuedPointer& pointer = call.pointers[call.pointerCount++];
+            if (!parsePointer(token, pointer, maxBytes)) {
+                return call;
+            }
+            pointerBytes+=(maxBytes+7) & ~7;
+            slot = pointer.slot;
+            if (pointer.countFunction && pointer.countSlot>call.argCount) {
+                call.argCount = pointer.countSlot;
+            }
+        } else if (token.length() && token[0]=='d') {
+            if (!parseSlot(token.substr(1), slot)) {
+                return call;
+            }
+            call.doubleMask |= 1 << slot;
+        } else if (token.substr(0, 2)=="ip") {
+            if (!parseSlot(token.substr(2), slot)) {
+                return call;
+            }
+        } else if (token.length() && std::string_view("fbsh").find(token[0])!=std::string_view::npos) {
+            if (!parseSlot(token.substr(1), slot)) {
+                return call;
+            }
+        } else if (!parseSlot(token, slot)) {
+            return call;
+        }
+        if (slot>call.argCount) {
+            call.argCount = slot;
+        }
+    }
+    call.queued = pointerBytes<=GL_REPLAY_MAX_POINTER_DATA;
+    return call;
+}
+
+#undef GL_FUNCTION
+#define GL_FUNCTION(func, RET, PARAMS, ARGS, PRE, POST, LOG) void glcommon_gl##func(CPU* cpu);
+#undef GL_FUNCTION_CUSTOM
+#define GL_FUNCTION_CUSTOM(func, RET, PARAMS)
+#undef GL_EXT_FUNCTION
+#define GL_EXT_FUNCTION(func, RET, PARAMS)
+
+#include "../glfunctions.h"
+
+// glfunctions.h is included in function bodies because glfunctions_ext.h has a typedef in it
+static constexpr U32 countDescribedCalls() {
+    U32 count = 0;
+#undef GL_FUNCTION
+#define GL_FUNCTION(func, RET, PARAMS, ARGS, PRE, POST, LOG) count++;
+#include "../glfunctions.h"
+    return count;
+}
+
+class GlDescribedCalls {
+public:
+    GlQueuedCall calls[countDescribedCalls()];
+};
+
+static constexpr GlDescribedCalls describeCalls() {
+    GlDescribedCalls result;
+    U32 count = 0;
+#undef GL_FUNCTION
+#define GL_FUNCTION(func, RET, PARAMS, ARGS, PRE, POST, LOG) result.calls[count++] = describeCall(func, glcommon_gl##func, #RET, #PRE, #POST, #ARGS);
+#include "../glfunctions.h"
+    return result;
+}
+
+// one for each GL_FUNCTION, worked out by the compiler
+static constexpr GlDescribedCalls describedCalls = describeCalls();
+
+static constexpr const GlQueuedCall& getDescribedCall(U32 index) {
+    for (auto& call : describedCalls.calls) {
+        if (call.index==index) {
+            return call;
+        }
+    }
+    return describedCalls.calls[0];
+}
+
+// a few of each kind, so that a change to glfunctions.h or the marshal macros that the parser doesn't understand doesn't quietly stop queueing calls
+static_assert(getDescribedCall(ClearColor).queued && getDescribedCall(ClearColor).argCount==4, "glClearColor should be queued");
+static_assert(getDescribedCall(Translated).queued && getDescribedCall(Translated).doubleMask==0xE, "glTranslated should copy its doubles");
+static_assert(getDescribedCall(ClipPlane).queued && getDescribedCall(ClipPlane).pointers[0].count==4 && getDescribedCall(ClipPlane).pointers[0].elementSize==8, "glClipPlane should copy 4 doubles");
+static_assert(getDescribedCall(Lightiv).queued && getDescribedCall(Lightiv).pointers[0].countFunction==glcommon_glLightv_size, "glLightiv should be sized by glcommon_glLightv_size");
+static_assert(!getDescribedCall(IsEnabled).queued && !getDescribedCall(GetClipPlane).queued, "calls with results can't be queued");
+
+void GlCommandQueue::init() {
+    for (auto& call : describedCalls.calls) {
+        // sdlgl_init and esgl_init replace some of them
+        if (call.queued && int99Callback[call.index]==call.callback) {
+            queuedCalls[call.index] = call;
+        }
+    }
+}
+
+static void wakeRenderThread() {
+    // pairs with the fence in glRenderThreadProc, either it sees the new work or we see that it is sleeping
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (renderThreadSleeping.load(std::memory_order_relaxed)) {
+        BOXEDWINE_CONDITION_LOCK(renderCond);
+        BOXEDWINE_CONDITION_SIGNAL(renderCond);
+        BOXEDWINE_CONDITION_UNLOCK(renderCond);
+    }
+}
+
+static void signalDone() {
+    BOXEDWINE_CONDITION_LOCK(doneCond);
+    BOXEDWINE_CONDITION_SIGNAL_ALL(doneCond);
+    BOXEDWINE_CONDITION_UNLOCK(doneCond);
+}
+
+static void waitForSync(GlSync& sync) {
+    BOXEDWINE_CONDITION_LOCK(doneCond);
+    while (!sync.done) {
+        BOXEDWINE_CONDITION_WAIT(doneCond);
+    }
+    BOXEDWINE_CONDITION_UNLOCK(doneCond);
+}
+
+static void makeCurrent(void* window, void* context) {
+    if (renderContext!=context) {
+        SDL_GL_MakeCurrent((SDL_Window*)window, (SDL_GLContext)context);
+        renderContext = context;
+    }
+}
+
+static void runSync(GlSync* sync) {
+    if (sync->context) {
+        makeCurrent(sync->window, sync->context);
+    }
+    sync->f();
+    // f might have created, deleted or changed the current context
+    renderContext = SDL_GL_GetCurrentContext();
+
+    BOXEDWINE_CONDITION_LOCK(doneCond);
+    sync->done = true;
+    BOXEDWINE_CONDITION_SIGNAL_ALL(doneCond);
+    BOXEDWINE_CONDITION_UNLOCK(doneCond);
+}
+
+bool GlCommandQueue::hasRenderWork() {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(queuesMutex);
+    if (pendingSyncs.size()) {
+        return true;
+    }
+    for (GlCommandQueue* queue : queues) {
+        if (!queue->buffer.isEmpty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int glRenderThreadProc(void* data) {
+    onRenderThread = true;
+    while (true) {
+        std::vector<GlSync*> syncs;
+        std::vector<std::pair<GlCommandQueue*, U32> > work;
+
+        {
+            BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(queuesMutex);
+            // Nothing can be queued without a context, so the thread stops after the last one is
+            // deleted.  runOnRenderThread starts a new one when it is needed again.
+            if (queues.empty() && pendingSyncs.empty()) {
+                renderThreadRunning = false;
+                renderContext = NULL;
+                return 0;
+            }
+            // take the syncs first, that way the sizes include everything that was queued before them
+            syncs.swap(pendingSyncs);
+            for (GlCommandQueue* queue : queues) {
+                U32 size = queue->buffer.size();
+                if (size) {
+                    work.push_back(std::make_pair(queue, size));
+                }
+            }
+        }
+        for (auto& w : work) {
+            w.first->drain(w.second);
+        }
+        for (GlSync* sync : syncs) {
+            runSync(sync);
+        }
+        if (work.empty() && syncs.empty()) {
+            BOXEDWINE_CONDITION_LOCK(renderCond);
+            renderThreadSleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!GlCommandQueue::hasRenderWork()) {
+                BOXEDWINE_CONDITION_WAIT(renderCond);
+            }
+            renderThreadSleeping.store(false, std::memory_order_relaxed);
+            BOXEDWINE_CONDITION_UNLOCK(renderCond);
+        }
+    }
+    return 0;
+}
+
+// queuesMutex has to be held, that way the thread can't decide to stop after the caller has queued something for it
+static void startRenderThread() {
+    if (!renderThreadRunning) {
+        if (renderThread) {
+            // it already stopped
+            renderThread->wait();
+            delete renderThread;
+        }
+        renderThreadRunning = true;
+        renderThread = KNativeThread::createAndStartThread(glRenderThreadProc, "OpenGL", NULL);
+    }
+}
+
+GlCommandQueue::GlCommandQueue(void* window, void* context) : window(window), context(context), waitingForSpace(false), pendingSwaps(0) {
+    this->buffer.allocate(GL_QUEUE_BUFFER_SIZE);
+}
+
+bool GlCommandQueue::isRenderThread() {
+    return onRenderThread;
+}
+
+GlCommandQueue* GlCommandQueue::getQueue(void* context) {
+    U32 generation = queuesGeneration.load(std::memory_order_acquire);
+
+    if (context==cachedContext && generation==cachedGeneration) {
+        return cachedQueue;
+    }
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(queuesMutex);
+    auto it = queueByContext.find(context);
+    cachedQueue = (it==queueByContext.end()?NULL:it->second);
+    cachedContext = context;
+    cachedGeneration = generation;
+    return cachedQueue;
+}
+
+void GlCommandQueue::contextCreated(void* window, void* context) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(queuesMutex);
+    GlCommandQueue* queue = new GlCommandQueue(window, context);
+    queues.push_back(queue);
+    queueByContext[context] = queue;
+    queuesGeneration++;
+}
+
+void GlCommandQueue::contextDeleted(void* context) {
+    BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(queuesMutex);
+    auto it = queueByContext.find(context);
+    if (it!=queueByContext.end()) {
+        GlCommandQueue* queue = it->second;
+        queueByContext.erase(it);
+        VECTOR_REMOVE(queues, queue);
+        queuesGeneration++;
+        delete queue;
+    }
+}
+
+void GlCommandQueue::shutdown() {
+    {
+        BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(queuesMutex);
+        if (!renderThread) {
+            return;
+        }
+    }
+    if (!onRenderThread) {
+        // SDL deletes the contexts that are left with the window, this gets rid of their queues
+        runOnRenderThread([]() {
+            BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(queuesMutex);
+            for (GlCommandQueue* queue : queues) {
+                delete queue;
+            }
+            queues.clear();
+            queueByContext.clear();
+            queuesGeneration++;
+        });
+    }
+    // with no queues left the thread stops once it runs out of work
+    KNativeThread* thread;
+    {
+        BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(queuesMutex);
+        thread = renderThread;
+        renderThread = NULL;
+    }
+    if (thread) {
+        thread->wait();
+        delete thread;
+    }
+}
+
+void GlCommandQueue::runOnRenderThread(const std::function<void()>& f, void* window, void* context) {
+    if (onRenderThread) {
+        if (context) {
+            makeCurrent(window, context);
+        }
+        f();
+        renderContext = SDL_GL_GetCurrentContext();
+        return;
+    }
+    GlSync sync(f, window, context);
+    {
+        BOXEDWINE_CRITICAL_SECTION_WITH_MUTEX(queuesMutex);
+        startRenderThread();
+        pendingSyncs.push_back(&sync);
+    }
+    wakeRenderThread();
+    waitForSync(sync);
+}
+
+void GlCommandQueue::write(const U8* data, U32 len) {
+    if (this->buffer.space()<len) {
+        BOXEDWINE_CONDITION_LOCK(doneCond);
+        this->waitingForSpace = true;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (this->buffer.space()<len) {
+            wakeRenderThread();
+            BOXEDWINE_CONDITION_WAIT(doneCond);
+        }
+        this->waitingForSpace = false;
+        BOXEDWINE_CONDITION_UNLOCK(doneCond);
+    }
+    this->buffer.write(data, len);
+    wakeRenderThread();
+}
+
+void GlCommandQueue::call(CPU* cpu, U32 index) {
+    if (index==XCreateContext || index==XMakeCurrent || index==XDestroyContext || index==XSwapBuffer) {
+        // KNativeWindowSdl passes these on to the render thread itself, a swap is only queued
+        int99Callback[index](cpu);
+        return;
+    }
+    GlCommandQueue* queue = getQueue(cpu->thread->currentContext);
+
+    if (!queue) {
+        // the context was deleted while it was still current
+        int99Callback[index](cpu);
+        return;
+    }
+    const GlQueuedCall& desc = queuedCalls[index];
+    if (desc.queued) {
+        U32 data[GL_QUEUE_MAX_COMMAND/4];
+        U32 len = 0;
+        U32 i;
+
+        data[len++] = index;
+        for (i=1;i<=desc.argCount;i++) {
+            data[len++] = cpu->peek32(i);
+        }
+        // data[n] is ARGn
+        for (i=1;i<=desc.argCount;i++) {
+            if (desc.doubleMask & (1 << i)) {
+                U64 value = readq(data[i]);
+                memcpy(&data[len], &value, 8);
+                len+=2;
+            }
+        }
+        for (i=0;i<desc.pointerCount;i++) {
+            const GlQueuedPointer& pointer = desc.pointers[i];
+            U32 address = data[pointer.slot];
+            U32 bytes = 0;
+
+            if (address) {
+                bytes = (pointer.countFunction?pointer.countFunction(data[pointer.countSlot]):pointer.count)*pointer.elementSize;
+                if (!bytes) {
+                    // a pname glMarshalSize.cpp doesn't know about, let the driver look at the real pointer
+                    break;
+                }
+                memcopyToNative(address, &data[len+1], bytes);
+            }
+            data[len] = bytes;
+            len+=1+(bytes+3)/4;
+        }
+        if (i==desc.pointerCount) {
+            queue->write((U8*)data, len*4);
+            return;
+        }
+    }
+
+    // The emulated thread is blocked until this finishes, so the render thread can use its memory
+    // and registers.  This is also how the call sees everything that was queued before it.
+    GlSync sync([cpu, index]() {
+        ChangeThread changeThread(cpu->thread);
+        int99Callback[index](cpu);
+    }, NULL, NULL);
+    GlSync* pSync = &sync;
+    U8 data[4+sizeof(GlSync*)];
+    U32 op = GL_QUEUE_SYNC;
+
+    memcpy(data, &op, 4);
+    memcpy(data+4, &pSync, sizeof(GlSync*));
+    queue->write(data, sizeof(data));
+    waitForSync(sync);
+}
+
+void GlCommandQueue::swapBuffers(KThread* thread, void* window) {
+    GlCommandQueue* queue = (thread->currentContext?getQueue(thread->currentContext):NULL);
+
+    if (!queue) {
+        runOnRenderThread([window]() {
+            SDL_GL_SwapWindow((SDL_Window*)window);
+        });
+        return;
+    }
+    // let the emulated thread get at most one frame ahead of the driver
+    if (queue->pendingSwaps.load()) {
+        BOXEDWINE_CONDITION_LOCK(doneCond);
+        while (queue->pendingSwaps.load()) {
+            BOXEDWINE_CONDITION_WAIT(doneCond);
+        }
+        BOXEDWINE_CONDITION_UNLOCK(doneCond);
+    }
+    queue->pendingSwaps++;
+    U32 op = GL_QUEUE_SWAP;
+    queue->write((U8*)&op, 4);
+}
+
+void GlCommandQueue::drain(U32 len) {
+    U32 done = 0;
+
+    makeCurrent(this->window, this->context);
+    while (done<len) {
+        U32 op;
+
+        done+=this->buffer.read((U8*)&op, 4);
+        if (op==GL_QUEUE_SYNC) {
+            GlSync* sync;
+            done+=this->buffer.read((U8*)&sync, sizeof(GlSync*));
+            runSync(sync);
+            makeCurrent(this->window, this->context);
+        } else if (op==GL_QUEUE_SWAP) {
+            SDL_GL_SwapWindow((SDL_Window*)this->window);
+            this->pendingSwaps--;
+            signalDone();
+        } else {
+            done+=this->replay(op);
+        }
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (this->waitingForSpace) {
+        signalDone();
+    }
+}
+
+U32 GlCommandQueue::replay(U32 index) {
+    const GlQueuedCall& desc = queuedCalls[index];
+    GlReplayCall call;
+    U8* data = (U8*)call.data;
+    U32 len = 0;
+    U32 i;
+
+    len+=this->buffer.read((U8*)&call.args[1], desc.argCount*4);
+    for (i=1;i<=desc.argCount;i++) {
+        if (desc.doubleMask & (1 << i)) {
+            len+=this->buffer.read((U8*)&call.doubles[i], 8);
+        }
+    }
+    call.pointerCount = desc.pointerCount;
+    for (i=0;i<desc.pointerCount;i++) {
+        U32 bytes;
+
+        len+=this->buffer.read((U8*)&bytes, 4);
+        call.pointerAddress[i] = call.args[desc.pointers[i].slot];
+        if (bytes) {
+            len+=this->buffer.read(data, (bytes+3) & ~3);
+            call.pointerData[i] = data;
+            data+=(bytes+7) & ~7;
+        } else {
+            call.pointerData[i] = NULL;
+        }
+    }
+    // only values, nothing in this call looks at the cpu
+    glReplayCall = &call;
+    int99Callback[index](NULL);
+    glReplayCall = NULL;
+    return len;
+}
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef __GL_COMMAND_QUEUE_H__
+#define __GL_COMMAND_QUEUE_H__
+
+#if defined(BOXEDWINE_OPENGL_SDL) && defined(BOXEDWINE_MULTI_THREADED) && defined(BOXEDWINE_64BIT_MMU)
+#define BOXEDWINE_GL_THREAD
+
+#include "../../util/kspscringbuffer.h"
+
+#define GL_REPLAY_MAX_POINTERS 4
+#define GL_REPLAY_MAX_POINTER_DATA 256
+
+// the arguments of a queued call while the render thread runs it, see GL_ARG
+class GlReplayCall {
+public:
+    U8* getPointer(U32 address);
+
+    U32 args[16];
+    U64 doubles[16]; // dARGn is passed by pointer, this is the value it pointed to when the call was queued
+    U32 pointerCount;
+    U32 pointerAddress[GL_REPLAY_MAX_POINTERS];
+    U8* pointerData[GL_REPLAY_MAX_POINTERS];
+    U64 data[GL_REPLAY_MAX_POINTER_DATA/8];
+};
+
+extern THREAD_LOCAL GlReplayCall* glReplayCall;
+
+// Command buffer mode for OpenGL (-glthread).  One render thread owns every SDL GL context, an
+// emulated thread only appends its GL calls to the ring buffer of its current context and keeps
+// running while the driver works on them.
+//
+// A call is queued if it doesn't return anything and its arguments are values, doubles passed by
+// pointer or arrays with a fixed size or a size from glMarshalSize.cpp, those are copied into the
+// buffer.  The compiler works that out from the argument list in glfunctions.h.  Everything else, calls
+// with return values, readbacks, client arrays and the extension functions, waits for the render
+// thread to get to it and then runs there on behalf of the emulated thread.
+class GlCommandQueue {
+public:
+    static bool isEnabled() {return KSystem::glThread;}
+    static bool isRenderThread();
+
+    // called by gl_init, picks the calls that can be queued
+    static void init();
+
+    // called instead of the int 99 callback when the thread has a current context
+    static void call(CPU* cpu, U32 index);
+    static void swapBuffers(KThread* thread, void* window);
+
+    // Runs f on the render thread after everything that was already queued, with context current
+    // if it isn't NULL.  f runs right away if this is the render thread.
+    static void runOnRenderThread(const std::function<void()>& f, void* window=NULL, void* context=NULL);
+
+    // called on the render thread when SDL creates or deletes a context
+    static void contextCreated(void* window, void* context);
+    static void contextDeleted(void* context);
+
+    // deletes the queues that are left and waits for the render thread to stop
+    static void shutdown();
+
+private:
+    GlCommandQueue(void* window, void* context);
+
+    static GlCommandQueue* getQueue(void* context);
+    static bool hasRenderWork();
+
+    void write(const U8* data, U32 len);
+    void drain(U32 len);
+    U32 replay(U32 index);
+
+    void* window;
+    void* context;
+    KSpscRingBuffer buffer;
+    std::atomic<bool> waitingForSpace;
+    std::atomic<U32> pendingSwaps;
+
+    friend int glRenderThreadProc(void* data);
+};
+
+#endif
+
+#endif
@@ -1,6 +1,7 @@
 #include "boxedwine.h"
 #ifndef BOXEDWINE_MULTI_THREADED
 #include "recorder.h"
+#include "player.h"
 #include "devfb.h"
 #include "knativesocket.h"
 #include "knativewindow.h"
@@ -14,6 +15,18 @@ static U32 lastTitleUpdate = 0;
 
 bool doMainLoop() {
     bool shouldQuit = false;
+#ifdef BOXEDWINE_CPU_WORKERS
+    bool cpuWorkers = KSystem::cpuWorkers>0;
+#ifdef BOXEDWINE_RECORDER
+    // a recording is only repeatable if the threads always run in the same order
+    if (Recorder::instance || Player::instance) {
+        cpuWorkers = false;
+    }
+#endif
+    if (cpuWorkers) {
+        startCpuWorkers(KSystem::cpuWorkers);
+    }
+#endif
 
     while (KSystem::getProcessCount()>0 && !shouldQuit) {
         bool ran = runSlice();
@@ -32,7 +45,7 @@ bool doMainLoop() {
         t = KSystem::getMilliesSinceStart();
 
         if (KSystem::killTime && KSystem::killTime <= t) {
-            return true;
+            break;
         }
         if (lastTitleUpdate+5000 < t) {            
             lastTitleUpdate = t;
@@ -49,11 +62,25 @@ bool doMainLoop() {
             if (KSystem::getRunningProcessCount()==0) {
                 break;
             }
-            if (!checkWaitingNativeSockets(20)) {
-                KNativeThread::sleep(20);
+            U32 wait = getMilliesUntilNextTimer(20);
+#ifdef BOXEDWINE_CPU_WORKERS
+            if (cpuWorkers) {
+                // the workers can't run while this thread holds the kernel lock
+                checkWaitingNativeSockets(0);
+                waitForMainThreadWork(wait<5?wait:5);
+                continue;
+            }
+#endif
+            if (!checkWaitingNativeSockets(wait) && wait) {
+                KNativeThread::sleep(wait);
             }
         }
     }
+#ifdef BOXEDWINE_CPU_WORKERS
+    if (cpuWorkers) {
+        stopCpuWorkers();
+    }
+#endif
     return true;
 }
 #endif
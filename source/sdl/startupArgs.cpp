@@ -190,10 +190,21 @@ std::vector<std::string> StartUpArgs::buildArgs() {
         args.push_back("-cpuAffinity");
         args.push_back(std::to_string(cpuAffinity));
     }
+    if (glThread) {
+        args.push_back("-glthread");
+    }
+    if (cpuWorkers) {
+        args.push_back("-workers");
+        args.push_back(std::to_string(cpuWorkers));
+    }
     if (pollRate >= 0) {
         args.push_back("-pollRate");
         args.push_back(std::to_string(this->pollRate));
     }
+    if (blockCacheDir.length()) {
+        args.push_back("-blockcache");
+        args.push_back(blockCacheDir);
+    }
     for (auto& m : mountInfo) {
         if (m.wine) {
             args.push_back("-mount_drive");            
@@ -216,10 +227,18 @@ bool StartUpArgs::apply() {
     if (KSystem::cpuAffinityCountForApp) {
         klog("CPU Affinity set to %d", KSystem::cpuAffinityCountForApp);
     }
+    KSystem::glThread = this->glThread;
+#endif
+#ifdef BOXEDWINE_CPU_WORKERS
+    KSystem::cpuWorkers = this->cpuWorkers;
+    if (KSystem::cpuWorkers) {
+        klog("CPU workers set to %d", KSystem::cpuWorkers);
+    }
 #endif
     KSystem::pentiumLevel = this->pentiumLevel;
     KSystem::pollRate = this->pollRate;
     KSystem::showWindowImmediately = this->showWindowImmediately;
+    KSystem::decodedBlockCacheDir = this->blockCacheDir;
 
     for (U32 f=0;f<nonExecFileFullPaths.size();f++) {
         FsFileNode::nonExecFileFullPaths.insert(nonExecFileFullPaths[f]);
@@ -602,11 +621,37 @@ bool StartUpArgs::parseStartupArgs(int argc, const char **argv) {
         else if (!strcmp(argv[i], "-pollRate")) {
             this->pollRate = atoi(argv[i + 1]);
             i++;
+        } else if (!strcmp(argv[i], "-blockcache")) {
+            if (!Fs::doesNativePathExist(argv[i+1])) {
+                MKDIR(argv[i+1]);
+                if (!Fs::doesNativePathExist(argv[i+1])) {
+                    klog("-blockcache path does not exist and could not be created: %s", argv[i+1]);
+                    return false;
+                }
+            }
+            this->blockCacheDir = argv[i+1];
+            i++;
         } else if (!strcmp(argv[i], "-cpuAffinity")) {
 #ifdef BOXEDWINE_MULTI_THREADED
             this->cpuAffinity = atoi(argv[i+1]);
 #else
             klog("ignoring -cpuAffinity");
+#endif
+            i++;
+        } else if (!strcmp(argv[i], "-glthread")) {
+#ifdef BOXEDWINE_MULTI_THREADED
+            this->glThread = true;
+#else
+            klog("ignoring -glthread");
+#endif
+        } else if (!strcmp(argv[i], "-workers") && i+1<argc) {
+#ifdef BOXEDWINE_CPU_WORKERS
+            this->cpuWorkers = atoi(argv[i+1]);
+            if (this->cpuWorkers<0) {
+                this->cpuWorkers = 0;
+            }
+#else
+            klog("ignoring -workers");
 #endif
             i++;
         }
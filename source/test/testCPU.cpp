@@ -23,7 +23,10 @@
 
 #include "../emulation/softmmu/soft_memory.h"
 #include "../emulation/hardmmu/hard_memory.h"
+#include "../io/fsfilenode.h"
+#include "../io/fsfileopennode.h"
 #include "../emulation/cpu/binaryTranslation/btCpu.h"
+#include "../emulation/cpu/normal/normalCPU.h"
 #include "knativethread.h"
 
 #ifdef BOXEDWINE_MSVC
@@ -34,6 +37,7 @@
 #include "testMMX.h"
 #include "testSSE.h"
 #include "testSSE2.h"
+#include "testPerf.h"
 
 static int cseip;
 
@@ -161,6 +165,11 @@ void useFlags() {
     pushCode8(0x02);
 }
 
+#ifndef BOXEDWINE_BINARY_TRANSLATOR
+// how many times runTestCPU called cpu->run(), less than the number of blocks that ran if they were chained
+static U32 runTestCPUCount;
+#endif
+
 void runTestCPU() {    
 #ifdef BOXEDWINE_BINARY_TRANSLATOR    
     pushCode8(0xcd);
@@ -173,8 +182,10 @@ void runTestCPU() {
     pushCode8(0x70); // jump will fetch the next block as well
     pushCode8(0);
     cpu->nextBlock = cpu->getNextBlock();    
+    runTestCPUCount = 0;
     while (cpu->nextBlock->op->inst != JumpO && (cpu->nextBlock->op->inst != Custom1 || cpu->nextBlock->op->next->inst != JumpO)) {
         cpu->run();
+        runTestCPUCount++;
     }
 #endif    
 #ifdef BOXEDWINE_64BIT_MMU
@@ -4674,6 +4685,100 @@ void testScasd0x2af() {
     strTest(4, 0xf3, 0xaf, DF, NULL, 0, "1234123412341235", 16, 0x00000010, 0x00000020, 0x00000010, 0x00000010, 0x00000010, 0x0000000C, true, true, false, HEAP_ADDRESS + 256, 0x31323334);
 }
 
+// rep string ops long enough to be done a page at a time, starting at odd addresses so the
+// runs get cut by both the source and the destination page boundaries
+void testRepStringPageRuns() {
+    cpu->big = true;
+    cpu->seg[ES].address = HEAP_ADDRESS;
+
+    // rep movsd
+    newInstruction(0xf3, 0);
+    pushCode8(0xa5);
+    for (U32 i=0;i<8000;i++) {
+        writeb(HEAP_ADDRESS+0x102+i, (U8)(i*7));
+    }
+    ESI = 0x102;
+    EDI = 0x8001;
+    ECX = 2000;
+    runTestCPU();
+    assertTrue(ESI==0x102+8000 && EDI==0x8001+8000 && ECX==0);
+    for (U32 i=0;i<8000;i++) {
+        assertTrue(readb(HEAP_ADDRESS+0x8001+i)==(U8)(i*7));
+    }
+
+    // rep movsd (DF), copies down from the last dword
+    newInstruction(0xf3, DF);
+    pushCode8(0xa5);
+    ESI = 0x102+8000-4;
+    EDI = 0xa003+6000-4;
+    ECX = 1500;
+    runTestCPU();
+    assertTrue(ESI==0x102+8000-4-6000 && EDI==0xa003-4 && ECX==0);
+    for (U32 i=0;i<6000;i++) {
+        assertTrue(readb(HEAP_ADDRESS+0xa003+i)==(U8)((i+2000)*7));
+    }
+
+    // rep movsb where the destination is one byte after the source fills memory with the first byte
+    newInstruction(0xf3, 0);
+    pushCode8(0xa4);
+    writeb(HEAP_ADDRESS+0xff0, 0x5a);
+    ESI = 0xff0;
+    EDI = 0xff1;
+    ECX = 5000;
+    runTestCPU();
+    assertTrue(ESI==0xff0+5000 && EDI==0xff1+5000 && ECX==0);
+    for (U32 i=0;i<=5000;i++) {
+        assertTrue(readb(HEAP_ADDRESS+0xff0+i)==0x5a);
+    }
+
+    // rep stosd
+    newInstruction(0xf3, 0);
+    pushCode8(0xab);
+    EAX = 0x11223344;
+    EDI = 0x3ffd;
+    ECX = 3000;
+    runTestCPU();
+    assertTrue(EDI==0x3ffd+12000 && ECX==0);
+    for (U32 i=0;i<3000;i++) {
+        assertTrue(readd(HEAP_ADDRESS+0x3ffd+i*4)==0x11223344);
+    }
+
+    // rep stosw (DF)
+    newInstruction(0x66, DF);
+    pushCode8(0xf3);
+    pushCode8(0xab);
+    EAX = 0xabcd;
+    EDI = 0x5001;
+    ECX = 3000;
+    runTestCPU();
+    assertTrue(EDI==0x5001-6000 && ECX==0);
+    for (U32 i=0;i<3000;i++) {
+        assertTrue(readw(HEAP_ADDRESS+0x5001-i*2)==0xabcd);
+    }
+
+    // repne scasb
+    zeroMemory(HEAP_ADDRESS, K_PAGE_SIZE*17);
+    writeb(HEAP_ADDRESS+0x2100, 0x77);
+    newInstruction(0xf2, 0);
+    pushCode8(0xae);
+    EAX = 0x77;
+    EDI = 0x10;
+    ECX = 0x3000;
+    runTestCPU();
+    assertTrue(EDI==0x2101 && ECX==0x3000-(0x2101-0x10) && cpu->getZF());
+
+    // repe cmpsd, the first dwords that differ are 1200 dwords in
+    writed(HEAP_ADDRESS+0x8003+1200*4, 1);
+    newInstruction(0xf3, 0);
+    pushCode8(0xa7);
+    ESI = 0x3;
+    EDI = 0x8003;
+    ECX = 2000;
+    runTestCPU();
+    assertTrue(ESI==0x3+1201*4 && EDI==0x8003+1201*4 && ECX==2000-1201 && !cpu->getZF() && cpu->getCF());
+    cpu->seg[ES].address = 0;
+}
+
 void testMovsb0x0a4() {
     cpu->big = false;
 
@@ -6831,6 +6936,289 @@ void testJcxz0x2e3() {
     doJcxz(0xe3, true);
 }
 
+// runs a loop across 2 blocks more than TRACE_HOT_COUNT times so that the blocks get chained
+void testTraceLoop() {
+    cpu->big = true;
+    newInstruction(0);
+    pushCode8(0xb9); pushCode32(100);               // 00 mov ecx, 100
+    pushCode8(0x31); pushCode8(0xc0);               // 05 xor eax, eax
+    pushCode8(0x31); pushCode8(0xd2);               // 07 xor edx, edx
+    pushCode8(0x83); pushCode8(0xc0); pushCode8(3); // 09 add eax, 3
+    pushCode8(0xeb); pushCode8(0);                  // 0c jmp 0e, ends the block
+    pushCode8(0x01); pushCode8(0xc2);               // 0e add edx, eax
+    pushCode8(0x49);                                // 10 dec ecx
+    pushCode8(0x75); pushCode8(0xf6);               // 11 jnz 09
+    runTestCPU();
+    assertTrue(EAX == 300);
+    assertTrue(EDX == 15150);
+    assertTrue(ECX == 0);
+    assertTrue(cpu->getZF() != 0);
+    assertTrue(cpu->getCF() == 0);
+    assertTrue(cpu->getSF() == 0);
+    assertTrue(cpu->getOF() == 0);
+#ifndef BOXEDWINE_BINARY_TRANSLATOR
+    assertTrue(runTestCPUCount < 200);
+#endif
+}
+
+// the binary translator points a jcc that lands in the same chunk straight at the target
+void testJumpBackInChunk() {
+    cpu->big = true;
+    newInstruction(0);
+    pushCode8(0xb9); pushCode32(10);                // 00 mov ecx, 10
+    pushCode8(0x83); pushCode8(0xc0); pushCode8(3); // 05 add eax, 3
+    pushCode8(0x49);                                // 08 dec ecx
+    pushCode8(0x75); pushCode8(0xfa);               // 09 jnz 05
+    pushCode8(0x83); pushCode8(0xc2); pushCode8(1); // 0b add edx, 1
+    runTestCPU();
+    assertTrue(EAX == 30);
+    assertTrue(ECX == 0);
+    assertTrue(EDX == 1);
+    assertTrue(cpu->getZF() == 0);
+}
+
+#ifndef BOXEDWINE_BINARY_TRANSLATOR
+// Same loop, but once the blocks are chained the second block rewrites the add in the first one
+// while the first block's ops are still on the stack.  The first block is freed, the rest of the loop
+// runs the new add.
+void testTraceSelfModifyingCode() {
+    // long enough that the whole loop is one trace once it is hot
+    U32 saveMaxBlocksPerTrace = NormalCPU::maxBlocksPerTrace;
+    NormalCPU::maxBlocksPerTrace = 1000;
+
+    cpu->big = true;
+    newInstruction(0);
+    pushCode8(0xb9); pushCode32(100);               // 00 mov ecx, 100
+    pushCode8(0x31); pushCode8(0xc0);               // 05 xor eax, eax
+    pushCode8(0x31); pushCode8(0xd2);               // 07 xor edx, edx
+    pushCode8(0xb3); pushCode8(1);                  // 09 mov bl, 1
+    pushCode8(0xeb); pushCode8(0);                  // 0b jmp 0d, ends the block
+    pushCode8(0x83); pushCode8(0xc0); pushCode8(1); // 0d add eax, 1
+    pushCode8(0xeb); pushCode8(0);                  // 10 jmp 12, ends the block
+    pushCode8(0x01); pushCode8(0xc2);               // 12 add edx, eax
+    pushCode8(0x31); pushCode8(0xdb);               // 14 xor ebx, ebx
+    pushCode8(0x83); pushCode8(0xf9); pushCode8(20);// 16 cmp ecx, 20
+    pushCode8(0x0f); pushCode8(0x9c); pushCode8(0xc3); // 19 setl bl
+    pushCode8(0x8d); pushCode8(0x5c); pushCode8(0x1b); pushCode8(1); // 1c lea ebx, [ebx+ebx+1]
+    pushCode8(0x2e); pushCode8(0x88); pushCode8(0x1d); pushCode32(0x0f); // 20 mov cs:[0f], bl
+    pushCode8(0x49);                                // 27 dec ecx
+    pushCode8(0x75); pushCode8(0xe3);               // 28 jnz 0d
+    runTestCPU();
+    NormalCPU::maxBlocksPerTrace = saveMaxBlocksPerTrace;
+
+    // ecx is 19 in the 82nd time through, after that the add is 3
+    assertTrue(EAX == 82 + 18 * 3);
+    assertTrue(EDX == 82 * 83 / 2 + 82 * 18 + 3 * (18 * 19 / 2));
+    assertTrue(ECX == 0);
+    assertTrue(EBX == 3);
+    assertTrue(readb(CODE_ADDRESS + 0x0f) == 3);
+    // dec leaves the carry from cmp 1, 20
+    assertTrue(cpu->getZF() != 0);
+    assertTrue(cpu->getCF() != 0);
+    assertTrue(cpu->getSF() == 0);
+    assertTrue(cpu->getOF() == 0);
+    assertTrue(runTestCPUCount < 200);
+}
+#endif
+
+#if !defined(BOXEDWINE_BINARY_TRANSLATOR) && !defined(BOXEDWINE_64BIT_MMU)
+// The first block ends in a jmp to a block that sets every flag, so its op runs without flags.  Then
+// the start of the second block is rewritten to read CF, that unlinks it and the op has to set the
+// flags again.
+void doNoFlagsJmp(int instruction, int flags, U32 eax, U32 ebx, U32 result, U32 cf) {
+    newInstructionWithRM(instruction, 0xd8, flags); // 00 op eax, ebx
+    pushCode8(0xeb); pushCode8(0);                  // 02 jmp 04, ends the block
+    pushCode8(0x83); pushCode8(0xe9); pushCode8(3); // 04 sub ecx, 3
+    pushCode8(0x83); pushCode8(0xe9); pushCode8(1); // 07 sub ecx, 1
+    EAX = eax;
+    EBX = ebx;
+    ECX = 5;
+    runTestCPU();
+    assertTrue(EAX == result);
+    assertTrue(ECX == 1);
+    assertTrue(cpu->getCF() == 0);
+    assertTrue(cpu->getZF() == 0);
+    DecodedBlock* block = memory->getCodeBlock(CODE_ADDRESS);
+    assertTrue(block && block->op->pfn != NormalCPU::getFunctionForOp(block->op));
+
+    newInstruction(flags);
+    cseip = CODE_ADDRESS + 4;
+    pushCode8(0x0f); pushCode8(0x92); pushCode8(0xc2); // 04 setc dl
+    block = memory->getCodeBlock(CODE_ADDRESS);
+    assertTrue(block && block->op->pfn == NormalCPU::getFunctionForOp(block->op));
+    // the second time the first block is already linked to the new one
+    for (int i = 0; i < 2; i++) {
+        newInstruction(flags);
+        cseip = CODE_ADDRESS + 10;
+        EAX = eax;
+        EBX = ebx;
+        ECX = 5;
+        EDX = 0xff;
+        runTestCPU();
+        assertTrue(EAX == result);
+        assertTrue(ECX == 4);
+        assertTrue(EDX == cf);
+    }
+}
+
+void testNoFlagsJmp() {
+    cpu->big = true;
+    doNoFlagsJmp(0x01, 0, 0xffffffff, 1, 0, 1);     // add
+    doNoFlagsJmp(0x29, 0, 0, 1, 0xffffffff, 1);     // sub
+    doNoFlagsJmp(0x21, CF, 3, 1, 1, 0);             // and
+}
+#endif
+
+#if defined(BOXEDWINE_64BIT_MMU) && !defined(BOXEDWINE_MSVC)
+#include <fcntl.h>
+#include <unistd.h>
+
+#define FORK_PRIVATE_ADDRESS 0x20000000
+#define FORK_SHARED_ADDRESS 0x30000000
+
+static U32 countMemoryFiles(Memory* m) {
+    U32 result = 0;
+
+    for (U32 i=1;i<m->nativeFiles.size();i++) {
+        if (m->nativeFiles[i] && !m->nativeFiles[i]->file) {
+            result++;
+        }
+    }
+    return result;
+}
+
+static U32* getForkAddress(Memory* m, U32 address) {
+    return (U32*)getNativeAddress(m, address);
+}
+
+// forks a process that keeps allocating pageCount pages, the parent must not end up with a memory file per fork
+static void doMemoryForks(Memory* parent, U32 address, U32 pageCount, U32 forks) {
+    for (U32 i=0;i<forks;i++) {
+        parent->allocPages(address >> K_PAGE_SHIFT, pageCount, PAGE_READ|PAGE_WRITE, -1, 0, NULL);
+        *getForkAddress(parent, address) = i;
+        Memory* child = new Memory();
+        child->clone(parent);
+        assertTrue(*getForkAddress(child, address)==i);
+        *getForkAddress(child, address) = 0xFFFFFFFF;
+        assertTrue(*getForkAddress(parent, address)==i);
+        *getForkAddress(parent, FORK_PRIVATE_ADDRESS) = i;
+        assertTrue(*getForkAddress(child, FORK_PRIVATE_ADDRESS)!=i);
+        *getForkAddress(child, FORK_SHARED_ADDRESS) = i;
+        assertTrue(*getForkAddress(parent, FORK_SHARED_ADDRESS)==i);
+        delete child;
+        address += pageCount << K_PAGE_SHIFT;
+    }
+    assertTrue(countMemoryFiles(parent)<40);
+}
+
+void testMemoryFork() {
+    Memory* parent = new Memory();
+    parent->allocPages(FORK_PRIVATE_ADDRESS >> K_PAGE_SHIFT, 16, PAGE_READ|PAGE_WRITE, -1, 0, NULL);
+    parent->allocPages(FORK_SHARED_ADDRESS >> K_PAGE_SHIFT, 4, PAGE_READ|PAGE_WRITE|PAGE_SHARED, -1, 0, NULL);
+    U32* parentPrivate = getForkAddress(parent, FORK_PRIVATE_ADDRESS);
+    U32* parentShared = getForkAddress(parent, FORK_SHARED_ADDRESS);
+    *parentPrivate = 1;
+    *parentShared = 1;
+
+    Memory* child = new Memory();
+    child->clone(parent);
+    U32* childPrivate = getForkAddress(child, FORK_PRIVATE_ADDRESS);
+    U32* childShared = getForkAddress(child, FORK_SHARED_ADDRESS);
+    assertTrue(*childPrivate==1);
+    assertTrue(*childShared==1);
+
+    // private pages are copy on write in both directions
+    *childPrivate = 2;
+    assertTrue(*parentPrivate==1);
+    *parentPrivate = 3;
+    assertTrue(*childPrivate==2);
+
+    // MAP_SHARED pages stay shared in both directions
+    *childShared = 2;
+    assertTrue(*parentShared==2);
+    *parentShared = 3;
+    assertTrue(*childShared==3);
+
+    // the grandchild gets what the child wrote after it was forked
+    Memory* grandChild = new Memory();
+    grandChild->clone(child);
+    U32* grandChildPrivate = getForkAddress(grandChild, FORK_PRIVATE_ADDRESS);
+    U32* grandChildShared = getForkAddress(grandChild, FORK_SHARED_ADDRESS);
+    assertTrue(*grandChildPrivate==2);
+    assertTrue(*grandChildShared==3);
+    *grandChildPrivate = 4;
+    assertTrue(*childPrivate==2);
+    assertTrue(*parentPrivate==3);
+    *grandChildShared = 4;
+    assertTrue(*childShared==4);
+    assertTrue(*parentShared==4);
+
+    delete grandChild;
+    delete child;
+    assertTrue(*parentPrivate==3);
+    assertTrue(*parentShared==4);
+
+    // small allocations, the old memory files are merged into the current one
+    doMemoryForks(parent, FORK_PRIVATE_ADDRESS+(16 << K_PAGE_SHIFT), 1, 300);
+    // large allocations, after a while the parent stops retiring its memory file and the children get copies
+    doMemoryForks(parent, 0x40000000, 128, 60);
+    delete parent;
+}
+
+// a read only private and a read only shared mapping of a file that was opened read only
+void testMemoryMapFile() {
+    char path[] = "/tmp/boxedwineTestXXXXXX";
+    S32 handle = mkstemp(path);
+    U32 data[K_PAGE_SIZE/2];
+    U32 page = FORK_PRIVATE_ADDRESS >> K_PAGE_SHIFT;
+
+    for (U32 i=0;i<K_PAGE_SIZE/2;i++) {
+        data[i] = i;
+    }
+    assertTrue(write(handle, data, sizeof(data))==sizeof(data));
+    close(handle);
+    handle = open(path, O_RDONLY);
+    unlink(path);
+    BoxedPtr<FsFileNode> node = new FsFileNode(0, 0, path, "", path, false, false, NULL);
+    BoxedPtr<MappedFile> mappedFile = new MappedFile();
+    mappedFile->file = std::make_shared<KFile>(new FsFileOpenNode(node, K_O_RDONLY, handle));
+
+    memory->allocPages(page, 2, PAGE_READ, handle, 0, mappedFile);
+    assertTrue((memory->nativeFlags[page] & (NATIVE_FLAG_FILE_MAPPED|NATIVE_FLAG_HOST_READONLY))==(NATIVE_FLAG_FILE_MAPPED|NATIVE_FLAG_HOST_READONLY));
+    assertTrue(readd(FORK_PRIVATE_ADDRESS+K_PAGE_SIZE+4)==K_PAGE_SIZE/4+1);
+    assertTrue(!widenNativeFilePage(memory, page, false));
+    // looking at it doesn't make it writable and reading from the file into it fails
+    assertTrue(getPhysicalAddress(FORK_PRIVATE_ADDRESS+K_PAGE_SIZE, 4)!=NULL);
+    assertTrue((memory->nativeFlags[page+1] & NATIVE_FLAG_HOST_READONLY)!=0);
+    assertTrue(mappedFile->file->read(FORK_PRIVATE_ADDRESS+K_PAGE_SIZE, 4)==(U32)-K_EFAULT);
+
+    // the guest made the first page writable, writing to it widens only that page
+    memory->protectPage(page, PAGE_READ|PAGE_WRITE);
+    writed(FORK_PRIVATE_ADDRESS+4, 0xFFFFFFFF);
+    assertTrue(readd(FORK_PRIVATE_ADDRESS+4)==0xFFFFFFFF);
+    assertTrue(!(memory->nativeFlags[page] & NATIVE_FLAG_HOST_READONLY));
+    assertTrue((memory->nativeFlags[page+1] & NATIVE_FLAG_HOST_READONLY)!=0);
+    assertTrue(pread(handle, data, 8, 0)==8 && data[1]==1);
+
+    // a shared mapping can't be widened, the file was opened read only
+    memory->allocPages(page+16, 1, PAGE_READ|PAGE_SHARED, handle, 0, mappedFile);
+    assertTrue((memory->nativeFlags[page+16] & (NATIVE_FLAG_FILE_MAPPED|NATIVE_FLAG_HOST_SHARED))==(NATIVE_FLAG_FILE_MAPPED|NATIVE_FLAG_HOST_SHARED));
+    assertTrue(readd(FORK_PRIVATE_ADDRESS+(16 << K_PAGE_SHIFT)+4)==1);
+    assertTrue(!widenNativeFilePage(memory, page+16, true));
+    memory->protectPage(page+16, PAGE_READ|PAGE_WRITE|PAGE_SHARED);
+    assertTrue(!widenNativeFilePage(memory, page+16, false));
+    // so the emulator's own writes to it fail instead of faulting on the host
+    assertTrue(!widenNativeFilePage(memory, page+16, true));
+    assertTrue(!memory->isValidWriteAddress(FORK_PRIVATE_ADDRESS+(16 << K_PAGE_SHIFT), 4));
+    assertTrue(getPhysicalWriteAddress(FORK_PRIVATE_ADDRESS+(16 << K_PAGE_SHIFT), 4)==NULL);
+    assertTrue(!memcopyFromNative(FORK_PRIVATE_ADDRESS+(16 << K_PAGE_SHIFT), data, 4));
+    assertTrue(readd(FORK_PRIVATE_ADDRESS+(16 << K_PAGE_SHIFT)+4)==1);
+
+    freeNativeMemory(memory, page, 2);
+    freeNativeMemory(memory, page+16, 1);
+}
+#endif
+
 void testCmc0x0f5() {cpu->big=false;EbReg(0xf5, 0, cmc);}
 void testCmc0x2f5() {cpu->big=true;EbReg(0xf5, 0, cmc);}
 
@@ -8895,6 +9283,10 @@ void test16BitMemoryAccess() {
 
 
 int main(int argc, char **argv) {	
+    if (argc>1 && !strcmp(argv[1], "-perf")) {
+        setup();
+        return runPerfTests();
+    }
     printf("Please wait, these first 2 tests can take a while\n");
     run(test32BitMemoryAccess, "32-bit Memory Access");
     run(test16BitMemoryAccess, "16-bit Memory Access");
@@ -9202,6 +9594,7 @@ int main(int argc, char **argv) {
     run(testScasb0x2ae, "Scasb 2ae");
     run(testScasw0x0af, "Scasw 0af");
     run(testScasd0x2af, "Scasd 2af");
+    run(testRepStringPageRuns, "Rep String Page Runs");
 
     run(testMovAlIb0x0b0, "Mov 0b0");
     run(testMovAlIb0x2b0, "Mov 2b0");
@@ -9279,6 +9672,18 @@ int main(int argc, char **argv) {
     run(testLoop0x2e2, "Loop 2e2");
     run(testJcxz0x0e3, "Jcxz 0e3");
     run(testJcxz0x2e3, "Jcxz 2e3");
+    run(testJumpBackInChunk, "Jump Back In Chunk");
+    run(testTraceLoop, "Trace Loop");
+#ifndef BOXEDWINE_BINARY_TRANSLATOR
+    run(testTraceSelfModifyingCode, "Trace Self Modifying Code");
+#endif
+#if !defined(BOXEDWINE_BINARY_TRANSLATOR) && !defined(BOXEDWINE_64BIT_MMU)
+    run(testNoFlagsJmp, "No Flags Jmp");
+#endif
+#if defined(BOXEDWINE_64BIT_MMU) && !defined(BOXEDWINE_MSVC)
+    run(testMemoryFork, "Memory Fork");
+    run(testMemoryMapFile, "Memory Map File");
+#endif
 
     run(testCmc0x0f5, "Cmc 0f5");
     run(testCmc0x2f5, "Cmc 2f5");
@@ -7,6 +7,7 @@ void pushCode16(int value);
 void pushCode32(int value);
 void runTestCPU();
 void failed(const char* msg, ...);
+void setup();
 
 extern CPU* cpu;
 
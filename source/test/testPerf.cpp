@@ -0,0 +1,590 @@
+#include "boxedwine.h"
+
+#ifdef __TEST
+
+#include "testCPU.h"
+#include "testPerf.h"
+#include "ksocket.h"
+#include "kvdso.h"
+#include "../io/fsfilenode.h"
+#include "../emulation/cpu/common/lazyFlagsCondition.h"
+#include "../emulation/hardmmu/hard_memory.h"
+#ifdef BOXEDWINE_X64
+#include "../emulation/cpu/x64/x64CPU.h"
+#endif
+#ifndef BOXEDWINE_BINARY_TRANSLATOR
+#include "../emulation/cpu/normal/normalCPU.h"
+#include "../emulation/cpu/normal/normal_strings.h"
+#endif
+
+static int perfFails;
+
+static void perfFailed(const char* name) {
+    printf("%s ... FAILED\n", name);
+    perfFails++;
+}
+
+static void perfResult(const char* name, U32 iterations, U64 micro) {
+    printf("%s ... %d iterations, %.3f us each\n", name, iterations, (double)micro / iterations);
+}
+
+// wineserver requests are a fixed 64 byte header plus optional data written with writev on
+// the request pipe, the reply is a 64 byte header read from the reply pipe
+static void perfWineserverRoundTrip() {
+    const char* name = "unix socket wineserver request/reply";
+    const U32 iterations = 100000;
+    KProcess* process = KThread::currentThread()->process.get();
+    U32 fds = HEAP_ADDRESS;
+    U32 iov = HEAP_ADDRESS + 16;
+    U32 request = HEAP_ADDRESS + 64;
+    U32 serverBuffer = HEAP_ADDRESS + 256;
+    U32 reply = HEAP_ADDRESS + 512;
+
+    setup();
+    ksocketpair(K_AF_UNIX, K_SOCK_STREAM, 0, fds, 0);
+    ksocketpair(K_AF_UNIX, K_SOCK_STREAM, 0, fds + 8, 0);
+    FD requestClient = readd(fds);
+    FD requestServer = readd(fds + 4);
+    FD replyServer = readd(fds + 8);
+    FD replyClient = readd(fds + 12);
+
+    writed(iov, request);
+    writed(iov + 4, 64);
+    writed(iov + 8, request + 64);
+    writed(iov + 12, 16);
+
+    U64 start = KSystem::getMicroCounter();
+    for (U32 i = 0; i < iterations; i++) {
+        writed(request, i);
+        if (process->writev(requestClient, iov, 2) != 80 || process->read(requestServer, serverBuffer, 80) != 80 || readd(serverBuffer) != i) {
+            perfFailed(name);
+            return;
+        }
+        writed(serverBuffer, i + 1);
+        if (process->write(replyServer, serverBuffer, 64) != 64 || process->read(replyClient, reply, 64) != 64 || readd(reply) != i + 1) {
+            perfFailed(name);
+            return;
+        }
+    }
+    perfResult(name, iterations, KSystem::getMicroCounter() - start);
+    process->close(requestClient);
+    process->close(requestServer);
+    process->close(replyServer);
+    process->close(replyClient);
+}
+
+// wineserver passes file descriptors with sendmsg/SCM_RIGHTS, 8 bytes of data plus the fd
+static void perfWineserverSendFd() {
+    const char* name = "unix socket wineserver send_fd";
+    const U32 iterations = 100000;
+    KProcess* process = KThread::currentThread()->process.get();
+    U32 fds = HEAP_ADDRESS;
+    U32 iov = HEAP_ADDRESS + 16;
+    U32 data = HEAP_ADDRESS + 32;
+    U32 msg = HEAP_ADDRESS + 64;
+    U32 control = HEAP_ADDRESS + 128;
+
+    setup();
+    ksocketpair(K_AF_UNIX, K_SOCK_STREAM, 0, fds, 0);
+    FD client = readd(fds);
+    FD server = readd(fds + 4);
+
+    writed(iov, data);
+    writed(iov + 4, 8);
+
+    U64 start = KSystem::getMicroCounter();
+    for (U32 i = 0; i < iterations; i++) {
+        zeroMemory(msg, 28);
+        writed(msg + 8, iov);
+        writed(msg + 12, 1);
+        writed(msg + 16, control);
+        writed(msg + 20, 16);
+        writed(control, 16);
+        writed(control + 4, K_SOL_SOCKET);
+        writed(control + 8, K_SCM_RIGHTS);
+        writed(control + 12, client);
+        writed(data, i);
+        writed(data + 4, client);
+        if (ksendmsg(server, msg, 0) != 8) {
+            perfFailed(name);
+            return;
+        }
+        writed(data, 0);
+        writed(control + 12, 0);
+        if (krecvmsg(client, msg, 0) != 8 || readd(data) != i || readd(msg + 20) != 16) {
+            perfFailed(name);
+            return;
+        }
+        process->close(readd(control + 12));
+    }
+    perfResult(name, iterations, KSystem::getMicroCounter() - start);
+    process->close(client);
+    process->close(server);
+}
+
+// Wine resolves Windows paths without regard to case, system32 holds thousands of files and most
+// lookups are for a spelling that doesn't match the case on disk
+static void perfIgnoreCasePathLookup() {
+    const char* name = "case insensitive path lookup";
+    const U32 fileCount = 3000;
+    const U32 pathCount = 4000;
+    const U32 rounds = 5;
+    BoxedPtr<FsNode> root = new FsFileNode(0, 0, "", "", "", true, true, NULL);
+    BoxedPtr<FsNode> windows = Fs::addFileNode("/windows", "", "", true, root);
+    BoxedPtr<FsNode> system32 = Fs::addFileNode("/windows/system32", "", "", true, windows);
+    std::vector<std::vector<std::string> > paths;
+    char tmp[64];
+
+    for (U32 i = 0; i < fileCount; i++) {
+        snprintf(tmp, sizeof(tmp), "/windows/system32/Lib%04d.dll", i);
+        Fs::addFileNode(tmp, "", "", false, system32);
+    }
+    // every 4th path doesn't exist
+    for (U32 i = 0; i < pathCount; i++) {
+        std::vector<std::string> parts;
+        parts.push_back((i & 1) ? "WINDOWS" : "Windows");
+        parts.push_back((i & 2) ? "System32" : "SYSTEM32");
+        snprintf(tmp, sizeof(tmp), (i & 1) ? "LIB%04d.DLL" : "lib%04d.Dll", (i % 4 == 3) ? fileCount + i : i % fileCount);
+        parts.push_back(tmp);
+        paths.push_back(parts);
+    }
+
+    U32 found = 0;
+    U64 start = KSystem::getMicroCounter();
+    for (U32 r = 0; r < rounds; r++) {
+        for (auto& parts : paths) {
+            BoxedPtr<FsNode> node = root;
+            for (auto& part : parts) {
+                node = node->getChildByNameIgnoreCase(part);
+                if (!node) {
+                    break;
+                }
+            }
+            if (node) {
+                found++;
+            }
+        }
+    }
+    U64 micro = KSystem::getMicroCounter() - start;
+    if (found != rounds * (pathCount - pathCount / 4)) {
+        perfFailed(name);
+        return;
+    }
+    perfResult(name, rounds * pathCount, micro);
+}
+
+// jcc after cmp, add, dec and test, once through the LazyFlags getters like the normal core used to
+// and once with the switch in lazyFlagsCondition
+static void perfLazyFlagsCondition() {
+    const char* getterName = "jcc condition through LazyFlags getters";
+    const char* switchName = "jcc condition with lazy flags type switch";
+    const U32 iterations = 4000000;
+    const LazyFlags* lazyFlags[] = {FLAGS_CMP32, FLAGS_ADD32, FLAGS_DEC32, FLAGS_TEST32};
+    CPU* cpu = KThread::currentThread()->cpu;
+    const LazyFlags* oldLazyFlags = cpu->lazyFlags;
+    U32 getterTaken = 0;
+    U32 switchTaken = 0;
+
+    // the fallback uses the getters, so this also checks the inline versions match them
+    for (U32 i = 0; i < 100000; i++) {
+        cpu->dst.u32 = i * 2654435761u;
+        cpu->src.u32 = i << (i & 31);
+        cpu->result.u32 = cpu->dst.u32 - cpu->src.u32;
+        cpu->oldCF = i & 1;
+        cpu->lazyFlags = lazyFlags[i & 3];
+        for (U32 condition = CONDITION_O; condition <= CONDITION_NLE; condition++) {
+            if (lazyFlagsCondition(cpu, condition) != lazyFlagsConditionFromGetters(cpu, condition)) {
+                cpu->lazyFlags = oldLazyFlags;
+                perfFailed(switchName);
+                return;
+            }
+        }
+    }
+
+    U64 start = KSystem::getMicroCounter();
+    for (U32 i = 0; i < iterations; i++) {
+        cpu->dst.u32 = i * 2654435761u;
+        cpu->src.u32 = i;
+        cpu->result.u32 = cpu->dst.u32 - cpu->src.u32;
+        cpu->lazyFlags = lazyFlags[i & 3];
+        if (cpu->getZF()) {
+            getterTaken++;
+        }
+        if (cpu->getZF() || cpu->getCF()) {
+            getterTaken++;
+        }
+        if (cpu->getZF() || (cpu->getSF() != 0) != (cpu->getOF() != 0)) {
+            getterTaken++;
+        }
+    }
+    U64 micro = KSystem::getMicroCounter() - start;
+    perfResult(getterName, iterations, micro);
+
+    start = KSystem::getMicroCounter();
+    for (U32 i = 0; i < iterations; i++) {
+        cpu->dst.u32 = i * 2654435761u;
+        cpu->src.u32 = i;
+        cpu->result.u32 = cpu->dst.u32 - cpu->src.u32;
+        cpu->lazyFlags = lazyFlags[i & 3];
+        if (lazyFlagsCondition(cpu, CONDITION_Z)) {
+            switchTaken++;
+        }
+        if (lazyFlagsCondition(cpu, CONDITION_BE)) {
+            switchTaken++;
+        }
+        if (lazyFlagsCondition(cpu, CONDITION_LE)) {
+            switchTaken++;
+        }
+    }
+    micro = KSystem::getMicroCounter() - start;
+    cpu->lazyFlags = oldLazyFlags;
+    if (switchTaken != getterTaken) {
+        perfFailed(switchName);
+    } else {
+        perfResult(switchName, iterations, micro);
+    }
+}
+
+#ifndef BOXEDWINE_BINARY_TRANSLATOR
+// a counting loop with a branch inside of it, so each iteration runs 3 blocks
+static U64 runNormalCoreLoop(U32 maxBlocksPerTrace, U32 iterations) {
+    CPU* cpu = KThread::currentThread()->cpu;
+    U32 address = cpu->seg[CS].address;
+    U8 code[] = {
+        0x01, 0xc8,                         // L: add eax, ecx
+        0xf7, 0xc1, 0x01, 0x00, 0x00, 0x00, // test ecx, 1
+        0x74, 0x02,                         // jz S
+        0x42,                               // inc edx
+        0x42,                               // inc edx
+        0x49,                               // S: dec ecx
+        0x75, 0xf1,                         // jnz L
+        0x70, 0x00                          // jo +0, never runs
+    };
+    for (U32 i = 0; i < sizeof(code); i++) {
+        writeb(address + i, code[i]);
+    }
+    U32 endEip = sizeof(code) - 2;
+    U32 oldMaxBlocksPerTrace = NormalCPU::maxBlocksPerTrace;
+
+    NormalCPU::maxBlocksPerTrace = maxBlocksPerTrace;
+    cpu->reg[0].u32 = 0;
+    cpu->reg[1].u32 = iterations;
+    cpu->reg[2].u32 = 0;
+    cpu->eip.u32 = 0;
+    cpu->nextBlock = cpu->getNextBlock();
+    U64 start = KSystem::getMicroCounter();
+    while (cpu->eip.u32 != endEip) {
+        cpu->run();
+    }
+    U64 micro = KSystem::getMicroCounter() - start;
+    NormalCPU::maxBlocksPerTrace = oldMaxBlocksPerTrace;
+    if (cpu->reg[0].u32 != (U32)((U64)iterations * (iterations + 1) / 2) || cpu->reg[2].u32 != iterations) {
+        return 0;
+    }
+    return micro;
+}
+
+static void perfNormalCoreTrace() {
+    const char* name = "normal core loop without superblocks";
+    const char* traceName = "normal core loop with superblocks";
+    const U32 iterations = 2000000;
+
+    U64 micro = runNormalCoreLoop(0, iterations);
+    if (!micro) {
+        perfFailed(name);
+    } else {
+        perfResult(name, iterations, micro);
+    }
+    micro = runNormalCoreLoop(NormalCPU::maxBlocksPerTrace ? NormalCPU::maxBlocksPerTrace : 4, iterations);
+    if (!micro) {
+        perfFailed(traceName);
+    } else {
+        perfResult(traceName, iterations, micro);
+    }
+}
+
+// rep movsd and rep stosd of 32KB between two heap buffers, the same way a guest memcpy/memset would
+static void perfRepString() {
+    const char* movsName = "rep movsd 32KB";
+    const char* stosName = "rep stosd 32KB";
+    const U32 iterations = 2000;
+    const U32 len = 32*1024;
+    CPU* cpu = KThread::currentThread()->cpu;
+    U32 oldES = cpu->seg[ES].address;
+    U32 oldDS = cpu->seg[DS].address;
+
+    cpu->seg[ES].address = HEAP_ADDRESS;
+    cpu->seg[DS].address = HEAP_ADDRESS;
+    cpu->df = 1;
+    for (U32 i = 0; i < len; i++) {
+        writeb(HEAP_ADDRESS + 4 + i, (U8)i);
+    }
+    U64 start = KSystem::getMicroCounter();
+    for (U32 i = 0; i < iterations; i++) {
+        ESI = 4;
+        EDI = len + 8;
+        ECX = len / 4;
+        movsd32r(cpu, DS);
+    }
+    U64 micro = KSystem::getMicroCounter() - start;
+    if (ECX || readb(HEAP_ADDRESS + len + 8 + 1000) != (U8)1000) {
+        perfFailed(movsName);
+    } else {
+        perfResult(movsName, iterations, micro);
+    }
+
+    EAX = 0x01020304;
+    start = KSystem::getMicroCounter();
+    for (U32 i = 0; i < iterations; i++) {
+        EDI = len + 8;
+        ECX = len / 4;
+        stosd32r(cpu);
+    }
+    micro = KSystem::getMicroCounter() - start;
+    if (ECX || readd(HEAP_ADDRESS + len + 8 + 1000) != 0x01020304) {
+        perfFailed(stosName);
+    } else {
+        perfResult(stosName, iterations, micro);
+    }
+    cpu->seg[ES].address = oldES;
+    cpu->seg[DS].address = oldDS;
+}
+#endif
+
+// fork of a process with a 32MB heap and a few other mappings, like a small wine process: new Memory, clone, then delete it
+static void perfMemoryClone() {
+    const char* name = "Memory clone";
+    const U32 iterations = 200;
+    const U32 heapPages = 8192;
+    Memory* from = new Memory();
+
+    from->allocPages(0x10000 >> K_PAGE_SHIFT, heapPages, PAGE_READ|PAGE_WRITE, -1, 0, NULL);
+    from->allocPages(0x7bc00000 >> K_PAGE_SHIFT, 256, PAGE_READ|PAGE_EXEC, -1, 0, NULL);
+    from->allocPages(0xd0000000 >> K_PAGE_SHIFT, 32, PAGE_READ|PAGE_WRITE, -1, 0, NULL);
+#ifdef BOXEDWINE_64BIT_MMU
+    memset(getNativeAddress(from, 0x10000), 1, heapPages << K_PAGE_SHIFT);
+#endif
+    U64 start = KSystem::getMicroCounter();
+    for (U32 i = 0; i < iterations; i++) {
+        Memory* memory = new Memory();
+#ifdef BOXEDWINE_64BIT_MMU
+        // the parent keeps writing after each fork, so the later clones see a mix of shared and changed pages
+        U32* parent = (U32*)getNativeAddress(from, 0x10000 + (i % 64) * K_PAGE_SIZE);
+        *parent = i;
+#endif
+        memory->clone(from);
+        bool failed = !memory->isPageAllocated(0x7bc00000 >> K_PAGE_SHIFT) || memory->isPageAllocated(0x7bb00000 >> K_PAGE_SHIFT);
+#ifdef BOXEDWINE_64BIT_MMU
+        U32* child = (U32*)getNativeAddress(memory, 0x10000 + (i % 64) * K_PAGE_SIZE);
+        failed |= *child != i;
+        *child = 0xFFFFFFFF;
+        failed |= *parent != i;
+        *parent = i + 1;
+        failed |= *child != 0xFFFFFFFF;
+#endif
+        if (failed) {
+            perfFailed(name);
+            delete memory;
+            delete from;
+            return;
+        }
+        delete memory;
+    }
+    U64 micro = KSystem::getMicroCounter() - start;
+    perfResult(name, iterations, micro);
+    delete from;
+}
+
+#ifdef BOXEDWINE_X64
+// looks a symbol up in the vDSO the way glibc does, through the dynamic section and the hash table
+static U32 findVdsoSymbol(U32 vdso, const char* name) {
+    U32 phoff = readd(vdso + 28);
+    U32 phnum = readw(vdso + 44);
+    U32 dynamic = 0;
+    U32 hash = 0;
+    U32 symtab = 0;
+    U32 strtab = 0;
+    U32 h = 0;
+    char tmp[64];
+
+    for (U32 i = 0; i < phnum; i++) {
+        if (readd(vdso + phoff + i * 32) == 2) { // PT_DYNAMIC
+            dynamic = vdso + readd(vdso + phoff + i * 32 + 8);
+        }
+    }
+    for (U32 dyn = dynamic; dyn && readd(dyn); dyn += 8) {
+        switch (readd(dyn)) {
+        case 4: hash = vdso + readd(dyn + 4); break; // DT_HASH
+        case 5: strtab = vdso + readd(dyn + 4); break; // DT_STRTAB
+        case 6: symtab = vdso + readd(dyn + 4); break; // DT_SYMTAB
+        }
+    }
+    if (!hash || !strtab || !symtab) {
+        return 0;
+    }
+    for (const char* p = name; *p; p++) {
+        h = (h << 4) + (U8)*p;
+        U32 g = h & 0xf0000000;
+        if (g) {
+            h ^= g >> 24;
+        }
+        h &= ~g;
+    }
+    U32 nbucket = readd(hash);
+    U32 chain = hash + 8 + nbucket * 4;
+    for (U32 i = readd(hash + 8 + (h % nbucket) * 4); i; i = readd(chain + i * 4)) {
+        U32 sym = symtab + i * 16;
+        if (!strcmp(getNativeString(strtab + readd(sym), tmp, sizeof(tmp)), name)) {
+            return vdso + readd(sym + 4);
+        }
+    }
+    return 0;
+}
+
+// clock_gettime(CLOCK_MONOTONIC, tp) called the way glibc would, function is either the vDSO or a
+// stub that makes the syscall
+static U64 runClockGettimeLoop(U32 function, U32 iterations, U32 tp) {
+    x64CPU* cpu = (x64CPU*)KThread::currentThread()->cpu;
+    U32 oldSeg[6];
+    U8 code[] = {
+        0x68, 0x00, 0x00, 0x00, 0x00,       // L: push tp
+        0x6a, 0x01,                         // push 1
+        0xe8, 0x00, 0x00, 0x00, 0x00,       // call function
+        0x83, 0xc4, 0x08,                   // add esp, 8
+        0x4e,                               // dec esi
+        0x75, 0xee,                         // jnz L
+        0xcd, 0x97,                         // returns from the translated code
+        0xb8, 0x09, 0x01, 0x00, 0x00,       // S: mov eax, 265
+        0x8b, 0x5c, 0x24, 0x04,             // mov ebx, [esp+4]
+        0x8b, 0x4c, 0x24, 0x08,             // mov ecx, [esp+8]
+        0xcd, 0x80,                         // int 0x80
+        0xc3                                // ret
+    };
+
+    if (!function) {
+        function = CODE_ADDRESS + 20;
+    }
+    memcpy(code + 1, &tp, 4);
+    U32 rel = function - (CODE_ADDRESS + 12);
+    memcpy(code + 8, &rel, 4);
+    for (U32 i = 0; i < sizeof(code); i++) {
+        writeb(CODE_ADDRESS + i, code[i]);
+    }
+    // the vDSO expects a flat address space
+    for (U32 i = 0; i < 6; i++) {
+        oldSeg[i] = cpu->seg[i].address;
+        cpu->seg[i].address = 0;
+    }
+    ESP = STACK_ADDRESS - 16;
+    ESI = iterations;
+    cpu->eip.u32 = CODE_ADDRESS;
+    U64 start = KSystem::getMicroCounter();
+    cpu->translateEip(cpu->eip.u32);
+    cpu->run();
+    U64 end = KSystem::getMicroCounter();
+    cpu->postTestRun();
+    KThread::currentThread()->memory->clearCodePageFromCache(CODE_ADDRESS >> K_PAGE_SHIFT);
+    for (U32 i = 0; i < 6; i++) {
+        cpu->seg[i].address = oldSeg[i];
+    }
+    U64 micro = (U64)readd(tp) * 1000000 + readd(tp + 4) / 1000;
+    // the vDSO interpolates between host updates, so allow it to be a little ahead
+    if (ESI || EAX || readd(tp + 4) >= 1000000000 || micro < start || micro > end + 1000000) {
+        return 0;
+    }
+    return end - start;
+}
+
+static void perfClockGettime() {
+    const char* vdsoName = "clock_gettime vDSO";
+    const char* syscallName = "clock_gettime syscall";
+    const U32 iterations = 200000;
+    static U32 vdso;
+
+    setup();
+    // linking the loop to the code it calls on another page needs what the translator sets up the
+    // first time it runs
+    newInstruction(0);
+    runTestCPU();
+    if (!vdso) {
+        vdso = KVdso::map(KThread::currentThread());
+        // until the host has measured the rdtsc rate, the rate in the time page is 0 and every call is a syscall
+        U64 start = KSystem::getMicroCounter();
+        while (vdso && !readd(vdso - K_PAGE_SIZE + 4) && KSystem::getMicroCounter() - start < 1000000) {
+            KVdso::update(KThread::currentThread());
+        }
+    }
+    U32 function = vdso ? findVdsoSymbol(vdso, "__vdso_clock_gettime") : 0;
+    U64 micro = function ? runClockGettimeLoop(function, iterations, HEAP_ADDRESS) : 0;
+    if (!micro) {
+        perfFailed(vdsoName);
+    } else {
+        perfResult(vdsoName, iterations, micro);
+    }
+    micro = runClockGettimeLoop(0, iterations, HEAP_ADDRESS);
+    if (!micro) {
+        perfFailed(syscallName);
+    } else {
+        perfResult(syscallName, iterations, micro);
+    }
+}
+
+// a chunk of typical integer code with forward and backward branches that all stay inside the chunk
+static void perfX64TranslateChunk() {
+    const char* name = "x64 translate chunk";
+    const U32 blockCount = 64;
+    const U32 rounds = 2000;
+    x64CPU* cpu = (x64CPU*)KThread::currentThread()->cpu;
+    U32 address = cpu->seg[CS].address;
+
+    for (U32 i = 0; i < blockCount; i++) {
+        U8 block[] = {
+            0x01, 0xc8,             // add eax, ecx
+            0x83, 0xf8, 0x05,       // cmp eax, 5
+            0x74, 0x03,             // jz +3
+            0x8b, 0x53, 0x04,       // mov edx, [ebx+4]
+            0x89, 0x53, 0x08,       // mov [ebx+8], edx
+            0x49,                   // dec ecx
+            0x75, 0xf0              // jnz to the add
+        };
+        for (U32 j = 0; j < sizeof(block); j++) {
+            writeb(address++, block[j]);
+        }
+    }
+    writeb(address++, 0xeb); // jmp to itself
+    writeb(address++, 0xfe);
+
+    U64 bytes = x64CPU::translatedBytes;
+    U64 start = KSystem::getMicroCounter();
+    for (U32 i = 0; i < rounds; i++) {
+        std::shared_ptr<BtCodeChunk> chunk = cpu->translateChunk(0);
+        if (chunk->getEipLen() != address - cpu->seg[CS].address) {
+            perfFailed(name);
+            return;
+        }
+        chunk->release(cpu->thread->memory);
+    }
+    U64 micro = KSystem::getMicroCounter() - start;
+    perfResult(name, rounds, micro);
+    printf("%s ... %d guest bytes per second\n", name, (U32)((x64CPU::translatedBytes - bytes) * 1000000 / micro));
+}
+#endif
+
+int runPerfTests() {
+    perfWineserverRoundTrip();
+    perfWineserverSendFd();
+    perfIgnoreCasePathLookup();
+    perfLazyFlagsCondition();
+#ifndef BOXEDWINE_BINARY_TRANSLATOR
+    perfNormalCoreTrace();
+    perfRepString();
+#endif
+    perfMemoryClone();
+#ifdef BOXEDWINE_X64
+    perfClockGettime();
+    perfX64TranslateChunk();
+#endif
+    return perfFails;
+}
+
+#endif
@@ -0,0 +1,7 @@
+#ifndef __TEST_PERF_H__
+#define __TEST_PERF_H__
+
+// micro-benchmarks for the kernel/emulation hot paths, run with: boxedwineTest -perf
+int runPerfTests();
+
+#endif
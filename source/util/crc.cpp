@@ -17,9 +17,14 @@
  */
 #include "boxedwine.h"
 #include <sys/stat.h>
+#include "crc.h"
 
 unsigned int crc32b(unsigned char *message, int len) {
-    unsigned int h = 0, g;
+    return crc32bUpdate(0, message, len);
+}
+
+unsigned int crc32bUpdate(unsigned int h, const unsigned char *message, int len) {
+    unsigned int g;
     int i;
 
     for (i=0;i<len;i++) {
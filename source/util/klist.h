@@ -37,6 +37,7 @@ public:
     bool isInList() {return list!=NULL;}
 
     KListNode<T>* getNext() {return this->next;}
+    KListNode<T>* getPrev() {return this->prev;}
 private:
     friend KList<T>;
     KListNode<T>* prev;
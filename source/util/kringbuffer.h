@@ -0,0 +1,93 @@
+#ifndef __KRINGBUFFER_H__
+#define __KRINGBUFFER_H__
+
+#include "platform.h"
+
+// Byte queue backed by a single power of two sized buffer.  Reads and writes
+// are at most two memcpy's, one for each side of the wrap around.  The buffer
+// grows when a write doesn't fit, it never shrinks.
+class KRingBuffer {
+public:
+    KRingBuffer() : buffer(0), mask(0), head(0), count(0), readPos(0) {}
+    ~KRingBuffer() {
+        if (this->buffer) {
+            delete[] this->buffer;
+        }
+    }
+
+    U32 size() const {return this->count;}
+    bool isEmpty() const {return this->count==0;}
+    // total number of bytes that have ever been read/written, wraps around
+    U32 getReadPos() const {return this->readPos;}
+    U32 getWritePos() const {return this->readPos+this->count;}
+
+    void write(const U8* data, U32 len) {
+        if (!len) {
+            return;
+        }
+        this->reserve(this->count+len);
+        U32 offset = (this->head+this->count) & this->mask;
+        U32 todo = this->mask+1-offset;
+        if (todo>len)
+            todo = len;
+        memcpy(this->buffer+offset, data, todo);
+        memcpy(this->buffer, data+todo, len-todo);
+        this->count+=len;
+    }
+
+    // copies up to len bytes without removing them, returns how many were copied
+    U32 peek(U8* data, U32 len) const {
+        if (len>this->count)
+            len = this->count;
+        if (!len) {
+            return 0;
+        }
+        U32 todo = this->mask+1-this->head;
+        if (todo>len)
+            todo = len;
+        memcpy(data, this->buffer+this->head, todo);
+        memcpy(data+todo, this->buffer, len-todo);
+        return len;
+    }
+
+    U32 read(U8* data, U32 len) {
+        return this->skip(this->peek(data, len));
+    }
+
+    U32 skip(U32 len) {
+        if (len>this->count)
+            len = this->count;
+        this->head = (this->head+len) & this->mask;
+        this->count-=len;
+        this->readPos+=len;
+        return len;
+    }
+
+private:
+    void reserve(U32 len) {
+        U32 capacity = (this->buffer?this->mask+1:0);
+        if (len<=capacity) {
+            return;
+        }
+        U32 newCapacity = (capacity?capacity:4096);
+        while (newCapacity<len) {
+            newCapacity<<=1;
+        }
+        U8* newBuffer = new U8[newCapacity];
+        this->peek(newBuffer, this->count);
+        if (this->buffer) {
+            delete[] this->buffer;
+        }
+        this->buffer = newBuffer;
+        this->mask = newCapacity-1;
+        this->head = 0;
+    }
+
+    U8* buffer;
+    U32 mask;
+    U32 head;
+    U32 count;
+    U32 readPos;
+};
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef __KSPSCRINGBUFFER_H__
+#define __KSPSCRINGBUFFER_H__
+
+#include "platform.h"
+#include <atomic>
+
+// Fixed size byte queue for exactly one producer thread and one consumer
+// thread, neither side takes a lock.  Reads and writes are at most two
+// memcpy's, one for each side of the wrap around.  The positions only ever
+// increase (and wrap at 2^32), the capacity is a power of two so the
+// difference between them is always the fill level.
+class KSpscRingBuffer {
+public:
+    KSpscRingBuffer() : buffer(0), mask(0), readPos(0), writePos(0) {}
+    ~KSpscRingBuffer() {
+        if (this->buffer) {
+            delete[] this->buffer;
+        }
+    }
+
+    // not thread safe, only call this while neither the producer nor the consumer is running
+    void allocate(U32 len) {
+        U32 newCapacity = 4096;
+        while (newCapacity<len) {
+            newCapacity<<=1;
+        }
+        if (newCapacity!=this->capacity()) {
+            if (this->buffer) {
+                delete[] this->buffer;
+            }
+            this->buffer = new U8[newCapacity];
+            this->mask = newCapacity-1;
+        }
+        this->readPos.store(0, std::memory_order_relaxed);
+        this->writePos.store(0, std::memory_order_relaxed);
+    }
+
+    U32 capacity() const {return (this->buffer?this->mask+1:0);}
+    U32 size() const {return this->writePos.load(std::memory_order_acquire)-this->readPos.load(std::memory_order_acquire);}
+    U32 space() const {return this->capacity()-this->size();}
+    bool isEmpty() const {return this->size()==0;}
+
+    // producer side, returns how many bytes fit
+    U32 write(const U8* data, U32 len) {
+        U32 pos = this->writePos.load(std::memory_order_relaxed);
+        U32 available = this->capacity()-(pos-this->readPos.load(std::memory_order_acquire));
+
+        if (len>available)
+            len = available;
+        if (!len) {
+            return 0;
+        }
+        U32 offset = pos & this->mask;
+        U32 todo = this->mask+1-offset;
+        if (todo>len)
+            todo = len;
+        memcpy(this->buffer+offset, data, todo);
+        memcpy(this->buffer, data+todo, len-todo);
+        this->writePos.store(pos+len, std::memory_order_release);
+        return len;
+    }
+
+    // consumer side, returns how many bytes were read
+    U32 read(U8* data, U32 len) {
+        U32 pos = this->readPos.load(std::memory_order_relaxed);
+        U32 available = this->writePos.load(std::memory_order_acquire)-pos;
+
+        if (len>available)
+            len = available;
+        if (!len) {
+            return 0;
+        }
+        U32 offset = pos & this->mask;
+        U32 todo = this->mask+1-offset;
+        if (todo>len)
+            todo = len;
+        memcpy(data, this->buffer+offset, todo);
+        memcpy(data+todo, this->buffer, len-todo);
+        this->readPos.store(pos+len, std::memory_order_release);
+        return len;
+    }
+
+private:
+    U8* buffer;
+    U32 mask;
+    std::atomic<U32> readPos;
+    std::atomic<U32> writePos;
+};
+
+#endif
@@ -164,10 +164,13 @@ void BoxedWineCondition::unlock() {
 
 void BoxedWineCondition::addChildCondition(BoxedWineCondition& cond, const std::function<void(void)>& doneWaitingCallback) {
     // this (parent) should be be locked while we call this
-    cond.lock();
-    if (VECTOR_CONTAINS(cond.parents, this)) {
-        kpanic("BoxedWineCondition::addChildCondition cond already has this parent");
+    for (auto &child : this->children) {
+        // two waited on objects can share a lock, it's already held for this wait
+        if (child.cond == &cond) {
+            return;
+        }
     }
+    cond.lock();
     cond.parents.push_back(this);
     this->children.push_back(BoxedWineConditionChild(&cond, doneWaitingCallback));
 }
@@ -273,11 +276,108 @@ U32 BoxedWineCondition::waitCount() {
 }
 
 void BoxedWineCondition::addChildCondition(BoxedWineCondition& cond, const std::function<void(void)>& doneWaitingCallback) {
-    if (VECTOR_CONTAINS(cond.parents, this)) {
-        kpanic("BoxedWineCondition::addChildCondition cond already has this parent");
+    for (auto &child : this->children) {
+        // two waited on objects can share a lock
+        if (child.cond == &cond) {
+            return;
+        }
     }
     cond.parents.push_back(this);
     this->children.push_back(BoxedWineConditionChild(&cond, doneWaitingCallback));
 }
 
 #endif
+
+#ifdef BOXEDWINE_CPU_WORKERS
+bool BoxedWineKernelLock::enabled;
+std::atomic<U32> BoxedWineKernelLock::writersWaiting;
+
+static KNativeMutex kernelLockMutex;
+static KNativeCondition kernelLockCond;
+static U32 kernelLockReaders;
+static bool kernelLockWriter;
+static THREAD_LOCAL U32 kernelLockDepth;
+static THREAD_LOCAL bool kernelLockShared;
+
+// kernelLockMutex must be held
+static void releaseSharedKernelLock() {
+    kernelLockReaders--;
+    if (!kernelLockReaders) {
+        kernelLockCond.signalAll();
+    }
+}
+
+// kernelLockMutex must be held, writers go first so that a busy worker can't starve a syscall
+void BoxedWineKernelLock::waitForShared() {
+    while (kernelLockWriter || writersWaiting) {
+        kernelLockCond.wait(kernelLockMutex);
+    }
+    kernelLockReaders++;
+}
+
+void BoxedWineKernelLock::lock() {
+    if (kernelLockDepth++) {
+        return;
+    }
+    kernelLockMutex.lock();
+    writersWaiting++;
+    if (kernelLockShared) {
+        releaseSharedKernelLock();
+    }
+    while (kernelLockWriter || kernelLockReaders) {
+        kernelLockCond.wait(kernelLockMutex);
+    }
+    writersWaiting--;
+    kernelLockWriter = true;
+    kernelLockMutex.unlock();
+}
+
+void BoxedWineKernelLock::unlock() {
+    if (--kernelLockDepth) {
+        return;
+    }
+    kernelLockMutex.lock();
+    kernelLockWriter = false;
+    kernelLockCond.signalAll();
+    if (kernelLockShared) {
+        waitForShared();
+    }
+    kernelLockMutex.unlock();
+}
+
+void BoxedWineKernelLock::lockShared() {
+    kernelLockMutex.lock();
+    kernelLockShared = true;
+    waitForShared();
+    kernelLockMutex.unlock();
+}
+
+void BoxedWineKernelLock::unlockShared() {
+    kernelLockMutex.lock();
+    kernelLockShared = false;
+    releaseSharedKernelLock();
+    kernelLockMutex.unlock();
+}
+
+bool BoxedWineKernelLock::yieldSharedToWriters() {
+    if (kernelLockDepth || !kernelLockShared) {
+        return false;
+    }
+    kernelLockMutex.lock();
+    releaseSharedKernelLock();
+    waitForShared();
+    kernelLockMutex.unlock();
+    return true;
+}
+
+U32 BoxedWineKernelLock::getDepth() {
+    return kernelLockDepth;
+}
+
+void BoxedWineKernelLock::unwindTo(U32 depth) {
+    if (kernelLockDepth>depth) {
+        kernelLockDepth = depth+1;
+        unlock();
+    }
+}
+#endif
@@ -145,4 +145,44 @@ typedef BoxedWineCondition BOXEDWINE_CONDITION;
 
 #endif
 
+#ifdef BOXEDWINE_CPU_WORKERS
+// With -workers the cpu workers hold this shared while they run guest code.  The kernel was written
+// for one host thread, so syscalls, signals, the slow memory paths and the code cache take it
+// exclusively, which stops the other workers at the end of the block they are running.  Taking it
+// exclusively while holding it shared gives up the shared hold until the exclusive one is released.
+class BoxedWineKernelLock {
+public:
+    static void lock();
+    static void unlock();
+    static void lockShared();
+    static void unlockShared();
+
+    // called by a worker between blocks, returns true if it let a waiting writer run
+    static bool yieldShared() {return writersWaiting.load(std::memory_order_relaxed) && yieldSharedToWriters();}
+
+    // a longjmp skips the destructors of the critical sections it jumps over
+    static U32 getDepth();
+    static void unwindTo(U32 depth);
+
+    static bool enabled;
+private:
+    static bool yieldSharedToWriters();
+    static void waitForShared();
+    static std::atomic<U32> writersWaiting;
+};
+
+class BoxedWineKernelCriticalSection {
+public:
+    BoxedWineKernelCriticalSection() : locked(BoxedWineKernelLock::enabled) {if (locked) BoxedWineKernelLock::lock();}
+    ~BoxedWineKernelCriticalSection() {if (locked) BoxedWineKernelLock::unlock();}
+
+private:
+    bool locked;
+};
+
+#define BOXEDWINE_KERNEL_CRITICAL_SECTION BoxedWineKernelCriticalSection boxedWineKernelCriticalSection
+#else
+#define BOXEDWINE_KERNEL_CRITICAL_SECTION
+#endif
+
 #endif
\ No newline at end of file